@@ -1,6 +1,8 @@
 const net = require('net');
+const dgram = require('dgram');
+const crypto = require('crypto');
 
-// 消息类型（与 C++ 客户端一致）
+// 消息类型（与 src/include/network/NetProtocol.hpp 一致）
 const MessageType = {
   Connect: 1,
   ConnectAck: 2,
@@ -40,12 +42,74 @@ const MessageType = {
   HostStartGame: 30,
   RoomInfo: 31,
   // 墙壁伤害同步
-  WallDamage: 32
+  WallDamage: 32,
+  // UDP 握手
+  UdpHello: 33,
+  // 分块迷宫传输
+  MazeChunk: 34,
+  MazeOffer: 35,
+  // 迷宫种子（对方本地重新生成）
+  MazeSeed: 36,
+  // 帧同步模式
+  InputFrame: 37,
+  StateHash: 38,
+  // 网络诊断
+  Ping: 39,
+  Pong: 40,
+  // 断线重连
+  ResumeSession: 41,
+  ResumeRequest: 42,
+  ResumeSnapshot: 43,
+  PeerDropped: 44,
+  // 墙体变化批量同步
+  WallBatch: 45,
+  // 服务器权威模拟（仅 C++ 服务器支持，这里不转发）
+  PlayerInput: 46,
+  PlayerSnapshot: 47
 };
 
+// MazeChunk 头：类型(1) + 模式标志(1) + 哈希(8) + 分块序号(2) + 分块总数(2)
+const MAZE_CHUNK_HEADER_SIZE = 14;
+// MazeSeed：类型(1) + 模式标志(1) + 算法版本(1) + 种子(4) + 宽(2) + 高(2) + 敌人数(2) + 哈希(8)
+const MAZE_SEED_SIZE = 21;
+// 断线重连：保留掉线玩家位置的时长，ResumeSession 中玩家状态的长度（见 SessionResume.hpp）
+const RESUME_GRACE_SECONDS = 30;
+const RESUME_PLAYER_SIZE = 25;
+
+// 走 UDP 的高频状态消息（数据报格式：类型(1) + 序号(4) + 负载）
+const UdpRelayTypes = new Set([
+  MessageType.PlayerUpdate,
+  MessageType.PlayerShoot,
+  MessageType.NpcUpdate,
+  MessageType.NpcShoot
+]);
+
 // 房间管理
 const rooms = new Map();
 
+// UDP 会话：sessionId -> TCP socket，"地址:端口" -> TCP socket
+const sessions = new Map();
+const udpEndpoints = new Map();
+
+// 会话ID 是 UdpHello 绑定端点的唯一凭据，必须随机且不可预测（非 0、不与现有会话重复）
+function generateSessionId() {
+  let id;
+  do {
+    id = crypto.randomInt(1, 0x100000000);
+  } while (sessions.has(id));
+  return id;
+}
+
+// 解除 socket 的 UDP 端点绑定（端点已被别的会话重新绑定时不动）
+function unbindUdpEndpoint(socket) {
+  if (!socket.udpPort) return;
+  const key = `${socket.udpAddress}:${socket.udpPort}`;
+  if (udpEndpoints.get(key) === socket) {
+    udpEndpoints.delete(key);
+  }
+  socket.udpPort = 0;
+}
+
 // 生成随机房间码（纯4位数字）
 function generateRoomCode() {
   const code = Math.floor(1000 + Math.random() * 9000).toString();
@@ -89,6 +153,11 @@ function sendRoomInfo(room) {
   }
 }
 
+// 分块迷宫缓存是否完整
+function isMazeCacheComplete(room) {
+  return room.mazeChunks.length > 0 && room.mazeChunks.every(chunk => chunk !== null);
+}
+
 // 发送消息给客户端
 function sendMessage(socket, data) {
   const len = data.length;
@@ -107,6 +176,77 @@ function broadcastToRoom(room, senderSocket, data) {
   }
 }
 
+// 转发 UDP 数据报给房间内其他玩家（对方没有 UDP 端点时去掉序号走 TCP）
+function relayDatagram(room, senderSocket, datagram) {
+  for (const player of room.players) {
+    if (player.socket === senderSocket) continue;
+    if (player.socket.udpPort) {
+      udpServer.send(datagram, player.socket.udpPort, player.socket.udpAddress);
+    } else {
+      sendMessage(player.socket, Buffer.concat([datagram.slice(0, 1), datagram.slice(5)]));
+    }
+  }
+}
+
+function sendRoomError(socket, error) {
+  const response = Buffer.alloc(2 + error.length);
+  response[0] = MessageType.RoomError;
+  response[1] = error.length;
+  response.write(error, 2);
+  sendMessage(socket, response);
+}
+
+// 断线重连令牌（非 0 的随机 32 位数）：持有令牌即可接管掉线玩家的位置，必须取自密码学随机源
+function generateResumeToken() {
+  return crypto.randomInt(1, 0x100000000);
+}
+
+// 有玩家离开后：重置房间状态，让剩余玩家回到房间大厅
+function resetRoomAfterLeave(room, wasHost) {
+  room.started = false;
+  for (const player of room.players) {
+    player.reachedExit = false;
+    player.token = 0;
+    // 新房主自动准备就绪
+    if (wasHost) {
+      player.ready = true;
+    }
+  }
+
+  // 如果离开的是房主，让剩余玩家成为新房主
+  if (wasHost && room.players.length > 0) {
+    room.players[0].isHost = true;
+    room.players[0].socket.isHost = true;
+    room.players[0].ready = true;  // 房主默认准备
+    console.log(`New host assigned in room ${room.code}`);
+  }
+
+  // 通知剩余玩家对方已离开，并告知是否成为新房主
+  for (const player of room.players) {
+    try {
+      const playerLeftMsg = Buffer.alloc(2);
+      playerLeftMsg[0] = MessageType.PlayerLeft;
+      playerLeftMsg[1] = player.isHost ? 1 : 0;
+      sendMessage(player.socket, playerLeftMsg);
+    } catch (e) {
+      console.error('Error sending PlayerLeft message:', e.message);
+    }
+  }
+
+  // 发送更新后的房间信息
+  sendRoomInfo(room);
+  console.log(`Notified remaining players in room ${room.code}`);
+}
+
+// 保留的位置超时未重连：按普通离开处理
+function expireHeldSlot(room) {
+  const held = room.held;
+  room.held = null;
+  if (!held || rooms.get(room.code) !== room) return;
+  console.log(`Resume window expired in room ${room.code}`);
+  resetRoomAfterLeave(room, held.isHost);
+}
+
 // 处理消息
 function handleMessage(socket, data) {
   if (data.length < 1) return;
@@ -116,15 +256,30 @@ function handleMessage(socket, data) {
   switch (msgType) {
     case MessageType.Connect: {
       console.log('Client connected');
-      // 发送连接确认
-      const response = Buffer.alloc(1);
+      // 发送连接确认（附带会话ID，客户端用它完成 UDP 握手）
+      if (!socket.sessionId) {
+        socket.sessionId = generateSessionId();
+        sessions.set(socket.sessionId, socket);
+      }
+      const response = Buffer.alloc(5);
       response[0] = MessageType.ConnectAck;
+      response.writeUInt32LE(socket.sessionId, 1);
       sendMessage(socket, response);
       break;
     }
 
+    case MessageType.Ping: {
+      // 原样带回负载，客户端据此计算 RTT
+      const pong = Buffer.from(data);
+      pong[0] = MessageType.Pong;
+      sendMessage(socket, pong);
+      break;
+    }
+
     case MessageType.Disconnect: {
       console.log('Client requested disconnect');
+      // 主动离开不保留位置
+      socket.leftVoluntarily = true;
       // 触发清理逻辑（与close事件相同）
       socket.end(); // 这会触发close事件，进而调用cleanupPlayer
       break;
@@ -136,6 +291,8 @@ function handleMessage(socket, data) {
       const mazeHeight = data.readUInt16LE(3);
       // 读取暗黑模式标志（如果存在）
       const isDarkMode = data.length > 5 ? data[5] !== 0 : false;
+      // 帧同步模式标志（第 6 字节是服务器权威模拟请求，本服务器不支持，忽略）
+      const lockstep = data.length > 7 ? data[7] !== 0 : false;
 
       // 创建房间
       let roomCode;
@@ -147,18 +304,24 @@ function handleMessage(socket, data) {
         code: roomCode,
         mazeWidth: mazeWidth,
         mazeHeight: mazeHeight,
-        mazeData: null,  // 存储迷宫数据
-        players: [{ socket: socket, reachedExit: false, isHost: true, ready: true }],
+        mazeData: null,  // 存储迷宫数据（旧版 MazeData 整帧）
+        mazeHash: null,  // 分块迷宫缓存：哈希(hex) + 模式标志 + 原始分块
+        mazeFlags: 0,
+        mazeChunks: [],
+        mazeSeed: null,  // 房主最新的 MazeSeed 消息
+        players: [{ socket: socket, reachedExit: false, isHost: true, ready: true, token: 0 }],
         started: false,
         isEscapeMode: false,  // 游戏模式（从迷宫数据中读取）
-        isDarkMode: isDarkMode  // 暗黑模式
+        isDarkMode: isDarkMode,  // 暗黑模式
+        lockstep: lockstep,  // 帧同步模式
+        held: null  // 对局中意外掉线的玩家：{ token, isHost, reachedExit, timer }
       };
 
       rooms.set(roomCode, room);
       socket.roomCode = roomCode;
       socket.isHost = true;
 
-      console.log(`Room created: ${roomCode} (${mazeWidth}x${mazeHeight}) darkMode=${isDarkMode}`);
+      console.log(`Room created: ${roomCode} (${mazeWidth}x${mazeHeight}) darkMode=${isDarkMode} lockstep=${lockstep}`);
 
       // 发送房间创建成功
       const response = Buffer.alloc(2 + roomCode.length);
@@ -185,6 +348,8 @@ function handleMessage(socket, data) {
 
       // 存储迷宫数据（包含游戏模式）
       room.mazeData = data;
+      room.mazeChunks = [];
+      room.mazeSeed = null;
       // 解析游戏模式（第2个字节）
       if (data.length >= 2) {
         room.isEscapeMode = (data[1] !== 0);
@@ -202,6 +367,92 @@ function handleMessage(socket, data) {
       break;
     }
 
+    case MessageType.MazeChunk: {
+      // 房主发送迷宫分块：缓存并转发给对方
+      const room = socket.roomCode ? rooms.get(socket.roomCode) : null;
+      if (!room || !socket.isHost || data.length < MAZE_CHUNK_HEADER_SIZE) break;
+
+      const flags = data[1];
+      const hash = data.slice(2, 10).toString('hex');
+      const index = data.readUInt16LE(10);
+      const count = data.readUInt16LE(12);
+      if (count === 0 || index >= count) break;
+
+      // 新的迷宫：丢弃旧缓存
+      if (room.mazeHash !== hash || room.mazeFlags !== flags || room.mazeChunks.length !== count) {
+        room.mazeHash = hash;
+        room.mazeFlags = flags;
+        room.mazeChunks = new Array(count).fill(null);
+      }
+      room.mazeChunks[index] = data;
+      room.mazeData = null;
+      // 分块与种子描述的不是同一张迷宫时，以分块为准
+      if (room.mazeSeed && room.mazeSeed.slice(13, 21).toString('hex') !== hash) {
+        room.mazeSeed = null;
+      }
+      room.isEscapeMode = (flags & 1) !== 0;
+
+      const guest = room.players.find(p => !p.isHost);
+      if (guest) {
+        sendMessage(guest.socket, data);
+      }
+      break;
+    }
+
+    case MessageType.MazeSeed: {
+      // 房主发送迷宫种子：缓存并转发给对方，由对方本地重新生成
+      const room = socket.roomCode ? rooms.get(socket.roomCode) : null;
+      if (!room || !socket.isHost || data.length < MAZE_SEED_SIZE) break;
+
+      room.mazeSeed = data;
+      room.isEscapeMode = (data[1] & 1) !== 0;
+
+      const guest = room.players.find(p => !p.isHost);
+      if (guest) {
+        sendMessage(guest.socket, data);
+      }
+      break;
+    }
+
+    case MessageType.RequestMaze: {
+      // 对方无法按种子重新生成：有缓存分块则直接发送，否则转给房主补发
+      const room = socket.roomCode ? rooms.get(socket.roomCode) : null;
+      if (!room || socket.isHost) break;
+
+      const hash = data.length >= 9 ? data.slice(1, 9).toString('hex') : null;
+      if (isMazeCacheComplete(room) && room.mazeHash === hash) {
+        room.mazeChunks.forEach(chunk => sendMessage(socket, chunk));
+      } else {
+        const host = room.players.find(p => p.isHost);
+        if (host) {
+          sendMessage(host.socket, data);
+        }
+      }
+      break;
+    }
+
+    case MessageType.MazeOffer: {
+      // 房主声明迷宫哈希：已缓存则直接复用，否则请求房主上传
+      const room = socket.roomCode ? rooms.get(socket.roomCode) : null;
+      if (!room || !socket.isHost || data.length < 10) break;
+
+      const flags = data[1];
+      const hash = data.slice(2, 10).toString('hex');
+      if (isMazeCacheComplete(room) && room.mazeHash === hash && room.mazeFlags === flags) {
+        const guest = room.players.find(p => !p.isHost);
+        if (guest) {
+          room.mazeChunks.forEach(chunk => sendMessage(guest.socket, chunk));
+        }
+        console.log(`Reused cached maze ${hash} in room ${socket.roomCode}`);
+      } else {
+        const request = Buffer.alloc(9);
+        request[0] = MessageType.RequestMaze;
+        data.copy(request, 1, 2, 10);
+        sendMessage(socket, request);
+      }
+      break;
+    }
+
     case MessageType.JoinRoom: {
       const codeLen = data[1];
       const roomCode = data.slice(2, 2 + codeLen).toString();
@@ -209,26 +460,17 @@ function handleMessage(socket, data) {
       const room = rooms.get(roomCode);
       if (!room) {
         // 房间不存在
-        const error = "Room not found";
-        const response = Buffer.alloc(2 + error.length);
-        response[0] = MessageType.RoomError;
-        response[1] = error.length;
-        response.write(error, 2);
-        sendMessage(socket, response);
+        sendRoomError(socket, "Room not found");
         break;
       }
 
-      if (room.players.length >= 2) {
-        const error = "Room is full";
-        const response = Buffer.alloc(2 + error.length);
-        response[0] = MessageType.RoomError;
-        response[1] = error.length;
-        response.write(error, 2);
-        sendMessage(socket, response);
+      // 掉线玩家的位置在保留期内也算占用
+      if (room.players.length >= 2 || room.held) {
+        sendRoomError(socket, "Room is full");
         break;
       }
 
-      room.players.push({ socket: socket, reachedExit: false, isHost: false, ready: false });
+      room.players.push({ socket: socket, reachedExit: false, isHost: false, ready: false, token: 0 });
       socket.roomCode = roomCode;
       socket.isHost = false;
 
@@ -241,8 +483,14 @@ function handleMessage(socket, data) {
       response.write(roomCode, 2);
       sendMessage(socket, response);
 
-      // 发送迷宫数据给新玩家（如果已有）
-      if (room.mazeData) {
+      // 发送迷宫数据给新玩家（如果已有，优先只发种子）
+      if (room.mazeSeed) {
+        sendMessage(socket, room.mazeSeed);
+        console.log(`Sent maze seed to guest in room ${roomCode}`);
+      } else if (isMazeCacheComplete(room)) {
+        room.mazeChunks.forEach(chunk => sendMessage(socket, chunk));
+        console.log(`Sent cached maze chunks to guest in room ${roomCode}`);
+      } else if (room.mazeData) {
         sendMessage(socket, room.mazeData);
         console.log(`Sent existing maze data to guest in room ${roomCode}`);
       } else {
@@ -315,10 +563,15 @@ function handleMessage(socket, data) {
         player.ready = false;
       }
 
-      // 发送游戏开始消息给两个玩家
-      const gameStartMsg = Buffer.alloc(1);
-      gameStartMsg[0] = MessageType.GameStart;
+      // 发送游戏开始消息给两个玩家：类型 + 权威模拟标志（恒为 0）+ 帧同步标志 + 断线重连令牌
+      // （帧同步模式下双方必须逐步对齐，不支持中途重连，令牌为 0）
       for (const player of room.players) {
+        player.token = room.lockstep ? 0 : generateResumeToken();
+        const gameStartMsg = Buffer.alloc(7);
+        gameStartMsg[0] = MessageType.GameStart;
+        gameStartMsg[1] = 0;
+        gameStartMsg[2] = room.lockstep ? 1 : 0;
+        gameStartMsg.writeUInt32LE(player.token, 3);
         sendMessage(player.socket, gameStartMsg);
       }
       console.log(`Game started in room: ${roomCode}`);
@@ -387,6 +640,11 @@ function handleMessage(socket, data) {
       const room = rooms.get(roomCode);
       if (!room || !room.started) break;
 
+      // 对局已分出结果，之后掉线不再保留位置
+      for (const player of room.players) {
+        player.token = 0;
+      }
+
       // 转发游戏结果给其他玩家
       broadcastToRoom(room, socket, data);
       console.log(`Game result sent in room ${roomCode}`);
@@ -400,6 +658,12 @@ function handleMessage(socket, data) {
       const room = rooms.get(roomCode);
       if (!room) break;
 
+      // 对方掉线后留下的一方返回房间：不再等待重连
+      if (room.held) {
+        clearTimeout(room.held.timer);
+        expireHeldSlot(room);
+      }
+
       // 重置房间状态，准备下一轮
       room.started = false;
 
@@ -409,6 +673,7 @@ function handleMessage(socket, data) {
       // 重置 reachedExit 状态，并根据发送者身份设置 ready 状态
       for (const player of room.players) {
         player.reachedExit = false;
+        player.token = 0;
 
         if (player.socket === socket) {
           // 发送者返回房间：房主自动 ready，非房主保持 not ready
@@ -426,6 +691,35 @@ function handleMessage(socket, data) {
       break;
     }
 
+    case MessageType.ResumeSession: {
+      // 掉线方重连：令牌匹配则回到原来的位置，请留下的一方发送快照
+      if (data.length < 2) break;
+      const codeLen = data[1];
+      const payloadOffset = 2 + codeLen + 4;
+      if (data.length < payloadOffset + RESUME_PLAYER_SIZE) break;
+
+      const roomCode = data.slice(2, 2 + codeLen).toString();
+      const token = data.readUInt32LE(2 + codeLen);
+      const room = rooms.get(roomCode);
+      if (!room || !room.held || room.held.token !== token || socket.roomCode) {
+        sendRoomError(socket, "Session expired");
+        break;
+      }
+
+      const held = room.held;
+      clearTimeout(held.timer);
+      room.held = null;
+      room.players.push({ socket: socket, reachedExit: held.reachedExit, isHost: held.isHost, ready: false, token: token });
+      socket.roomCode = roomCode;
+      socket.isHost = held.isHost;
+      console.log(`Player resumed session in room ${roomCode}`);
+
+      // 转给留下的一方：ResumeRequest + 重连方的玩家状态
+      const request = Buffer.concat([Buffer.from([MessageType.ResumeRequest]), data.slice(payloadOffset)]);
+      broadcastToRoom(room, socket, request);
+      break;
+    }
+
     // 救援同步消息
     case MessageType.RescueStart:
     case MessageType.RescueProgress:
@@ -449,7 +743,11 @@ function handleMessage(socket, data) {
     case MessageType.NpcDamage:
     case MessageType.ClimaxStart:
     case MessageType.WallPlace:
-    case MessageType.WallDamage: {
+    case MessageType.WallDamage:
+    case MessageType.WallBatch:
+    case MessageType.InputFrame:
+    case MessageType.StateHash:
+    case MessageType.ResumeSnapshot: {
       const roomCode = socket.roomCode;
       if (!roomCode) break;
 
@@ -477,49 +775,40 @@ const server = net.createServer((socket) => {
 
     console.log('Cleaning up player...');
 
+    // 清理 UDP 会话
+    if (socket.sessionId) {
+      sessions.delete(socket.sessionId);
+    }
+    unbindUdpEndpoint(socket);
+
     if (socket.roomCode) {
       const room = rooms.get(socket.roomCode);
       if (room) {
         const wasHost = socket.isHost;
+        const leaving = room.players.find(p => p.socket === socket);
         room.players = room.players.filter(p => p.socket !== socket);
 
         if (room.players.length === 0) {
+          if (room.held) {
+            clearTimeout(room.held.timer);
+          }
           rooms.delete(socket.roomCode);
           console.log(`Room ${socket.roomCode} deleted`);
-        } else {
-          // 重置房间状态，让剩余玩家回到房间大厅
-          room.started = false;
+        } else if (room.started && leaving && leaving.token && !socket.leftVoluntarily && !room.held) {
+          // 对局中意外掉线：保留位置等待重连，对局继续
+          room.held = {
+            token: leaving.token,
+            isHost: wasHost,
+            reachedExit: leaving.reachedExit,
+            timer: setTimeout(() => expireHeldSlot(room), RESUME_GRACE_SECONDS * 1000)
+          };
+          const dropped = Buffer.from([MessageType.PeerDropped, RESUME_GRACE_SECONDS]);
           for (const player of room.players) {
-            player.reachedExit = false;
-            // 新房主自动准备就绪
-            if (wasHost) {
-              player.ready = true;
-            }
+            sendMessage(player.socket, dropped);
           }
-
-          // 如果离开的是房主，让剩余玩家成为新房主
-          if (wasHost && room.players.length > 0) {
-            room.players[0].isHost = true;
-            room.players[0].socket.isHost = true;
-            room.players[0].ready = true;  // 房主默认准备
-            console.log(`New host assigned in room ${socket.roomCode}`);
-          }
-
-          // 通知剩余玩家对方已离开，并告知是否成为新房主
-          for (const player of room.players) {
-            try {
-              const playerLeftMsg = Buffer.alloc(2);
-              playerLeftMsg[0] = MessageType.PlayerLeft;
-              playerLeftMsg[1] = player.isHost ? 1 : 0;
-              sendMessage(player.socket, playerLeftMsg);
-            } catch (e) {
-              console.error('Error sending PlayerLeft message:', e.message);
-            }
-          }
-
-          // 发送更新后的房间信息
-          sendRoomInfo(room);
-          console.log(`Notified remaining players in room ${socket.roomCode}`);
+          console.log(`Player dropped from room ${socket.roomCode}, holding slot for ${RESUME_GRACE_SECONDS}s`);
+        } else {
+          resetRoomAfterLeave(room, wasHost);
         }
       }
     }
@@ -555,7 +844,47 @@ const server = net.createServer((socket) => {
   });
 });
 
+// UDP 中继（与 TCP 同端口）
+const udpServer = dgram.createSocket('udp4');
+
+udpServer.on('message', (msg, rinfo) => {
+  if (msg.length < 5) return;
+
+  const msgType = msg[0];
+
+  if (msgType === MessageType.UdpHello) {
+    // 握手：绑定会话与 UDP 端点，并原样回复确认
+    const socket = sessions.get(msg.readUInt32LE(1));
+    if (!socket) return;
+    unbindUdpEndpoint(socket);
+    const previous = udpEndpoints.get(`${rinfo.address}:${rinfo.port}`);
+    if (previous && previous !== socket) {
+      previous.udpPort = 0;
+    }
+    socket.udpAddress = rinfo.address;
+    socket.udpPort = rinfo.port;
+    udpEndpoints.set(`${rinfo.address}:${rinfo.port}`, socket);
+    udpServer.send(msg, rinfo.port, rinfo.address);
+    return;
+  }
+
+  if (!UdpRelayTypes.has(msgType)) return;
+
+  const socket = udpEndpoints.get(`${rinfo.address}:${rinfo.port}`);
+  if (!socket || !socket.roomCode) return;
+
+  const room = rooms.get(socket.roomCode);
+  if (!room || !room.started) return;
+
+  relayDatagram(room, socket, msg);
+});
+
+udpServer.on('error', (err) => {
+  console.error('UDP error:', err.message);
+});
+
 const PORT = 9999;
+udpServer.bind(PORT);
 server.listen(PORT, () => {
   console.log(`Tank Maze Server running on port ${PORT}`);
   console.log('Waiting for players...');
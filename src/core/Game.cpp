@@ -2,12 +2,22 @@
 #include "CollisionSystem.hpp"
 #include "UIHelper.hpp"
 #include "MultiplayerHandler.hpp"
+#include "MazeGenerator.hpp"
 #include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <cstdlib>
 #include <iostream>
+#include <limits>
+#include <random>
+
+// 录像文件直接保存 Tank 的输入位
+static_assert(Tank::INPUT_UP == REPLAY_KEY_UP && Tank::INPUT_DOWN == REPLAY_KEY_DOWN &&
+                  Tank::INPUT_LEFT == REPLAY_KEY_LEFT && Tank::INPUT_RIGHT == REPLAY_KEY_RIGHT &&
+                  Tank::INPUT_FIRE == REPLAY_KEY_FIRE,
+              "Tank input bits are stored verbatim in replay files");
 
 Game::Game()
-    : m_mazeGenerator(31, 21) // 默认中等尺寸
 {
   // 获取桌面尺寸，计算最大窗口大小（保持16:9比例）
   auto desktop = sf::VideoMode::getDesktopMode();
@@ -37,6 +47,40 @@ Game::Game()
   m_uiView = sf::View(sf::FloatRect({0.f, 0.f}, {static_cast<float>(LOGICAL_WIDTH), static_cast<float>(LOGICAL_HEIGHT)}));
 }
 
+bool Game::setReplayOptions(const ReplayOptions &options)
+{
+  m_replayOptions = options;
+  m_replayOptions.speed = std::clamp(options.speed, 0.05f, 64.f);
+  if (options.replayPath.empty())
+    return true;
+
+  if (!m_replayReader.open(options.replayPath))
+  {
+    std::cerr << "[Replay] " << options.replayPath << ": " << m_replayReader.error() << std::endl;
+    return false;
+  }
+  const ReplayHeader &header = m_replayReader.header();
+  if (header.generatorVersion != MazeGenerator::ALGORITHM_VERSION)
+  {
+    std::cerr << "[Replay] Recorded with maze generator v" << header.generatorVersion << ", this build has v"
+              << static_cast<int>(MazeGenerator::ALGORITHM_VERSION) << std::endl;
+    return false;
+  }
+  if (header.tickRate != std::lround(1.f / REPLAY_TICK_DT))
+  {
+    std::cerr << "[Replay] Unsupported tick rate " << header.tickRate << std::endl;
+    return false;
+  }
+
+  std::cout << "[Replay] Loaded " << m_replayReader.tickCount() << " ticks (" << header.mazeWidth << "x"
+            << header.mazeHeight << ", seed " << header.mazeSeed << ", " << header.enemyCount << " NPCs)" << std::endl;
+  m_replaying = true;
+  m_replayOptions.recordPath.clear(); // 回放时不录制
+  if (m_replayOptions.headless)
+    m_window.setVisible(false);
+  return true;
+}
+
 bool Game::init()
 {
   // 加载字体 - 跨平台支持
@@ -91,13 +135,11 @@ bool Game::init()
     return false;
   }
 
-  // 初始化音频系统（使用资源路径）
+  // 初始化音频系统（使用资源路径）：后台加载，菜单先显示，BGM 就绪后再开始
+  // 加载失败不阻止游戏运行（AudioManager 会打印警告并保持静音）；无界面回放不加载
   std::string resourcePath = getResourcePath();
-  if (!AudioManager::getInstance().init(resourcePath + "music_assets/"))
-  {
-    std::cerr << "Warning: Failed to initialize audio system" << std::endl;
-    // 音频初始化失败不阻止游戏运行
-  }
+  if (!m_replayOptions.headless)
+    AudioManager::getInstance().initAsync(resourcePath + "music_assets/");
 
   // 设置听音范围（基于视野大小）
   AudioManager::getInstance().setListeningRange(LOGICAL_WIDTH * VIEW_ZOOM * 0.6f);
@@ -110,20 +152,47 @@ bool Game::init()
 
 void Game::generateRandomMaze()
 {
-  // 使用已设置的迷宫尺寸（来自预设或自定义）
-  m_mazeGenerator = MazeGenerator(m_mazeWidth, m_mazeHeight);
+  // 使用已设置的迷宫尺寸（来自预设或自定义）和菜单中选择的敌人数量
+  // Escape 模式（单人 Escape 也生成治疗墙）
+  bool isEscape = (m_gameModeOption == GameModeOption::EscapeMode);
+  loadMaze({m_mazeWidth, m_mazeHeight, m_enemyOptions[m_enemyIndex], false, isEscape});
+}
 
-  // 使用菜单中选择的敌人数量
-  int enemyCount = m_enemyOptions[m_enemyIndex];
-  m_mazeGenerator.setEnemyCount(enemyCount);
-  m_mazeGenerator.setDestructibleRatio(0.15f);
+void Game::loadMaze(const MazeRequest &request)
+{
+  if (!m_mazePool.take(request, m_maze))
+  {
+    m_maze.generateRandomMaze(request.width, request.height, 0, request.enemyCount, request.multiplayer,
+                              request.escape);
+  }
 
-  // 设置 Escape 模式（单人 Escape 也生成治疗墙）
-  bool isEscape = (m_gameModeOption == GameModeOption::EscapeMode);
-  m_mazeGenerator.setEscapeMode(isEscape);
+  // 联机地图记录生成参数，发送时只需种子
+  if (request.multiplayer)
+  {
+    m_mpState.generatedMazeSeed = {MazeGenerator::ALGORITHM_VERSION, m_maze.getSeed(),
+                                   static_cast<uint16_t>(request.width), static_cast<uint16_t>(request.height),
+                                   static_cast<uint16_t>(request.enemyCount)};
+  }
 
-  auto mazeMap = m_mazeGenerator.generate();
-  m_maze.loadFromString(mazeMap);
+  // 重开时大概率使用相同参数，提前准备下一张
+  m_mazePool.prefetch(request);
+}
+
+void Game::prefetchMaze()
+{
+  if (m_mpState.isMultiplayer || !m_mpState.roomCode.empty())
+  {
+    // 房间内只有房主生成地图
+    if (m_mpState.isHost)
+    {
+      m_mazePool.prefetch({m_mpState.mazeWidth, m_mpState.mazeHeight, m_mpState.npcCount, true,
+                           m_mpState.isEscapeMode});
+    }
+    return;
+  }
+
+  bool isEscape = (m_gameModeOption == GameModeOption::EscapeMode);
+  m_mazePool.prefetch({m_mazeWidth, m_mazeHeight, m_enemyOptions[m_enemyIndex], m_isMultiplayer, isEscape});
 }
 
 void Game::startGame()
@@ -131,11 +200,47 @@ void Game::startGame()
   // 停止所有残留音效
   AudioManager::getInstance().stopAllSFX();
 
-  // 生成随机地图
-  generateRandomMaze();
+  // 录制或回放时从干净的状态开始：实体 id、AI 调度轮转与 rand() 序列都与之前的对局无关
+  bool fixedStep = m_replaying || !m_replayOptions.recordPath.empty();
+  if (fixedStep)
+  {
+    m_enemies.clear();
+    m_player.reset();
+    m_otherPlayer.reset();
+    m_entities.clear();
+    m_aiScheduler = AIScheduler();
+    // 预算按耗时计，会让思考时机随机器快慢变化；录像中不设上限
+    m_aiScheduler.setBudgetMs(std::numeric_limits<double>::infinity());
+    m_tickAccumulator = 0.f;
+    m_replayTick = 0;
+    m_pendingPlacement.reset();
+  }
+
+  // 生成随机地图（回放时按文件头重建同一张）
+  m_chunkStreamer.reset();
+  if (m_replaying)
+  {
+    const ReplayHeader &header = m_replayReader.header();
+    m_gameModeOption = header.escapeMode ? GameModeOption::EscapeMode : GameModeOption::BattleMode;
+    m_darkModeOption = header.darkMode != 0;
+    m_maze.generateRandomMaze(header.mazeWidth, header.mazeHeight, header.mazeSeed, header.enemyCount, false,
+                              header.escapeMode != 0);
+  }
+  else if (m_mapSizePreset == MapSizePreset::Endless)
+  {
+    // 无尽模式：m_maze 只装载玩家周围的区块窗口
+    std::random_device device;
+    uint64_t seed = (static_cast<uint64_t>(device()) << 32) | device();
+    m_chunkStreamer = std::make_unique<ChunkStreamer>(seed, ENDLESS_ENEMIES_PER_CHUNK);
+    m_chunkStreamer->start(m_maze);
+  }
+  else
+  {
+    generateRandomMaze();
+  }
 
   // 创建玩家
-  m_player = std::make_unique<Tank>();
+  m_player = std::make_unique<Tank>(m_entities);
 
   // 加载玩家坦克纹理
   std::string resPath = getResourcePath();
@@ -154,9 +259,32 @@ void Game::startGame()
   // 清空子弹
   m_bullets.clear();
 
-  // 在指定位置生成敌人
+  // 在指定位置生成敌人（Enemy 构造时用 rand() 取初始方向）
+  uint32_t randSeed = m_replaying ? m_replayReader.header().randSeed : m_maze.getSeed();
+  if (fixedStep)
+    std::srand(randSeed);
   spawnEnemies();
 
+  // 录制只针对 --record 之后的第一局单人对局（文件头描述不了无尽模式，留给下一局有限地图）
+  if (!m_replaying && !m_replayOptions.recordPath.empty() && !m_chunkStreamer)
+  {
+    ReplayHeader header;
+    header.tickRate = static_cast<uint16_t>(std::lround(1.f / REPLAY_TICK_DT));
+    header.generatorVersion = MazeGenerator::ALGORITHM_VERSION;
+    header.mazeSeed = m_maze.getSeed();
+    header.mazeWidth = static_cast<uint16_t>(m_mazeWidth);
+    header.mazeHeight = static_cast<uint16_t>(m_mazeHeight);
+    header.enemyCount = static_cast<uint16_t>(m_enemyOptions[m_enemyIndex]);
+    header.escapeMode = m_gameModeOption == GameModeOption::EscapeMode;
+    header.darkMode = m_darkModeOption;
+    header.randSeed = randSeed;
+    if (m_replayWriter.open(m_replayOptions.recordPath, header))
+      std::cout << "[Replay] Recording to " << m_replayOptions.recordPath << std::endl;
+    else
+      std::cerr << "[Replay] Cannot write " << m_replayOptions.recordPath << std::endl;
+    m_replayOptions.recordPath.clear();
+  }
+
   m_gameState = GameState::Playing;
   m_gameOver = false;
   m_gameWon = false;
@@ -170,24 +298,68 @@ void Game::startGame()
 void Game::spawnEnemies()
 {
   m_enemies.clear();
-  const auto &spawnPoints = m_maze.getEnemySpawnPoints();
 
+  // 无尽模式的 NPC 随区块换入
+  if (m_chunkStreamer)
+  {
+    streamChunks();
+    return;
+  }
+
+  for (const auto &pos : m_maze.getEnemySpawnPoints())
+    spawnEnemyAt(pos);
+}
+
+void Game::spawnEnemyAt(sf::Vector2f position, float health)
+{
   std::string resPath = getResourcePath();
-  for (const auto &pos : spawnPoints)
+  auto enemy = std::make_unique<Enemy>(m_entities);
+  if (enemy->loadTextures(resPath + "tank_assets/PNG/Hulls_Color_D/Hull_01.png",
+                          resPath + "tank_assets/PNG/Weapon_Color_D/Gun_01.png"))
   {
-    auto enemy = std::make_unique<Enemy>();
-    if (enemy->loadTextures(resPath + "tank_assets/PNG/Hulls_Color_D/Hull_01.png",
-                            resPath + "tank_assets/PNG/Weapon_Color_D/Gun_01.png"))
-    {
-      enemy->setPosition(pos);
-      enemy->setBounds(m_maze.getSize());
-      m_enemies.push_back(std::move(enemy));
-    }
+    enemy->setPosition(position);
+    enemy->setBounds(m_maze.getSize());
+    if (health > 0.f)
+      enemy->setHealth(health);
+    m_enemies.push_back(std::move(enemy));
   }
 }
 
+void Game::streamChunks()
+{
+  sf::Vector2f shift;
+  if (m_chunkStreamer->update(m_player->getPosition(), m_maze, shift))
+  {
+    // 浮动原点：玩家、NPC、子弹与相机平移同样的距离，画面上看不出窗口重建
+    m_player->setPosition(m_player->getPosition() + shift);
+    for (auto &enemy : m_enemies)
+      enemy->shiftOrigin(shift);
+    for (auto &bullet : m_bullets)
+      bullet->shiftOrigin(shift);
+    m_currentCameraPos += shift;
+    m_gameView.setCenter(m_gameView.getCenter() + shift);
+
+    // 离开窗口的 NPC 换出为所在区块的记录
+    m_enemies.erase(std::remove_if(m_enemies.begin(), m_enemies.end(),
+                                   [this](const std::unique_ptr<Enemy> &e)
+                                   {
+                                     if (m_chunkStreamer->contains(e->getPosition()))
+                                       return false;
+                                     m_chunkStreamer->pageOut(e->getPosition(), e->getHealth());
+                                     return true;
+                                   }),
+                    m_enemies.end());
+  }
+
+  for (const auto &npc : m_chunkStreamer->takeArrivals())
+    spawnEnemyAt(npc.position, npc.health);
+}
+
 void Game::resetGame()
 {
+  stopRecording();
+  m_replaying = false;
+  m_aimOverride.reset();
   m_gameState = GameState::MainMenu;
   m_gameOver = false;
   m_gameWon = false;
@@ -197,8 +369,11 @@ void Game::resetGame()
   m_bullets.clear();
   m_player.reset();
   m_otherPlayer.reset();
+  m_chunkStreamer.reset();
   m_mpState.isMultiplayer = false;
   m_mpState.isHost = false;
+  m_mpState.lockstep = false;
+  m_mpState.lockstepSession.stop();
   m_mpState.localPlayerReachedExit = false;
   m_mpState.otherPlayerReachedExit = false;
   m_mpState.roomCode.clear();
@@ -206,6 +381,9 @@ void Game::resetGame()
   m_inputText.clear();
   m_inputMode = InputMode::None;
   m_mpState.generatedMazeData.clear();
+  m_mpState.generatedMazeSeed = {};
+  m_mpState.reconnecting = false;
+  m_mpState.peerDropped = false;
 
   // 重置 Escape 模式相关状态
   m_mpState.isEscapeMode = false;
@@ -238,6 +416,17 @@ void Game::run()
   // 开始播放菜单BGM
   AudioManager::getInstance().playBGM(BGMType::Menu);
 
+  // 回放：跳过菜单直接开局
+  if (m_replaying)
+  {
+    startGame();
+    if (m_replayOptions.headless)
+    {
+      runHeadlessReplay();
+      m_window.close();
+    }
+  }
+
   while (m_window.isOpen())
   {
     float dt = m_clock.restart().asSeconds();
@@ -245,11 +434,14 @@ void Game::run()
     // 处理网络消息
     NetworkManager::getInstance().update();
 
-    // 更新音频系统（清理已播放完的音效）
-    AudioManager::getInstance().update();
-
     processEvents();
 
+    // 非对局界面空闲时在后台准备下一张地图
+    if (m_gameState != GameState::Playing && m_gameState != GameState::Multiplayer)
+    {
+      prefetchMaze();
+    }
+
     switch (m_gameState)
     {
     case GameState::MainMenu:
@@ -261,7 +453,10 @@ void Game::run()
       }
       break;
     case GameState::Playing:
-      update(dt);
+      if (m_replaying || m_replayWriter.isOpen())
+        advanceFixedTicks(dt);
+      else
+        update(dt);
       // 检查是否看到终点，切换BGM
       if (!m_exitVisible && isExitInView())
       {
@@ -299,7 +494,18 @@ void Game::run()
       break;
     }
 
+    // 更新音频系统（合并并播放本帧收集的音效）
+    AudioManager::getInstance().update();
+
     render();
+
+    // 启动耗时：从构造 Game 到第一帧显示
+    if (!m_firstFrameReported)
+    {
+      m_firstFrameReported = true;
+      std::cout << "[Startup] First frame after " << m_startupClock.getElapsedTime().asMilliseconds() << " ms (audio "
+                << (AudioManager::getInstance().isReady() ? "ready" : "still loading") << ")" << std::endl;
+    }
   }
 
   // 在窗口关闭后清理静态资源（避免 OpenGL 上下文销毁后释放纹理）
@@ -347,6 +553,9 @@ void Game::processMainMenuEvents(const sf::Event &event)
         m_heightIndex = 8;
         m_enemyIndex = 8; // 80 NPCs
         break;
+      case MapSizePreset::Endless:
+        // 尺寸与 NPC 数量由区块决定；联机仍使用当前宽高
+        break;
       case MapSizePreset::Custom:
         // 保持当前自定义值
         m_mazeWidth = m_widthOptions[m_widthIndex];
@@ -605,6 +814,18 @@ void Game::processEvents()
       break;
 
     case GameState::Playing:
+      // 回放中只响应退出与暂停，输入全部来自录像
+      if (m_replaying)
+      {
+        if (const auto *keyPressed = event->getIf<sf::Event::KeyPressed>())
+        {
+          if (keyPressed->code == sf::Keyboard::Key::Escape)
+            resetGame();
+          else if (keyPressed->code == sf::Keyboard::Key::P)
+            m_gameState = GameState::Paused;
+        }
+        break;
+      }
       if (m_player)
       {
         // 放置模式下不处理鼠标事件（避免放置墙壁时同时发射子弹）
@@ -668,46 +889,9 @@ void Game::processEvents()
           {
             // 获取鼠标在世界坐标中的位置
             sf::Vector2f mouseWorldPos = m_window.mapPixelToCoords(mousePressed->position, m_gameView);
-
-            // 检查位置是否有坦克
-            bool hasTankAtPos = false;
-            GridPos grid = m_maze.worldToGrid(mouseWorldPos);
-            sf::Vector2f gridCenter = m_maze.gridToWorld(grid);
-            float checkRadius = m_maze.getTileSize() * 1.0f;
-
-            // 检查玩家
-            if (m_player)
-            {
-              float dist = std::hypot(m_player->getPosition().x - gridCenter.x, m_player->getPosition().y - gridCenter.y);
-              if (dist < checkRadius)
-                hasTankAtPos = true;
-            }
-            // 检查NPC
-            if (!hasTankAtPos)
-            {
-              for (const auto &enemy : m_enemies)
-              {
-                if (!enemy->isDead())
-                {
-                  float dist = std::hypot(enemy->getPosition().x - gridCenter.x, enemy->getPosition().y - gridCenter.y);
-                  if (dist < checkRadius)
-                  {
-                    hasTankAtPos = true;
-                    break;
-                  }
-                }
-              }
-            }
-
-            // 尝试放置墙壁
-            if (!hasTankAtPos && m_maze.placeWall(mouseWorldPos))
+            if (tryPlaceWall(mouseWorldPos) && m_replayWriter.isOpen())
             {
-              m_player->useWallFromBag();
-              // 播放放置音效
-              AudioManager::getInstance().playSFX(SFXType::MenuConfirm, mouseWorldPos, m_player->getPosition());
-
-              // 放置成功后自动退出放置模式
-              m_placementMode = false;
+              m_pendingPlacement = m_maze.worldToGrid(mouseWorldPos);
             }
           }
           else if (mousePressed->button == sf::Mouse::Button::Right)
@@ -750,9 +934,10 @@ void Game::processEvents()
 
               // 重新生成迷宫（使用菜单选择的NPC数量，联机模式，根据游戏模式决定墙体类型）
               int npcCount = m_enemyOptions[m_enemyIndex];
-              m_maze.generateRandomMaze(m_mazeWidth, m_mazeHeight, 0, npcCount, true, m_mpState.isEscapeMode);
+              loadMaze({m_mazeWidth, m_mazeHeight, npcCount, true, m_mpState.isEscapeMode});
               m_mpState.generatedMazeData = m_maze.getMazeData();
-              NetworkManager::getInstance().sendMazeData(m_mpState.generatedMazeData, m_mpState.isEscapeMode, m_mpState.isDarkMode);
+              NetworkManager::getInstance().sendMazeData(m_mpState.generatedMazeData, m_mpState.isEscapeMode, m_mpState.isDarkMode,
+                                                         m_mpState.generatedMazeSeed);
 
               // 房主默认准备
               m_mpState.localPlayerReady = true;
@@ -858,6 +1043,11 @@ void Game::processEvents()
         {
           m_mpState.eKeyHeld = true;
         }
+        // F3 切换网络诊断面板
+        if (keyPressed->code == sf::Keyboard::Key::F3)
+        {
+          m_mpState.showNetStats = !m_mpState.showNetStats;
+        }
         // 空格键切换放置模式
         if (keyPressed->code == sf::Keyboard::Key::Space)
         {
@@ -889,7 +1079,15 @@ void Game::processEvents()
       {
         if (const auto *mousePressed = event->getIf<sf::Event::MouseButtonPressed>())
         {
-          if (mousePressed->button == sf::Mouse::Button::Left)
+          if (mousePressed->button == sf::Mouse::Button::Left && m_mpState.lockstep)
+          {
+            // 帧同步模式：只记录格子，随下一次输入发出，由两端在同一步判定并放置
+            GridPos cell = m_maze.worldToGrid(m_window.mapPixelToCoords(mousePressed->position, m_gameView));
+            m_mpState.pendingPlaceCol = cell.x;
+            m_mpState.pendingPlaceRow = cell.y;
+            m_placementMode = false;
+          }
+          else if (mousePressed->button == sf::Mouse::Button::Left)
           {
             // 获取鼠标在世界坐标中的位置
             sf::Vector2f mouseWorldPos = m_window.mapPixelToCoords(mousePressed->position, m_gameView);
@@ -937,8 +1135,9 @@ void Game::processEvents()
               m_player->useWallFromBag();
               // 播放放置音效
               AudioManager::getInstance().playSFX(SFXType::MenuConfirm, mouseWorldPos, m_player->getPosition());
-              // 发送到网络同步
-              NetworkManager::getInstance().sendWallPlace(mouseWorldPos.x, mouseWorldPos.y);
+              // 发送到网络同步（随本帧的 WallBatch 发出）
+              GridPos placed = m_maze.worldToGrid(mouseWorldPos);
+              NetworkManager::getInstance().queueWallPlace(placed.y, placed.x);
               // 放置成功后自动退出放置模式
               m_placementMode = false;
             }
@@ -955,60 +1154,210 @@ void Game::processEvents()
   }
 }
 
-void Game::update(float dt)
+bool Game::tryPlaceWall(sf::Vector2f worldPos)
 {
-  if (!m_player)
-    return;
+  if (!m_player || m_player->getWallsInBag() <= 0)
+    return false;
 
-  // 获取鼠标在世界坐标中的位置
-  sf::Vector2i mousePixelPos = sf::Mouse::getPosition(m_window);
-  sf::Vector2f mouseWorldPos = m_window.mapPixelToCoords(mousePixelPos, m_gameView);
+  // 检查位置是否有坦克
+  bool hasTankAtPos = false;
+  GridPos grid = m_maze.worldToGrid(worldPos);
+  sf::Vector2f gridCenter = m_maze.gridToWorld(grid);
+  float checkRadius = m_maze.getTileSize() * 1.0f;
 
-  // 保存旧位置用于碰撞检测
-  sf::Vector2f oldPos = m_player->getPosition();
+  // 检查玩家
+  float playerDist = std::hypot(m_player->getPosition().x - gridCenter.x, m_player->getPosition().y - gridCenter.y);
+  if (playerDist < checkRadius)
+    hasTankAtPos = true;
+  // 检查NPC
+  if (!hasTankAtPos)
+  {
+    for (const auto &enemy : m_enemies)
+    {
+      if (!enemy->isDead())
+      {
+        float dist = std::hypot(enemy->getPosition().x - gridCenter.x, enemy->getPosition().y - gridCenter.y);
+        if (dist < checkRadius)
+        {
+          hasTankAtPos = true;
+          break;
+        }
+      }
+    }
+  }
 
-  // 获取移动向量
-  sf::Vector2f movement = m_player->getMovement(dt);
+  // 尝试放置墙壁
+  if (hasTankAtPos || !m_maze.placeWall(worldPos))
+    return false;
 
-  // 更新玩家
-  m_player->update(dt, mouseWorldPos);
+  m_player->useWallFromBag();
+  // 播放放置音效
+  AudioManager::getInstance().playSFX(SFXType::MenuConfirm, worldPos, m_player->getPosition());
 
-  // 检查玩家与墙壁的碰撞并实现墙壁滑动
-  sf::Vector2f newPos = m_player->getPosition();
-  float radius = m_player->getCollisionRadius();
+  // 放置成功后自动退出放置模式
+  m_placementMode = false;
+  return true;
+}
 
-  if (m_maze.checkCollision(newPos, radius))
-  {
-    // 尝试只在 X 方向移动
-    sf::Vector2f posX = {oldPos.x + movement.x, oldPos.y};
-    // 尝试只在 Y 方向移动
-    sf::Vector2f posY = {oldPos.x, oldPos.y + movement.y};
+sf::Vector2f Game::aimWorldPosition() const
+{
+  if (m_aimOverride)
+    return *m_aimOverride;
+  // 鼠标在世界坐标中的位置
+  return m_window.mapPixelToCoords(sf::Mouse::getPosition(m_window), m_gameView);
+}
 
-    bool canMoveX = !m_maze.checkCollision(posX, radius);
-    bool canMoveY = !m_maze.checkCollision(posY, radius);
+void Game::advanceFixedTicks(float dt)
+{
+  // 回放按倍速推进；追赶上限随倍速放大，避免高倍速被截断
+  float speed = m_replaying ? m_replayOptions.speed : 1.f;
+  int maxTicks = MAX_TICKS_PER_FRAME * std::max(1, static_cast<int>(std::ceil(speed)));
+  m_tickAccumulator += dt * speed;
 
-    if (canMoveX && canMoveY)
+  int ticks = 0;
+  while (m_tickAccumulator >= REPLAY_TICK_DT && m_gameState == GameState::Playing)
+  {
+    if (ticks == maxTicks)
     {
-      // 两个方向都能走，选择移动量大的
-      if (std::abs(movement.x) > std::abs(movement.y))
-        m_player->setPosition(posX);
-      else
-        m_player->setPosition(posY);
+      m_tickAccumulator = 0.f;
+      break;
     }
-    else if (canMoveX)
+    m_tickAccumulator -= REPLAY_TICK_DT;
+    ticks++;
+    if (!stepReplayTick())
+      break;
+  }
+}
+
+bool Game::stepReplayTick()
+{
+  if (!m_player)
+    return false;
+
+  ReplayTick tick;
+  if (m_replaying)
+  {
+    if (m_replayTick >= m_replayReader.tickCount())
     {
-      m_player->setPosition(posX);
+      finishReplay();
+      return false;
     }
-    else if (canMoveY)
+    tick = m_replayReader.tick(m_replayTick);
+    m_player->setInputBits(tick.buttons & REPLAY_TANK_KEYS);
+    m_eKeyHeld = (tick.buttons & REPLAY_KEY_EXIT) != 0;
+    if (tick.buttons & REPLAY_PLACE_WALL)
+      tryPlaceWall(m_maze.gridToWorld({tick.placeCol, tick.placeRow}));
+  }
+  else
+  {
+    // 录制：按键状态已由本帧事件更新，瞄准点取此刻的鼠标位置
+    sf::Vector2f aim = m_window.mapPixelToCoords(sf::Mouse::getPosition(m_window), m_gameView);
+    tick.buttons = m_player->getInputBits() | (m_eKeyHeld ? REPLAY_KEY_EXIT : 0);
+    if (m_pendingPlacement)
     {
-      m_player->setPosition(posY);
+      tick.buttons |= REPLAY_PLACE_WALL;
+      tick.placeCol = static_cast<int16_t>(m_pendingPlacement->x);
+      tick.placeRow = static_cast<int16_t>(m_pendingPlacement->y);
+      m_pendingPlacement.reset();
     }
+    tick.aimX = aim.x;
+    tick.aimY = aim.y;
+    m_replayWriter.append(tick);
+  }
+
+  m_aimOverride = sf::Vector2f(tick.aimX, tick.aimY);
+  m_replayTick++;
+  update(REPLAY_TICK_DT);
+
+  // 对局结束
+  if (m_gameState != GameState::Playing)
+  {
+    if (m_replaying)
+      finishReplay();
     else
-    {
-      // 两个方向都不能走，退回原位
-      m_player->setPosition(oldPos);
-    }
+      stopRecording();
+  }
+  return true;
+}
+
+void Game::stopRecording()
+{
+  if (!m_replayWriter.isOpen())
+    return;
+  std::cout << "[Replay] Recorded " << m_replayWriter.tickCount() << " ticks" << std::endl;
+  m_replayWriter.close();
+  m_aimOverride.reset();
+}
+
+void Game::finishReplay()
+{
+  if (!m_replaying)
+    return;
+  m_replaying = false;
+  m_aimOverride.reset();
+
+  const char *outcome = m_gameState == GameState::Victory    ? "victory"
+                        : m_gameState == GameState::GameOver ? "defeat"
+                                                             : "end of input";
+  sf::Vector2f pos = m_player ? m_player->getPosition() : sf::Vector2f{};
+  std::cout << "[Replay] Finished at tick " << m_replayTick << "/" << m_replayReader.tickCount() << " (" << outcome
+            << "), player at (" << pos.x << ", " << pos.y << ") health " << (m_player ? m_player->getHealth() : 0.f)
+            << ", " << m_enemies.size() << " NPCs left" << std::endl;
+  // 录制在对局结束那一步停止，提前结束说明模拟与录制时不一致
+  if (m_gameState != GameState::Playing && m_replayTick < m_replayReader.tickCount())
+  {
+    std::cout << "[Replay] Warning: match ended " << (m_replayReader.tickCount() - m_replayTick)
+              << " ticks before the recording did, playback diverged" << std::endl;
+  }
+
+  // 输入放完但对局未结束：停在最后一帧，继续后由玩家接管
+  if (m_gameState == GameState::Playing)
+    m_gameState = GameState::Paused;
+}
+
+void Game::runHeadlessReplay()
+{
+  std::size_t ticks = 0;
+  double totalMs = 0.0;
+  double maxMs = 0.0;
+  while (m_replaying && m_gameState == GameState::Playing)
+  {
+    auto start = std::chrono::steady_clock::now();
+    if (!stepReplayTick())
+      break;
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    totalMs += ms;
+    maxMs = std::max(maxMs, ms);
+    ticks++;
+  }
+
+  if (ticks > 0)
+  {
+    std::cout << "[Replay] Headless: " << ticks << " ticks in " << totalMs << " ms (" << ticks * 1000.0 / totalMs
+              << " ticks/s, avg " << totalMs / ticks << " ms, max " << maxMs << " ms per tick)" << std::endl;
   }
+}
+
+void Game::update(float dt)
+{
+  if (!m_player)
+    return;
+
+  // 玩家瞄准点（录像时为本步记录的鼠标位置）
+  sf::Vector2f mouseWorldPos = aimWorldPosition();
+
+  // 保存旧位置用于碰撞检测
+  sf::Vector2f oldPos = m_player->getPosition();
+
+  // 更新玩家
+  m_player->update(dt, mouseWorldPos);
+
+  // 检查玩家与墙壁的碰撞并实现墙壁滑动
+  m_player->setPosition(m_maze.resolveMovement(oldPos, m_player->getPosition(), m_player->getCollisionRadius()));
+
+  // 无尽模式：越过区块边界后平移常驻窗口
+  if (m_chunkStreamer)
+    streamChunks();
 
   // E键状态已通过事件驱动在 processEvents 中设置
 
@@ -1076,14 +1425,30 @@ void Game::update(float dt)
     AudioManager::getInstance().playSFX(SFXType::Shoot, bulletPos, m_player->getPosition());
   }
 
-  // 更新敌人
-  for (auto &enemy : m_enemies)
+  // 更新敌人（AI 按距离分级思考，移动每帧更新）
+  m_aiScheduler.beginFrame({m_player->getPosition()});
+
+  // 群体避让：用本帧开始时的位置建邻居网格
+  m_crowd.build(m_entities);
+
+  for (std::size_t i = 0; i < m_enemies.size(); ++i)
   {
+    auto &enemy = m_enemies[i];
+
     // 单人模式：自动激活检测
     enemy->checkAutoActivation(m_player->getPosition());
 
     enemy->setTarget(m_player->getPosition());
-    enemy->update(dt, m_maze);
+    if (enemy->isActivated() && m_aiScheduler.shouldThink(i, enemy->getPosition()))
+    {
+      auto thinkStart = std::chrono::steady_clock::now();
+      enemy->update(dt, m_maze, true, &m_crowd);
+      m_aiScheduler.endThink(thinkStart);
+    }
+    else
+    {
+      enemy->update(dt, m_maze, false, &m_crowd);
+    }
 
     // 只有激活的敌人才射击
     if (enemy->shouldShoot())
@@ -1148,8 +1513,7 @@ void Game::updateCamera()
   sf::Vector2f playerPos = m_player->getPosition();
 
   // 获取鼠标在世界坐标中的位置
-  sf::Vector2i mousePixelPos = sf::Mouse::getPosition(m_window);
-  sf::Vector2f mouseWorldPos = m_window.mapPixelToCoords(mousePixelPos, m_gameView);
+  sf::Vector2f mouseWorldPos = aimWorldPosition();
 
   // 计算鼠标与玩家的距离
   sf::Vector2f toMouse = mouseWorldPos - playerPos;
@@ -1207,7 +1571,8 @@ void Game::checkCollisions()
 void Game::checkMultiplayerCollisions()
 {
   CollisionSystem::checkMultiplayerCollisions(
-      m_player.get(), m_otherPlayer.get(), m_enemies, m_bullets, m_maze, m_mpState.isHost);
+      m_player.get(), m_otherPlayer.get(), m_enemies, m_bullets, m_maze, m_mpState.ownsWorldSimulation(),
+      !m_mpState.serverAuthoritative);
 }
 
 void Game::render()
@@ -1257,16 +1622,11 @@ void Game::render()
 void Game::renderMainMenu()
 {
   m_window.setView(m_uiView);
+  m_menuUI.begin();
+  const float centerX = LOGICAL_WIDTH / 2.f;
 
   // 标题
-  sf::Text title(m_font);
-  title.setString("TANK MAZE");
-  title.setCharacterSize(72);
-  title.setFillColor(sf::Color::White);
-  title.setStyle(sf::Text::Bold);
-  sf::FloatRect titleBounds = title.getLocalBounds();
-  title.setPosition({(LOGICAL_WIDTH - titleBounds.size.x) / 2.f, 100.f});
-  m_window.draw(title);
+  m_menuUI.text("title", "TANK MAZE", 72, sf::Color::White, {centerX, 100.f}, UIAlign::Center, true);
 
   // 菜单选项
   float startY = 220.f;
@@ -1288,6 +1648,9 @@ void Game::renderMainMenu()
   case MapSizePreset::Ultra:
     mapSizeStr = "Ultra (121x101, 80 NPCs)";
     break;
+  case MapSizePreset::Endless:
+    mapSizeStr = "Endless (single player)";
+    break;
   case MapSizePreset::Custom:
     mapSizeStr = "Custom";
     break;
@@ -1307,48 +1670,30 @@ void Game::renderMainMenu()
 
   for (size_t i = 0; i < options.size(); ++i)
   {
-    sf::Text optionText(m_font);
-    optionText.setString(options[i]);
-    optionText.setCharacterSize(32);
-
-    // MapWidth/MapHeight/NPCs 在任何预设下都使用相同视觉样式
-    bool isCustomOption = (i == 3 || i == 4 || i == 5); // MapWidth, MapHeight, NPCs
-
-    if (static_cast<int>(i) == static_cast<int>(m_mainMenuOption))
-    {
-      optionText.setFillColor(sf::Color::Yellow);
-      optionText.setString("> " + options[i] + " <");
-    }
-    else
-    {
-      optionText.setFillColor(sf::Color(180, 180, 180));
-    }
-
-    sf::FloatRect bounds = optionText.getLocalBounds();
-    optionText.setPosition({(LOGICAL_WIDTH - bounds.size.x) / 2.f, startY + i * spacing});
-    m_window.draw(optionText);
+    bool selected = static_cast<int>(i) == static_cast<int>(m_mainMenuOption);
+    m_menuUI.text("option" + std::to_string(i), selected ? "> " + options[i] + " <" : options[i], 32,
+                  selected ? sf::Color::Yellow : sf::Color(180, 180, 180), {centerX, startY + i * spacing},
+                  UIAlign::Center);
   }
 
   // 地图预览信息
-  sf::Text mapInfo(m_font);
   int totalCells = m_mazeWidth * m_mazeHeight;
-  mapInfo.setString("Map: " + std::to_string(m_mazeWidth) + " x " +
-                    std::to_string(m_mazeHeight) + " = " +
-                    std::to_string(totalCells) + " cells");
-  mapInfo.setCharacterSize(20);
-  mapInfo.setFillColor(sf::Color(100, 180, 100));
-  sf::FloatRect mapInfoBounds = mapInfo.getLocalBounds();
-  mapInfo.setPosition({(LOGICAL_WIDTH - mapInfoBounds.size.x) / 2.f, LOGICAL_HEIGHT - 120.f});
-  m_window.draw(mapInfo);
+  std::string mapInfo = "Map: " + std::to_string(m_mazeWidth) + " x " + std::to_string(m_mazeHeight) + " = " +
+                        std::to_string(totalCells) + " cells";
+  if (m_mapSizePreset == MapSizePreset::Endless)
+  {
+    mapInfo = "Map: endless, " + std::to_string(ChunkedMaze::CHUNK_TILES) + "x" +
+              std::to_string(ChunkedMaze::CHUNK_TILES) + " chunks, " + std::to_string(ENDLESS_ENEMIES_PER_CHUNK) +
+              " NPCs each (multiplayer keeps " + std::to_string(m_mazeWidth) + " x " + std::to_string(m_mazeHeight) +
+              ")";
+  }
+  m_menuUI.text("mapInfo", mapInfo, 20, sf::Color(100, 180, 100), {centerX, LOGICAL_HEIGHT - 120.f},
+                UIAlign::Center);
 
   // 提示
-  sf::Text hint(m_font);
-  hint.setString("W/S: Navigate | A/D: Adjust values | Enter: Select");
-  hint.setCharacterSize(18);
-  hint.setFillColor(sf::Color(120, 120, 120));
-  sf::FloatRect hintBounds = hint.getLocalBounds();
-  hint.setPosition({(LOGICAL_WIDTH - hintBounds.size.x) / 2.f, LOGICAL_HEIGHT - 60.f});
-  m_window.draw(hint);
+  m_menuUI.text("hint", "W/S: Navigate | A/D: Adjust values | Enter: Select", 18, sf::Color(120, 120, 120),
+                {centerX, LOGICAL_HEIGHT - 60.f}, UIAlign::Center);
+  m_menuUI.draw(m_window);
 }
 
 void Game::renderModeSelect()
@@ -1669,66 +2014,44 @@ void Game::renderGame()
 
     float uiY = 50.f; // UI 起始 Y 位置
 
+    m_hudUI.begin();
+
     // Battle 模式显示金币数量
     if (m_gameModeOption == GameModeOption::BattleMode)
     {
-      sf::Text coinsText(m_font);
-      coinsText.setString("Coins: " + std::to_string(m_player->getCoins()));
-      coinsText.setCharacterSize(24);
-      coinsText.setFillColor(sf::Color(255, 200, 50)); // 金色
-      coinsText.setPosition({20.f, uiY});
-      m_window.draw(coinsText);
+      m_hudUI.text("coins", "Coins: " + std::to_string(m_player->getCoins()), 24, sf::Color(255, 200, 50),
+                   {20.f, uiY}); // 金色
       uiY += 30.f;
     }
 
     // 绘制背包中的墙壁数量
-    sf::Text wallsText(m_font);
-    wallsText.setString("Walls: " + std::to_string(m_player->getWallsInBag()));
-    wallsText.setCharacterSize(24);
-    wallsText.setFillColor(sf::Color(139, 90, 43)); // 棕色
-    wallsText.setPosition({20.f, uiY});
-    m_window.draw(wallsText);
+    m_hudUI.text("walls", "Walls: " + std::to_string(m_player->getWallsInBag()), 24, sf::Color(139, 90, 43),
+                 {20.f, uiY}); // 棕色
     uiY += 30.f;
 
     // Escape 模式或暗黑模式下显示剩余存活的敌人数量
     if ((m_gameModeOption == GameModeOption::EscapeMode || m_darkModeOption) && !m_isMultiplayer)
     {
       int aliveEnemies = 0;
-      for (const auto &enemy : m_enemies)
-      {
-        if (!enemy->isDead())
-          aliveEnemies++;
-      }
-      sf::Text enemyCountText(m_font);
-      enemyCountText.setString("Enemies: " + std::to_string(aliveEnemies));
-      enemyCountText.setCharacterSize(24);
-      enemyCountText.setFillColor(sf::Color(255, 100, 100)); // 红色
-      enemyCountText.setPosition({20.f, uiY});
-      m_window.draw(enemyCountText);
+      for (EntityId id = 0; id < m_entities.capacity(); id++)
+        aliveEnemies += m_entities.isAliveNpc(id);
+      m_hudUI.text("enemies", "Enemies: " + std::to_string(aliveEnemies), 24, sf::Color(255, 100, 100),
+                   {20.f, uiY}); // 红色
       uiY += 30.f;
     }
 
     // 如果处于放置模式，显示提示
     if (m_placementMode)
     {
-      sf::Text placeHint(m_font);
-      placeHint.setString("[PLACEMENT MODE] Click to place wall, Space to cancel");
-      placeHint.setCharacterSize(20);
-      placeHint.setFillColor(sf::Color::Yellow);
-      sf::FloatRect hintBounds = placeHint.getLocalBounds();
-      placeHint.setPosition({(LOGICAL_WIDTH - hintBounds.size.x) / 2.f, 20.f});
-      m_window.draw(placeHint);
+      m_hudUI.text("placeHint", "[PLACEMENT MODE] Click to place wall, Space to cancel", 20, sf::Color::Yellow,
+                   {LOGICAL_WIDTH / 2.f, 20.f}, UIAlign::Center);
     }
     else if (m_player->getWallsInBag() > 0)
     {
       // 提示可以按 SPACE 进入放置模式
-      sf::Text bagHint(m_font);
-      bagHint.setString("Press SPACE to place walls");
-      bagHint.setCharacterSize(18);
-      bagHint.setFillColor(sf::Color(150, 150, 150));
-      bagHint.setPosition({20.f, uiY});
-      m_window.draw(bagHint);
+      m_hudUI.text("bagHint", "Press SPACE to place walls", 18, sf::Color(150, 150, 150), {20.f, uiY});
     }
+    m_hudUI.draw(m_window);
   }
 }
 
@@ -1857,6 +2180,7 @@ void Game::setupNetworkCallbacks()
     m_otherPlayer.reset();
     m_enemies.clear();
     m_bullets.clear();
+    m_mpState.lockstepSession.stop();
     
     // 重置多人游戏状态
     m_mpState.localPlayerReachedExit = false;
@@ -1867,6 +2191,7 @@ void Game::setupNetworkCallbacks()
     m_mpState.otherPlayerInRoom = false;
     m_mpState.otherPlayerReady = false;
     m_mpState.otherPlayerIP = "";
+    m_mpState.peerDropped = false;
     m_gameOver = false;
     m_gameWon = false;
     
@@ -1929,7 +2254,7 @@ void Game::setupNetworkCallbacks()
     // 房主生成迷宫（使用菜单选择的NPC数量，联机模式生成特殊方块，根据游戏模式决定墙体类型）
     int npcCount = m_enemyOptions[m_enemyIndex];
     std::cout << "[DEBUG] Creating room with " << npcCount << " NPCs, isEscapeMode=" << m_mpState.isEscapeMode << std::endl;
-    m_maze.generateRandomMaze(m_mazeWidth, m_mazeHeight, 0, npcCount, true, m_mpState.isEscapeMode);
+    loadMaze({m_mazeWidth, m_mazeHeight, npcCount, true, m_mpState.isEscapeMode});
     m_mpState.generatedMazeData = m_maze.getMazeData();
     
     // 检查迷宫数据中是否有敌人标记 'X'
@@ -1941,7 +2266,8 @@ void Game::setupNetworkCallbacks()
     }
     std::cout << "[DEBUG] Maze data contains " << xCount << " enemy markers (X)" << std::endl;
     
-    NetworkManager::getInstance().sendMazeData(m_mpState.generatedMazeData, m_mpState.isEscapeMode, m_mpState.isDarkMode);
+    NetworkManager::getInstance().sendMazeData(m_mpState.generatedMazeData, m_mpState.isEscapeMode, m_mpState.isDarkMode,
+                                               m_mpState.generatedMazeSeed);
     
     // 进入房间大厅
     m_gameState = GameState::RoomLobby;
@@ -1992,15 +2318,29 @@ void Game::setupNetworkCallbacks()
                        {
     // 服务器请求迷宫数据（房主收到）
     if (m_mpState.isHost && !m_mpState.generatedMazeData.empty()) {
-      NetworkManager::getInstance().sendMazeData(m_mpState.generatedMazeData, m_mpState.isEscapeMode, m_mpState.isDarkMode);
+      NetworkManager::getInstance().sendMazeData(m_mpState.generatedMazeData, m_mpState.isEscapeMode, m_mpState.isDarkMode,
+                                                 m_mpState.generatedMazeSeed);
     } });
 
   net.setOnGameStart([this]()
                      {
     m_mpState.isMultiplayer = true;
+    m_mpState.serverAuthoritative = NetworkManager::getInstance().isServerAuthoritative();
+    m_mpState.lockstep = NetworkManager::getInstance().isLockstep();
+    
+    // 帧同步：两端从完全相同的状态开始，实体 id 从 0 分配、rand() 序列由地图决定
+    if (m_mpState.lockstep) {
+      m_enemies.clear();
+      m_bullets.clear();
+      m_player.reset();
+      m_otherPlayer.reset();
+      m_entities.clear();
+    }
     
-    // 使用已接收/生成的迷宫数据
-    if (!m_mpState.generatedMazeData.empty()) {
+    // 使用已接收/生成的迷宫数据（房主的 m_maze 已是刚换入的同一张地图，无需重建墙体；
+    // 帧同步模式下双方都从字符串重建，保证墙体状态一致）
+    bool mazeLoaded = m_mpState.isHost && !m_mpState.lockstep && m_maze.getMazeData() == m_mpState.generatedMazeData;
+    if (!m_mpState.generatedMazeData.empty() && !mazeLoaded) {
       m_maze.loadFromString(m_mpState.generatedMazeData);
     }
     
@@ -2033,6 +2373,8 @@ void Game::setupNetworkCallbacks()
     m_mpState.rescueProgress = 0.f;
     m_mpState.fKeyHeld = false;
     m_mpState.canRescue = false;
+    m_mpState.reconnecting = false;
+    m_mpState.peerDropped = false;
     
     // 重置终点交互状态
     m_mpState.isAtExitZone = false;
@@ -2040,9 +2382,12 @@ void Game::setupNetworkCallbacks()
     m_mpState.exitHoldProgress = 0.f;
     m_mpState.eKeyHeld = false;
     
-    // 创建本地玩家并加载贴图
+    // 创建本地玩家并加载贴图（帧同步模式下先创建房主的坦克，两端实体 id 一致）
     std::string resPath = getResourcePath();
-    m_player = std::make_unique<Tank>();
+    if (m_mpState.lockstep && !m_mpState.isHost) {
+      m_otherPlayer = std::make_unique<Tank>(m_entities);
+    }
+    m_player = std::make_unique<Tank>(m_entities);
     m_player->loadTextures(resPath + "tank_assets/PNG/Hulls_Color_A/Hull_01.png",
                            resPath + "tank_assets/PNG/Weapon_Color_A/Gun_01.png");
     m_player->setPosition(mySpawn);
@@ -2050,11 +2395,14 @@ void Game::setupNetworkCallbacks()
     m_player->setCoins(10);  // 初始10个金币
     
     // 设置第二个玩家（另一个客户端）- 使用不同颜色贴图
-    m_otherPlayer = std::make_unique<Tank>();
+    if (!m_otherPlayer) {
+      m_otherPlayer = std::make_unique<Tank>(m_entities);
+    }
     m_otherPlayer->loadTextures(resPath + "tank_assets/PNG/Hulls_Color_B/Hull_01.png",
                                 resPath + "tank_assets/PNG/Weapon_Color_B/Gun_01.png");
     m_otherPlayer->setPosition(otherSpawn);
     m_otherPlayer->setScale(m_tankScale);
+    m_otherPlayer->setCoins(10);  // 对方的金币只在帧同步模式下参与本地模拟
     
     // 设置阵营：Escape 模式下双方同队，Battle 模式下对立
     if (m_mpState.isEscapeMode) {
@@ -2080,6 +2428,10 @@ void Game::setupNetworkCallbacks()
     const auto& spawnPoints = m_maze.getEnemySpawnPoints();
     std::cout << "[DEBUG] Multiplayer: Enemy spawn points count = " << spawnPoints.size() << std::endl;
     
+    // 帧同步：NPC 初始朝向来自 rand()，两端用地图哈希作种子
+    if (m_mpState.lockstep) {
+      std::srand(static_cast<unsigned>(MazeCodec::hash(m_mpState.generatedMazeData)));
+    }
     spawnEnemies();  // 使用现有的敌人生成逻辑
     
     std::cout << "[DEBUG] Multiplayer: Enemies spawned = " << m_enemies.size() << std::endl;
@@ -2099,6 +2451,26 @@ void Game::setupNetworkCallbacks()
     m_bullets.clear();
     m_mpState.nearbyNpcIndex = -1;
     
+    // 清空上一局的插值快照
+    m_mpState.otherPlayerSnapshots.clear();
+    m_mpState.npcSnapshots.assign(m_enemies.size(), SnapshotBuffer());
+    
+    // 帧同步：重置会话与双方的模拟状态
+    if (m_mpState.lockstep) {
+      m_mpState.lockstepSession.start(m_mpState.isHost ? 0 : 1);
+      m_mpState.lockstepAccumulator = 0.f;
+      m_mpState.lockstepPlayers[0] = {};
+      m_mpState.lockstepPlayers[1] = {};
+      m_mpState.pendingPlaceCol = -1;
+      m_mpState.pendingPlaceRow = -1;
+      m_mpState.rKeyJustPressed = false;
+      std::cout << "[Lockstep] Match started as slot " << m_mpState.lockstepSession.localSlot() << ", "
+                << m_enemies.size() << " NPCs, input delay " << LockstepSession::INPUT_DELAY << " ticks" << std::endl;
+    } else {
+      m_mpState.lockstepSession.stop();
+    }
+    MultiplayerHandler::beginMatch(m_mpState);
+    
     // 初始化相机位置和缩放
     m_gameView.setCenter(spawn1Pos);
     m_gameView.setSize({LOGICAL_WIDTH * VIEW_ZOOM, LOGICAL_HEIGHT * VIEW_ZOOM});
@@ -2113,9 +2485,11 @@ void Game::setupNetworkCallbacks()
   net.setOnPlayerUpdate([this](const PlayerState &state)
                         {
     if (m_otherPlayer) {
-      m_otherPlayer->setPosition({state.x, state.y});
-      m_otherPlayer->setRotation(state.rotation);
-      m_otherPlayer->setTurretRotation(state.turretAngle);
+      // 位置和朝向进入插值缓冲，由 MultiplayerHandler 每帧采样
+      m_mpState.otherPlayerSnapshots.push(state.timestamp, NetworkManager::getInstance().getNetworkTime(),
+                                          {state.x, state.y}, state.rotation, state.turretAngle);
+      m_mpState.remotePlayerPos = {state.x, state.y};
+      m_mpState.hasRemotePlayerPos = true;
       m_otherPlayer->setHealth(state.health);
       m_mpState.otherPlayerReachedExit = state.reachedExit;
       
@@ -2138,6 +2512,13 @@ void Game::setupNetworkCallbacks()
       }
     } });
 
+  net.setOnServerPlayerState([this](uint32_t inputSeq, const PlayerState &state)
+                              {
+    // 服务器权威模拟：本方坦克的服务器状态，由 MultiplayerHandler 每帧校正预测
+    m_mpState.serverPlayerState = state;
+    m_mpState.serverInputSeq = inputSeq;
+    m_mpState.hasServerPlayerState = true; });
+
   net.setOnPlayerShoot([this](float x, float y, float angle)
                        {
     // 创建另一个玩家的子弹 - 紫色
@@ -2200,7 +2581,7 @@ void Game::setupNetworkCallbacks()
         
         // 如果是房主收到激活请求，需要转发给所有客户端（包括原发送者）
         // 确保双方同步
-        if (m_mpState.isHost) {
+        if (m_mpState.ownsWorldSimulation()) {
           NetworkManager::getInstance().sendNpcActivate(npcId, team, activatorId);
           std::cout << "[DEBUG] Host forwarding NPC activation to all clients" << std::endl;
         }
@@ -2209,8 +2590,8 @@ void Game::setupNetworkCallbacks()
 
   net.setOnNpcUpdate([this](const NpcState &state)
                      {
-    // 更新NPC状态（仅非房主接收）- 直接设置位置，不使用插值
-    if (!m_mpState.isHost && state.id >= 0 && state.id < static_cast<int>(m_enemies.size())) {
+    // 更新NPC状态（仅非房主接收）- 位置进入插值缓冲
+    if (!m_mpState.ownsWorldSimulation() && state.id >= 0 && state.id < static_cast<int>(m_enemies.size())) {
       auto& npc = m_enemies[state.id];
       
       // 如果 NPC 在本地已经死亡，不要让远程数据覆盖
@@ -2218,10 +2599,12 @@ void Game::setupNetworkCallbacks()
         return;
       }
       
-      // 直接设置NPC位置、旋转、炮塔角度
-      npc->setPosition({state.x, state.y});
-      npc->setRotation(state.rotation);
-      npc->setTurretRotation(state.turretAngle);
+      // NPC位置、旋转、炮塔角度进入插值缓冲
+      if (state.id >= static_cast<int>(m_mpState.npcSnapshots.size())) {
+        m_mpState.npcSnapshots.resize(m_enemies.size());
+      }
+      m_mpState.npcSnapshots[state.id].push(state.timestamp, NetworkManager::getInstance().getNetworkTime(),
+                                            {state.x, state.y}, state.rotation, state.turretAngle);
       
       // 更新血量（只有当远程血量更低时才更新）
       if (state.health < npc->getHealth()) {
@@ -2237,7 +2620,7 @@ void Game::setupNetworkCallbacks()
   net.setOnNpcShoot([this](int npcId, float x, float y, float angle)
                     {
     // NPC射击（创建子弹）- 非房主接收
-    if (!m_mpState.isHost) {
+    if (!m_mpState.ownsWorldSimulation()) {
       int npcTeam = 0;
       if (npcId >= 0 && npcId < static_cast<int>(m_enemies.size())) {
         npcTeam = m_enemies[npcId]->getTeam();
@@ -2275,7 +2658,7 @@ void Game::setupNetworkCallbacks()
         
         // 房主收到非房主的伤害消息后，需要再同步给非房主
         // 因为服务器只转发给"其他玩家"，非房主收不到自己发的消息
-        if (m_mpState.isHost) {
+        if (m_mpState.ownsWorldSimulation()) {
           NetworkManager::getInstance().sendNpcDamage(npcId, damage);
         }
         
@@ -2293,50 +2676,28 @@ void Game::setupNetworkCallbacks()
 
   net.setOnWallDamage([this](int row, int col, float damage, bool destroyed, int attribute, int destroyerId)
                       {
-    // 非房主接收墙壁伤害同步
-    if (!m_mpState.isHost) {
+    // 非房主接收墙壁伤害同步（旧版本逐条发送）
+    if (!m_mpState.ownsWorldSimulation()) {
       WallDestroyResult result = m_maze.applyWallDamage(row, col, damage, destroyed);
-      
-      // 如果墙被摧毁，检查是否是本地玩家（非房主）的子弹造成的
-      // destroyerId: 0=房主, 1=非房主（本地玩家）
-      if (destroyed && result.destroyed && m_player) {
-        sf::Vector2f listenerPos = m_player->getPosition();
-        WallAttribute attr = static_cast<WallAttribute>(attribute);
-        
-        // 如果是非房主（本地玩家）打掉的墙，给本地玩家加增益
-        if (destroyerId == 1) {
-          switch (attr) {
-            case WallAttribute::Gold:
-              m_player->addCoins(2);  // 金色墙：获得2金币
-              AudioManager::getInstance().playSFX(SFXType::CollectCoins, result.position, listenerPos);
-              break;
-            case WallAttribute::Heal:
-              m_player->heal(0.25f);  // 治疗墙：恢复25%血量
-              AudioManager::getInstance().playSFX(SFXType::Bingo, result.position, listenerPos);
-              break;
-            case WallAttribute::None:
-              m_player->addWallToBag();  // 棕色墙：收集到背包
-              AudioManager::getInstance().playSFX(SFXType::WallBroken, result.position, listenerPos);
-              break;
-            default:
-              break;
-          }
-        } else {
-          // 房主打掉的墙，只播放音效，不给本地玩家加增益
-          switch (attr) {
-            case WallAttribute::Gold:
-              AudioManager::getInstance().playSFX(SFXType::CollectCoins, result.position, listenerPos);
-              break;
-            case WallAttribute::Heal:
-              AudioManager::getInstance().playSFX(SFXType::Bingo, result.position, listenerPos);
-              break;
-            case WallAttribute::None:
-              AudioManager::getInstance().playSFX(SFXType::WallBroken, result.position, listenerPos);
-              break;
-            default:
-              break;
-          }
-        }
+      if (destroyed && result.destroyed) {
+        onRemoteWallDestroyed(result, static_cast<WallAttribute>(attribute), destroyerId);
+      }
+    } });
+
+  net.setOnWallBatch([this](const std::vector<WallBatchEntry> &entries)
+                     {
+    // 对方一帧内的墙体变化：放置总是应用，伤害只由非房主应用（房主自己负责墙体伤害）
+    bool applyDamage = !m_mpState.ownsWorldSimulation();
+    std::vector<WallChange> changes;
+    changes.reserve(entries.size());
+    for (const auto& entry : entries) {
+      changes.push_back({entry.row, entry.col, entry.placed, applyDamage && entry.destroyed, applyDamage ? entry.damage : 0.f});
+    }
+    
+    std::vector<WallDestroyResult> results = m_maze.applyWallChanges(changes);
+    for (std::size_t i = 0; i < results.size(); ++i) {
+      if (results[i].destroyed && entries[i].destroyed) {
+        onRemoteWallDestroyed(results[i], static_cast<WallAttribute>(entries[i].attribute), entries[i].destroyer);
       }
     } });
 
@@ -2370,6 +2731,13 @@ void Game::setupNetworkCallbacks()
     m_mpState.beingRescued = false;
     m_mpState.rescueProgress = 0.f; });
 
+  // 帧同步：对方的输入与状态哈希交给会话
+  net.setOnLockstepInput([this](uint32_t tick, const LockstepInput &input)
+                         { m_mpState.lockstepSession.receiveRemoteInput(tick, input); });
+
+  net.setOnStateHash([this](uint32_t tick, uint64_t hash)
+                     { m_mpState.lockstepSession.receiveRemoteHash(tick, hash); });
+
   net.setOnPlayerReady([this](bool isReady)
                        {
     // 收到对方准备状态
@@ -2395,6 +2763,73 @@ void Game::setupNetworkCallbacks()
 
   net.setOnError([this](const std::string &error)
                  { m_mpState.connectionStatus = "Error: " + error; });
+
+  // 断线重连（见 SessionResume.hpp）
+  net.setResumePlayerProvider([this]()
+                              {
+    auto ctx = getMultiplayerContext();
+    return MultiplayerHandler::captureLocalPlayer(ctx, m_mpState); });
+
+  net.setOnReconnecting([this]()
+                        {
+    m_mpState.reconnecting = true;
+    std::cout << "[DEBUG] Connection lost, reconnecting to room " << m_mpState.roomCode << std::endl; });
+
+  net.setOnPeerDropped([this](float graceSeconds)
+                       {
+    m_mpState.peerDropped = true;
+    m_mpState.peerDropTimer = graceSeconds; });
+
+  net.setOnResumeRequest([this](const ResumePlayer &player)
+                         {
+    // 对方重连：应用它上报的状态，再把当前对局发给它
+    if (m_gameState != GameState::Multiplayer || !m_player)
+      return;
+    auto ctx = getMultiplayerContext();
+    MultiplayerHandler::applyRemoteResumePlayer(ctx, m_mpState, player);
+    NetworkManager::getInstance().sendResumeSnapshot(MultiplayerHandler::captureResumeSnapshot(ctx, m_mpState));
+    std::cout << "[DEBUG] Other player resumed, sent snapshot" << std::endl; });
+
+  net.setOnResumeSnapshot([this](const ResumeSnapshot &snapshot)
+                          {
+    if (m_gameState != GameState::Multiplayer || !m_player) {
+      NetworkManager::getInstance().disconnect();
+      return;
+    }
+    
+    // 地图不一致时按快照重建（种子或整图），都不可用则放弃
+    if (MazeCodec::hash(m_maze.getMazeData()) != snapshot.mazeHash) {
+      std::vector<std::string> mazeData = snapshot.mazeData;
+      if (mazeData.empty() && snapshot.seed.version == MazeGenerator::ALGORITHM_VERSION && snapshot.seed.seed != 0) {
+        MazeGenerator generator(snapshot.seed.width, snapshot.seed.height);
+        generator.setSeed(snapshot.seed.seed);
+        generator.setEnemyCount(snapshot.seed.enemyCount);
+        generator.setMultiplayerMode(true);
+        generator.setEscapeMode((snapshot.modeFlags & 1) != 0);
+        mazeData = generator.generate();
+      }
+      if (mazeData.empty() || MazeCodec::hash(mazeData) != snapshot.mazeHash) {
+        std::cerr << "[DEBUG] Resume snapshot maze does not match, giving up" << std::endl;
+        NetworkManager::getInstance().disconnect();
+        return;
+      }
+      m_maze.loadFromString(mazeData);
+      m_mpState.generatedMazeData = mazeData;
+      m_enemies.clear();
+    }
+    
+    if (m_enemies.size() != snapshot.npcs.size()) {
+      spawnEnemies();
+      int npcId = 0;
+      for (auto& enemy : m_enemies) {
+        enemy->setId(npcId++);
+      }
+    }
+    
+    auto ctx = getMultiplayerContext();
+    MultiplayerHandler::applyResumeSnapshot(ctx, m_mpState, snapshot);
+    std::cout << "[DEBUG] Session resumed: " << snapshot.walls.size() << " wall changes, " << snapshot.npcs.size()
+              << " NPCs" << std::endl; });
 }
 
 void Game::processConnectingEvents(const sf::Event &event)
@@ -2474,6 +2909,37 @@ void Game::processConnectingEvents(const sf::Event &event)
   }
 }
 
+void Game::onRemoteWallDestroyed(const WallDestroyResult &result, WallAttribute attr, int destroyerId)
+{
+  if (!m_player)
+    return;
+
+  // 如果是非房主（本地玩家）打掉的墙，给本地玩家加增益；房主打掉的墙只播放音效
+  // destroyerId: 0=房主, 1=非房主（本地玩家）
+  sf::Vector2f listenerPos = m_player->getPosition();
+  bool rewardLocal = destroyerId == 1;
+  switch (attr)
+  {
+  case WallAttribute::Gold:
+    if (rewardLocal)
+      m_player->addCoins(2); // 金色墙：获得2金币
+    AudioManager::getInstance().playSFX(SFXType::CollectCoins, result.position, listenerPos);
+    break;
+  case WallAttribute::Heal:
+    if (rewardLocal)
+      m_player->heal(0.25f); // 治疗墙：恢复25%血量
+    AudioManager::getInstance().playSFX(SFXType::Bingo, result.position, listenerPos);
+    break;
+  case WallAttribute::None:
+    if (rewardLocal)
+      m_player->addWallToBag(); // 棕色墙：收集到背包
+    AudioManager::getInstance().playSFX(SFXType::WallBroken, result.position, listenerPos);
+    break;
+  default:
+    break;
+  }
+}
+
 MultiplayerContext Game::getMultiplayerContext()
 {
   return MultiplayerContext{
@@ -2484,6 +2950,7 @@ MultiplayerContext Game::getMultiplayerContext()
       m_player.get(),
       m_otherPlayer.get(),
       m_enemies,
+      m_entities,
       m_bullets,
       m_maze,
       LOGICAL_WIDTH,  // 使用逻辑分辨率
@@ -2502,6 +2969,9 @@ void Game::updateMultiplayer(float dt)
   MultiplayerHandler::update(ctx, m_mpState, dt, [this]()
                              { m_gameState = GameState::Victory; }, [this]()
                              { m_gameState = GameState::GameOver; });
+
+  // 本帧的墙体变化合并为一条消息
+  NetworkManager::getInstance().flushWallBatch();
 }
 
 void Game::renderConnecting()
@@ -2559,15 +3029,13 @@ void Game::processRoomLobbyEvents(const sf::Event &event)
         m_mpState.isEscapeMode = (m_gameModeOption == GameModeOption::EscapeMode);
         int npcCount = m_mpState.npcCount;
 
-        // 设置迷宫生成器模式
-        m_mazeGenerator.setEscapeMode(m_mpState.isEscapeMode);
-
-        // 生成新地图
-        m_maze.generateRandomMaze(m_mpState.mazeWidth, m_mpState.mazeHeight, 0, npcCount, true, m_mpState.isEscapeMode);
+        // 生成新地图（优先使用大厅期间后台预生成的）
+        loadMaze({m_mpState.mazeWidth, m_mpState.mazeHeight, npcCount, true, m_mpState.isEscapeMode});
         m_mpState.generatedMazeData = m_maze.getMazeData();
 
         // 发送新地图给服务器和对方玩家
-        NetworkManager::getInstance().sendMazeData(m_mpState.generatedMazeData, m_mpState.isEscapeMode, m_mpState.isDarkMode);
+        NetworkManager::getInstance().sendMazeData(m_mpState.generatedMazeData, m_mpState.isEscapeMode, m_mpState.isDarkMode,
+                                                   m_mpState.generatedMazeSeed);
 
         std::cout << "[DEBUG] Host generated new maze before game start: "
                   << m_mpState.mazeWidth << "x" << m_mpState.mazeHeight
@@ -2586,205 +3054,136 @@ void Game::renderRoomLobby()
 {
   m_window.clear(sf::Color(30, 30, 30));
   m_window.setView(m_uiView);
+  m_lobbyUI.begin();
 
   float centerX = LOGICAL_WIDTH / 2.f;
   float startY = 80.f;
 
   // 标题
-  sf::Text title(m_font);
-  title.setString("ROOM LOBBY");
-  title.setCharacterSize(56);
-  title.setFillColor(sf::Color::White);
-  title.setStyle(sf::Text::Bold);
-  sf::FloatRect titleBounds = title.getLocalBounds();
-  title.setPosition({centerX - titleBounds.size.x / 2.f, startY});
-  m_window.draw(title);
+  m_lobbyUI.text("title", "ROOM LOBBY", 56, sf::Color::White, {centerX, startY}, UIAlign::Center, true);
 
   // 房间信息框
   float boxY = startY + 100.f;
   float boxWidth = 700.f;
   float boxHeight = 500.f;
   float boxX = centerX - boxWidth / 2.f;
-
-  sf::RectangleShape infoBox({boxWidth, boxHeight});
-  infoBox.setPosition({boxX, boxY});
-  infoBox.setFillColor(sf::Color(50, 50, 50, 200));
-  infoBox.setOutlineColor(sf::Color::White);
-  infoBox.setOutlineThickness(2.f);
-  m_window.draw(infoBox);
+  m_lobbyUI.panel("infoBox", {boxX, boxY}, {boxWidth, boxHeight}, sf::Color(50, 50, 50, 200), 0.f, sf::Color::White,
+                  2.f);
 
   float textX = boxX + 30.f;
   float textY = boxY + 20.f;
   float lineHeight = 45.f;
 
   // 房间号
-  sf::Text roomCodeText(m_font);
-  roomCodeText.setString("Room Code: " + m_mpState.roomCode);
-  roomCodeText.setCharacterSize(32);
-  roomCodeText.setFillColor(sf::Color::Yellow);
-  roomCodeText.setPosition({textX, textY});
-  m_window.draw(roomCodeText);
+  m_lobbyUI.text("roomCode", "Room Code: " + m_mpState.roomCode, 32, sf::Color::Yellow, {textX, textY});
   textY += lineHeight;
 
   // 分隔线
-  sf::RectangleShape separator({boxWidth - 60.f, 2.f});
-  separator.setPosition({textX, textY});
-  separator.setFillColor(sf::Color(100, 100, 100));
-  m_window.draw(separator);
+  const sf::Vector2f separatorSize = {boxWidth - 60.f, 2.f};
+  m_lobbyUI.panel("separator1", {textX, textY}, separatorSize, sf::Color(100, 100, 100));
   textY += 20.f;
 
   // 游戏模式
-  sf::Text modeText(m_font);
-  modeText.setString(std::string("Game Mode: ") + (m_mpState.isEscapeMode ? "Escape (Co-op)" : "Battle (PvP)"));
-  modeText.setCharacterSize(28);
-  modeText.setFillColor(m_mpState.isEscapeMode ? sf::Color::Green : sf::Color::Red);
-  modeText.setPosition({textX, textY});
-  m_window.draw(modeText);
+  m_lobbyUI.text("mode", std::string("Game Mode: ") + (m_mpState.isEscapeMode ? "Escape (Co-op)" : "Battle (PvP)"), 28,
+                 m_mpState.isEscapeMode ? sf::Color::Green : sf::Color::Red, {textX, textY});
   textY += lineHeight;
 
   // 暗黑模式
-  sf::Text darkModeText(m_font);
-  darkModeText.setString(std::string("Dark Mode: ") + (m_mpState.isDarkMode ? "ON" : "OFF"));
-  darkModeText.setCharacterSize(28);
-  darkModeText.setFillColor(m_mpState.isDarkMode ? sf::Color(200, 100, 255) : sf::Color(150, 150, 150));
-  darkModeText.setPosition({textX, textY});
-  m_window.draw(darkModeText);
+  m_lobbyUI.text("darkMode", std::string("Dark Mode: ") + (m_mpState.isDarkMode ? "ON" : "OFF"), 28,
+                 m_mpState.isDarkMode ? sf::Color(200, 100, 255) : sf::Color(150, 150, 150), {textX, textY});
   textY += lineHeight;
 
   // 迷宫尺寸
-  sf::Text mazeText(m_font);
-  mazeText.setString("Maze Size: " + std::to_string(m_mpState.mazeWidth) + " x " + std::to_string(m_mpState.mazeHeight));
-  mazeText.setCharacterSize(28);
-  mazeText.setFillColor(sf::Color::White);
-  mazeText.setPosition({textX, textY});
-  m_window.draw(mazeText);
+  m_lobbyUI.text("mazeSize",
+                 "Maze Size: " + std::to_string(m_mpState.mazeWidth) + " x " + std::to_string(m_mpState.mazeHeight),
+                 28, sf::Color::White, {textX, textY});
   textY += lineHeight;
 
   // NPC数量
-  sf::Text npcText(m_font);
-  npcText.setString("NPCs: " + std::to_string(m_mpState.npcCount));
-  npcText.setCharacterSize(28);
-  npcText.setFillColor(sf::Color::White);
-  npcText.setPosition({textX, textY});
-  m_window.draw(npcText);
+  m_lobbyUI.text("npcs", "NPCs: " + std::to_string(m_mpState.npcCount), 28, sf::Color::White, {textX, textY});
   textY += lineHeight + 10.f;
 
   // 分隔线
-  separator.setPosition({textX, textY});
-  m_window.draw(separator);
+  m_lobbyUI.panel("separator2", {textX, textY}, separatorSize, sf::Color(100, 100, 100));
   textY += 20.f;
 
   // 玩家列表标题
-  sf::Text playersTitle(m_font);
-  playersTitle.setString("Players:");
-  playersTitle.setCharacterSize(28);
-  playersTitle.setFillColor(sf::Color::Cyan);
-  playersTitle.setPosition({textX, textY});
-  m_window.draw(playersTitle);
+  m_lobbyUI.text("playersTitle", "Players:", 28, sf::Color::Cyan, {textX, textY});
   textY += lineHeight;
 
   // 玩家1（房主或本地）
-  sf::Text player1Text(m_font);
   std::string p1Status = m_mpState.isHost ? "[HOST] You" : ("[HOST] " + (m_mpState.otherPlayerIP.empty() ? "Unknown" : m_mpState.otherPlayerIP));
   if (m_mpState.isHost)
   {
     p1Status += " - " + m_mpState.localPlayerIP;
   }
-  player1Text.setString(p1Status);
-  player1Text.setCharacterSize(26);
-  player1Text.setFillColor(m_mpState.isHost ? sf::Color::Yellow : sf::Color::White);
-  player1Text.setPosition({textX + 20.f, textY});
-  m_window.draw(player1Text);
+  m_lobbyUI.text("player1", p1Status, 26, m_mpState.isHost ? sf::Color::Yellow : sf::Color::White,
+                 {textX + 20.f, textY});
 
   // 准备状态（房主默认准备）- 右对齐
   float readyRightEdge = boxX + boxWidth - 30.f; // 准备状态右边界
-  sf::Text p1Ready(m_font);
-  p1Ready.setString("READY");
-  p1Ready.setCharacterSize(24);
-  p1Ready.setFillColor(sf::Color::Green);
-  sf::FloatRect p1ReadyBounds = p1Ready.getLocalBounds();
-  p1Ready.setPosition({readyRightEdge - p1ReadyBounds.size.x, textY});
-  m_window.draw(p1Ready);
+  m_lobbyUI.text("player1Ready", "READY", 24, sf::Color::Green, {readyRightEdge, textY}, UIAlign::Right);
   textY += lineHeight;
 
   // 玩家2
-  sf::Text player2Text(m_font);
   if (m_mpState.otherPlayerInRoom)
   {
     std::string p2Status = m_mpState.isHost ? ("Player 2: " + m_mpState.otherPlayerIP) : ("[YOU] " + m_mpState.localPlayerIP);
-    player2Text.setString(p2Status);
-    player2Text.setFillColor(m_mpState.isHost ? sf::Color::White : sf::Color::Yellow);
+    m_lobbyUI.text("player2", p2Status, 26, m_mpState.isHost ? sf::Color::White : sf::Color::Yellow,
+                   {textX + 20.f, textY});
+
+    // 玩家2准备状态 - 右对齐
+    bool isP2Ready = m_mpState.isHost ? m_mpState.otherPlayerReady : m_mpState.localPlayerReady;
+    m_lobbyUI.text("player2Ready", isP2Ready ? "READY" : "NOT READY", 24, isP2Ready ? sf::Color::Green : sf::Color::Red,
+                   {readyRightEdge, textY}, UIAlign::Right);
   }
   else
   {
-    player2Text.setString("Waiting for player to join...");
-    player2Text.setFillColor(sf::Color(150, 150, 150));
-  }
-  player2Text.setCharacterSize(26);
-  player2Text.setPosition({textX + 20.f, textY});
-  m_window.draw(player2Text);
-
-  // 玩家2准备状态 - 右对齐
-  if (m_mpState.otherPlayerInRoom)
-  {
-    sf::Text p2Ready(m_font);
-    bool isP2Ready = m_mpState.isHost ? m_mpState.otherPlayerReady : m_mpState.localPlayerReady;
-    p2Ready.setString(isP2Ready ? "READY" : "NOT READY");
-    p2Ready.setCharacterSize(24);
-    p2Ready.setFillColor(isP2Ready ? sf::Color::Green : sf::Color::Red);
-    sf::FloatRect p2ReadyBounds = p2Ready.getLocalBounds();
-    p2Ready.setPosition({readyRightEdge - p2ReadyBounds.size.x, textY});
-    m_window.draw(p2Ready);
+    m_lobbyUI.text("player2", "Waiting for player to join...", 26, sf::Color(150, 150, 150), {textX + 20.f, textY});
   }
   textY += lineHeight + 30.f;
 
   // 操作提示
-  sf::Text hintText(m_font);
+  std::string hint;
+  sf::Color hintColor;
   if (m_mpState.isHost)
   {
     if (m_mpState.otherPlayerInRoom && m_mpState.otherPlayerReady)
     {
-      hintText.setString("Press ENTER to start game");
-      hintText.setFillColor(sf::Color::Green);
+      hint = "Press ENTER to start game";
+      hintColor = sf::Color::Green;
     }
     else if (m_mpState.otherPlayerInRoom)
     {
-      hintText.setString("Waiting for player to ready...");
-      hintText.setFillColor(sf::Color::Yellow);
+      hint = "Waiting for player to ready...";
+      hintColor = sf::Color::Yellow;
     }
     else
     {
-      hintText.setString("Waiting for player to join...");
-      hintText.setFillColor(sf::Color(150, 150, 150));
+      hint = "Waiting for player to join...";
+      hintColor = sf::Color(150, 150, 150);
     }
   }
   else
   {
     if (m_mpState.localPlayerReady)
     {
-      hintText.setString("Waiting for host to start... (Press R to cancel ready)");
-      hintText.setFillColor(sf::Color::Yellow);
+      hint = "Waiting for host to start... (Press R to cancel ready)";
+      hintColor = sf::Color::Yellow;
     }
     else
     {
-      hintText.setString("Press R to ready up");
-      hintText.setFillColor(sf::Color::Cyan);
+      hint = "Press R to ready up";
+      hintColor = sf::Color::Cyan;
     }
   }
-  hintText.setCharacterSize(28);
-  sf::FloatRect hintBounds = hintText.getLocalBounds();
-  hintText.setPosition({centerX - hintBounds.size.x / 2.f, textY});
-  m_window.draw(hintText);
+  m_lobbyUI.text("hint", hint, 28, hintColor, {centerX, textY}, UIAlign::Center);
 
   // ESC退出提示
-  sf::Text escText(m_font);
-  escText.setString("Press ESC to leave room");
-  escText.setCharacterSize(22);
-  escText.setFillColor(sf::Color(150, 150, 150));
-  sf::FloatRect escBounds = escText.getLocalBounds();
-  escText.setPosition({centerX - escBounds.size.x / 2.f, boxY + boxHeight + 20.f});
-  m_window.draw(escText);
+  m_lobbyUI.text("esc", "Press ESC to leave room", 22, sf::Color(150, 150, 150), {centerX, boxY + boxHeight + 20.f},
+                 UIAlign::Center);
 
+  m_lobbyUI.draw(m_window);
   m_window.display();
 }
 
@@ -3111,13 +3510,12 @@ void Game::renderMinimap()
   const float minimapX = minimapMargin;
   const float minimapY = static_cast<float>(LOGICAL_HEIGHT) - minimapSize - minimapMargin - 35.f;
 
-  // 绘制小地图背景
-  sf::RectangleShape minimapBg({minimapSize, minimapSize});
-  minimapBg.setPosition({minimapX, minimapY});
-  minimapBg.setFillColor(sf::Color(20, 20, 20, 200));
-  minimapBg.setOutlineColor(sf::Color(100, 100, 100, 255));
-  minimapBg.setOutlineThickness(2.f);
-  m_window.draw(minimapBg);
+  // 小地图背景和标签（保留模式，画在标记点下面）
+  m_minimapUI.begin();
+  m_minimapUI.panel("background", {minimapX, minimapY}, {minimapSize, minimapSize}, sf::Color(20, 20, 20, 200), 0.f,
+                    sf::Color(100, 100, 100, 255), 2.f);
+  m_minimapUI.text("label", "Minimap", 12, sf::Color(180, 180, 180), {minimapX + 5.f, minimapY + 3.f});
+  m_minimapUI.draw(m_window);
 
   // 计算地图范围（基于迷宫大小）
   sf::Vector2f mazeSize = m_maze.getSize();
@@ -3137,20 +3535,19 @@ void Game::renderMinimap()
         offsetY + worldPos.y * scale);
   };
 
-  // 绘制NPC
-  for (const auto &enemy : m_enemies)
+  // 绘制NPC（线性扫描实体存储）
+  for (EntityId id = 0; id < m_entities.capacity(); id++)
   {
-    if (enemy->isDead())
+    if (!m_entities.isAliveNpc(id))
       continue;
 
-    sf::Vector2f npcPos = enemy->getPosition();
-    sf::Vector2f npcMiniPos = worldToMinimap(npcPos);
+    sf::Vector2f npcMiniPos = worldToMinimap({m_entities.x[id], m_entities.y[id]});
 
     sf::CircleShape npcDot(3.f);
     npcDot.setPosition({npcMiniPos.x - 3.f, npcMiniPos.y - 3.f});
 
     // 根据激活状态显示不同颜色
-    if (enemy->isActivated())
+    if (m_entities.isActiveNpc(id))
     {
       npcDot.setFillColor(GameColors::MinimapEnemyNpc); // 已激活：红色
     }
@@ -3161,6 +3558,23 @@ void Game::renderMinimap()
     m_window.draw(npcDot);
   }
 
+  // 无尽模式：出口通常在窗口外，夹到小地图边缘指示方向
+  if (m_chunkStreamer)
+  {
+    sf::Vector2f center(minimapX + minimapSize / 2.f, minimapY + minimapSize / 2.f);
+    sf::Vector2f exitMiniPos = worldToMinimap(m_maze.getExitPosition());
+    sf::Vector2f toExit = exitMiniPos - center;
+    float reach = minimapSize / 2.f - 6.f;
+    float extent = std::max(std::abs(toExit.x), std::abs(toExit.y));
+    if (extent > reach)
+      exitMiniPos = center + toExit * (reach / extent);
+
+    sf::CircleShape exitDot(4.f);
+    exitDot.setPosition({exitMiniPos.x - 4.f, exitMiniPos.y - 4.f});
+    exitDot.setFillColor(GameColors::MinimapExit);
+    m_window.draw(exitDot);
+  }
+
   // 绘制玩家（黄色，最后绘制以确保在最上层）
   if (m_player)
   {
@@ -3173,14 +3587,6 @@ void Game::renderMinimap()
     m_window.draw(playerDot);
   }
 
-  // 小地图标签
-  sf::Text minimapLabel(m_font);
-  minimapLabel.setString("Minimap");
-  minimapLabel.setCharacterSize(12);
-  minimapLabel.setFillColor(sf::Color(180, 180, 180));
-  minimapLabel.setPosition({minimapX + 5.f, minimapY + 3.f});
-  m_window.draw(minimapLabel);
-
   // 恢复之前的视图
   m_window.setView(currentView);
 }
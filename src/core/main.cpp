@@ -1,8 +1,55 @@
 #include "Game.hpp"
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
 
-int main()
+namespace
 {
+  // 整个参数必须是正的有限数，否则按用法错误处理
+  bool parseSpeed(const char *text, float &speed)
+  {
+    char *end = nullptr;
+    float value = std::strtof(text, &end);
+    if (end == text || *end != '\0' || !std::isfinite(value) || value <= 0.f)
+      return false;
+    speed = value;
+    return true;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  ReplayOptions replay;
+  for (int i = 1; i < argc; i++)
+  {
+    std::string arg = argv[i];
+    if (arg == "--record" && i + 1 < argc)
+      replay.recordPath = argv[++i];
+    else if (arg == "--replay" && i + 1 < argc)
+      replay.replayPath = argv[++i];
+    else if (arg == "--speed" && i + 1 < argc && parseSpeed(argv[i + 1], replay.speed))
+      i++;
+    else if (arg == "--headless")
+      replay.headless = true;
+    else
+    {
+      std::cout << "Usage: \"Tank Maze Game\" [--record file.tkrp] [--replay file.tkrp [--speed x] [--headless]]"
+                << std::endl;
+      return arg == "--help" ? 0 : 1;
+    }
+  }
+  if (replay.headless && replay.replayPath.empty())
+  {
+    std::cout << "--headless requires --replay" << std::endl;
+    return 1;
+  }
+
   Game game;
+  if (!game.setReplayOptions(replay))
+  {
+    return 1;
+  }
 
   if (!game.init())
   {
@@ -11,4 +58,4 @@ int main()
 
   game.run();
   return 0;
-}
\ No newline at end of file
+}
@@ -64,6 +64,13 @@ sf::Vector2f Bullet::getPosition() const
   return m_position;
 }
 
+void Bullet::shiftOrigin(sf::Vector2f offset)
+{
+  m_position += offset;
+  if (m_sprite)
+    m_sprite->move(offset);
+}
+
 void Bullet::checkBounds(float width, float height)
 {
   sf::Vector2f pos = m_position;
@@ -1,41 +1,58 @@
 #include "Enemy.hpp"
 #include "Maze.hpp"
+#include "CrowdSteering.hpp"
 #include "Utils.hpp"
 #include <cstdlib>
 #include <cmath>
 #include <algorithm>
 
-Enemy::Enemy()
-    : m_healthBar(50.f, 6.f)
+Enemy::Enemy(EntityStore &store)
+    : m_store(&store), m_entity(store.create(EntityKind::Npc)), m_healthBar(50.f, 6.f)
 {
-  m_healthBar.setMaxHealth(100.f);
-  m_healthBar.setHealth(100.f);
+  m_store->radius[m_entity] = 18.f;
+  m_healthBar.setMaxHealth(m_store->maxHealth[m_entity]);
+  m_healthBar.setHealth(m_store->health[m_entity]);
 
   // 随机初始移动方向
   float angle = static_cast<float>(rand() % 360) * Utils::PI / 180.f;
   m_moveDirection = {std::cos(angle), std::sin(angle)};
 }
 
-bool Enemy::loadTextures(const std::string &hullPath, const std::string &turretPath)
+Enemy::~Enemy()
 {
-  if (!m_hullTexture.loadFromFile(hullPath))
-    return false;
-  if (!m_turretTexture.loadFromFile(turretPath))
-    return false;
+  m_store->destroy(m_entity);
+}
 
+void Enemy::createSprites()
+{
   m_hull = std::make_unique<sf::Sprite>(m_hullTexture);
   m_hull->setOrigin(sf::Vector2f(m_hullTexture.getSize()) / 2.f);
   m_hull->setScale({m_scale, m_scale});
 
   m_turret = std::make_unique<sf::Sprite>(m_turretTexture);
   // 炮塔旋转中心在底部中心（炮塔底座位置）
-  auto turretSize1 = sf::Vector2f(m_turretTexture.getSize());
-  m_turret->setOrigin({turretSize1.x / 2.f, turretSize1.y * 0.75f});
+  auto turretSize = sf::Vector2f(m_turretTexture.getSize());
+  m_turret->setOrigin({turretSize.x / 2.f, turretSize.y * 0.75f});
   m_turret->setScale({m_scale, m_scale});
+}
 
+bool Enemy::loadTextures(const std::string &hullPath, const std::string &turretPath)
+{
+  if (!m_hullTexture.loadFromFile(hullPath))
+    return false;
+  if (!m_turretTexture.loadFromFile(turretPath))
+    return false;
+
+  createSprites();
   return true;
 }
 
+void Enemy::initHeadless()
+{
+  // 模拟状态都在实体存储里，无贴图模式不需要精灵
+  m_headless = true;
+}
+
 bool Enemy::loadActivatedTextures()
 {
   // 加载激活状态的贴图（Color_C）
@@ -45,58 +62,47 @@ bool Enemy::loadActivatedTextures()
   if (!m_turretTexture.loadFromFile(resPath + "tank_assets/PNG/Weapon_Color_C/Gun_01.png"))
     return false;
 
-  // 保存当前位置和旋转
-  sf::Vector2f pos = m_hull ? m_hull->getPosition() : sf::Vector2f{0.f, 0.f};
-  float hullRot = m_hull ? m_hull->getRotation().asDegrees() : 0.f;
-  float turretRot = m_turret ? m_turret->getRotation().asDegrees() : 0.f;
-
-  // 重新创建精灵
-  m_hull = std::make_unique<sf::Sprite>(m_hullTexture);
-  m_hull->setOrigin(sf::Vector2f(m_hullTexture.getSize()) / 2.f);
-  m_hull->setScale({m_scale, m_scale});
-  m_hull->setPosition(pos);
-  m_hull->setRotation(sf::degrees(hullRot));
-
-  m_turret = std::make_unique<sf::Sprite>(m_turretTexture);
-  // 炮塔旋转中心在底部中心（炮塔底座位置）
-  auto turretSize2 = sf::Vector2f(m_turretTexture.getSize());
-  m_turret->setOrigin({turretSize2.x / 2.f, turretSize2.y * 0.75f});
-  m_turret->setScale({m_scale, m_scale});
-  m_turret->setPosition(pos);
-  m_turret->setRotation(sf::degrees(turretRot));
-
+  // 重新创建精灵（位置与角度在绘制时从实体存储同步）
+  createSprites();
   return true;
 }
 
 void Enemy::activate(int team, int activatorId)
 {
-  if (!m_activated)
+  if (!isActivated())
   {
-    m_activated = true;
-    m_team = team;
+    m_store->flags[m_entity] |= ENTITY_ACTIVATED;
+    m_store->team[m_entity] = static_cast<int8_t>(team);
     m_activatorId = activatorId; // 记录激活者 (-1=自动激活, 0=本地玩家, 1=另一玩家)
     m_primaryTargetDowned = false;
     // 切换到激活状态贴图
-    loadActivatedTextures();
+    if (!m_headless)
+      loadActivatedTextures();
   }
 }
 
 void Enemy::setPosition(sf::Vector2f position)
 {
-  if (m_hull)
-  {
-    m_hull->setPosition(position);
-  }
-  // 同步更新炮塔位置
-  if (m_turret)
-  {
-    m_turret->setPosition(position);
-  }
-  // 同步更新血条位置
-  sf::Vector2f healthBarPos = position;
-  healthBarPos.x -= 25.f;
-  healthBarPos.y -= 45.f;
-  m_healthBar.setPosition(healthBarPos);
+  m_store->x[m_entity] = position.x;
+  m_store->y[m_entity] = position.y;
+}
+
+void Enemy::shiftOrigin(sf::Vector2f offset)
+{
+  setPosition(getPosition() + offset);
+  for (auto &point : m_path)
+    point += offset;
+  for (auto &target : m_targets)
+    target += offset;
+  m_targetPos += offset;
+  m_destructibleWallTarget += offset;
+  m_shootTarget += offset;
+  m_aimTarget += offset;
+}
+
+void Enemy::setHealth(float health)
+{
+  m_store->health[m_entity] = std::clamp(health, 0.f, m_store->maxHealth[m_entity]);
 }
 
 void Enemy::setTarget(sf::Vector2f targetPos)
@@ -104,82 +110,24 @@ void Enemy::setTarget(sf::Vector2f targetPos)
   m_targetPos = targetPos;
 }
 
-void Enemy::update(float dt, const Maze &maze)
+void Enemy::update(float dt, const Maze &maze, bool think, const CrowdSteering *crowd)
 {
-  if (!m_hull || !m_turret)
-    return;
+  EntityStore &store = *m_store;
+  const EntityId id = m_entity;
+  store.shootTimer[id] += dt;
+  store.pathTimer[id] += dt;
 
   // 如果未激活，只是待机（不移动不攻击）
-  if (!m_activated)
-  {
-    // 炮塔跟随车身位置
-    m_turret->setPosition(m_hull->getPosition());
-    // 更新血条位置
-    sf::Vector2f healthBarPos = m_hull->getPosition();
-    healthBarPos.x -= 25.f;
-    healthBarPos.y -= 45.f;
-    m_healthBar.setPosition(healthBarPos);
+  if (!isActivated())
     return;
-  }
 
   // 保存旧位置
-  sf::Vector2f oldPos = m_hull->getPosition();
+  sf::Vector2f oldPos = getPosition();
 
-  // 定期更新路径（使用智能路径，考虑可破坏墙）
-  if (m_pathUpdateClock.getElapsedTime().asSeconds() > m_pathUpdateInterval || m_path.empty())
+  // 定期更新路径（使用智能路径，考虑可破坏墙）；不思考的帧沿用旧路径
+  if (think && (store.pathTimer[id] > m_pathUpdateInterval || m_path.empty()))
   {
-    // 首先尝试普通路径
-    auto normalPath = maze.findPath(oldPos, m_targetPos);
-
-    // 然后尝试穿过可破坏墙的路径
-    auto smartPathResult = maze.findPathThroughDestructible(oldPos, m_targetPos, 10.0f);
-
-    // 比较两条路径，选择更优的
-    // 如果智能路径明显更短（考虑到可破坏墙的额外代价），则使用智能路径
-    bool useSmartPath = false;
-
-    if (!smartPathResult.path.empty())
-    {
-      if (normalPath.empty())
-      {
-        // 普通路径找不到，使用智能路径
-        useSmartPath = true;
-      }
-      else if (smartPathResult.hasDestructibleWall)
-      {
-        // 如果智能路径穿过可破坏墙，比较实际长度
-        // 智能路径需要比普通路径短很多才值得（因为需要花时间打墙）
-        float normalLen = static_cast<float>(normalPath.size());
-        float smartLen = static_cast<float>(smartPathResult.path.size());
-
-        // 如果智能路径比普通路径短50%以上，使用智能路径
-        if (smartLen < normalLen * 0.5f)
-        {
-          useSmartPath = true;
-        }
-      }
-      else
-      {
-        // 智能路径没有可破坏墙，且不为空，说明和普通路径一样
-        useSmartPath = false;
-      }
-    }
-
-    if (useSmartPath)
-    {
-      m_path = smartPathResult.path;
-      m_hasDestructibleWallOnPath = smartPathResult.hasDestructibleWall;
-      m_destructibleWallTarget = smartPathResult.firstDestructibleWallPos;
-    }
-    else
-    {
-      m_path = normalPath;
-      m_hasDestructibleWallOnPath = false;
-      m_destructibleWallTarget = {0.f, 0.f};
-    }
-
-    m_currentPathIndex = 0;
-    m_pathUpdateClock.restart();
+    refreshPath(maze, oldPos);
   }
 
   // 沿路径移动
@@ -237,60 +185,99 @@ void Enemy::update(float dt, const Maze &maze)
   }
   // 如果有墙阻挡（losToPlayer != 0），继续沿A*路径移动
 
-  // 移动
-  sf::Vector2f movement = m_moveDirection * m_moveSpeed * dt;
-  sf::Vector2f newPos = oldPos + movement;
+  // 移动（期望速度先经过群体避让：与其他 NPC 分开，并绕开即将相撞的邻居）
+  sf::Vector2f velocity = m_moveDirection * m_moveSpeed;
+  if (crowd)
+    crowd->steer(id, velocity.x, velocity.y, m_moveSpeed);
+  sf::Vector2f newPos = oldPos + velocity * dt;
 
   // 边界检查
   newPos.x = std::max(50.f, std::min(newPos.x, m_bounds.x - 50.f));
   newPos.y = std::max(50.f, std::min(newPos.y, m_bounds.y - 50.f));
 
   // 检查墙壁碰撞并实现滑动
-  if (!maze.checkCollision(newPos, getCollisionRadius()))
+  sf::Vector2f resolved = maze.resolveMovement(oldPos, newPos, getCollisionRadius());
+  store.x[id] = resolved.x;
+  store.y[id] = resolved.y;
+
+  // 车身转向移动方向
+  sf::Vector2f actualMovement = resolved - oldPos;
+  store.vx[id] = dt > 0.f ? actualMovement.x / dt : 0.f;
+  store.vy[id] = dt > 0.f ? actualMovement.y / dt : 0.f;
+  if (actualMovement.x != 0.f || actualMovement.y != 0.f)
   {
-    m_hull->setPosition(newPos);
+    float targetAngle = Utils::getDirectionAngle(actualMovement);
+    store.hullAngle[id] = Utils::lerpAngle(store.hullAngle[id], targetAngle, m_rotationSpeed * dt);
   }
-  else
+
+  // 选择最佳目标和射击策略（弹道检测开销大，由 AI 调度决定是否本帧执行）
+  if (think)
   {
-    // 尝试只在 X 或 Y 方向移动（滑动）
-    sf::Vector2f newPosX = {oldPos.x + movement.x, oldPos.y};
-    sf::Vector2f newPosY = {oldPos.x, oldPos.y + movement.y};
+    selectTarget(maze);
+  }
+
+  // 炮塔朝向射击目标（如果有有效目标），没有有效目标时朝向上次选出的最佳目标
+  store.turretAngle[id] = Utils::getAngle(resolved, m_hasValidTarget ? m_shootTarget : m_aimTarget);
+}
+
+void Enemy::refreshPath(const Maze &maze, sf::Vector2f oldPos)
+{
+  // 首先尝试普通路径
+  auto normalPath = maze.findPath(oldPos, m_targetPos);
 
-    bool canMoveX = !maze.checkCollision(newPosX, getCollisionRadius());
-    bool canMoveY = !maze.checkCollision(newPosY, getCollisionRadius());
+  // 然后尝试穿过可破坏墙的路径
+  auto smartPathResult = maze.findPathThroughDestructible(oldPos, m_targetPos, 10.0f);
 
-    if (canMoveX && canMoveY)
+  // 比较两条路径，选择更优的
+  // 如果智能路径明显更短（考虑到可破坏墙的额外代价），则使用智能路径
+  bool useSmartPath = false;
+
+  if (!smartPathResult.path.empty())
+  {
+    if (normalPath.empty())
     {
-      // 选择主要移动方向
-      if (std::abs(movement.x) > std::abs(movement.y))
-        m_hull->setPosition(newPosX);
-      else
-        m_hull->setPosition(newPosY);
+      // 普通路径找不到，使用智能路径
+      useSmartPath = true;
     }
-    else if (canMoveX)
+    else if (smartPathResult.hasDestructibleWall)
     {
-      m_hull->setPosition(newPosX);
+      // 如果智能路径穿过可破坏墙，比较实际长度
+      // 智能路径需要比普通路径短很多才值得（因为需要花时间打墙）
+      float normalLen = static_cast<float>(normalPath.size());
+      float smartLen = static_cast<float>(smartPathResult.path.size());
+
+      // 如果智能路径比普通路径短50%以上，使用智能路径
+      if (smartLen < normalLen * 0.5f)
+      {
+        useSmartPath = true;
+      }
     }
-    else if (canMoveY)
+    else
     {
-      m_hull->setPosition(newPosY);
+      // 智能路径没有可破坏墙，且不为空，说明和普通路径一样
+      useSmartPath = false;
     }
-    // 如果两个方向都碰撞，则不移动
   }
 
-  // 车身转向移动方向
-  sf::Vector2f actualMovement = m_hull->getPosition() - oldPos;
-  if (actualMovement.x != 0.f || actualMovement.y != 0.f)
+  if (useSmartPath)
   {
-    float targetAngle = Utils::getDirectionAngle(actualMovement);
-    m_hullAngle = Utils::lerpAngle(m_hullAngle, targetAngle, m_rotationSpeed * dt);
-    m_hull->setRotation(sf::degrees(m_hullAngle));
+    m_path = smartPathResult.path;
+    m_hasDestructibleWallOnPath = smartPathResult.hasDestructibleWall;
+    m_destructibleWallTarget = smartPathResult.firstDestructibleWallPos;
+  }
+  else
+  {
+    m_path = normalPath;
+    m_hasDestructibleWallOnPath = false;
+    m_destructibleWallTarget = {0.f, 0.f};
   }
 
-  // 炮塔跟随车身位置
-  m_turret->setPosition(m_hull->getPosition());
+  m_currentPathIndex = 0;
+  m_store->pathTimer[m_entity] = 0.f;
+}
 
-  // 选择最佳目标和射击策略
+void Enemy::selectTarget(const Maze &maze)
+{
   m_hasValidTarget = false;
   sf::Vector2f bestTarget = m_targetPos;
   int bestBulletPath = 2; // 默认假设最差情况（不可拆墙阻挡）
@@ -306,18 +293,29 @@ void Enemy::update(float dt, const Maze &maze)
     allTargets.push_back(m_targetPos);
   }
 
+  // 先让炮塔朝向每个目标计算枪口位置，再一次性批量检测所有子弹路径
+  std::vector<RayQuery> rays;
+  rays.reserve(allTargets.size());
   for (const auto &target : allTargets)
   {
-    sf::Vector2f toTarget = target - m_hull->getPosition();
-    float dist = std::sqrt(toTarget.x * toTarget.x + toTarget.y * toTarget.y);
-
-    // 先让炮塔朝向目标，计算枪口位置
-    float angle = Utils::getAngle(m_hull->getPosition(), target);
+    float angle = Utils::getAngle(getPosition(), target);
     float angleRad = (angle - 90.f) * Utils::PI / 180.f;
-    sf::Vector2f testGunPos = m_hull->getPosition() + sf::Vector2f{std::cos(angleRad) * m_gunLength, std::sin(angleRad) * m_gunLength};
+    sf::Vector2f testGunPos = getPosition() + sf::Vector2f{std::cos(angleRad) * m_gunLength, std::sin(angleRad) * m_gunLength};
+    rays.push_back({testGunPos.x, testGunPos.y, target.x, target.y});
+  }
+  std::vector<RayHit> hits(rays.size());
+  maze.getOccupancy().castRays(rays.data(), rays.size(), hits.data(), RayMode::FirstHit);
+
+  for (std::size_t i = 0; i < allTargets.size(); i++)
+  {
+    const sf::Vector2f &target = allTargets[i];
+    sf::Vector2f toTarget = target - getPosition();
+    float dist = std::sqrt(toTarget.x * toTarget.x + toTarget.y * toTarget.y);
 
-    // 使用精确的子弹路径检测
-    int bulletPath = maze.checkBulletPath(testGunPos, target);
+    // 与 Maze::checkBulletPath 一致：枪口几乎贴着目标时视为可以命中
+    float rayX = rays[i].x1 - rays[i].x0;
+    float rayY = rays[i].y1 - rays[i].y0;
+    int bulletPath = rayX * rayX + rayY * rayY < 1.f ? 0 : static_cast<int>(hits[i].block);
 
     // 优先选择：无阻挡 > 可拆墙 > 不可拆墙，距离作为次要因素
     if (bulletPath < bestBulletPath || (bulletPath == bestBulletPath && dist < bestDist))
@@ -361,9 +359,9 @@ void Enemy::update(float dt, const Maze &maze)
     if (m_hasDestructibleWallOnPath)
     {
       // 计算朝向智能路径目标墙的枪口位置
-      float wallAngle = Utils::getAngle(m_hull->getPosition(), m_destructibleWallTarget);
+      float wallAngle = Utils::getAngle(getPosition(), m_destructibleWallTarget);
       float wallAngleRad = (wallAngle - 90.f) * Utils::PI / 180.f;
-      sf::Vector2f wallGunPos = m_hull->getPosition() + sf::Vector2f{std::cos(wallAngleRad) * m_gunLength, std::sin(wallAngleRad) * m_gunLength};
+      sf::Vector2f wallGunPos = getPosition() + sf::Vector2f{std::cos(wallAngleRad) * m_gunLength, std::sin(wallAngleRad) * m_gunLength};
 
       // 检查子弹是否能打到智能路径上的可破坏墙
       int bulletToWall = maze.checkBulletPath(wallGunPos, m_destructibleWallTarget);
@@ -388,30 +386,18 @@ void Enemy::update(float dt, const Maze &maze)
     // 如果还是没有有效目标，不射击，继续移动寻找更好的位置
   }
 
-  // 炮塔朝向射击目标（如果有有效目标）
-  if (m_hasValidTarget)
-  {
-    float angle = Utils::getAngle(m_turret->getPosition(), m_shootTarget);
-    m_turret->setRotation(sf::degrees(angle));
-  }
-  else
-  {
-    // 没有有效目标时，炮塔朝向移动方向
-    float angle = Utils::getAngle(m_turret->getPosition(), bestTarget);
-    m_turret->setRotation(sf::degrees(angle));
-  }
-
-  // 更新血条位置（在坦克上方）
-  sf::Vector2f healthBarPos = m_hull->getPosition();
-  healthBarPos.x -= 25.f; // 居中
-  healthBarPos.y -= 45.f; // 在坦克上方
-  m_healthBar.setPosition(healthBarPos);
+  m_aimTarget = bestTarget;
 }
 
 void Enemy::draw(sf::RenderWindow &window) const
 {
   if (m_hull && m_turret)
   {
+    sf::Vector2f position = getPosition();
+    m_hull->setPosition(position);
+    m_hull->setRotation(sf::degrees(m_store->hullAngle[m_entity]));
+    m_turret->setPosition(position);
+    m_turret->setRotation(sf::degrees(m_store->turretAngle[m_entity]));
     window.draw(*m_hull);
     window.draw(*m_turret);
   }
@@ -419,17 +405,20 @@ void Enemy::draw(sf::RenderWindow &window) const
 
 void Enemy::drawHealthBar(sf::RenderWindow &window) const
 {
+  // 血条在坦克上方居中
+  m_healthBar.setHealth(getHealth());
+  m_healthBar.setPosition(getPosition() - sf::Vector2f{25.f, 45.f});
   m_healthBar.draw(window);
 }
 
 sf::Vector2f Enemy::getPosition() const
 {
-  return m_hull ? m_hull->getPosition() : sf::Vector2f{0.f, 0.f};
+  return {m_store->x[m_entity], m_store->y[m_entity]};
 }
 
 float Enemy::getTurretAngle() const
 {
-  return m_turret ? m_turret->getRotation().asDegrees() : 0.f;
+  return m_store->turretAngle[m_entity];
 }
 
 float Enemy::getTurretRotation() const
@@ -439,36 +428,31 @@ float Enemy::getTurretRotation() const
 
 void Enemy::setTurretRotation(float angle)
 {
-  if (m_turret)
-  {
-    m_turret->setRotation(sf::degrees(angle));
-  }
+  m_store->turretAngle[m_entity] = angle;
 }
 
 sf::Vector2f Enemy::getGunPosition() const
 {
-  if (!m_turret || !m_hull)
-    return {0.f, 0.f};
-
-  float angleRad = (m_turret->getRotation().asDegrees() - 90.f) * Utils::PI / 180.f;
+  float angleRad = (getTurretAngle() - 90.f) * Utils::PI / 180.f;
   sf::Vector2f offset = {std::cos(angleRad) * m_gunLength,
                          std::sin(angleRad) * m_gunLength};
-  return m_hull->getPosition() + offset;
+  return getPosition() + offset;
 }
 
 bool Enemy::shouldShoot()
 {
   // 只有激活后才会射击
-  if (!m_activated)
+  if (!isActivated())
     return false;
 
   // 没有有效目标时不射击（不可拆墙阻挡）
   if (!m_hasValidTarget)
     return false;
 
-  if (m_shootClock.getElapsedTime().asSeconds() > m_shootCooldown)
+  float &timer = m_store->shootTimer[m_entity];
+  if (timer > m_shootCooldown)
   {
-    m_shootClock.restart();
+    timer = 0.f;
     return true;
   }
   return false;
@@ -476,7 +460,7 @@ bool Enemy::shouldShoot()
 
 void Enemy::takeDamage(float damage)
 {
-  m_healthBar.setHealth(m_healthBar.getHealth() - damage);
+  setHealth(getHealth() - damage);
 }
 
 bool Enemy::isPlayerInRange(sf::Vector2f playerPos) const
@@ -489,7 +473,7 @@ bool Enemy::isPlayerInRange(sf::Vector2f playerPos) const
 void Enemy::checkAutoActivation(sf::Vector2f playerPos)
 {
   // 单人模式使用：距离600内自动激活
-  if (m_activated)
+  if (isActivated())
     return;
 
   sf::Vector2f toPlayer = playerPos - getPosition();
@@ -497,8 +481,8 @@ void Enemy::checkAutoActivation(sf::Vector2f playerPos)
 
   if (dist < 600.f)
   {
-    m_activated = true;
-    m_team = 0; // 单人模式中敌人没有阵营，攻击玩家
+    m_store->flags[m_entity] |= ENTITY_ACTIVATED;
+    m_store->team[m_entity] = 0; // 单人模式中敌人没有阵营，攻击玩家
   }
 }
 
@@ -0,0 +1,74 @@
+#include "EntityStore.hpp"
+
+EntityId EntityStore::create(EntityKind entityKind)
+{
+  EntityId id;
+  if (!m_free.empty())
+  {
+    id = m_free.back();
+    m_free.pop_back();
+  }
+  else
+  {
+    id = static_cast<EntityId>(kind.size());
+    kind.push_back(EntityKind::None);
+    flags.push_back(0);
+    team.push_back(0);
+    x.push_back(0.f);
+    y.push_back(0.f);
+    vx.push_back(0.f);
+    vy.push_back(0.f);
+    hullAngle.push_back(0.f);
+    turretAngle.push_back(0.f);
+    health.push_back(0.f);
+    maxHealth.push_back(0.f);
+    radius.push_back(0.f);
+    shootTimer.push_back(0.f);
+    pathTimer.push_back(0.f);
+  }
+
+  kind[id] = entityKind;
+  flags[id] = 0;
+  team[id] = 0;
+  x[id] = y[id] = 0.f;
+  vx[id] = vy[id] = 0.f;
+  hullAngle[id] = turretAngle[id] = 0.f;
+  health[id] = maxHealth[id] = 100.f;
+  radius[id] = 0.f;
+  shootTimer[id] = 0.f;
+  pathTimer[id] = 0.f;
+  return id;
+}
+
+void EntityStore::destroy(EntityId id)
+{
+  if (!valid(id))
+    return;
+  kind[id] = EntityKind::None;
+  m_free.push_back(id);
+}
+
+void EntityStore::clear()
+{
+  kind.clear();
+  flags.clear();
+  team.clear();
+  x.clear();
+  y.clear();
+  vx.clear();
+  vy.clear();
+  hullAngle.clear();
+  turretAngle.clear();
+  health.clear();
+  maxHealth.clear();
+  radius.clear();
+  shootTimer.clear();
+  pathTimer.clear();
+  m_free.clear();
+}
+
+std::size_t EntityStore::memoryBytes() const
+{
+  std::size_t perEntity = sizeof(EntityKind) + sizeof(uint8_t) + sizeof(int8_t) + sizeof(float) * 12;
+  return kind.size() * perEntity + m_free.size() * sizeof(EntityId);
+}
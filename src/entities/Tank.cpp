@@ -1,22 +1,27 @@
 #include "Tank.hpp"
 #include "AudioManager.hpp"
+#include <algorithm>
 
-Tank::Tank()
-    : m_healthBar(200.f, 20.f)
+Tank::Tank(EntityStore &store)
+    : m_store(&store), m_entity(store.create(EntityKind::Tank)), m_healthBar(200.f, 20.f)
 {
-  m_healthBar.setMaxHealth(100.f);
-  m_healthBar.setHealth(100.f);
+  m_store->radius[m_entity] = 12.f * m_scale / 0.25f;
+  m_healthBar.setMaxHealth(m_store->maxHealth[m_entity]);
+  m_healthBar.setHealth(m_store->health[m_entity]);
   m_healthBar.setPosition({20.f, 20.f});
   m_useSimpleGraphics = true;
 }
 
-Tank::Tank(float x, float y, sf::Color color)
-    : m_healthBar(200.f, 20.f), m_color(color), m_position(x, y)
+Tank::Tank(EntityStore &store, float x, float y, sf::Color color)
+    : Tank(store)
 {
-  m_healthBar.setMaxHealth(100.f);
-  m_healthBar.setHealth(100.f);
-  m_healthBar.setPosition({20.f, 20.f});
-  m_useSimpleGraphics = true;
+  m_color = color;
+  setPosition({x, y});
+}
+
+Tank::~Tank()
+{
+  m_store->destroy(m_entity);
 }
 
 bool Tank::loadTextures(const std::string &hullPath, const std::string &turretPath)
@@ -29,7 +34,6 @@ bool Tank::loadTextures(const std::string &hullPath, const std::string &turretPa
   // 创建并设置车身
   m_hull = std::make_unique<sf::Sprite>(m_hullTexture);
   m_hull->setOrigin(sf::Vector2f(m_hullTexture.getSize()) / 2.f);
-  m_hull->setPosition({640.f, 360.f});
   m_hull->setScale({m_scale, m_scale});
 
   // 创建并设置炮塔
@@ -39,7 +43,7 @@ bool Tank::loadTextures(const std::string &hullPath, const std::string &turretPa
   m_turret->setOrigin({turretSize.x / 2.f, turretSize.y * 0.75f});
   m_turret->setScale({m_scale, m_scale});
 
-  m_position = m_hull->getPosition();
+  setPosition({640.f, 360.f});
   m_useSimpleGraphics = false;
 
   return true;
@@ -87,16 +91,34 @@ void Tank::handleInput(const sf::Event &event)
   }
 }
 
+uint8_t Tank::getInputBits() const
+{
+  return (m_keyW ? INPUT_UP : 0) | (m_keyS ? INPUT_DOWN : 0) | (m_keyA ? INPUT_LEFT : 0) |
+         (m_keyD ? INPUT_RIGHT : 0) | (m_mouseHeld ? INPUT_FIRE : 0);
+}
+
+void Tank::setInputBits(uint8_t bits)
+{
+  m_keyW = bits & INPUT_UP;
+  m_keyS = bits & INPUT_DOWN;
+  m_keyA = bits & INPUT_LEFT;
+  m_keyD = bits & INPUT_RIGHT;
+  m_mouseHeld = bits & INPUT_FIRE;
+}
+
 void Tank::update(float dt, sf::Vector2f mousePos)
 {
+  EntityStore &store = *m_store;
+  const EntityId id = m_entity;
+
   // 更新射击计时器
-  m_shootTimer += dt;
+  store.shootTimer[id] += dt;
   m_firedBullet = false;
 
-  if (m_mouseHeld && m_shootTimer >= m_shootCooldown)
+  if (m_mouseHeld && store.shootTimer[id] >= m_shootCooldown)
   {
     m_firedBullet = true;
-    m_shootTimer = 0.f;
+    store.shootTimer[id] = 0.f;
   }
 
   // 计算移动
@@ -113,32 +135,29 @@ void Tank::update(float dt, sf::Vector2f mousePos)
   // 移动并转向
   if (movement.x != 0.f || movement.y != 0.f)
   {
-    m_position += movement;
+    store.x[id] += movement.x;
+    store.y[id] += movement.y;
 
     float targetAngle = Utils::getDirectionAngle(movement);
-    m_hullAngle = Utils::lerpAngle(m_hullAngle, targetAngle, m_rotationSpeed * dt);
-
-    if (m_hull)
-    {
-      m_hull->move(movement);
-      m_hull->setRotation(sf::degrees(m_hullAngle));
-    }
+    store.hullAngle[id] = Utils::lerpAngle(store.hullAngle[id], targetAngle, m_rotationSpeed * dt);
   }
 
   // 炮塔朝向鼠标
-  m_turretAngle = Utils::getAngle(m_position, mousePos);
-
-  if (m_hull && m_turret)
-  {
-    m_turret->setPosition(m_hull->getPosition());
-    m_turret->setRotation(sf::degrees(m_turretAngle));
-  }
+  store.turretAngle[id] = Utils::getAngle(getPosition(), mousePos);
 }
 
 void Tank::draw(sf::RenderWindow &window) const
 {
+  sf::Vector2f position = getPosition();
+  float hullAngle = getRotation();
+  float turretAngle = getTurretAngle();
+
   if (m_hull && m_turret && !m_useSimpleGraphics)
   {
+    m_hull->setPosition(position);
+    m_hull->setRotation(sf::degrees(hullAngle));
+    m_turret->setPosition(position);
+    m_turret->setRotation(sf::degrees(turretAngle));
     window.draw(*m_hull);
     window.draw(*m_turret);
   }
@@ -150,8 +169,8 @@ void Tank::draw(sf::RenderWindow &window) const
     // 车身
     sf::RectangleShape hull({size * 1.5f, size});
     hull.setOrigin({size * 0.75f, size * 0.5f});
-    hull.setPosition(m_position);
-    hull.setRotation(sf::degrees(m_hullAngle));
+    hull.setPosition(position);
+    hull.setRotation(sf::degrees(hullAngle));
     hull.setFillColor(m_color);
     hull.setOutlineColor(sf::Color::Black);
     hull.setOutlineThickness(2.f);
@@ -160,15 +179,15 @@ void Tank::draw(sf::RenderWindow &window) const
     // 炮塔
     sf::CircleShape turretBase(size * 0.4f);
     turretBase.setOrigin({size * 0.4f, size * 0.4f});
-    turretBase.setPosition(m_position);
+    turretBase.setPosition(position);
     turretBase.setFillColor(sf::Color(m_color.r * 0.7f, m_color.g * 0.7f, m_color.b * 0.7f));
     window.draw(turretBase);
 
     // 炮管
     sf::RectangleShape barrel({size * 1.2f, size * 0.2f});
     barrel.setOrigin({0.f, size * 0.1f});
-    barrel.setPosition(m_position);
-    barrel.setRotation(sf::degrees(m_turretAngle - 90.f));
+    barrel.setPosition(position);
+    barrel.setRotation(sf::degrees(turretAngle - 90.f));
     barrel.setFillColor(sf::Color(80, 80, 80));
     window.draw(barrel);
   }
@@ -176,39 +195,38 @@ void Tank::draw(sf::RenderWindow &window) const
 
 void Tank::drawUI(sf::RenderWindow &window) const
 {
+  m_healthBar.setHealth(getHealth());
   m_healthBar.draw(window);
 }
 
 void Tank::setPosition(sf::Vector2f pos)
 {
-  m_position = pos;
-  if (m_hull)
-  {
-    m_hull->setPosition(pos);
-  }
-  if (m_turret)
-  {
-    m_turret->setPosition(pos);
-  }
+  m_store->x[m_entity] = pos.x;
+  m_store->y[m_entity] = pos.y;
 }
 
 sf::Vector2f Tank::getPosition() const
 {
-  return m_position;
+  return {m_store->x[m_entity], m_store->y[m_entity]};
 }
 
 float Tank::getTurretAngle() const
 {
-  return m_turretAngle;
+  return m_store->turretAngle[m_entity];
+}
+
+void Tank::setHealth(float health)
+{
+  m_store->health[m_entity] = std::clamp(health, 0.f, m_store->maxHealth[m_entity]);
 }
 
 sf::Vector2f Tank::getGunPosition() const
 {
   float size = 20.f * m_scale / 0.25f;
-  float angleRad = (m_turretAngle - 90.f) * Utils::PI / 180.f;
+  float angleRad = (getTurretAngle() - 90.f) * Utils::PI / 180.f;
   sf::Vector2f offset = {std::cos(angleRad) * size * 1.2f,
                          std::sin(angleRad) * size * 1.2f};
-  return m_position + offset;
+  return getPosition() + offset;
 }
 
 bool Tank::hasFiredBullet()
@@ -220,7 +238,7 @@ bool Tank::hasFiredBullet()
 
 void Tank::takeDamage(float damage)
 {
-  m_healthBar.setHealth(m_healthBar.getHealth() - damage);
+  setHealth(getHealth() - damage);
 }
 
 sf::Vector2f Tank::getMovement(float dt) const
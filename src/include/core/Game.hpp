@@ -7,10 +7,17 @@
 #include "Bullet.hpp"
 #include "Enemy.hpp"
 #include "Maze.hpp"
-#include "MazeGenerator.hpp"
+#include "MazePool.hpp"
+#include "ChunkStreamer.hpp"
+#include "AIScheduler.hpp"
+#include "CrowdSteering.hpp"
 #include "NetworkManager.hpp"
 #include "MultiplayerHandler.hpp"
 #include "AudioManager.hpp"
+#include "UILayer.hpp"
+#include "ReplayFile.hpp"
+#include <optional>
+#include <string>
 
 // 游戏状态枚举
 enum class GameState
@@ -44,11 +51,12 @@ enum class MainMenuOption
 // 地图大小预设
 enum class MapSizePreset
 {
-  Small,  // 31x21, 10 NPCs
-  Medium, // 41x31, 20 NPCs
-  Large,  // 61x51, 30 NPCs
-  Ultra,  // 121x101, 80 NPCs
-  Custom, // 自定义
+  Small,   // 31x21, 10 NPCs
+  Medium,  // 41x31, 20 NPCs
+  Large,   // 61x51, 30 NPCs
+  Ultra,   // 121x101, 80 NPCs
+  Endless, // 无尽分块世界（仅单人，见 ChunkStreamer）
+  Custom,  // 自定义
   Count
 };
 
@@ -69,11 +77,23 @@ enum class InputMode
   RoomCode
 };
 
+// 命令行录像选项（--record / --replay / --speed / --headless）
+struct ReplayOptions
+{
+  std::string recordPath; // 录制下一局单人对局
+  std::string replayPath; // 启动后直接回放
+  float speed = 1.f;      // 回放倍速（渲染模式）
+  bool headless = false;  // 回放时不渲染，逐步连续跑完并打印耗时
+};
+
 class Game
 {
 public:
   Game();
 
+  // 须在 init 之前调用；回放文件打不开时返回 false
+  bool setReplayOptions(const ReplayOptions &options);
+
   bool init();
   void run();
 
@@ -100,11 +120,24 @@ private:
   void checkCollisions();
   void checkMultiplayerCollisions();
   void spawnEnemies();
+  void spawnEnemyAt(sf::Vector2f position, float health = 0.f); // health <= 0 为满血
+  void streamChunks(); // 无尽模式：按玩家位置平移常驻窗口，换入/换出区块中的 NPC
   void resetGame();
   void startGame();
   void updateCamera();
   void generateRandomMaze();
+  void loadMaze(const MazeRequest &request); // 从预生成池换入迷宫（未就绪时同步生成）
+  void prefetchMaze();                       // 菜单/大厅/结算界面时预生成下一局的迷宫
   void handleWindowResize(); // 处理窗口大小变化，保持宽高比
+  bool tryPlaceWall(sf::Vector2f worldPos); // 单人模式放置墙壁，成功返回 true
+  sf::Vector2f aimWorldPosition() const;    // 玩家瞄准点（录像时为本步记录的值）
+
+  // 录像：录制或回放时对局按固定步长推进
+  void advanceFixedTicks(float dt);
+  bool stepReplayTick(); // 推进一步；回放已读完返回 false
+  void stopRecording();
+  void finishReplay();
+  void runHeadlessReplay();
 
   // 网络回调
   void setupNetworkCallbacks();
@@ -122,6 +155,7 @@ private:
   const float m_cameraLookAhead = 100.f; // 视角向瞄准方向偏移量
   const float m_cameraSmoothSpeed = 3.f; // 相机平滑跟随速度（越小越平滑）
   const float m_tankScale = 0.4f;
+  static constexpr int ENDLESS_ENEMIES_PER_CHUNK = 2;
 
   sf::Vector2f m_currentCameraPos = {0.f, 0.f}; // 当前相机位置（用于平滑插值）
 
@@ -129,17 +163,41 @@ private:
   sf::View m_gameView; // 游戏视图（跟随玩家）
   sf::View m_uiView;   // UI 视图（固定）
 
+  EntityStore m_entities; // 坦克与 NPC 的热数据，须在 m_player / m_enemies 之前声明（最后析构）
   std::unique_ptr<Tank> m_player;
   std::unique_ptr<Tank> m_otherPlayer; // 另一个玩家（多人模式）
   std::vector<std::unique_ptr<Enemy>> m_enemies;
   std::vector<std::unique_ptr<Bullet>> m_bullets;
   Maze m_maze;
-  MazeGenerator m_mazeGenerator;
+  MazePool m_mazePool;
+  std::unique_ptr<ChunkStreamer> m_chunkStreamer; // 无尽模式：非空时 m_maze 是分块世界上的常驻窗口
+  AIScheduler m_aiScheduler; // NPC AI 分级调度
+  CrowdSteering m_crowd;     // NPC 群体避让
 
   sf::Font m_font;
 
+  // 保留模式 UI（主菜单 / HUD / 小地图 / 房间大厅）：文字和面板只在内容变化时重建顶点
+  UILayer m_menuUI{m_font};
+  UILayer m_hudUI{m_font};
+  UILayer m_minimapUI{m_font};
+  UILayer m_lobbyUI{m_font};
+
+  // 录像
+  static constexpr float REPLAY_TICK_DT = 1.f / 60.f;
+  static constexpr int MAX_TICKS_PER_FRAME = 8; // 卡顿时最多追赶的步数，超出部分丢弃
+  ReplayOptions m_replayOptions;
+  ReplayWriter m_replayWriter;
+  ReplayReader m_replayReader;
+  bool m_replaying = false;
+  std::size_t m_replayTick = 0;               // 已推进的步数
+  float m_tickAccumulator = 0.f;
+  std::optional<sf::Vector2f> m_aimOverride;  // 固定步长下本步的瞄准点
+  std::optional<GridPos> m_pendingPlacement;  // 录制中：两步之间放置的墙，写入下一步
+
   sf::Clock m_clock;
   sf::Clock m_shootClock;
+  sf::Clock m_startupClock;          // 启动计时（报告首帧耗时）
+  bool m_firstFrameReported = false;
 
   // 游戏状态
   GameState m_gameState = GameState::MainMenu;
@@ -194,6 +252,9 @@ private:
   // 获取多人模式上下文
   MultiplayerContext getMultiplayerContext();
 
+  // 对方同步过来的墙被摧毁：播放音效，本地玩家打掉的墙给本地玩家加增益
+  void onRemoteWallDestroyed(const WallDestroyResult &result, WallAttribute attr, int destroyerId);
+
   // 检查终点是否在玩家视野内
   bool isExitInView() const;
 
@@ -34,6 +34,9 @@ public:
   // 检查是否出界
   void checkBounds(float width, float height);
 
+  // 无尽模式窗口重建时平移
+  void shiftOrigin(sf::Vector2f offset);
+
   // 碰撞检测
   sf::Vector2f getPosition() const;
   BulletOwner getOwner() const { return m_owner; }
@@ -5,20 +5,34 @@
 #include <vector>
 #include "Utils.hpp"
 #include "HealthBar.hpp"
+#include "EntityStore.hpp"
 
 // 前向声明
 class Maze;
+class CrowdSteering;
 
+// NPC：位置、角度、血量、阵营、激活状态与计时器存放在 EntityStore 中（见 EntityStore.hpp），
+// 这里只保留贴图、精灵、血条图形与寻路/选目标等 AI 状态
 class Enemy
 {
 public:
-  Enemy();
+  explicit Enemy(EntityStore &store);
+  ~Enemy();
+  Enemy(const Enemy &) = delete;
+  Enemy &operator=(const Enemy &) = delete;
 
   bool loadTextures(const std::string &hullPath, const std::string &turretPath);
 
+  // 无贴图模式（服务器端模拟）：使用空纹理创建精灵，激活时不加载贴图
+  void initHeadless();
+
   void setPosition(sf::Vector2f position);
+  // 无尽模式窗口重建：位置和缓存的路径、目标点一起平移
+  void shiftOrigin(sf::Vector2f offset);
   void setTarget(sf::Vector2f targetPos);
-  void update(float dt, const Maze &maze); // 添加迷宫参数用于碰撞检测
+  // think 为 false 时跳过寻路刷新和目标选择（沿用上次结果），只积分移动（见 AIScheduler）
+  // crowd 非空时沿路径的期望速度再经过群体避让（crowd 按实体 id 建表，见 CrowdSteering::build）
+  void update(float dt, const Maze &maze, bool think = true, const CrowdSteering *crowd = nullptr);
   void draw(sf::RenderWindow &window) const;
   void drawHealthBar(sf::RenderWindow &window) const; // 单独绘制血条
 
@@ -31,13 +45,15 @@ public:
 
   // 受到伤害
   void takeDamage(float damage);
-  bool isDead() const { return m_healthBar.isDead(); }
+  bool isDead() const { return m_store->health[m_entity] <= 0.f; }
 
   // 获取碰撞半径
-  float getCollisionRadius() const { return 18.f; }
+  float getCollisionRadius() const { return m_store->radius[m_entity]; }
+
+  EntityId getEntityId() const { return m_entity; }
 
   // 激活状态（多人模式需要手动激活，单人模式自动激活）
-  bool isActivated() const { return m_activated; }
+  bool isActivated() const { return (m_store->flags[m_entity] & ENTITY_ACTIVATED) != 0; }
   void activate(int team, int activatorId = -1); // activatorId: 0=local, 1=other, -1=auto
 
   // Escape 模式：获取/设置激活者和目标优先级
@@ -57,8 +73,8 @@ public:
   void checkAutoActivation(sf::Vector2f playerPos);
 
   // 阵营系统（0=未激活/中立，1=玩家1阵营，2=玩家2阵营）
-  int getTeam() const { return m_team; }
-  void setTeam(int team) { m_team = team; }
+  int getTeam() const { return m_store->team[m_entity]; }
+  void setTeam(int team) { m_store->team[m_entity] = static_cast<int8_t>(team); }
 
   // 设置多个目标（用于追踪敌方阵营的所有目标）
   void setTargets(const std::vector<sf::Vector2f> &targets);
@@ -71,27 +87,31 @@ public:
   void setId(int id) { m_id = id; }
 
   // 网络同步需要的getter/setter
-  float getRotation() const { return m_hullAngle; }
-  void setRotation(float angle)
-  {
-    m_hullAngle = angle;
-    if (m_hull)
-      m_hull->setRotation(sf::degrees(angle));
-  }
+  float getRotation() const { return m_store->hullAngle[m_entity]; }
+  void setRotation(float angle) { m_store->hullAngle[m_entity] = angle; }
   float getTurretRotation() const;
   void setTurretRotation(float angle);
-  float getHealth() const { return m_healthBar.getHealth(); }
-  void setHealth(float health) { m_healthBar.setHealth(health); }
+  float getHealth() const { return m_store->health[m_entity]; }
+  void setHealth(float health);
 
   // （已移除）网络插值相关 - 未在工程中使用
 
 private:
+  void refreshPath(const Maze &maze, sf::Vector2f oldPos); // A* 与穿墙路径比较
+  void selectTarget(const Maze &maze);                     // 弹道检测，选择射击目标
+  void createSprites();
+
+  EntityStore *m_store;
+  EntityId m_entity;
+
+  // 渲染数据：绘制前从实体存储同步
   sf::Texture m_hullTexture;
   sf::Texture m_turretTexture;
   std::unique_ptr<sf::Sprite> m_hull;
   std::unique_ptr<sf::Sprite> m_turret;
+  bool m_headless = false;
 
-  HealthBar m_healthBar;
+  mutable HealthBar m_healthBar;
 
   sf::Vector2f m_targetPos;
   sf::Vector2f m_moveDirection;
@@ -100,19 +120,12 @@ private:
   // A* 寻路
   std::vector<sf::Vector2f> m_path;
   size_t m_currentPathIndex = 0;
-  sf::Clock m_pathUpdateClock;
   const float m_pathUpdateInterval = 0.5f; // 每0.5秒更新路径
 
   // 智能路径（考虑可破坏墙）
   bool m_hasDestructibleWallOnPath = false;
   sf::Vector2f m_destructibleWallTarget = {0.f, 0.f}; // 路径上第一个可破坏墙的位置
 
-  float m_hullAngle = 0.f;
-  sf::Clock m_shootClock;
-  sf::Clock m_directionChangeClock;
-
-  bool m_activated = false;           // 是否被激活
-  int m_team = 0;                     // 阵营：0=中立，1=玩家1，2=玩家2
   int m_id = 0;                       // NPC唯一ID
   int m_activatorId = -1;             // Escape 模式：激活者 ID（0=local, 1=other, -1=自动激活）
   bool m_primaryTargetDowned = false; // 主目标是否倒地
@@ -122,6 +135,7 @@ private:
 
   // 射击目标（可能是玩家或可拆墙）
   sf::Vector2f m_shootTarget = {0.f, 0.f};
+  sf::Vector2f m_aimTarget = {0.f, 0.f}; // 无有效目标时炮塔朝向（上次选出的最佳目标）
   bool m_hasValidTarget = false;
   int m_lastLineOfSightResult = 0; // 0=无阻挡, 1=可拆墙, 2=不可拆墙
 
@@ -131,6 +145,5 @@ private:
   const float m_scale = 0.175f; // 原0.25的70%
   const float m_gunLength = 25.f;
   const float m_shootCooldown = 1.0f;
-  const float m_directionChangeInterval = 2.0f;
   const float m_activationRange = 60.f; // 激活距离（需要接近才能激活）
 };
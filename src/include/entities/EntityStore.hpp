@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 坦克与 NPC 的热数据存储（不依赖 SFML）
+// 模拟每帧都要读写的组件按实体 id 存成并列数组，遍历全部实体就是对几个连续数组的线性扫描；
+// 贴图、精灵、血条图形与寻路缓存等只在渲染或思考时用到的数据仍留在 Tank / Enemy 对象里。
+// Tank / Enemy 只是持有 (store, id) 的视图，构造时分配槽位，析构时归还。
+
+using EntityId = uint32_t;
+
+enum class EntityKind : uint8_t
+{
+  None = 0, // 空闲槽位
+  Tank,
+  Npc
+};
+
+// 实体标志位
+constexpr uint8_t ENTITY_ACTIVATED = 1; // NPC 已激活
+
+class EntityStore
+{
+public:
+  EntityId create(EntityKind kind);
+  void destroy(EntityId id);
+
+  // 清空全部槽位（只能在没有存活实体时调用）：之后分配的 id 从 0 开始，与历史无关
+  void clear();
+
+  bool valid(EntityId id) const { return id < kind.size() && kind[id] != EntityKind::None; }
+
+  // 存活的 NPC（alive）/ 存活且已激活的 NPC（active）
+  bool isAliveNpc(EntityId id) const { return kind[id] == EntityKind::Npc && health[id] > 0.f; }
+  bool isActiveNpc(EntityId id) const { return isAliveNpc(id) && (flags[id] & ENTITY_ACTIVATED); }
+
+  // 扫描范围（含空闲槽位，按 kind 过滤）
+  std::size_t capacity() const { return kind.size(); }
+  std::size_t count() const { return kind.size() - m_free.size(); }
+
+  std::size_t memoryBytes() const;
+
+  // 并列数组直接公开，系统代码按下标线性扫描
+  std::vector<EntityKind> kind;
+  std::vector<uint8_t> flags;
+  std::vector<int8_t> team; // 0=中立/未设置，1/2=玩家阵营
+  std::vector<float> x, y;
+  std::vector<float> vx, vy; // 上一帧的实际速度
+  std::vector<float> hullAngle, turretAngle;
+  std::vector<float> health, maxHealth;
+  std::vector<float> radius; // 碰撞半径
+  std::vector<float> shootTimer; // 距上次射击的秒数
+  std::vector<float> pathTimer;  // 距上次寻路的秒数（NPC）
+
+private:
+  std::vector<EntityId> m_free; // 可复用的槽位
+};
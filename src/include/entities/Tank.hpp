@@ -4,17 +4,32 @@
 #include <memory>
 #include "Utils.hpp"
 #include "HealthBar.hpp"
+#include "EntityStore.hpp"
 
+// 玩家坦克：位置、角度、血量、阵营与射击计时存放在 EntityStore 中（见 EntityStore.hpp），
+// 这里只保留输入状态、贴图与金币/背包等不参与逐帧扫描的数据
 class Tank
 {
 public:
-  Tank();
-  Tank(float x, float y, sf::Color color = sf::Color::Blue);
+  explicit Tank(EntityStore &store);
+  Tank(EntityStore &store, float x, float y, sf::Color color = sf::Color::Blue);
+  ~Tank();
+  Tank(const Tank &) = delete;
+  Tank &operator=(const Tank &) = delete;
 
   bool loadTextures(const std::string &hullPath, const std::string &turretPath);
 
   void handleInput(const sf::Event &event);
   void update(float dt, sf::Vector2f mousePos);
+
+  // 当前按键状态打包成位（录像用）：移动 W/S/A/D 与鼠标左键
+  static constexpr uint8_t INPUT_UP = 1;
+  static constexpr uint8_t INPUT_DOWN = 2;
+  static constexpr uint8_t INPUT_LEFT = 4;
+  static constexpr uint8_t INPUT_RIGHT = 8;
+  static constexpr uint8_t INPUT_FIRE = 16;
+  uint8_t getInputBits() const;
+  void setInputBits(uint8_t bits);
   void draw(sf::RenderWindow &window) const;
   void render(sf::RenderWindow &window) const { draw(window); }
   void drawUI(sf::RenderWindow &window) const; // 绘制 UI（血条在左上角）
@@ -24,20 +39,10 @@ public:
   float getTurretAngle() const;
 
   // 获取/设置旋转角度
-  float getRotation() const { return m_hullAngle; }
-  void setRotation(float angle)
-  {
-    m_hullAngle = angle;
-    if (m_hull)
-      m_hull->setRotation(sf::degrees(m_hullAngle));
-  }
-  float getTurretRotation() const { return m_turretAngle; }
-  void setTurretRotation(float angle)
-  {
-    m_turretAngle = angle;
-    if (m_turret)
-      m_turret->setRotation(sf::degrees(m_turretAngle));
-  }
+  float getRotation() const { return m_store->hullAngle[m_entity]; }
+  void setRotation(float angle) { m_store->hullAngle[m_entity] = angle; }
+  float getTurretRotation() const { return m_store->turretAngle[m_entity]; }
+  void setTurretRotation(float angle) { m_store->turretAngle[m_entity] = angle; }
 
   // 获取枪口位置
   sf::Vector2f getGunPosition() const;
@@ -50,30 +55,28 @@ public:
   bool hasFiredBullet();
 
   // 获取/设置生命值
-  float getHealth() const { return m_healthBar.getHealth(); }
-  void setHealth(float health) { m_healthBar.setHealth(health); }
+  float getHealth() const { return m_store->health[m_entity]; }
+  void setHealth(float health);
 
   // 受到伤害
   void takeDamage(float damage);
-  bool isDead() const { return m_healthBar.isDead(); }
+  bool isDead() const { return m_store->health[m_entity] <= 0.f; }
 
   // 治疗（恢复百分比血量）
-  void heal(float percent)
-  {
-    float maxHp = m_healthBar.getMaxHealth();
-    float current = m_healthBar.getHealth();
-    float healAmount = maxHp * percent;
-    m_healthBar.setHealth(std::min(current + healAmount, maxHp));
-  }
+  void heal(float percent) { setHealth(getHealth() + m_store->maxHealth[m_entity] * percent); }
 
   // 获取碰撞半径 (减小以适应迷宫通道)
-  float getCollisionRadius() const { return 12.f * m_scale / 0.25f; }
+  float getCollisionRadius() const { return m_store->radius[m_entity]; }
 
   // 获取当前移动向量（用于墙壁滑动）
   sf::Vector2f getMovement(float dt) const;
 
   // 设置缩放
-  void setScale(float scale) { m_scale = scale; }
+  void setScale(float scale)
+  {
+    m_scale = scale;
+    m_store->radius[m_entity] = 12.f * m_scale / 0.25f;
+  }
 
   // 金币系统
   int getCoins() const { return m_coins; }
@@ -104,10 +107,16 @@ public:
   }
 
   // 阵营（用于多人模式，0=未设置，1=玩家1阵营，2=玩家2阵营）
-  int getTeam() const { return m_team; }
-  void setTeam(int team) { m_team = team; }
+  int getTeam() const { return m_store->team[m_entity]; }
+  void setTeam(int team) { m_store->team[m_entity] = static_cast<int8_t>(team); }
+
+  EntityId getEntityId() const { return m_entity; }
 
 private:
+  EntityStore *m_store;
+  EntityId m_entity;
+
+  // 渲染数据：绘制前从实体存储同步
   sf::Texture m_hullTexture;
   sf::Texture m_turretTexture;
   std::unique_ptr<sf::Sprite> m_hull;
@@ -117,7 +126,7 @@ private:
   sf::Color m_color = sf::Color::Blue;
   bool m_useSimpleGraphics = true;
 
-  HealthBar m_healthBar;
+  mutable HealthBar m_healthBar;
 
   // 移动状态
   bool m_keyW = false;
@@ -126,13 +135,8 @@ private:
   bool m_keyD = false;
   bool m_mouseHeld = false;
 
-  // 角度
-  float m_hullAngle = 0.f;
-  float m_turretAngle = 0.f;
-
   // 射击检测
   bool m_firedBullet = false;
-  float m_shootTimer = 0.f;
   const float m_shootCooldown = 0.3f;
 
   // 配置
@@ -141,14 +145,9 @@ private:
   float m_scale = 0.25f;
   const float m_gunLength = 25.f;
 
-  sf::Vector2f m_position;
-
   // 金币系统（多人模式）
   int m_coins = 10; // 初始10个金币
 
   // 背包系统
   int m_wallsInBag = 0; // 初始0个棕色格子
-
-  // 阵营（多人模式）
-  int m_team = 0; // 0=未设置，1=玩家1，2=玩家2
 };
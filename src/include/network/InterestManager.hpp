@@ -0,0 +1,65 @@
+#pragma once
+
+#include <SFML/System.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class OccupancyGrid;
+
+// NPC 同步的关注区域（area of interest）
+// 以接收方坦克为中心、视野半径加余量为半径：区域内的 NPC 每帧发送 NpcUpdate，区域外每 FAR_INTERVAL 秒发送一次
+// （同级 NPC 按下标错开，避免集中在同一帧）；NPC 从区域外进入的那一帧强制发送。
+// 子弹沿直线飞到第一堵墙为止，只有这段轨迹经过关注区域时才发送 NpcShoot。
+// 还不知道接收方位置时全部按区域内处理。
+class InterestManager
+{
+public:
+  static constexpr float VIEW_RADIUS = 830.f; // 1440x810 视野（1920x1080 × VIEW_ZOOM）的半对角线
+  static constexpr float MARGIN = 300.f;      // 镜头前视偏移、快照延迟与对方转向的余量
+  static constexpr float RADIUS = VIEW_RADIUS + MARGIN;
+  static constexpr float FAR_INTERVAL = 0.25f; // 区域外的发送间隔（秒），不超过插值缓冲的外推时长
+
+  struct Stats
+  {
+    uint64_t nearUpdates = 0;    // 区域内发送
+    uint64_t farUpdates = 0;     // 区域外按低频发送
+    uint64_t forcedUpdates = 0;  // 进入区域时强制发送
+    uint64_t skippedUpdates = 0; // 区域外本帧不发送
+    uint64_t shotsSent = 0;
+    uint64_t shotsCulled = 0;
+  };
+
+  // 每局开始时调用
+  void reset();
+
+  // 每帧开始时调用；hasObserver 为 false（尚未收到接收方位置）时全部按区域内处理
+  void beginFrame(float dt, bool hasObserver, sf::Vector2f observer);
+
+  // 本帧是否发送该 NPC 的状态；index 为 NPC 在列表中的下标
+  bool shouldSendUpdate(std::size_t index, sf::Vector2f position);
+
+  // 从 start 以 angleDegrees 方向射出的子弹，停下之前是否经过关注区域
+  bool shouldSendShot(const OccupancyGrid &grid, sf::Vector2f start, float angleDegrees);
+
+  // 上一次 beginFrame 之后判定的区域内 / 区域外 NPC 数
+  int insideCount() const { return m_insideCount; }
+  int outsideCount() const { return m_outsideCount; }
+
+  const Stats &getStats() const { return m_stats; }
+
+private:
+  struct Entry
+  {
+    bool inside = false;
+    float lastSent = -1.f; // 负数表示从未发送
+  };
+
+  std::vector<Entry> m_entries;
+  bool m_hasObserver = false;
+  sf::Vector2f m_observer;
+  float m_time = 0.f;
+  int m_insideCount = 0;
+  int m_outsideCount = 0;
+  Stats m_stats;
+};
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+
+// 确定性帧同步（lockstep，不依赖 SFML）
+// 双方用同一张地图、同一个 rand() 种子和固定步长各自运行完整模拟，网络上只交换每步的输入。
+// 本地输入延迟 INPUT_DELAY 步生效，给对方输入留出到达时间；某一步缺对方输入时整体停下等待。
+// 每 HASH_INTERVAL 步交换一次状态哈希，不一致即判定失步（只报告，不修复）。
+
+// 每步输入的按键位（低 5 位与 Tank 的 INPUT_* 一致）
+constexpr uint8_t LOCKSTEP_KEY_UP = 1;
+constexpr uint8_t LOCKSTEP_KEY_DOWN = 2;
+constexpr uint8_t LOCKSTEP_KEY_LEFT = 4;
+constexpr uint8_t LOCKSTEP_KEY_RIGHT = 8;
+constexpr uint8_t LOCKSTEP_KEY_FIRE = 16;
+constexpr uint8_t LOCKSTEP_KEY_EXIT = 32;      // E 键（终点确认）
+constexpr uint8_t LOCKSTEP_KEY_RESCUE = 64;    // F 键（救援）
+constexpr uint8_t LOCKSTEP_KEY_ACTIVATE = 128; // 本步按下了 R（激活 NPC）
+constexpr uint8_t LOCKSTEP_TANK_KEYS = 0x1F;   // 交给 Tank 的部分（移动 + 射击）
+
+struct LockstepInput
+{
+  uint8_t buttons = 0;
+  int16_t placeCol = -1; // 本步放置墙壁的格子，-1 表示不放置
+  int16_t placeRow = -1;
+  float aimX = 0.f; // 鼠标的世界坐标（炮塔朝向）
+  float aimY = 0.f;
+};
+
+// 状态哈希（FNV-1a，按字节累加）
+class StateHasher
+{
+public:
+  void add(const void *data, std::size_t size)
+  {
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    for (std::size_t i = 0; i < size; i++)
+    {
+      m_hash ^= bytes[i];
+      m_hash *= 1099511628211ull;
+    }
+  }
+
+  template <typename T>
+  void add(T value) { add(&value, sizeof(value)); }
+
+  uint64_t value() const { return m_hash; }
+
+private:
+  uint64_t m_hash = 1469598103934665603ull;
+};
+
+class LockstepSession
+{
+public:
+  static constexpr float TICK_DT = 1.f / 60.f;
+  static constexpr uint32_t INPUT_DELAY = 4;    // 本地输入延迟的步数（约 67ms）
+  static constexpr uint32_t HASH_INTERVAL = 30; // 每多少步比较一次状态哈希
+  static constexpr uint32_t WINDOW = 128;       // 输入缓冲的步数，对方最多领先这么多步
+
+  struct Stats
+  {
+    uint64_t ticks = 0;          // 已模拟的步数
+    uint64_t stalledFrames = 0;  // 因缺对方输入而停下的帧数
+    uint64_t inputsSent = 0;
+    uint64_t inputsReceived = 0;
+    uint64_t hashesCompared = 0;
+  };
+
+  // 开始一局；localSlot 0=房主，1=非房主。前 INPUT_DELAY 步双方都用空输入
+  void start(int localSlot);
+  void stop() { m_active = false; }
+
+  bool active() const { return m_active; }
+  int localSlot() const { return m_localSlot; }
+  int remoteSlot() const { return 1 - m_localSlot; }
+  uint32_t tick() const { return m_tick; } // 下一步要模拟的步号
+
+  // 本地输入：每模拟一步采样一次，作用于 tick() + INPUT_DELAY；返回它所属的步号
+  bool needsLocalInput() const { return m_active && m_nextLocalTick <= m_tick + INPUT_DELAY; }
+  uint32_t pushLocalInput(const LockstepInput &input);
+
+  // 对方输入（已模拟过或超出窗口的步号直接丢弃）
+  void receiveRemoteInput(uint32_t tick, const LockstepInput &input);
+
+  // 当前步双方输入是否都已到齐
+  bool ready() const;
+  const LockstepInput &input(int slot) const { return m_inputs[m_tick % WINDOW].input[slot]; }
+  void advance();
+  void noteStall() { m_stats.stalledFrames++; }
+
+  // 状态哈希
+  bool isHashTick() const { return m_tick % HASH_INTERVAL == 0; }
+  void recordLocalHash(uint32_t tick, uint64_t hash);
+  void receiveRemoteHash(uint32_t tick, uint64_t hash);
+  bool desynced() const { return m_desynced; }
+  uint32_t desyncTick() const { return m_desyncTick; }
+
+  const Stats &getStats() const { return m_stats; }
+
+private:
+  struct Slot
+  {
+    uint32_t tick = 0;
+    bool has[2] = {false, false};
+    LockstepInput input[2];
+  };
+
+  void compareHash(uint32_t tick);
+
+  bool m_active = false;
+  int m_localSlot = 0;
+  uint32_t m_tick = 0;
+  uint32_t m_nextLocalTick = 0;
+  Slot m_inputs[WINDOW];
+
+  // 尚未配对的哈希：步号 -> 哈希
+  std::map<uint32_t, uint64_t> m_localHashes;
+  std::map<uint32_t, uint64_t> m_remoteHashes;
+  bool m_desynced = false;
+  uint32_t m_desyncTick = 0;
+
+  Stats m_stats;
+};
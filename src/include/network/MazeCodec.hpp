@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 迷宫传输编码（客户端与 C++ 服务器共用，不依赖 SFML）
+// 编码数据：宽(2) + 高(2) + 符号表长度(1) + 符号表 + 游程序列
+// 游程字节：高 4 位为符号下标，低 4 位为 长度-1；低 4 位为 15 时后跟 varint(长度-16)
+// MazeChunk 消息：类型(1) + 模式标志(1) + 哈希(8) + 分块序号(2) + 分块总数(2) + 编码数据片段
+// MazeSeed 消息：类型(1) + 模式标志(1) + 算法版本(1) + 种子(4) + 宽(2) + 高(2) + 敌人数(2) + 哈希(8)
+
+// 迷宫生成参数（接收方用 MazeGenerator 按同一版本重新生成，再用哈希校验）
+struct MazeSeedParams
+{
+  uint8_t version = 0;
+  uint32_t seed = 0;
+  uint16_t width = 0;
+  uint16_t height = 0;
+  uint16_t enemyCount = 0;
+};
+
+class MazeCodec
+{
+public:
+  static constexpr std::size_t CHUNK_HEADER_SIZE = 14;
+  static constexpr std::size_t SEED_MESSAGE_SIZE = 21;
+  static constexpr std::size_t CHUNK_PAYLOAD_SIZE = 16 * 1024;
+  static constexpr std::size_t MAX_SYMBOLS = 16;
+  // 宽高上限（远大于游戏里的地图）：解码来自网络的数据时防止按伪造的尺寸分配内存
+  static constexpr std::size_t MAX_DIMENSION = 1024;
+  // 最坏情况（每格一个游程字节）下的分块数
+  static constexpr std::size_t MAX_CHUNKS =
+      (5 + MAX_SYMBOLS + MAX_DIMENSION * MAX_DIMENSION + CHUNK_PAYLOAD_SIZE - 1) / CHUNK_PAYLOAD_SIZE;
+
+  // FNV-1a 64 位哈希（覆盖宽高与全部格子）
+  static uint64_t hash(const std::vector<std::string> &rows);
+
+  // 行宽不一致、宽高超过 MAX_DIMENSION 或符号超过 16 种时返回 false
+  static bool encode(const std::vector<std::string> &rows, std::vector<uint8_t> &out);
+  static bool decode(const uint8_t *data, std::size_t len, std::vector<std::string> &rows);
+
+  // 编码并切分为 MazeChunk 消息，失败时返回空
+  static std::vector<std::vector<uint8_t>> buildChunks(const std::vector<std::string> &rows, uint8_t modeFlags,
+                                                       uint64_t &hashOut);
+
+  static std::vector<uint8_t> buildSeedMessage(const MazeSeedParams &params, uint8_t modeFlags, uint64_t hash);
+  static bool parseSeedMessage(const std::vector<uint8_t> &message, MazeSeedParams &params, uint8_t &modeFlags,
+                               uint64_t &hash);
+
+  static void writeHash(std::vector<uint8_t> &out, uint64_t hash);
+  static uint64_t readHash(const uint8_t *data);
+};
+
+// MazeChunk 重组：哈希或分块数变化时丢弃旧分块
+class MazeChunkAssembler
+{
+public:
+  // 消息格式错误时返回 false
+  bool add(const std::vector<uint8_t> &message);
+  bool complete() const { return !m_chunks.empty() && m_received == m_chunks.size(); }
+  void clear();
+
+  uint64_t hash() const { return m_hash; }
+  uint8_t modeFlags() const { return m_modeFlags; }
+
+  // 原始 MazeChunk 消息（服务器缓存后原样转发）
+  const std::vector<std::vector<uint8_t>> &chunks() const { return m_chunks; }
+
+  // 拼接并解码，校验哈希
+  bool decode(std::vector<std::string> &rows) const;
+
+private:
+  uint64_t m_hash = 0;
+  uint8_t m_modeFlags = 0;
+  std::vector<std::vector<uint8_t>> m_chunks;
+  std::size_t m_received = 0;
+};
@@ -1,6 +1,9 @@
 #pragma once
 
 #include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <deque>
+#include <utility>
 #include <vector>
 #include <memory>
 #include <string>
@@ -10,6 +13,12 @@
 #include "Enemy.hpp"
 #include "Maze.hpp"
 #include "NetworkManager.hpp"
+#include "SnapshotBuffer.hpp"
+#include "Lockstep.hpp"
+#include "AIScheduler.hpp"
+#include "CrowdSteering.hpp"
+#include "InterestManager.hpp"
+#include "UILayer.hpp"
 
 // 多人模式状态
 struct MultiplayerState
@@ -25,6 +34,7 @@ struct MultiplayerState
   int nearbyNpcIndex = -1;
   bool rKeyJustPressed = false;
   std::vector<std::string> generatedMazeData;
+  MazeSeedParams generatedMazeSeed; // 房主生成地图的种子与参数（version 为 0 表示只能整图传输）
 
   // Escape 模式相关
   bool isEscapeMode = false;    // 是否是 Escape 模式（否则是 Battle 模式）
@@ -53,6 +63,54 @@ struct MultiplayerState
   int mazeWidth = 41;             // 迷宫宽度
   int mazeHeight = 31;            // 迷宫高度
   bool isDarkMode = false;        // 是否是暗黑模式
+
+  // 服务器权威模拟：NPC AI、墙壁与全部伤害由服务器负责，双方都按非房主逻辑运行
+  bool serverAuthoritative = false;
+  bool ownsWorldSimulation() const { return isHost && !serverAuthoritative; }
+
+  // 服务器权威模拟下本方坦克：只上报输入，本地先行预测，收到服务器状态后校正
+  uint32_t inputSeq = 0;          // 最近一次上报的输入序号
+  uint8_t lastSentButtons = 0;
+  float inputSendTimer = 0.f;
+  std::deque<std::pair<uint32_t, sf::Vector2f>> predictedPositions; // 每次上报输入时的预测位置
+  bool hasServerPlayerState = false;  // 收到了尚未应用的服务器状态
+  uint32_t serverInputSeq = 0;        // 服务器处理到的输入序号
+  PlayerState serverPlayerState;
+
+  // 远程实体插值缓冲（对方坦克；NPC 仅非房主使用，下标为 NPC ID）
+  SnapshotBuffer otherPlayerSnapshots;
+  std::vector<SnapshotBuffer> npcSnapshots;
+
+  // 对方最近一次 PlayerUpdate 的位置（房主据此做 NPC 同步的关注区域）
+  sf::Vector2f remotePlayerPos;
+  bool hasRemotePlayerPos = false;
+
+  // 帧同步模式：双方各自运行完整模拟，只交换每步输入（见 Lockstep.hpp）
+  bool lockstep = false;
+  LockstepSession lockstepSession;
+  float lockstepAccumulator = 0.f;
+  int pendingPlaceCol = -1; // 放置模式下点击的格子，随下一次输入发出
+  int pendingPlaceRow = -1;
+  uint32_t reportedDesyncTick = UINT32_MAX; // 已报告过的失步 tick，每局开始时重置
+
+  // 帧同步模式下每个玩家的模拟状态，按槽位存放（0=房主，1=非房主），每帧映射到上面的显示字段
+  struct LockstepPlayer
+  {
+    bool dead = false;
+    bool reachedExit = false;
+    float exitHold = 0.f; // 在终点按住 E 的秒数
+    float rescue = 0.f;   // 正在救援对方的秒数
+  };
+  LockstepPlayer lockstepPlayers[2];
+
+  // 断线重连（见 SessionResume.hpp）：本方重连中时暂停本地模拟；对方掉线时显示剩余保留时间
+  bool reconnecting = false;
+  bool peerDropped = false;
+  float peerDropTimer = 0.f;
+
+  // 网络诊断面板（F3 切换）
+  bool showNetStats = false;
+  float frameTimeMs = 0.f; // 平滑后的本地帧耗时
 };
 
 // 多人游戏渲染和更新所需的上下文
@@ -65,6 +123,7 @@ struct MultiplayerContext
   Tank *player;
   Tank *otherPlayer;
   std::vector<std::unique_ptr<Enemy>> &enemies;
+  EntityStore &entities; // 坦克与 NPC 的热数据（enemies 与玩家都是它的视图）
   std::vector<std::unique_ptr<Bullet>> &bullets;
   Maze &maze;
   unsigned int screenWidth;
@@ -112,6 +171,34 @@ public:
       MultiplayerContext &ctx,
       MultiplayerState &state);
 
+  // 每局开始时调用：重置 NPC AI 调度（帧同步模式下两端必须从相同状态开始）
+  static void beginMatch(MultiplayerState &state);
+
+  // 断线重连：本方当前状态（随 ResumeSession 发出）
+  static ResumePlayer captureLocalPlayer(
+      MultiplayerContext &ctx,
+      MultiplayerState &state);
+
+  // 留下的一方：把重连方上报的状态应用到对方坦克，再序列化当前对局
+  static void applyRemoteResumePlayer(
+      MultiplayerContext &ctx,
+      MultiplayerState &state,
+      const ResumePlayer &player);
+  static ResumeSnapshot captureResumeSnapshot(
+      MultiplayerContext &ctx,
+      MultiplayerState &state);
+
+  // 重连方：地图与 NPC 数量已与快照一致后，应用墙体、NPC 与双方状态
+  static void applyResumeSnapshot(
+      MultiplayerContext &ctx,
+      MultiplayerState &state,
+      const ResumeSnapshot &snapshot);
+
+  // 按插值缓冲更新对方坦克和NPC（非房主）的显示位置（非帧同步模式每帧调用）
+  static void applyRemoteSnapshots(
+      MultiplayerContext &ctx,
+      MultiplayerState &state);
+
   // 清理静态资源（在程序退出前调用）
   static void cleanup();
 
@@ -122,6 +209,45 @@ private:
       MultiplayerState &state,
       float dt);
 
+  // NPC 目标选择、移动与射击；tanks/dead 按 房主、非房主 的顺序，broadcast 为 false 时不发送同步消息
+  static void simulateNpcs(
+      MultiplayerContext &ctx,
+      MultiplayerState &state,
+      float dt,
+      Tank *const tanks[2],
+      const bool dead[2],
+      bool broadcast);
+
+  // 帧同步模式的每帧更新：采样并发送本地输入，按固定步长推进双方输入都已到齐的步
+  static void updateLockstep(
+      MultiplayerContext &ctx,
+      MultiplayerState &state,
+      float dt,
+      const std::function<void()> &onVictory,
+      const std::function<void()> &onDefeat);
+
+  // 按双方输入模拟一步；返回 1=本地胜利，-1=本地失败，0=继续
+  static int simulateLockstepTick(
+      MultiplayerContext &ctx,
+      MultiplayerState &state,
+      Tank *const tanks[2]);
+
+  // 帧同步状态哈希：实体存储、子弹与双方的模拟状态
+  static uint64_t hashLockstepState(
+      MultiplayerContext &ctx,
+      MultiplayerState &state,
+      Tank *const tanks[2]);
+
+  // 服务器权威模拟：上报本方输入，并按服务器状态校正本地预测与血量
+  static void sendServerInput(
+      MultiplayerContext &ctx,
+      MultiplayerState &state,
+      float dt,
+      sf::Vector2f aim);
+  static void reconcileWithServer(
+      MultiplayerContext &ctx,
+      MultiplayerState &state);
+
   // 检查玩家接近的NPC（用于激活提示）
   static void checkNearbyNpc(
       MultiplayerContext &ctx,
@@ -147,10 +273,25 @@ private:
       MultiplayerContext &ctx,
       MultiplayerState &state);
 
+  // 渲染网络诊断面板（RTT、收发速率与按消息类型的流量）
+  static void renderNetStats(
+      MultiplayerContext &ctx,
+      MultiplayerState &state);
+
   // 渲染暗黑模式遮罩
   static void renderDarkModeOverlay(
       MultiplayerContext &ctx);
 
+  // 房主 NPC AI 分级调度（静态成员）
+  static AIScheduler s_aiScheduler;
+  static CrowdSteering s_crowd; // 房主 NPC 群体避让
+  static InterestManager s_interest; // 房主按对方位置给 NPC 同步分级
+
+  // 保留模式 HUD 与小地图文字（首次渲染时按 ctx.font 创建）
+  static std::unique_ptr<UILayer> s_hudUI;
+  static std::unique_ptr<UILayer> s_minimapUI;
+  static std::unique_ptr<UILayer> s_netStatsUI;
+
   // 暗黑模式遮罩纹理（静态成员）
   static std::unique_ptr<sf::Texture> s_darkModeTexture;
   static std::unique_ptr<sf::Sprite> s_darkModeSprite;
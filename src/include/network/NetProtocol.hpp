@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// 网络协议定义（客户端与 C++ 服务器共用，不依赖 SFML）
+// 帧格式：长度(2字节, 小端) + 消息类型(1字节) + 负载
+// server/server.js 中的 MessageType 必须与此保持一致
+
+// 网络消息类型
+enum class NetMessageType : uint8_t
+{
+  // 连接相关
+  Connect = 1,
+  ConnectAck,
+  Disconnect,
+
+  // 游戏房间
+  CreateRoom,
+  JoinRoom,
+  RoomCreated,
+  RoomJoined,
+  RoomError,
+  GameStart, // 附带权威模拟标志、帧同步标志与断线重连令牌（4 字节）
+
+  // 游戏状态同步
+  PlayerUpdate,   // 玩家位置、角度等
+  PlayerShoot,    // 玩家射击
+  MazeData,       // 迷宫数据
+  RequestMaze,    // 请求迷宫数据
+  ReachExit,      // 到达终点
+  GameWin,        // 游戏胜利（先到终点）
+  GameResult,     // 游戏结果（胜/负）
+  RestartRequest, // 重新开始请求
+
+  // NPC同步
+  NpcActivate, // NPC激活
+  NpcUpdate,   // NPC状态更新（位置、血量等）
+  NpcShoot,    // NPC射击
+  NpcDamage,   // NPC受伤
+
+  // 墙壁放置同步
+  WallPlace, // 放置墙壁
+
+  // 音乐同步
+  ClimaxStart, // 开始播放高潮BGM
+
+  // 玩家离开
+  PlayerLeft, // 对方玩家离开房间
+
+  // Escape 模式救援
+  RescueStart,    // 开始救援
+  RescueProgress, // 救援进度
+  RescueComplete, // 救援完成
+  RescueCancel,   // 取消救援
+
+  // 房间大厅
+  PlayerReady,   // 玩家准备就绪
+  HostStartGame, // 房主开始游戏
+  RoomInfo,      // 房间信息同步
+
+  // 墙壁伤害同步
+  WallDamage, // 墙壁受到伤害
+
+  // UDP 通道
+  UdpHello, // UDP 握手（携带会话ID，服务器据此绑定 UDP 端点）
+
+  // 分块迷宫传输（编码见 MazeCodec.hpp）
+  MazeChunk, // 迷宫分块
+  MazeOffer, // 房主声明迷宫哈希，服务器已缓存则直接复用，否则回复 RequestMaze(哈希)
+  MazeSeed,  // 迷宫种子与参数，对方本地重新生成；版本或哈希不符时回复 RequestMaze(哈希) 改为分块传输
+
+  // 帧同步模式（见 Lockstep.hpp）
+  InputFrame, // 某一步的输入：步号(4) + 按键(1) + 放置格子列/行(2+2) + 瞄准点(4+4)
+  StateHash,  // 某一步的状态哈希：步号(4) + 哈希(8)
+
+  // 网络诊断（见 NetStats.hpp）
+  Ping, // 序号(4) + 发送时间(4, 微秒)，服务器直接回复 Pong
+  Pong, // 原样带回 Ping 的负载
+
+  // 断线重连（见 SessionResume.hpp）
+  ResumeSession,  // 掉线方重连：房间码 + 令牌 + 本方玩家状态
+  ResumeRequest,  // 服务器 -> 留下的一方：对方已重连（附带其玩家状态），请回复快照
+  ResumeSnapshot, // 留下的一方 -> 服务器 -> 重连方：完整对局快照
+  PeerDropped,    // 服务器 -> 留下的一方：对方意外掉线，位置保留的秒数(1)
+
+  // 墙体变化批量同步（见 WallBatch.hpp），取代逐条的 WallDamage / WallPlace
+  WallBatch,
+
+  // 服务器权威模拟（见 ServerSimulation.hpp）：客户端只上报输入，玩家移动与伤害由服务器结算
+  PlayerInput,    // 客户端 -> 服务器：输入序号(4) + 按键(1) + 瞄准点(4+4) + 标志(1, 1=已到达终点)
+  PlayerSnapshot, // 服务器 -> 客户端：对象(1, 0=接收方自己 1=对方) + 已处理的输入序号(4) + 位置(4+4) + 车身/炮塔角(4+4) + 血量(4) + 标志(1) + 模拟时间(4)
+};
+
+// 帧头长度与最大负载
+constexpr std::size_t NET_FRAME_HEADER_SIZE = 2;
+constexpr std::size_t NET_MAX_FRAME_PAYLOAD = 0xFFFF;
+
+// UDP 数据报头：类型(1) + 序号(4)
+constexpr std::size_t NET_DATAGRAM_HEADER_SIZE = 5;
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// 网络诊断统计（不依赖 SFML）
+// 按收发方向和消息类型统计累计值与最近 1 秒的字节数/消息数，字节按线上大小计
+// （TCP 含 2 字节帧头，UDP 为整个数据报）。最近 1 秒由 BUCKETS 个小段滚动得到，正在累加的一段不计入速率。
+// RTT 由 Ping/Pong 测得：平滑值同 TCP（RFC 6298），抖动为相邻样本差的平滑均值（RFC 3550）。
+
+enum class NetDirection : uint8_t
+{
+  Sent = 0,
+  Received = 1
+};
+
+class NetStats
+{
+public:
+  static constexpr int BUCKETS = 5;              // 4 段已完成 + 1 段正在累加
+  static constexpr float BUCKET_SECONDS = 0.25f; // 每段时长
+  static constexpr float WINDOW_SECONDS = (BUCKETS - 1) * BUCKET_SECONDS;
+
+  struct Counter
+  {
+    uint64_t messages = 0;
+    uint64_t bytes = 0;
+  };
+
+  struct Rate
+  {
+    float messagesPerSec = 0.f;
+    float bytesPerSec = 0.f;
+  };
+
+  struct Rtt
+  {
+    float lastMs = 0.f;
+    float smoothedMs = 0.f;
+    float jitterMs = 0.f;
+    float minMs = 0.f;
+    uint64_t samples = 0;
+  };
+
+  void reset(float now);
+
+  // 记录一条收发的消息；now 为秒，单调递增
+  void record(NetDirection dir, uint8_t type, std::size_t bytes, bool udp, float now);
+
+  // 推进滚动窗口（没有流量时也要调用，速率才会回落）
+  void advance(float now);
+
+  void addRttSample(float rttMs);
+  const Rtt &rtt() const { return m_rtt; }
+
+  // 单个类型 / 整个方向的累计值与最近 1 秒速率
+  const Counter &total(NetDirection dir, uint8_t type) const { return m_types[index(dir)][type].total; }
+  Counter total(NetDirection dir) const;
+  const Counter &udpTotal(NetDirection dir) const { return m_udp[index(dir)]; }
+  Rate rate(NetDirection dir, uint8_t type) const;
+  Rate rate(NetDirection dir) const;
+
+  // 单行 JSON（供压力测试脚本解析），只列出出现过的消息类型
+  std::string toJson(float now) const;
+
+  static const char *typeName(uint8_t type);
+
+private:
+  struct TypeCounters
+  {
+    Counter total;
+    uint32_t bucketMessages[BUCKETS] = {};
+    uint32_t bucketBytes[BUCKETS] = {};
+  };
+
+  static int index(NetDirection dir) { return static_cast<int>(dir); }
+  void appendDirectionJson(std::string &out, NetDirection dir) const;
+
+  TypeCounters m_types[2][256];
+  Counter m_udp[2];
+  int m_bucket = 0;          // 正在累加的段
+  float m_bucketStart = 0.f; // 当前段的开始时间
+  Rtt m_rtt;
+};
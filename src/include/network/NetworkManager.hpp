@@ -2,67 +2,22 @@
 
 #include <SFML/Graphics.hpp>
 #include <SFML/Network.hpp>
+#include <cstdio>
 #include <string>
 #include <vector>
 #include <queue>
 #include <mutex>
 #include <functional>
-
-// 网络消息类型
-enum class NetMessageType : uint8_t
-{
-  // 连接相关
-  Connect = 1,
-  ConnectAck,
-  Disconnect,
-
-  // 游戏房间
-  CreateRoom,
-  JoinRoom,
-  RoomCreated,
-  RoomJoined,
-  RoomError,
-  GameStart,
-
-  // 游戏状态同步
-  PlayerUpdate,   // 玩家位置、角度等
-  PlayerShoot,    // 玩家射击
-  MazeData,       // 迷宫数据
-  RequestMaze,    // 请求迷宫数据
-  ReachExit,      // 到达终点
-  GameWin,        // 游戏胜利（先到终点）
-  GameResult,     // 游戏结果（胜/负）
-  RestartRequest, // 重新开始请求
-
-  // NPC同步
-  NpcActivate, // NPC激活
-  NpcUpdate,   // NPC状态更新（位置、血量等）
-  NpcShoot,    // NPC射击
-  NpcDamage,   // NPC受伤
-
-  // 墙壁放置同步
-  WallPlace, // 放置墙壁
-
-  // 音乐同步
-  ClimaxStart, // 开始播放高潮BGM
-
-  // 玩家离开
-  PlayerLeft, // 对方玩家离开房间
-
-  // Escape 模式救援
-  RescueStart,    // 开始救援
-  RescueProgress, // 救援进度
-  RescueComplete, // 救援完成
-  RescueCancel,   // 取消救援
-
-  // 房间大厅
-  PlayerReady,   // 玩家准备就绪
-  HostStartGame, // 房主开始游戏
-  RoomInfo,      // 房间信息同步
-
-  // 墙壁伤害同步
-  WallDamage, // 墙壁受到伤害
-};
+#include <map>
+#include <optional>
+#include <random>
+#include <unordered_map>
+#include "NetProtocol.hpp"
+#include "MazeCodec.hpp"
+#include "Lockstep.hpp"
+#include "NetStats.hpp"
+#include "SessionResume.hpp"
+#include "WallBatch.hpp"
 
 // 玩家状态数据
 struct PlayerState
@@ -72,7 +27,8 @@ struct PlayerState
   float turretAngle = 0;
   float health = 100;
   bool reachedExit = false;
-  bool isDead = false; // 是否已死亡（可被救援）
+  bool isDead = false;    // 是否已死亡（可被救援）
+  float timestamp = 0.f; // 发送方网络时钟（秒），0 表示未携带
 };
 
 // NPC状态数据
@@ -85,6 +41,7 @@ struct NpcState
   float health = 100;
   int team = 0;
   bool activated = false;
+  float timestamp = 0.f; // 发送方网络时钟（秒），0 表示未携带
 };
 
 // 回调类型
@@ -97,6 +54,7 @@ using OnMazeDataCallback = std::function<void(const std::vector<std::string> &ma
 using OnRequestMazeCallback = std::function<void()>;
 using OnPlayerUpdateCallback = std::function<void(const PlayerState &state)>;
 using OnPlayerShootCallback = std::function<void(float x, float y, float angle)>;
+using OnServerPlayerStateCallback = std::function<void(uint32_t inputSeq, const PlayerState &state)>;
 using OnGameResultCallback = std::function<void(bool isWinner)>;
 using OnRestartRequestCallback = std::function<void()>;
 using OnErrorCallback = std::function<void(const std::string &error)>;
@@ -115,6 +73,13 @@ using OnGameModeReceivedCallback = std::function<void(bool isEscapeMode)>;
 using OnPlayerReadyCallback = std::function<void(bool isReady)>;
 using OnRoomInfoCallback = std::function<void(const std::string &hostIP, const std::string &guestIP, bool guestReady, bool isDarkMode)>;
 using OnWallDamageCallback = std::function<void(int row, int col, float damage, bool destroyed, int attribute, int destroyerId)>;
+using OnWallBatchCallback = std::function<void(const std::vector<WallBatchEntry> &entries)>;
+using OnLockstepInputCallback = std::function<void(uint32_t tick, const LockstepInput &input)>;
+using OnStateHashCallback = std::function<void(uint32_t tick, uint64_t hash)>;
+using OnReconnectingCallback = std::function<void()>;
+using OnPeerDroppedCallback = std::function<void(float graceSeconds)>;
+using OnResumeRequestCallback = std::function<void(const ResumePlayer &player)>;
+using OnResumeSnapshotCallback = std::function<void(const ResumeSnapshot &snapshot)>;
 
 class NetworkManager
 {
@@ -134,12 +99,16 @@ public:
   void createRoom(int mazeWidth, int mazeHeight, bool isDarkMode = false);
   void joinRoom(const std::string &roomCode);
 
-  // 发送迷宫数据（房主调用）
-  void sendMazeData(const std::vector<std::string> &mazeData, bool isEscapeMode = false, bool isDarkMode = false);
+  // 发送迷宫数据（房主调用）：带有效种子（version 非 0）时只发 MazeSeed，对方本地重新生成；
+  // 否则游程编码后分块发送，同一迷宫再次发送时只发哈希
+  void sendMazeData(const std::vector<std::string> &mazeData, bool isEscapeMode = false, bool isDarkMode = false,
+                    const MazeSeedParams &seed = {});
 
   // 发送游戏数据
   void sendPosition(const PlayerState &state);
   void sendShoot(float x, float y, float angle);
+  // 服务器权威模拟：只上报输入（按键位同 Tank::INPUT_*），自己的位置与血量以服务器快照为准
+  void sendPlayerInput(uint32_t seq, uint8_t buttons, sf::Vector2f aim, bool reachedExit);
   void sendReachExit();
   void sendGameResult(bool localWin); // 发送游戏结果
   void sendRestartRequest();          // 发送重新开始请求
@@ -151,9 +120,10 @@ public:
   void sendNpcDamage(int npcId, float damage);                     // 发送NPC受伤
   void sendClimaxStart();                                          // 发送开始播放高潮BGM
 
-  // 墙壁放置同步
-  void sendWallPlace(float x, float y);                                                                // 发送墙壁放置
-  void sendWallDamage(int row, int col, float damage, bool destroyed, int attribute, int destroyerId); // 发送墙壁伤害，destroyerId: 0=房主, 1=非房主
+  // 墙壁同步：放置与伤害先进入本帧的批次（同一格子的多次命中合并），每帧末尾 flushWallBatch 发出一条 WallBatch
+  void queueWallPlace(int row, int col);                                                                // 墙壁放置
+  void queueWallDamage(int row, int col, float damage, bool destroyed, int attribute, int destroyerId); // 墙壁伤害，destroyerId: 0=房主, 1=非房主
+  void flushWallBatch();
 
   // 救援同步
   void sendRescueStart();                  // 开始救援
@@ -161,6 +131,10 @@ public:
   void sendRescueComplete();               // 救援完成
   void sendRescueCancel();                 // 取消救援
 
+  // 帧同步：每步输入与周期性状态哈希（走 TCP，必须按序可靠到达）
+  void sendLockstepInput(uint32_t tick, const LockstepInput &input);
+  void sendStateHash(uint32_t tick, uint64_t hash);
+
   // 房间大厅
   void sendPlayerReady(bool isReady); // 发送准备状态
   void sendHostStartGame();           // 房主发起开始游戏
@@ -168,6 +142,37 @@ public:
   // 处理网络消息（在主线程调用）
   void update();
 
+  // UDP 传输：高频状态消息（PlayerUpdate/NpcUpdate/PlayerShoot/NpcShoot/PlayerInput/PlayerSnapshot）走 UDP，
+  // 握手未完成或被禁用时自动回退到 TCP
+  void setUdpEnabled(bool enabled) { m_udpEnabled = enabled; }
+  bool isUdpActive() const { return m_udpEnabled && m_udpReady; }
+
+  // 本地网络模拟（作用于接收端）：lossRate 0-1，latency/jitter 单位毫秒
+  // UDP 丢包直接丢弃；TCP 丢包按重传超时延迟，且保持顺序（模拟队头阻塞）
+  void setNetworkSimulation(float lossRate, float latencyMs, float jitterMs);
+
+  // 服务器权威模拟：创建房间时请求由服务器运行 NPC AI 与碰撞（仅原生服务器支持）
+  // 是否生效以 GameStart 附带的标志为准
+  void setServerSimulationRequested(bool requested) { m_serverSimRequested = requested; }
+  bool isServerAuthoritative() const { return m_serverAuthoritative; }
+
+  // 帧同步模式：创建房间时请求，是否生效以 GameStart 附带的标志为准（优先于服务器权威模拟）
+  void setLockstepRequested(bool requested) { m_lockstepRequested = requested; }
+  bool isLockstep() const { return m_lockstep; }
+
+  // 网络诊断：每秒向服务器发一次 Ping 测 RTT，收发消息按类型计数（见 NetStats.hpp）
+  // 设置了路径时每秒追加一行 JSON，断开连接时再写最后一行
+  const NetStats &getStats() const { return m_stats; }
+  void setStatsDumpPath(const std::string &path) { m_statsDumpPath = path; }
+
+  // 断线重连（见 SessionResume.hpp）：对局中连接意外断开时不立即回调 onDisconnected，
+  // 而是在保留期内每秒重连一次并发送 ResumeSession；收到快照或放弃（超时、服务器拒绝）后结束
+  bool isResuming() const { return m_resuming; }
+  // 重连时取本方当前状态（位置、血量、金币等）随 ResumeSession 发出
+  void setResumePlayerProvider(std::function<ResumePlayer()> provider) { m_resumePlayerProvider = provider; }
+  // 对方请求重连时由留下的一方发送当前对局快照
+  void sendResumeSnapshot(const ResumeSnapshot &snapshot);
+
   // 设置回调
   void setOnConnected(OnConnectedCallback cb) { m_onConnected = cb; }
   void setOnDisconnected(OnDisconnectedCallback cb) { m_onDisconnected = cb; }
@@ -178,6 +183,8 @@ public:
   void setOnRequestMaze(OnRequestMazeCallback cb) { m_onRequestMaze = cb; }
   void setOnPlayerUpdate(OnPlayerUpdateCallback cb) { m_onPlayerUpdate = cb; }
   void setOnPlayerShoot(OnPlayerShootCallback cb) { m_onPlayerShoot = cb; }
+  // 服务器权威模拟：本方坦克的服务器状态（对方坦克的快照走 onPlayerUpdate）
+  void setOnServerPlayerState(OnServerPlayerStateCallback cb) { m_onServerPlayerState = cb; }
   void setOnGameResult(OnGameResultCallback cb) { m_onGameResult = cb; }
   void setOnRestartRequest(OnRestartRequestCallback cb) { m_onRestartRequest = cb; }
   void setOnError(OnErrorCallback cb) { m_onError = cb; }
@@ -189,6 +196,7 @@ public:
   void setOnClimaxStart(OnClimaxStartCallback cb) { m_onClimaxStart = cb; }
   void setOnWallPlace(OnWallPlaceCallback cb) { m_onWallPlace = cb; }
   void setOnWallDamage(OnWallDamageCallback cb) { m_onWallDamage = cb; }
+  void setOnWallBatch(OnWallBatchCallback cb) { m_onWallBatch = cb; }
   void setOnRescueStart(OnRescueStartCallback cb) { m_onRescueStart = cb; }
   void setOnRescueProgress(OnRescueProgressCallback cb) { m_onRescueProgress = cb; }
   void setOnRescueComplete(OnRescueCompleteCallback cb) { m_onRescueComplete = cb; }
@@ -196,16 +204,36 @@ public:
   void setOnGameModeReceived(OnGameModeReceivedCallback cb) { m_onGameModeReceived = cb; }
   void setOnPlayerReady(OnPlayerReadyCallback cb) { m_onPlayerReady = cb; }
   void setOnRoomInfo(OnRoomInfoCallback cb) { m_onRoomInfo = cb; }
+  void setOnLockstepInput(OnLockstepInputCallback cb) { m_onLockstepInput = cb; }
+  void setOnStateHash(OnStateHashCallback cb) { m_onStateHash = cb; }
+  void setOnReconnecting(OnReconnectingCallback cb) { m_onReconnecting = cb; }
+  void setOnPeerDropped(OnPeerDroppedCallback cb) { m_onPeerDropped = cb; }
+  void setOnResumeRequest(OnResumeRequestCallback cb) { m_onResumeRequest = cb; }
+  void setOnResumeSnapshot(OnResumeSnapshotCallback cb) { m_onResumeSnapshot = cb; }
 
   std::string getRoomCode() const { return m_roomCode; }
 
+  // 本地网络时钟（秒），用于快照时间戳
+  float getNetworkTime() const { return m_netClock.getElapsedTime().asSeconds(); }
+
 private:
   NetworkManager() = default;
   ~NetworkManager() { disconnect(); }
 
   void sendPacket(const std::vector<uint8_t> &data);
+  void sendStatePacket(const std::vector<uint8_t> &data); // 高频状态消息，优先走 UDP
+  void sendUdpHello();
   void receiveData();
+  void receiveDatagrams();
+  void deliverMessage(std::vector<uint8_t> &&data, bool fromUdp, uint32_t seq); // 经过网络模拟后分发
+  void flushDelayedMessages();
+  bool isStaleDatagram(const std::vector<uint8_t> &data, uint32_t seq);
   void processMessage(const std::vector<uint8_t> &data);
+  void sendPing();
+  void writeStatsDump();
+  bool openSockets(const sf::IpAddress &address, unsigned short port, sf::Time timeout);
+  void beginResume();
+  void updateResume();
 
   sf::TcpSocket m_socket;
   bool m_connected = false;
@@ -214,6 +242,77 @@ private:
   // 接收缓冲区
   std::vector<uint8_t> m_receiveBuffer;
 
+  // 网络时钟（快照时间戳）
+  sf::Clock m_netClock;
+
+  // UDP 通道
+  sf::UdpSocket m_udpSocket;
+  std::optional<sf::IpAddress> m_serverAddress;
+  unsigned short m_serverPort = 0;
+  bool m_udpEnabled = true;
+  bool m_udpReady = false;   // 服务器已确认 UDP 端点
+  uint32_t m_sessionId = 0;  // ConnectAck 下发的会话ID
+  uint32_t m_udpSendSeq = 0; // 发送序号（每个数据报递增）
+  int m_udpHelloAttempts = 0;
+  sf::Clock m_udpHelloClock;
+  std::unordered_map<uint16_t, uint32_t> m_lastUdpSeq; // (类型<<8 | 实体ID) -> 已处理的最新序号
+
+  // 分块迷宫传输
+  void resetMazeTransfer();
+  void sendMazeChunks();
+  void handleMazeSeed(const std::vector<uint8_t> &data);
+  void deliverMaze(const std::vector<std::string> &mazeData, uint8_t modeFlags);
+  MazeChunkAssembler m_incomingMaze;
+  std::vector<std::vector<uint8_t>> m_outgoingMazeChunks;
+  uint64_t m_outgoingMazeHash = 0;
+  uint8_t m_outgoingMazeFlags = 0;
+  bool m_mazeUploaded = false; // 服务器已收到当前迷宫的全部分块
+
+  // 服务器权威模拟
+  bool m_serverSimRequested = false;
+  bool m_serverAuthoritative = false;
+
+  // 帧同步模式
+  bool m_lockstepRequested = false;
+  bool m_lockstep = false;
+
+  // 网络诊断
+  static constexpr float PING_INTERVAL = 1.f;       // 秒
+  static constexpr float STATS_DUMP_INTERVAL = 1.f; // 秒
+  NetStats m_stats;
+  uint32_t m_pingSeq = 0;
+  float m_lastPingAt = 0.f;
+  std::string m_statsDumpPath;
+  std::FILE *m_statsDump = nullptr;
+  float m_lastStatsDumpAt = 0.f;
+
+  // 本帧待发送的墙体变化
+  WallBatch m_wallBatch;
+
+  // 断线重连
+  static constexpr float RESUME_RETRY_INTERVAL = 1.f;    // 秒
+  static constexpr float RESUME_CONNECT_TIMEOUT = 0.5f;  // 秒，重连时阻塞主线程的上限
+  uint32_t m_resumeToken = 0; // GameStart 下发，0 表示本局不支持重连
+  bool m_resuming = false; // 重连中或已发出 ResumeSession 等待快照
+  float m_resumeDeadline = 0.f;
+  float m_lastResumeAttemptAt = 0.f;
+  std::function<ResumePlayer()> m_resumePlayerProvider;
+
+  // 网络模拟
+  struct DelayedMessage
+  {
+    std::vector<uint8_t> data;
+    bool fromUdp = false;
+    uint32_t seq = 0;
+  };
+  float m_simLossRate = 0.f;
+  float m_simLatencyMs = 0.f;
+  float m_simJitterMs = 0.f;
+  float m_lastReliableDeliverAt = 0.f;                    // TCP 按序到达
+  std::multimap<float, DelayedMessage> m_delayedMessages; // 到达时间 -> 消息
+  sf::Clock m_simClock;
+  std::mt19937 m_simRng{std::random_device{}()};
+
   // 回调
   OnConnectedCallback m_onConnected;
   OnDisconnectedCallback m_onDisconnected;
@@ -224,6 +323,7 @@ private:
   OnRequestMazeCallback m_onRequestMaze;
   OnPlayerUpdateCallback m_onPlayerUpdate;
   OnPlayerShootCallback m_onPlayerShoot;
+  OnServerPlayerStateCallback m_onServerPlayerState;
   OnGameResultCallback m_onGameResult;
   OnRestartRequestCallback m_onRestartRequest;
   OnErrorCallback m_onError;
@@ -235,6 +335,7 @@ private:
   OnClimaxStartCallback m_onClimaxStart;
   OnWallPlaceCallback m_onWallPlace;
   OnWallDamageCallback m_onWallDamage;
+  OnWallBatchCallback m_onWallBatch;
   OnRescueStartCallback m_onRescueStart;
   OnRescueProgressCallback m_onRescueProgress;
   OnRescueCompleteCallback m_onRescueComplete;
@@ -242,4 +343,10 @@ private:
   OnGameModeReceivedCallback m_onGameModeReceived;
   OnPlayerReadyCallback m_onPlayerReady;
   OnRoomInfoCallback m_onRoomInfo;
+  OnLockstepInputCallback m_onLockstepInput;
+  OnStateHashCallback m_onStateHash;
+  OnReconnectingCallback m_onReconnecting;
+  OnPeerDroppedCallback m_onPeerDropped;
+  OnResumeRequestCallback m_onResumeRequest;
+  OnResumeSnapshotCallback m_onResumeSnapshot;
 };
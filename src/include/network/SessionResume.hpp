@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "MazeCodec.hpp"
+
+// 断线重连（客户端与 C++ 服务器共用，不依赖 SFML）
+// 游戏开始时服务器给每个玩家一个令牌（附在 GameStart 后）。对局中意外掉线时服务器保留该位置 RESUME_GRACE_SECONDS 秒，
+// 掉线方重连后发送 ResumeSession(房间码 + 令牌 + 本方状态)，服务器转给留下的一方（ResumeRequest），
+// 对方把当前对局序列化为 ResumeSnapshot 经服务器转发，重连方载入后继续游戏。
+//
+// ResumeSession：类型(1) + 房间码长度(1) + 房间码 + 令牌(4) + 玩家状态
+// ResumeRequest：类型(1) + 玩家状态（原样转发）
+// ResumeSnapshot：类型(1) + 格式版本(1) + 模式标志(1) + 地图哈希(8) + 种子参数(11) + 整图长度(2) + 整图编码
+//                 + 行(2) + 列(2) + 变化位图 + 每个变化格子：状态(1)[+ 血量(1)] + NPC 数(1) + NPC 状态 + 双方玩家状态
+// 玩家状态：x, y, 车身角度, 炮塔角度, 血量(各 4) + 标志(1) + 金币(2) + 背包墙数(2)
+// NPC 状态：x, y, 车身角度, 炮塔角度, 血量(各 4) + 阵营(1) + 标志(1) + 激活者+128(1)
+
+constexpr float RESUME_GRACE_SECONDS = 30.f; // 服务器保留掉线玩家位置的时长
+
+struct ResumePlayer
+{
+  float x = 0.f, y = 0.f;
+  float rotation = 0.f;
+  float turretAngle = 0.f;
+  float health = 100.f;
+  bool reachedExit = false;
+  bool isDead = false;
+  uint16_t coins = 0;
+  uint16_t wallsInBag = 0;
+};
+
+struct ResumeNpc
+{
+  float x = 0.f, y = 0.f;
+  float rotation = 0.f;
+  float turretAngle = 0.f;
+  float health = 0.f;
+  int team = 0;
+  bool activated = false;
+  int activatorId = -1; // 激活者槽位：0=房主，1=非房主，-1=自动激活
+};
+
+// 与原始地图不同的可破坏墙格子
+struct ResumeWall
+{
+  uint16_t row = 0;
+  uint16_t col = 0;
+  bool present = false;  // 现在有可破坏墙；false 表示原有的墙已被摧毁
+  uint8_t attribute = 0; // WallAttribute
+  float health = 0.f;    // 传输时按整数向上取整（未摧毁的墙不会变成 0）
+};
+
+struct ResumeSnapshot
+{
+  uint8_t modeFlags = 0; // 与 MazeChunk 相同：bit 0 = Escape，bit 1 = 暗黑
+  uint64_t mazeHash = 0; // 原始地图（未受伤害时）的哈希
+  MazeSeedParams seed;   // version 非 0 时可按种子重新生成
+  std::vector<std::string> mazeData; // 没有种子时附带原始地图；编码后放不下时为空，只能按哈希匹配本地地图
+  uint16_t rows = 0;
+  uint16_t cols = 0;
+  std::vector<ResumeWall> walls; // 按行优先排列
+  std::vector<ResumeNpc> npcs;   // 下标为 NPC ID
+  ResumePlayer players[2];       // 0=房主，1=非房主
+};
+
+class ResumeCodec
+{
+public:
+  static constexpr uint8_t FORMAT_VERSION = 1;
+  static constexpr std::size_t PLAYER_SIZE = 25;
+  static constexpr std::size_t NPC_SIZE = 23;
+  static constexpr std::size_t MAX_NPCS = 255; // NPC ID 在其他消息里只占 1 字节
+
+  // 超过一帧的最大负载时先去掉整图，仍放不下返回空
+  static std::vector<uint8_t> buildSnapshot(const ResumeSnapshot &snapshot);
+  static bool parseSnapshot(const std::vector<uint8_t> &message, ResumeSnapshot &snapshot);
+
+  static std::vector<uint8_t> buildSessionMessage(const std::string &roomCode, uint32_t token, const ResumePlayer &self);
+  // 只解析头部（服务器用）；payloadOffset 为玩家状态的起始位置
+  static bool parseSessionHeader(const std::vector<uint8_t> &message, std::string &roomCode, uint32_t &token,
+                                 std::size_t &payloadOffset);
+
+  static bool parseRequestMessage(const std::vector<uint8_t> &message, ResumePlayer &player);
+
+  static void writePlayer(std::vector<uint8_t> &out, const ResumePlayer &player);
+  static void readPlayer(const uint8_t *data, ResumePlayer &player);
+};
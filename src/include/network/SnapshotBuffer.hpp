@@ -0,0 +1,45 @@
+#pragma once
+
+#include <SFML/System.hpp>
+#include <array>
+#include <cstddef>
+
+// 远程实体快照（时间为本地网络时钟，单位秒）
+struct EntitySnapshot
+{
+  float time = 0.f;
+  sf::Vector2f position = {0.f, 0.f};
+  float rotation = 0.f;
+  float turretAngle = 0.f;
+};
+
+// 快照插值缓冲
+// 渲染时间比最新数据落后 INTERP_DELAY，在相邻两帧快照之间插值；
+// 数据断档时按最后速度外推，最多 MAX_EXTRAPOLATION 秒，之后停在原地
+class SnapshotBuffer
+{
+public:
+  static constexpr float INTERP_DELAY = 0.1f;
+  static constexpr float MAX_EXTRAPOLATION = 0.25f;
+  static constexpr std::size_t CAPACITY = 32;
+
+  // remoteTime: 发送方时间戳（<=0 表示对方未携带，使用到达时间）
+  void push(float remoteTime, float localTime, sf::Vector2f position, float rotation, float turretAngle);
+
+  // 采样 localTime 时刻应显示的状态，缓冲为空时返回 false
+  bool sample(float localTime, EntitySnapshot &out) const;
+
+  void clear();
+  bool empty() const { return m_count == 0; }
+
+private:
+  const EntitySnapshot &at(std::size_t i) const { return m_snapshots[(m_head + i) % CAPACITY]; }
+
+  std::array<EntitySnapshot, CAPACITY> m_snapshots;
+  std::size_t m_head = 0;  // 最旧快照下标
+  std::size_t m_count = 0;
+
+  // 时钟偏移估计：本地时间 - 发送方时间（取最小值，即延迟最小的那一帧）
+  float m_clockOffset = 0.f;
+  bool m_hasClockOffset = false;
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// 墙体变化批量同步（客户端与服务器模拟共用，不依赖 SFML）
+// 一帧（服务器为一个模拟步）内的墙体伤害与放置合并为一条 WallBatch，同一格子的多次命中累计为一个条目；
+// 格子被摧毁后该格再有变化另起条目，接收方按顺序应用。
+//
+// WallBatch：类型(1) + 条目数(2) + 条目 × N
+// 条目：行(2) + 列(2) + 标志(1: bit0 放置, bit1 摧毁) + 属性(1) + 摧毁者+128(1) + 累计伤害(4)
+struct WallBatchEntry
+{
+  uint16_t row = 0;
+  uint16_t col = 0;
+  bool placed = false;    // 先在该空格子放置一堵墙
+  bool destroyed = false; // 发送方已判定摧毁（接收方强制摧毁）
+  uint8_t attribute = 0;  // 被摧毁墙的 WallAttribute
+  int destroyer = -1;     // 与 WallDamage 相同，按接收方解释：1=接收方，0=另一玩家，-1=NPC
+  float damage = 0.f;     // 本帧累计伤害
+};
+
+class WallBatch
+{
+public:
+  static constexpr std::size_t ENTRY_SIZE = 11;
+  static constexpr std::size_t MAX_ENTRIES_PER_MESSAGE = 4096; // 远小于一帧的最大负载
+
+  void addDamage(int row, int col, float damage, bool destroyed, int attribute, int destroyer);
+  void addPlace(int row, int col);
+
+  bool empty() const { return m_entries.empty(); }
+  const std::vector<WallBatchEntry> &entries() const { return m_entries; }
+  void clear();
+
+  // 按条目数拆成若干消息（通常只有一条）
+  std::vector<std::vector<uint8_t>> build() const;
+  static bool parse(const uint8_t *data, std::size_t size, std::vector<WallBatchEntry> &entries);
+
+private:
+  std::vector<WallBatchEntry> m_entries;
+  std::unordered_map<uint32_t, std::size_t> m_open; // (行 << 16 | 列) -> 仍可合并的条目
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// 固定容量的字节环形缓冲区（每个连接一个输入、一个输出）
+// 容量向上取整为 2 的幂，读写只移动下标，不做整体搬移
+class RingBuffer
+{
+public:
+  explicit RingBuffer(std::size_t capacity);
+
+  std::size_t size() const { return static_cast<std::size_t>(m_tail - m_head); }
+  std::size_t capacity() const { return m_data.size(); }
+  std::size_t freeSpace() const { return capacity() - size(); }
+  bool empty() const { return m_head == m_tail; }
+
+  // 写入全部数据，空间不足时不写入并返回 false
+  bool write(const uint8_t *data, std::size_t len);
+
+  // 从头部拷贝 len 字节（不消费），调用方保证 len <= size()
+  void peek(uint8_t *out, std::size_t len, std::size_t offset = 0) const;
+  void consume(std::size_t len);
+  void clear() { m_head = m_tail = 0; }
+
+  // 连续可写区域（用于 recv 直接写入），写完后 commitWrite
+  std::pair<uint8_t *, std::size_t> writableSpan();
+  void commitWrite(std::size_t len) { m_tail += len; }
+
+  // 连续可读区域（用于 send 直接读取），发送后 consume
+  std::pair<const uint8_t *, std::size_t> readableSpan() const;
+
+private:
+  std::vector<uint8_t> m_data;
+  std::size_t m_mask;
+  uint64_t m_head = 0; // 单调递增，取模后为实际下标
+  uint64_t m_tail = 0;
+};
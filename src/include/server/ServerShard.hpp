@@ -0,0 +1,188 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <netinet/in.h>
+#include "MazeCodec.hpp"
+#include "RingBuffer.hpp"
+
+class TankServer;
+class ServerSimulation;
+
+// 单个 TCP 连接（同一时刻只属于一个分片）
+struct ServerConnection
+{
+  static constexpr std::size_t BUFFER_SIZE = 128 * 1024; // 可容纳一个最大帧（2 + 65535 字节）
+
+  int fd = -1;
+  uint32_t sessionId = 0;
+  std::string ip;
+  RingBuffer input{BUFFER_SIZE};
+  RingBuffer output{BUFFER_SIZE};
+  bool wantWrite = false; // 是否已注册 EPOLLOUT
+  bool closing = false;
+
+  // 房间
+  std::string roomCode;
+  bool isHost = false;
+
+  // UDP 端点（握手后有效）
+  bool hasUdp = false;
+  sockaddr_in udpAddr{};
+  uint32_t udpSendSeq = 0; // 服务器自身发出的数据报序号（权威模拟）
+
+  // 迁移到其他分片（加入其他分片的房间时）
+  int migrateTo = -1;
+  std::vector<uint8_t> replayFrame;
+};
+
+// 分片收件箱事件（由主线程或其他分片投递）
+enum class ShardEventType
+{
+  Adopt,    // 接管连接（新连接或迁移）
+  Datagram, // 需要中继的 UDP 数据报
+  UdpBind   // UDP 握手
+};
+
+struct ShardEvent
+{
+  ShardEventType type = ShardEventType::Adopt;
+  std::unique_ptr<ServerConnection> conn;
+  uint32_t sessionId = 0;
+  std::vector<uint8_t> data;
+  sockaddr_in addr{};
+};
+
+// 房间分片：独立线程 + 独立 epoll，负责一部分房间及其连接
+// 房间码满足 code % shardCount == shardIndex，加入其他分片的房间时连接随之迁移
+class ServerShard
+{
+public:
+  ServerShard(TankServer &server, int index, int shardCount);
+  ~ServerShard();
+
+  bool start();
+  void stop();
+  void post(ShardEvent &&event);
+
+  // 是否编译了服务器权威模拟（需要 SFML，见 CMake 的 TANK_SERVER_SIMULATION）
+  static bool simulationAvailable();
+
+  // 统计（主线程读取）
+  std::atomic<int> connectionCount{0};
+  std::atomic<int> roomCount{0};
+  std::atomic<uint64_t> framesIn{0};
+  std::atomic<uint64_t> framesOut{0};
+  std::atomic<uint64_t> datagramsRelayed{0};
+
+private:
+  struct RoomPlayer
+  {
+    ServerConnection *conn = nullptr;
+    bool reachedExit = false;
+    bool isHost = false;
+    bool ready = false;
+    uint32_t token = 0; // 断线重连令牌（对局开始时分配，0 表示不保留位置）
+  };
+
+  // 对局中意外掉线的玩家：保留位置等待 ResumeSession（见 SessionResume.hpp）
+  struct HeldSlot
+  {
+    uint32_t token = 0;
+    bool isHost = false;
+    bool reachedExit = false;
+    std::chrono::steady_clock::time_point expires;
+  };
+
+  struct Room
+  {
+    std::string code;
+    int mazeWidth = 0;
+    int mazeHeight = 0;
+    MazeChunkAssembler maze; // 房主上传的迷宫分块（按哈希缓存，重开或加入时直接复用）
+    std::vector<uint8_t> mazeSeed; // 房主最新的 MazeSeed 消息（加入时优先转发）
+    std::vector<RoomPlayer> players;
+    bool started = false;
+    bool isEscapeMode = false;
+    bool isDarkMode = false;
+    bool lockstep = false; // 帧同步模式：服务器只转发输入与状态哈希
+    std::optional<HeldSlot> held;
+
+    // 服务器权威模拟（创建房间时请求，游戏开始时创建）
+    bool simulated = false;
+    std::shared_ptr<ServerSimulation> simulation;
+    std::chrono::steady_clock::time_point nextTick;
+  };
+
+  void run();
+  void drainInbox();
+  void adopt(std::unique_ptr<ServerConnection> conn, std::vector<uint8_t> &&replay);
+  void handleReadable(ServerConnection &conn);
+  void handleWritable(ServerConnection &conn);
+  void processInput(ServerConnection &conn);
+  void handleMessage(ServerConnection &conn, const std::vector<uint8_t> &data);
+  void relayDatagram(uint32_t sessionId, const std::vector<uint8_t> &datagram);
+  void bindUdp(uint32_t sessionId, const sockaddr_in &addr, const std::vector<uint8_t> &hello);
+
+  // 发送
+  void sendFrame(ServerConnection &conn, const uint8_t *data, std::size_t len);
+  void sendFrame(ServerConnection &conn, const std::vector<uint8_t> &data) { sendFrame(conn, data.data(), data.size()); }
+  void broadcastToRoom(Room &room, ServerConnection *sender, const std::vector<uint8_t> &data);
+  void sendRoomInfo(Room &room);
+  void sendRoomError(ServerConnection &conn, const std::string &error);
+  void updateWriteInterest(ServerConnection &conn);
+
+  // 房间
+  Room *findRoom(const ServerConnection &conn);
+  RoomPlayer *findPlayer(Room &room, const ServerConnection &conn);
+  std::string generateRoomCode();
+  uint32_t generateResumeToken(); // 非 0
+  int ownerShard(const std::string &code) const; // 不是 4 位数字时返回 -1
+  // allowResume：对局中意外断开时保留位置等待重连，否则按离开处理
+  void leaveRoom(ServerConnection &conn, bool allowResume = false);
+  void resetAfterLeave(Room &room, bool wasHost);
+  void expireHeldSlots();
+
+  // 权威模拟
+  void startSimulation(Room &room);
+  void stopSimulation(Room &room);
+  bool feedSimulation(Room &room, const ServerConnection &sender, const std::vector<uint8_t> &data);
+  void tickSimulations();
+  int nextTickTimeout(int defaultMs) const;
+
+  // 连接生命周期（批处理结束时统一执行）
+  void requestClose(ServerConnection &conn);
+  void flushPendingClosures();
+
+  TankServer &m_server;
+  int m_index;
+  int m_shardCount;
+  int m_epollFd = -1;
+  int m_wakeFd = -1;
+  std::thread m_thread;
+  std::atomic<bool> m_running{false};
+
+  std::mutex m_inboxMutex;
+  std::vector<ShardEvent> m_inbox;
+  std::vector<ShardEvent> m_inboxSwap;
+
+  std::unordered_map<int, std::unique_ptr<ServerConnection>> m_connections; // fd -> 连接
+  std::unordered_map<uint32_t, ServerConnection *> m_sessions;             // 会话ID -> 连接
+  std::unordered_map<std::string, Room> m_rooms;
+  std::vector<ServerConnection *> m_pendingClose;
+  std::vector<ServerConnection *> m_pendingMigrate;
+  std::vector<uint8_t> m_frame; // 复用的帧缓冲
+  int m_simulationCount = 0;
+  int m_heldCount = 0; // 保留着掉线玩家位置的房间数
+  uint32_t m_rngState;          // 房间码（公开，可预测无妨）
+  std::random_device m_tokenSource; // 重连令牌：取自系统熵源，与房间码的随机数无关
+};
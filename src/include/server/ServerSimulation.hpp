@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Maze.hpp"
+#include "Enemy.hpp"
+#include "Bullet.hpp"
+#include "Tank.hpp"
+#include "AIScheduler.hpp"
+#include "CrowdSteering.hpp"
+#include "InterestManager.hpp"
+#include "WallBatch.hpp"
+
+// 服务器权威模拟（无窗口）：在服务器上运行一个房间的迷宫、NPC AI、玩家移动与碰撞
+// 服务器充当"虚拟房主"，两个客户端都按非房主逻辑运行：只上报输入（PlayerInput），
+// 双方坦克的位置与血量以服务器下发的 PlayerSnapshot 为准
+class ServerSimulation
+{
+public:
+  static constexpr float TICK_INTERVAL = 1.f / 30.f; // 固定步长
+  static constexpr int HOST = 0;
+  static constexpr int GUEST = 1;
+  static constexpr int BOTH = -1;
+
+  // 待发送消息：target 为玩家下标或 BOTH，isState 表示可走 UDP 的高频状态
+  struct Outgoing
+  {
+    int target;
+    bool isState;
+    std::vector<uint8_t> data;
+  };
+
+  // 从房主上传的迷宫初始化（ServerShard 负责分块重组与解码）
+  bool init(const std::vector<std::string> &mazeData, bool isEscapeMode);
+
+  // 处理客户端上报（PlayerInput / NpcActivate / WallPlace / WallBatch / RescueComplete）
+  void handleClientMessage(int playerIndex, const uint8_t *data, std::size_t len);
+
+  // 推进一个固定步长，产生的同步消息追加到 outgoing()
+  void tick();
+
+  std::vector<Outgoing> &outgoing() { return m_outgoing; }
+  std::size_t npcCount() const { return m_enemies.size(); }
+
+private:
+  // 每个玩家最近一次的输入：按住的按键持续生效，直到下一条 PlayerInput
+  struct InputState
+  {
+    uint32_t seq = 0;
+    uint8_t buttons = 0;
+    sf::Vector2f aim;
+    bool reachedExit = false;
+  };
+
+  void updatePlayers(float dt);
+  void sendPlayerSnapshots();
+  void updateNpcAI(float dt);
+  void sendNpcState(std::size_t index, const Enemy &npc);
+  void pushToInterested(bool toHost, bool toGuest, bool isState, std::vector<uint8_t> &&msg);
+  void queueWallDamage(const WallDestroyResult &result, const Bullet &bullet);
+  void flushWallBatches();
+
+  Maze m_maze;
+  EntityStore m_entities; // 坦克与 NPC 的热数据，须在 m_enemies / m_players 之前声明（最后析构）
+  std::vector<std::unique_ptr<Enemy>> m_enemies;
+  AIScheduler m_aiScheduler; // NPC AI 分级调度
+  CrowdSteering m_crowd;     // NPC 群体避让
+  InterestManager m_interest[2]; // 每个接收方一份 NPC 同步关注区域
+  bool m_reported[2] = {false, false}; // 是否已收到该玩家的 PlayerInput（之前不做关注区域过滤）
+  std::vector<std::unique_ptr<Bullet>> m_bullets;
+  Tank m_players[2]{Tank(m_entities), Tank(m_entities)}; // 玩家坦克（按客户端输入在服务器上移动）
+  InputState m_inputs[2];
+  bool m_isEscapeMode = false;
+  float m_time = 0.f; // 模拟时钟（作为快照时间戳）
+  std::vector<Outgoing> m_outgoing;
+  WallBatch m_wallBatches[2]; // 本步的墙体变化，按接收方分开（摧毁者 ID 相对接收方）
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ServerShard.hpp"
+
+// 原生中继/房间服务器（Linux epoll），协议与 server/server.js 一致
+// 主线程负责 accept 和 UDP 收包，房间逻辑在各分片线程中执行
+class TankServer
+{
+public:
+  TankServer(unsigned short port, int shardCount, bool verbose);
+  ~TankServer();
+
+  bool start();
+  void run(const std::atomic<bool> &stopFlag);
+  void stop();
+
+  int udpFd() const { return m_udpFd; }
+  int shardCount() const { return static_cast<int>(m_shards.size()); }
+  bool verbose() const { return m_verbose; }
+
+  // 分片间通信
+  void postToShard(int shard, ShardEvent &&event);
+  void setSessionShard(uint32_t sessionId, int shard);
+  void removeSession(uint32_t sessionId);
+
+private:
+  void acceptConnections();
+  void receiveDatagrams();
+  // 新会话：取一个未使用的随机ID并登记所在分片
+  uint32_t registerSession(int shard);
+  // UdpHello：把端点绑定到会话（会话已关闭时返回 -1），否则返回会话所在分片
+  int bindUdpEndpoint(uint64_t endpoint, uint32_t sessionId);
+  // 数据报：按端点找会话与分片，未绑定或会话已关闭时返回 -1
+  int findEndpointShard(uint64_t endpoint, uint32_t &sessionId);
+  void printStats(float elapsed);
+
+  unsigned short m_port;
+  bool m_verbose;
+  int m_listenFd = -1;
+  int m_udpFd = -1;
+  int m_epollFd = -1;
+  int m_nextShard = 0;
+  std::vector<std::unique_ptr<ServerShard>> m_shards;
+
+  // 会话ID -> 所在分片（分片迁移/关闭连接时更新）
+  // 会话ID 是 UdpHello 绑定端点的唯一凭据，必须随机且不可预测，不能顺序递增
+  std::mutex m_sessionMutex;
+  std::unordered_map<uint32_t, int> m_sessionShards;
+  std::random_device m_sessionIdSource;
+
+  // UDP 端点 <-> 会话ID（与上面共用锁；关闭会话时一并清除）
+  std::unordered_map<uint64_t, uint32_t> m_udpEndpoints;
+  std::unordered_map<uint32_t, uint64_t> m_sessionEndpoints;
+
+  uint64_t m_lastFramesIn = 0;
+  uint64_t m_lastFramesOut = 0;
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <SFML/System.hpp>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// NPC AI 细节层次调度
+// 按到最近焦点（玩家）的距离分级：近处每帧思考，中距离与远处降频，同级 NPC 按下标轮转分桶，
+// 避免同一帧集中思考。降频的 NPC 还受每帧 AI 时间预算限制，超出预算顺延到之后的帧。
+// “思考”指寻路刷新与目标选择（弹道检测），移动每帧照常积分，不会卡顿。
+class AIScheduler
+{
+public:
+  static constexpr float NEAR_DISTANCE = 640.f;  // 此距离内每帧思考
+  static constexpr float MID_DISTANCE = 1600.f;  // 此距离内每 MID_PERIOD 帧思考
+  static constexpr int MID_PERIOD = 2;
+  static constexpr int FAR_PERIOD = 4;          // 更远处每 FAR_PERIOD 帧思考
+  static constexpr int MAX_STALE_FRAMES = 12;   // 被预算顺延的 NPC 最多等待的帧数
+  static constexpr double DEFAULT_BUDGET_MS = 2.0;
+
+  struct Stats
+  {
+    uint64_t thinks = 0;   // 实际思考次数
+    uint64_t skipped = 0;  // 因距离降频跳过
+    uint64_t deferred = 0; // 因预算顺延
+  };
+
+  void setBudgetMs(double ms) { m_budgetMs = ms; }
+
+  // 每帧开始时调用，传入距离参考点（没有参考点时全部按近处处理）
+  void beginFrame(const std::vector<sf::Vector2f> &focus);
+
+  // 本帧该 NPC 是否思考；index 为 NPC 在列表中的下标
+  bool shouldThink(std::size_t index, sf::Vector2f position);
+
+  // 思考完成后调用，计入本帧预算
+  void endThink(std::chrono::steady_clock::time_point start);
+
+  const Stats &getStats() const { return m_stats; }
+
+private:
+  int periodFor(sf::Vector2f position) const;
+
+  std::vector<sf::Vector2f> m_focus;
+  std::vector<int> m_staleFrames; // 每个 NPC 距上次思考的帧数
+  uint64_t m_frame = 0;
+  double m_spentMs = 0.0;
+  double m_budgetMs = DEFAULT_BUDGET_MS;
+  Stats m_stats;
+};
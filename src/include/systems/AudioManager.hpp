@@ -1,6 +1,10 @@
 #pragma once
 
 #include <SFML/Audio.hpp>
+#include <array>
+#include <cstdint>
+#include <future>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <memory>
@@ -29,24 +33,42 @@ enum class SFXType
   MenuConfirm    // 菜单确认
 };
 
+// 一次性音效的统计（语音池满或超过同类上限时丢弃/抢占）
+struct SFXStats
+{
+  uint64_t played = 0;  // 实际播放
+  uint64_t dropped = 0; // 优先级不够被丢弃
+  uint64_t stolen = 0;  // 抢占了正在播放的语音
+  uint64_t merged = 0;  // 与同帧/刚开始的同类音效合并
+};
+
 class AudioManager
 {
 public:
+  static constexpr std::size_t MAX_VOICES = 32;   // 一次性音效的语音池大小
+  static constexpr float MERGE_RADIUS = 96.f;     // 同类音效在此距离内合并（像素）
+  static constexpr float MERGE_WINDOW = 0.05f;    // 刚开始播放不到这么久的同类语音直接加大音量（秒）
+
   static AudioManager &getInstance();
 
-  // 初始化（加载所有音频资源）
+  // 初始化（加载所有音频资源，阻塞到加载完成）
   bool init(const std::string &assetPath = "music_assets/");
 
+  // 在后台线程加载音频资源，立即返回加载结果的 future（重复调用返回同一个）
+  // 就绪前 playBGM 只记录请求、就绪后开始播放；音效请求直接丢弃
+  std::shared_future<bool> initAsync(const std::string &assetPath = "music_assets/");
+  bool isReady() const { return m_initialized; }
+
   // 背景音乐控制
   void playBGM(BGMType type);
   void stopBGM();
   void setBGMVolume(float volume); // 0-100
   BGMType getCurrentBGM() const { return m_currentBGM; }
 
-  // 音效播放（带位置，用于距离衰减）
+  // 音效播放（带位置，用于距离衰减）：先进入本帧队列，由 update() 合并后播放
   void playSFX(SFXType type, sf::Vector2f soundPos, sf::Vector2f listenerPos);
 
-  // 音效播放（无位置，全局音效）
+  // 音效播放（无位置，全局音效）：同样进入队列，同类全局音效每帧只播放一次
   void playSFXGlobal(SFXType type);
 
   // 循环音效控制（用于坦克移动等）
@@ -61,7 +83,10 @@ public:
   void setListeningRange(float range) { m_listeningRange = range; }
   float getListeningRange() const { return m_listeningRange; }
 
-  // 更新（清理已播放完的音效）
+  // 一次性音效统计
+  const SFXStats &getSFXStats() const { return m_sfxStats; }
+
+  // 更新（BGM 切换，合并并播放本帧的音效队列），每帧调用一次
   void update();
 
   // 停止所有音效（重启游戏时调用）
@@ -77,9 +102,48 @@ private:
   AudioManager(const AudioManager &) = delete;
   AudioManager &operator=(const AudioManager &) = delete;
 
+  // 加载全部音频资源（后台线程执行，期间主线程不访问音乐与缓冲区）
+  bool loadAssets(const std::string &assetPath);
+
+  // 主线程检查后台加载：完成时标记就绪并播放等待中的 BGM
+  bool pollLoader();
+
   // 根据距离计算音量（0-100）
   float calculateVolume(sf::Vector2f soundPos, sf::Vector2f listenerPos) const;
 
+  // 语音池中的一个语音（sf::Sound 首次使用时创建，之后只换缓冲区）
+  struct Voice
+  {
+    std::optional<sf::Sound> sound;
+    SFXType type = SFXType::Shoot;
+    float priority = 0.f; // 开始播放时的音量（已含距离衰减）
+    sf::Vector2f position;
+    bool positional = false;
+    float startTime = 0.f; // m_audioClock 时间
+  };
+
+  // 本帧待播放的音效（同类且相近的请求合并为一个）
+  struct SFXEvent
+  {
+    SFXType type;
+    sf::Vector2f position;
+    bool positional;
+    float volume;
+  };
+
+  // 合并音量：按能量叠加，不超过音效总音量
+  float combineVolume(float a, float b) const;
+  void queueSFX(SFXType type, sf::Vector2f position, bool positional, float volume);
+  void flushSFXQueue();
+
+  // 同类音效同时播放的上限
+  static int voiceLimit(SFXType type);
+
+  // 按优先级分配语音并播放：同类超限或池满时抢占优先级最低的语音，都比它高则丢弃
+  void playVoice(const SFXEvent &event);
+  bool isVoiceBusy(const Voice &voice) const;
+  float voicePriority(const Voice &voice) const; // 随播放进度降低，快结束的语音先被抢占
+
   // 背景音乐
   sf::Music m_bgmMenu;
   sf::Music m_bgmStart;
@@ -92,8 +156,11 @@ private:
   // 音效缓冲区
   std::unordered_map<SFXType, sf::SoundBuffer> m_sfxBuffers;
 
-  // 活跃的音效实例（用于同时播放多个相同音效）
-  std::vector<std::unique_ptr<sf::Sound>> m_activeSounds;
+  // 一次性音效的固定语音池（不再每次播放都分配 sf::Sound）
+  std::array<Voice, MAX_VOICES> m_voices;
+  std::vector<SFXEvent> m_sfxQueue;
+  sf::Clock m_audioClock;
+  SFXStats m_sfxStats;
 
   float m_sfxVolume = 70.f;
   float m_listeningRange = 800.f; // 默认听音范围（像素）
@@ -102,4 +169,8 @@ private:
   std::unordered_map<SFXType, std::unique_ptr<sf::Sound>> m_loopSounds;
 
   bool m_initialized = false;
+  bool m_loadFailed = false;
+  std::shared_future<bool> m_loader;
+  sf::Clock m_loadClock;
+  std::optional<BGMType> m_pendingBGM; // 就绪前请求的 BGM
 };
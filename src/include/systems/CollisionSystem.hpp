@@ -3,6 +3,7 @@
 #include <SFML/Graphics.hpp>
 #include <vector>
 #include <memory>
+#include <functional>
 #include "Bullet.hpp"
 #include "Tank.hpp"
 #include "Enemy.hpp"
@@ -20,15 +21,44 @@ public:
       Maze &maze);
 
   // 多人模式碰撞检测
+  // ownsPlayerDamage 为 false（服务器权威模拟）时本地玩家不扣血，血量以服务器快照为准
   static void checkMultiplayerCollisions(
       Tank *player,
       Tank *otherPlayer,
       std::vector<std::unique_ptr<Enemy>> &enemies,
       std::vector<std::unique_ptr<Bullet>> &bullets,
       Maze &maze,
-      bool isHost);
+      bool isHost,
+      bool ownsPlayerDamage = true);
+
+  // 服务器权威模拟碰撞：墙壁、NPC 与玩家伤害都由服务器判定
+  // 墙壁与 NPC 伤害通过回调同步，玩家血量随 PlayerSnapshot 下发
+  // hostPlayer 的子弹为 BulletOwner::Player，guestPlayer 的为 BulletOwner::OtherPlayer
+  static void checkServerCollisions(
+      Tank *hostPlayer,
+      Tank *guestPlayer,
+      std::vector<std::unique_ptr<Enemy>> &enemies,
+      std::vector<std::unique_ptr<Bullet>> &bullets,
+      Maze &maze,
+      const std::function<void(const WallDestroyResult &, const Bullet &)> &onWallHit,
+      const std::function<void(Enemy &, float damage)> &onNpcDamage);
+
+  // 帧同步碰撞：双方各自完整判定墙壁、坦克与 NPC 伤害，不发送任何消息
+  // hostPlayer 的子弹为 BulletOwner::Player，guestPlayer 的为 BulletOwner::OtherPlayer；listener 只用于音效
+  static void checkLockstepCollisions(
+      Tank *hostPlayer,
+      Tank *guestPlayer,
+      std::vector<std::unique_ptr<Enemy>> &enemies,
+      std::vector<std::unique_ptr<Bullet>> &bullets,
+      Maze &maze,
+      const Tank *listener);
 
 private:
+  // 阵营规则（联机、服务器权威与帧同步共用）
+  // tankBullets 为这辆坦克自己发射的子弹的 owner（自己的子弹不伤自己）
+  static bool bulletCanHitTank(const Bullet &bullet, const Tank &tank, BulletOwner tankBullets);
+  static bool bulletCanHitNpc(const Bullet &bullet, const Enemy &npc);
+
   // 检查子弹与墙壁碰撞（简单版本，单机模式用）
   static bool checkBulletWallCollision(Bullet *bullet, Maze &maze);
 
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "EntityStore.hpp"
+
+// NPC 群体避让（不依赖 SFML，客户端、服务器模拟与 tank_bench 共用）
+// 每帧把所有 NPC 按位置计数排序进均匀网格，邻居查询只看周围 3x3 格，代价与邻居数 k 成正比而不是 N。
+// 寻路给出期望速度后，先叠加分离力把重叠的 NPC 推开，再用速度障碍在候选方向中选一个
+// 短时间内不会撞上邻居、且最接近期望速度的速度。
+
+// 一个参与避让的个体（世界坐标，速度为上一帧的实际速度）
+struct CrowdAgent
+{
+  float x = 0.f;
+  float y = 0.f;
+  float vx = 0.f;
+  float vy = 0.f;
+  float radius = 0.f; // 0 表示不参与（已死亡等），下标仍然保留
+};
+
+class CrowdSteering
+{
+public:
+  static constexpr float NEIGHBOR_RANGE = 90.f; // 邻居查询半径，同时是网格边长
+  static constexpr int MAX_NEIGHBORS = 8;       // 只考虑最近的 k 个邻居
+  static constexpr float SEPARATION_MARGIN = 6.f;
+  static constexpr float TIME_HORIZON = 0.75f; // 速度障碍的预判时间（秒）
+
+  struct Stats
+  {
+    uint64_t steered = 0;          // steer 调用次数
+    uint64_t neighborsVisited = 0; // 查询中检查过的个体数
+    uint64_t avoided = 0;          // 期望速度会撞上邻居、改选了其他速度的次数
+  };
+
+  // 每帧：clear，按下标顺序 add，最后 build
+  void clear() { m_agents.clear(); }
+  std::size_t add(const CrowdAgent &agent)
+  {
+    m_agents.push_back(agent);
+    return m_agents.size() - 1;
+  }
+  void build();
+
+  // 直接从实体存储建表：下标即实体 id，只有存活的 NPC 参与（未激活的视为静止障碍）
+  void build(const EntityStore &store);
+
+  // 查询 (x, y) 周围 range 内最近的最多 maxCount 个个体（跳过 self），按距离升序写入 out，返回个数
+  std::size_t queryNeighbors(float x, float y, float range, std::size_t self, std::size_t *out,
+                             std::size_t maxCount) const;
+
+  // 调整第 index 个个体的期望速度 (vx, vy)；速度大小不超过 maxSpeed
+  void steer(std::size_t index, float &vx, float &vy, float maxSpeed) const;
+
+  std::size_t size() const { return m_agents.size(); }
+  const Stats &getStats() const { return m_stats; }
+
+private:
+  int cellIndex(float x, float y) const;
+
+  std::vector<CrowdAgent> m_agents;
+
+  // 计数排序后的网格：m_cellStart[c]..m_cellStart[c+1] 为第 c 格内个体在 m_sorted 中的范围
+  std::vector<uint32_t> m_cellStart;
+  std::vector<uint32_t> m_sorted;
+  float m_originX = 0.f;
+  float m_originY = 0.f;
+  int m_cols = 0;
+  int m_rows = 0;
+
+  mutable Stats m_stats;
+};
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// 单人对局录像文件（不依赖 SFML）
+// 布局：固定大小的文件头 + 每个固定步长一条定长输入记录，只追加写入；
+// 第 i 条记录位于 headerSize + i * sizeof(ReplayTick)，读取时整个文件映射进内存直接按下标访问。
+// 数值按小端存储（目前支持的平台都是小端）。文件末尾不完整的记录（录制中途崩溃）会被忽略。
+
+constexpr char REPLAY_MAGIC[4] = {'T', 'K', 'R', 'P'};
+constexpr uint16_t REPLAY_VERSION = 1;
+
+struct ReplayHeader
+{
+  char magic[4] = {'T', 'K', 'R', 'P'};
+  uint16_t version = REPLAY_VERSION;
+  uint16_t headerSize = 0;       // 写入时填 sizeof(ReplayHeader)，读取时按它跳过文件头
+  uint16_t tickRate = 60;        // 每秒步数
+  uint16_t generatorVersion = 0; // MazeGenerator::ALGORITHM_VERSION，不一致时无法复现地图
+  uint32_t mazeSeed = 0;
+  uint16_t mazeWidth = 0;
+  uint16_t mazeHeight = 0;
+  uint16_t enemyCount = 0;
+  uint8_t escapeMode = 0;
+  uint8_t darkMode = 0;
+  uint32_t randSeed = 0; // std::srand 种子（NPC 初始方向）
+  uint32_t reserved[3] = {};
+};
+static_assert(sizeof(ReplayHeader) == 40, "ReplayHeader layout is part of the file format");
+
+// 每步输入的按键位
+constexpr uint8_t REPLAY_KEY_UP = 1;
+constexpr uint8_t REPLAY_KEY_DOWN = 2;
+constexpr uint8_t REPLAY_KEY_LEFT = 4;
+constexpr uint8_t REPLAY_KEY_RIGHT = 8;
+constexpr uint8_t REPLAY_KEY_FIRE = 16;
+constexpr uint8_t REPLAY_KEY_EXIT = 32;       // E 键（终点确认）
+constexpr uint8_t REPLAY_PLACE_WALL = 64;     // 本步开始前在 (placeCol, placeRow) 放置了墙
+constexpr uint8_t REPLAY_TANK_KEYS = 0x1F;    // 交给 Tank 的部分（移动 + 射击）
+
+struct ReplayTick
+{
+  uint8_t buttons = 0;
+  uint8_t reserved = 0;
+  int16_t placeCol = 0;
+  int16_t placeRow = 0;
+  uint16_t reserved2 = 0;
+  float aimX = 0.f; // 鼠标的世界坐标（炮塔朝向）
+  float aimY = 0.f;
+};
+static_assert(sizeof(ReplayTick) == 16, "ReplayTick layout is part of the file format");
+
+class ReplayWriter
+{
+public:
+  ~ReplayWriter() { close(); }
+
+  bool open(const std::string &path, const ReplayHeader &header);
+  void append(const ReplayTick &tick);
+  void close();
+
+  bool isOpen() const { return m_file != nullptr; }
+  uint64_t tickCount() const { return m_ticks; }
+
+private:
+  static constexpr uint64_t FLUSH_INTERVAL = 60; // 每秒落盘一次，崩溃最多丢一秒
+
+  std::FILE *m_file = nullptr;
+  uint64_t m_ticks = 0;
+};
+
+class ReplayReader
+{
+public:
+  ~ReplayReader() { close(); }
+
+  // 失败时返回 false，error() 给出原因
+  bool open(const std::string &path);
+  void close();
+
+  bool isOpen() const { return m_data != nullptr; }
+  const ReplayHeader &header() const { return m_header; }
+  std::size_t tickCount() const { return m_tickCount; }
+  ReplayTick tick(std::size_t index) const;
+  const std::string &error() const { return m_error; }
+
+private:
+  const unsigned char *m_data = nullptr;
+  std::size_t m_size = 0;
+  bool m_mapped = false;
+  std::vector<unsigned char> m_buffer; // 不支持 mmap 的平台整读进内存
+  ReplayHeader m_header;
+  std::size_t m_tickCount = 0;
+  std::string m_error;
+};
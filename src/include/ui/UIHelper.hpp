@@ -1,7 +1,9 @@
 #pragma once
 
 #include <SFML/Graphics.hpp>
+#include <algorithm>
 #include <string>
+#include "UILayer.hpp"
 
 // UI绘制辅助函数
 namespace UIHelper
@@ -51,6 +53,22 @@ namespace UIHelper
     window.draw(bar);
   }
 
+  // 提交带边框的血条到保留模式 UI 层（血量不变时不重建顶点）
+  inline void drawHealthBar(
+      UILayer &layer,
+      const std::string &id,
+      float x, float y,
+      float width, float height,
+      float healthPercent,
+      sf::Color fillColor,
+      sf::Color bgColor = sf::Color(60, 60, 60),
+      sf::Color outlineColor = sf::Color::White,
+      float outlineThickness = 2.f)
+  {
+    layer.panel(id + "Bg", {x, y}, {width, height}, bgColor, 0.f, outlineColor, outlineThickness);
+    layer.panel(id + "Fill", {x, y}, {width * std::clamp(healthPercent, 0.f, 1.f), height}, fillColor);
+  }
+
   // 绘制输入框
   inline void drawInputBox(
       sf::RenderWindow &window,
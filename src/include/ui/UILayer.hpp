@@ -0,0 +1,96 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// 文字对齐方式（以提交的 x 坐标为基准）
+enum class UIAlign
+{
+  Left,
+  Center,
+  Right
+};
+
+// 保留模式 UI 层：每帧按 id 提交文字/面板，内容、字号或尺寸不变时复用缓存的顶点，
+// 位置或显隐变化只重新拼接批次，所有控件按纹理合批（面板一批，每个字号的字形纹理一批）。
+// 注意：面板总是画在文字下面，同一批内按提交顺序绘制。
+class UILayer
+{
+public:
+  struct Stats
+  {
+    uint64_t geometryBuilds = 0; // 重建控件顶点（字形排版 / 形状三角化）
+    uint64_t batchBuilds = 0;    // 重新拼接批次
+    uint64_t drawCalls = 0;
+  };
+
+  explicit UILayer(const sf::Font &font) : m_font(&font) {}
+
+  // 开始新的一帧：本帧没有再提交的控件不再绘制（缓存保留，再次出现时直接复用）
+  void begin();
+
+  // 提交文字，返回本帧的全局包围盒（用于后续排版）
+  sf::FloatRect text(const std::string &id, const std::string &str, unsigned int size, sf::Color color,
+                     sf::Vector2f position, UIAlign align = UIAlign::Left, bool bold = false);
+
+  // 提交面板（radius > 0 时四角为圆角，描边画在面板外侧）
+  void panel(const std::string &id, sf::Vector2f position, sf::Vector2f size, sf::Color fill, float radius = 0.f,
+             sf::Color outline = sf::Color::Transparent, float outlineThickness = 0.f);
+
+  // 绘制本帧提交的全部控件（使用 target 当前的视图）
+  void draw(sf::RenderTarget &target);
+
+  // 丢弃所有缓存（字体重新加载后调用）
+  void clear();
+
+  const Stats &getStats() const { return m_stats; }
+
+private:
+  struct Widget
+  {
+    bool isText = false;
+
+    // 内容（变化时重建几何）
+    std::string str;
+    unsigned int size = 0;
+    bool bold = false;
+    sf::Vector2f panelSize;
+    float radius = 0.f;
+    float outlineThickness = 0.f;
+    sf::Color color;
+    sf::Color outline;
+
+    // 布局（变化时只重新拼接批次）
+    sf::Vector2f offset;
+
+    std::vector<sf::Vertex> vertices; // 局部坐标下的三角形
+    sf::FloatRect bounds;             // 局部包围盒
+    const sf::Texture *texture = nullptr;
+    bool hasGeometry = false;
+    uint64_t frame = 0; // 最近一次提交所在的帧
+  };
+
+  struct Batch
+  {
+    const sf::Texture *texture = nullptr;
+    std::vector<sf::Vertex> vertices;
+  };
+
+  Widget &submit(const std::string &id);
+  void buildText(Widget &widget);
+  void buildPanel(Widget &widget);
+  void recolor(Widget &widget);
+  void rebuildBatches();
+
+  const sf::Font *m_font;
+  std::unordered_map<std::string, Widget> m_widgets;
+  std::vector<const Widget *> m_frame;     // 本帧提交顺序
+  std::vector<const Widget *> m_lastFrame; // 上一次拼批时的提交顺序
+  std::vector<Batch> m_batches;
+  uint64_t m_frameId = 1;
+  bool m_dirty = true;
+  Stats m_stats;
+};
@@ -52,6 +52,7 @@ namespace GameColors
   const sf::Color MinimapEnemyNpc = sf::Color::Red;              // 敌方NPC
   const sf::Color MinimapInactiveNpc = sf::Color(128, 128, 128); // 未激活NPC
   const sf::Color MinimapDowned = sf::Color(100, 100, 100);      // 倒地状态
+  const sf::Color MinimapExit = sf::Color(0, 200, 0);            // 出口方向（无尽模式）
 }
 
 namespace Utils
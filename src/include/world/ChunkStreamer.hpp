@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "ChunkedMaze.hpp"
+#include "Maze.hpp"
+
+// 无尽模式（单人）：分块世界上的浮动原点窗口
+// Maze 只装载焦点所在区块周围 (2 * WINDOW_RADIUS + 1)^2 个区块；焦点进入相邻区块超过
+// RECENTER_MARGIN 格后以该区块为中心重建窗口，调用方把所有实体和相机平移 update() 给出的偏移量。
+// 离开窗口的区块把墙体改动和存活的 NPC 压缩成记录，再次进入窗口时恢复，
+// 因此渲染、碰撞与 NPC 模拟只覆盖窗口，内存与世界大小无关
+class ChunkStreamer
+{
+public:
+  static constexpr int WINDOW_RADIUS = 1;
+  static constexpr int WINDOW_TILES = (2 * WINDOW_RADIUS + 1) * ChunkedMaze::CHUNK_TILES;
+  static constexpr int RECENTER_MARGIN = 4; // 避免在区块边界来回走动时反复重建
+
+  // 换入的 NPC（窗口坐标）；health <= 0 表示第一次出现，使用满血
+  struct NpcSpawn
+  {
+    sf::Vector2f position;
+    float health = 0.f;
+  };
+
+  ChunkStreamer(uint64_t seed, int enemiesPerChunk);
+  ChunkStreamer(const ChunkStreamer &) = delete; // 区块回调持有 this
+  ChunkStreamer &operator=(const ChunkStreamer &) = delete;
+
+  // 以起点区块为中心载入第一个窗口，返回起点（窗口坐标）
+  sf::Vector2f start(Maze &maze);
+
+  // 焦点（窗口坐标）离中心区块足够远时重建窗口并返回 true，shift 为实体需要加上的平移量
+  bool update(sf::Vector2f focus, Maze &maze, sf::Vector2f &shift);
+
+  // 位置（窗口坐标）是否在当前窗口内
+  bool contains(sf::Vector2f position) const;
+
+  // 离开窗口的 NPC 记到所在区块，区块再次进入窗口时由 takeArrivals 交还
+  void pageOut(sf::Vector2f position, float health);
+
+  // 取出新进入窗口的区块中的 NPC：第一次到达的区块取自生成的 'X'，到过的区块取换出时的记录
+  std::vector<NpcSpawn> takeArrivals();
+
+  // 统计
+  std::size_t visitedChunks() const { return m_records.size(); }
+  std::size_t residentChunks() const { return m_chunks.residentChunks(); }
+
+private:
+  using ChunkCoord = ChunkedMaze::ChunkCoord;
+
+  // 世界格子坐标 + 格内偏移：离原点很远也不损失精度
+  struct NpcRecord
+  {
+    int tileX = 0;
+    int tileY = 0;
+    sf::Vector2f offset;
+    float health = 0.f;
+  };
+
+  // 到过的区块：墙体改动（世界格子坐标）与换出的 NPC
+  struct ChunkRecord
+  {
+    std::vector<WallDelta> walls;
+    std::vector<NpcRecord> npcs;
+  };
+
+  void onChunkLoaded(const ChunkedMaze::Chunk &chunk);
+  void captureWalls(const Maze &maze); // 窗口内区块的墙体改动以当前 Maze 为准
+  void loadWindow(Maze &maze);         // 按 m_center 换入区块并重建 Maze
+
+  ChunkedMaze m_chunks;
+  ChunkCoord m_center;
+  int m_originX = 0; // 窗口左上角的世界格子坐标
+  int m_originY = 0;
+  float m_tileSize = TILE_SIZE;
+  std::unordered_map<ChunkCoord, ChunkRecord, ChunkedMaze::ChunkCoordHash> m_records;
+  std::vector<NpcRecord> m_arrivals;
+};
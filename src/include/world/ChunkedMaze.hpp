@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// 分块迷宫（流式模式，不依赖 SFML，随机数见 MazeRandom.hpp）
+// 世界按 CHUNK_TILES x CHUNK_TILES 格切成区块，每个区块只由 (种子, 区块坐标) 决定，
+// 可以在任意时刻、以任意顺序单独生成；内存只与焦点附近的常驻区块数量成正比。
+//
+// 区块内部是房间网格上的完美迷宫（房间位于局部奇数坐标），区块只拥有自己的
+// 西侧一列和北侧一行墙，并在这两条边上各开一扇门；门的位置由边的哈希决定，
+// 相邻区块计算出的是同一扇门，因此整个世界连通。
+class ChunkedMaze
+{
+public:
+  static constexpr int CHUNK_ROOMS = 16;              // 区块边长（房间数）
+  static constexpr int CHUNK_TILES = CHUNK_ROOMS * 2; // 区块边长（格子数）
+  static constexpr int EXIT_DISTANCE = 4;             // 出口区块到原点区块的切比雪夫距离（区块数）
+
+  struct ChunkCoord
+  {
+    int x = 0;
+    int y = 0;
+    bool operator==(const ChunkCoord &other) const { return x == other.x && y == other.y; }
+  };
+
+  struct ChunkCoordHash
+  {
+    std::size_t operator()(const ChunkCoord &coord) const
+    {
+      return std::hash<int64_t>()((static_cast<int64_t>(coord.x) << 32) ^ static_cast<uint32_t>(coord.y));
+    }
+  };
+
+  struct Chunk
+  {
+    ChunkCoord coord;
+    std::vector<char> tiles; // 行优先，CHUNK_TILES * CHUNK_TILES
+  };
+
+  using ChunkCallback = std::function<void(const Chunk &chunk)>;
+
+  explicit ChunkedMaze(uint64_t seed, int enemiesPerChunk = 2, float destructibleRatio = 0.15f);
+
+  // 生成单个区块（纯函数：相同参数总是得到相同内容）
+  static void generateChunk(uint64_t seed, ChunkCoord coord, int enemiesPerChunk, float destructibleRatio,
+                            std::vector<char> &tiles);
+
+  // 保留焦点格子周围 radius 个区块内的区块，载入缺失的、换出其余的
+  void updateResidency(const std::vector<std::pair<int, int>> &focusTiles, int radius = 1);
+
+  // 世界格子坐标查询；所在区块未载入时视为不可破坏墙
+  char tileAt(int x, int y) const;
+  bool isLoaded(ChunkCoord coord) const { return m_chunks.count(coord) != 0; }
+  static ChunkCoord chunkOf(int tileX, int tileY);
+
+  // 出口：方向由种子决定，位于距原点 EXIT_DISTANCE 个区块的区块中央房间（世界格子坐标）
+  static std::pair<int, int> exitTile(uint64_t seed);
+  // 起点固定在原点区块的第一个房间
+  static std::pair<int, int> startTile() { return {1, 1}; }
+  uint64_t getSeed() const { return m_seed; }
+
+  // 换入/换出回调（渲染数据、NPC 模拟据此分页）
+  void setOnChunkLoaded(ChunkCallback cb) { m_onChunkLoaded = std::move(cb); }
+  void setOnChunkUnloaded(ChunkCallback cb) { m_onChunkUnloaded = std::move(cb); }
+
+  // 统计
+  std::size_t residentChunks() const { return m_chunks.size(); }
+  std::size_t residentBytes() const { return m_chunks.size() * CHUNK_TILES * CHUNK_TILES; }
+  uint64_t chunksGenerated() const { return m_chunksGenerated; }
+
+private:
+  uint64_t m_seed;
+  int m_enemiesPerChunk;
+  float m_destructibleRatio;
+  std::unordered_map<ChunkCoord, Chunk, ChunkCoordHash> m_chunks;
+  std::vector<ChunkCoord> m_wanted; // updateResidency 复用的缓冲
+  uint64_t m_chunksGenerated = 0;
+
+  ChunkCallback m_onChunkLoaded;
+  ChunkCallback m_onChunkUnloaded;
+};
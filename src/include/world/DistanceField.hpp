@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 迷宫墙体的有符号距离场（不依赖 SFML）
+// 每格 4x4 个采样点，存到最近墙体（按实际绘制的圆角矩形）的距离，墙内为负，超过一格的距离截断为一格。
+// 查询时双线性插值，同时给出梯度（指向远离墙体的方向），圆与墙的碰撞和滑动方向只需一次查询。
+class DistanceField
+{
+public:
+  static constexpr int SAMPLES_PER_TILE = 4;
+
+  // 每格的墙体信息：bit0 = 阻挡，bit1..4 = [左上, 右上, 右下, 左下] 是否圆角
+  static constexpr uint8_t CELL_BLOCKING = 1;
+  static uint8_t cornerBit(int corner) { return static_cast<uint8_t>(2 << corner); }
+
+  // inset：墙体相对格子边缘的内缩；cornerRadius：圆角半径
+  void reset(int cols, int rows, float tileSize, float inset, float cornerRadius);
+
+  // 只修改格子信息，需要之后调用 rebuild 或 patch
+  void setCell(int col, int row, uint8_t cell);
+
+  // 重新计算全部采样点
+  void rebuild();
+
+  // 格子 (col, row) 及其相邻格的形状变化后，只重算受影响的采样点
+  void patch(int col, int row);
+
+  // 插值后的有符号距离；gradX/gradY 非空时输出梯度
+  float distance(float x, float y, float *gradX = nullptr, float *gradY = nullptr) const;
+
+  // 截断距离（tileSize）：半径接近它时插值结果不再可靠，应使用精确检测
+  float maxDistance() const { return m_tileSize; }
+  bool empty() const { return m_samples.empty(); }
+  std::size_t memoryBytes() const { return m_samples.size() * sizeof(float) + m_cells.size(); }
+
+  void swap(DistanceField &other);
+
+private:
+  uint8_t cell(int col, int row) const
+  {
+    if (col < 0 || col >= m_cols || row < 0 || row >= m_rows)
+      return 0;
+    return m_cells[static_cast<std::size_t>(row) * m_cols + col];
+  }
+
+  // 采样点的精确距离（只看周围 3x3 个格子）
+  float exactDistance(float x, float y) const;
+  void computeSamples(int sx0, int sy0, int sx1, int sy1);
+
+  int m_cols = 0;
+  int m_rows = 0;
+  float m_tileSize = 1.f;
+  float m_inset = 0.f;
+  float m_cornerRadius = 0.f;
+  float m_spacing = 1.f;
+  int m_sampleCols = 0;
+  int m_sampleRows = 0;
+  std::vector<uint8_t> m_cells;
+  std::vector<float> m_samples;
+};
@@ -8,6 +8,10 @@
 #include "MazeGenerator.hpp"
 #include "Utils.hpp"
 #include "RoundedRectangle.hpp"
+#include "Raycast.hpp"
+#include "DistanceField.hpp"
+
+class ChunkedMaze;
 
 // 墙体类型
 enum class WallType
@@ -36,6 +40,26 @@ struct WallDestroyResult
   int gridY = 0;
 };
 
+// 联机同步的一次墙体变化：先在空格子放置，再扣除累计伤害
+struct WallChange
+{
+  int row = 0;
+  int col = 0;
+  bool placed = false;
+  bool destroyed = false; // 发送方已判定摧毁，无论剩余血量都摧毁
+  float damage = 0.f;
+};
+
+// 与原始地图（getMazeData）不同的可破坏墙格子，用于断线重连时同步墙体状态
+struct WallDelta
+{
+  int row = 0;
+  int col = 0;
+  bool present = false; // 现在有可破坏墙；false 表示原有的墙已被摧毁
+  WallAttribute attribute = WallAttribute::None;
+  float health = 0.f;
+};
+
 // 圆角半径常量
 constexpr float WALL_CORNER_RADIUS = 12.f;
 
@@ -86,16 +110,29 @@ public:
   // 生成随机迷宫（使用 MazeGenerator）
   void generateRandomMaze(int width, int height, unsigned int seed = 0, int enemyCount = 8, bool multiplayerMode = false, bool escapeMode = false);
 
+  // 交换两个迷宫的全部内容（O(1)，用于换入后台预生成的迷宫）
+  void swap(Maze &other);
+
   // 获取迷宫数据（用于网络传输）
   std::vector<std::string> getMazeData() const { return m_mazeData; }
 
+  // 生成该迷宫所用的种子（loadFromString 载入的迷宫为 0）
+  unsigned int getSeed() const { return m_seed; }
+
   void update(float dt);
   void draw(sf::RenderWindow &window) const;
   void render(sf::RenderWindow &window) const { draw(window); } // 别名
 
-  // 碰撞检测
+  // 碰撞检测（半径小于一格时查距离场，否则逐个墙体精确检测）
   bool checkCollision(sf::Vector2f position, float radius) const;
 
+  // 到最近墙体的有符号距离（墙内为负），normal 非空时输出远离墙体的单位方向
+  float getWallDistance(sf::Vector2f position, sf::Vector2f *normal = nullptr) const;
+
+  // 统一的移动解算（玩家、对方坦克与 NPC 共用）：
+  // 从 from 移动到 to，撞墙时去掉撞向墙面的分量沿墙滑动，已经卡在墙里时沿法线推出
+  sf::Vector2f resolveMovement(sf::Vector2f from, sf::Vector2f to, float radius) const;
+
   // 子弹与墙壁碰撞，返回是否击中，同时处理可破坏墙
   bool bulletHit(sf::Vector2f bulletPos, float damage);
 
@@ -148,30 +185,47 @@ public:
   // 网络同步：应用墙壁伤害（用于非房主接收同步数据）
   WallDestroyResult applyWallDamage(int row, int col, float damage, bool forceDestroy = false);
 
+  // 按顺序应用一批墙体变化，圆角、占用网格与距离场整批只更新一次；返回值与 changes 一一对应
+  std::vector<WallDestroyResult> applyWallChanges(const std::vector<WallChange> &changes);
+
   // 世界坐标转网格坐标
   GridPos worldToGrid(sf::Vector2f pos) const;
 
   // 网格坐标转世界坐标（返回格子中心）
   sf::Vector2f gridToWorld(GridPos grid) const;
 
-  // 视线检测：检查从 start 到 end 是否有清晰视线
+  // 视线检测：检查从 start 到 end 是否有清晰视线（基于占用网格的精确格子遍历）
   // 返回值：0 = 无阻挡, 1 = 有可拆墙阻挡, 2 = 有不可拆墙阻挡
   int checkLineOfSight(sf::Vector2f start, sf::Vector2f end) const;
 
   // 精确射击检测：检查子弹从 start 射向 target 是否能命中
   // 返回值：0 = 可以命中, 1 = 会先命中可破坏墙, 2 = 会先命中不可破坏墙
-  // 这个函数使用更细的步进来模拟子弹轨迹
   int checkBulletPath(sf::Vector2f start, sf::Vector2f target) const;
 
   // 获取视线方向上第一个被阻挡的位置（用于判断是否应该攻击可拆墙）
   sf::Vector2f getFirstBlockedPosition(sf::Vector2f start, sf::Vector2f end) const;
 
+  // 按位打包的墙体占用网格（与 m_walls 同步），批量射线检测直接使用
+  const OccupancyGrid &getOccupancy() const { return m_occupancy; }
+
   // 检查某个位置是否可以放置墙壁（空地且不在出口/起点）
   bool canPlaceWall(sf::Vector2f worldPos) const;
 
   // 在指定位置放置一个棕色墙壁
   bool placeWall(sf::Vector2f worldPos);
 
+  // 断线重连：与原始地图相比被摧毁、受损或新放置的可破坏墙
+  std::vector<WallDelta> getWallDeltas() const;
+
+  // 恢复为原始地图后应用 deltas（整体重建占用网格与距离场）
+  void restoreWallDeltas(const std::vector<WallDelta> &deltas);
+
+  // 无尽模式：载入分块世界中以世界格子 (originX, originY) 为左上角、size x size 格的常驻窗口，
+  // 再应用窗口坐标下的墙体改动。'X' 不记录为生成点（NPC 由调用方按区块换入），
+  // 起点和出口换算到窗口坐标，不在窗口内时位于网格之外
+  void loadChunkWindow(const ChunkedMaze &chunks, int originX, int originY, int size,
+                       const std::vector<WallDelta> &deltas);
+
 private:
   // 检查某个格子是否是墙（用于圆角计算）
   bool isWall(int row, int col) const;
@@ -179,7 +233,24 @@ private:
   // 计算所有墙体的圆角
   void calculateRoundedCorners();
 
+  // 逐个墙体的精确圆角矩形碰撞（大半径时使用）
+  bool checkCollisionExact(sf::Vector2f position, float radius) const;
+
+  // 同步单个格子到占用网格与距离场（不重算距离场采样）
+  void syncOccupancy(int row, int col);
+
+  // 墙体被摧毁或放置后：同步该格与相邻格，并局部重算距离场
+  void onWallChanged(int row, int col);
+
+  // 把格子设为满血的棕色可破坏墙（放置墙壁与断线重连共用）
+  void setPlacedWall(int row, int col);
+
+  // 在当前地图上应用墙体改动并整体重建占用网格与距离场
+  void applyWallDeltas(const std::vector<WallDelta> &deltas);
+
   std::vector<std::vector<Wall>> m_walls;
+  OccupancyGrid m_occupancy;
+  DistanceField m_distanceField;
   std::vector<std::string> m_mazeData; // 保存原始迷宫数据用于网络传输
   sf::Vector2f m_startPosition;
   sf::Vector2f m_exitPosition;
@@ -190,6 +261,7 @@ private:
   int m_rows = 0;
   int m_cols = 0;
   float m_tileSize = TILE_SIZE;
+  unsigned int m_seed = 0;
 
   // 颜色
   const sf::Color m_solidColor = sf::Color(80, 80, 80);
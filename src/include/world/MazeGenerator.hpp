@@ -1,19 +1,25 @@
 #pragma once
 
+#include <array>
 #include <vector>
 #include <string>
-#include <random>
+#include "MazeRandom.hpp"
 
 class MazeGenerator
 {
 public:
+  // 生成算法版本：相同版本 + 种子 + 参数在任何平台上生成相同迷宫（MazeSeed 同步依赖这一点）
+  // 任何会改变输出的修改都要递增该版本
+  static constexpr uint8_t ALGORITHM_VERSION = 2;
+
   MazeGenerator(int width, int height);
 
   // 生成随机迷宫
   std::vector<std::string> generate();
 
-  // 设置随机种子
+  // 设置随机种子；未设置时 generate() 随机选取
   void setSeed(unsigned int seed);
+  unsigned int getSeed() const { return m_seed; }
 
   // 设置敌人数量
   void setEnemyCount(int count) { m_enemyCount = count; }
@@ -32,18 +38,36 @@ public:
   std::pair<int, int> getSpawn2() const { return {m_spawn2X, m_spawn2Y}; }
 
 private:
-  void carvePassage(int x, int y);
+  // 回溯挖通道的显式栈帧（替代递归，避免大地图栈溢出）
+  struct CarveFrame
+  {
+    int x, y;
+    std::array<int, 4> dirs;
+    int next; // 下一个要尝试的方向下标
+  };
+
+  char &cell(int x, int y) { return m_grid[static_cast<std::size_t>(y) * m_width + x]; }
+
+  void carvePassages(int startX, int startY);
   void placeEnemies();
   void placeDestructibleWalls();
   void placeStartAndEnd();                                     // 随机放置起点和终点
   void placeMultiplayerSpawns();                               // 放置多人模式两个出生点
-  void ensurePath(int startX, int startY, int endX, int endY); // 确保起点到终点有路径
-  std::vector<std::pair<int, int>> getEmptySpaces();           // 获取所有空地
+  void ensurePath(int startX, int startY, int endX, int endY,
+                  const std::vector<int> &distance); // 确保起点到终点有路径（distance 为起点的距离图）
+  void collectOpenCells();                           // 收集所有空地（挖完通道后一次）
+  void computeDistances(int fromX, int fromY, std::vector<int> &distance); // BFS 距离图，-1 表示不可达
 
   int m_width;
   int m_height;
-  std::vector<std::vector<char>> m_grid;
-  std::mt19937 m_rng;
+  std::vector<char> m_grid; // 行优先的一维网格
+  std::vector<CarveFrame> m_carveStack;
+
+  // 放置步骤共用的空地列表与距离图（单人：[0] 为起点；多人：[0]/[1] 为两个出生点）
+  std::vector<std::pair<int, int>> m_openCells;
+  std::vector<int> m_distance[2];
+  std::vector<int> m_bfsQueue;
+  MazeRandom m_rng;
   unsigned int m_seed = 0;
   bool m_seedSet = false;
 
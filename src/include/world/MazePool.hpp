@@ -0,0 +1,65 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Maze.hpp"
+
+// 迷宫预生成参数（同一参数的迷宫可以互相替换）
+struct MazeRequest
+{
+  int width = 41;
+  int height = 31;
+  int enemyCount = 8;
+  bool multiplayer = false;
+  bool escape = false;
+
+  bool operator==(const MazeRequest &other) const
+  {
+    return width == other.width && height == other.height && enemyCount == other.enemyCount &&
+           multiplayer == other.multiplayer && escape == other.escape;
+  }
+};
+
+// 后台迷宫池：工作线程生成网格并构建墙体几何（不涉及纹理/OpenGL），
+// 主线程开局时直接换入现成的迷宫，避免大地图卡顿
+class MazePool
+{
+public:
+  static constexpr std::size_t MAX_READY = 4;   // 最多缓存的现成迷宫
+  static constexpr std::size_t MAX_PENDING = 4; // 最多排队的生成任务
+
+  MazePool();
+  ~MazePool();
+
+  MazePool(const MazePool &) = delete;
+  MazePool &operator=(const MazePool &) = delete;
+
+  // 确保该参数有一个迷宫已就绪或正在生成（重复调用无副作用）
+  void prefetch(const MazeRequest &request);
+
+  // 取出一个现成迷宫并与 out 交换；没有现成的返回 false
+  bool take(const MazeRequest &request, Maze &out);
+
+private:
+  struct ReadyMaze
+  {
+    MazeRequest request;
+    std::unique_ptr<Maze> maze;
+  };
+
+  void workerLoop();
+  bool isKnown(const MazeRequest &request) const; // 调用方需持有 m_mutex
+
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  std::deque<MazeRequest> m_pending;
+  std::deque<ReadyMaze> m_ready;
+  bool m_busy = false;
+  MazeRequest m_current; // 正在生成的参数（m_busy 时有效）
+  bool m_stop = false;
+  std::thread m_worker;
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <utility>
+
+// 可移植的迷宫随机数（SplitMix64 + 自带的 Fisher-Yates 洗牌）
+// 不依赖标准库分布和 std::shuffle 的实现细节，不同编译器/平台上相同种子输出一致。
+// 修改这里的任何算法都会改变迷宫内容，必须同时递增 MazeGenerator::ALGORITHM_VERSION
+class MazeRandom
+{
+public:
+  explicit MazeRandom(uint64_t seed = 0) : m_state(seed) {}
+
+  void seed(uint64_t seed) { m_state = seed; }
+
+  // SplitMix64 的混合函数（也用于由坐标派生种子）
+  static uint64_t mix(uint64_t x)
+  {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+  }
+
+  uint64_t next() { return mix(m_state++); }
+
+  // [0, bound) 内的整数；bound 为 0 时返回 0
+  uint32_t below(uint32_t bound)
+  {
+    return static_cast<uint32_t>(((next() >> 32) * static_cast<uint64_t>(bound)) >> 32);
+  }
+
+  // [0, 1) 内的浮点数（24 位精度）
+  float unit() { return static_cast<float>(next() >> 40) / static_cast<float>(1u << 24); }
+
+  template <typename It>
+  void shuffle(It first, It last)
+  {
+    auto n = std::distance(first, last);
+    for (auto i = n - 1; i > 0; --i)
+    {
+      auto j = static_cast<decltype(i)>(below(static_cast<uint32_t>(i + 1)));
+      using std::swap;
+      swap(first[i], first[j]);
+    }
+  }
+
+private:
+  uint64_t m_state;
+};
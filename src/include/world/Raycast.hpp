@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 射线检测用的按位打包占用网格（不依赖 SFML，客户端、服务器模拟与 tank_bench 共用）
+// 每格 2 位，一个 64 位字存 32 格；151x101 的迷宫不到 4 KB，整张图常驻 L1
+
+// 格子阻挡类型（数值越大越严重）
+enum class CellBlock : uint8_t
+{
+  Empty = 0,
+  Destructible = 1,
+  Solid = 2
+};
+
+// 射线遍历方式
+enum class RayMode : uint8_t
+{
+  FirstHit,   // 停在第一个墙格（子弹轨迹）
+  LineOfSight // 穿过可破坏墙，停在第一个不可破坏墙（视线，结果取最严重的阻挡）
+};
+
+// 世界坐标下的线段
+struct RayQuery
+{
+  float x0, y0;
+  float x1, y1;
+};
+
+struct RayHit
+{
+  CellBlock block = CellBlock::Empty; // FirstHit：第一个阻挡；LineOfSight：最严重的阻挡
+  int col = -1;                       // 第一个阻挡格（无阻挡为 -1）
+  int row = -1;
+  float t = 1.f; // 射线进入第一个阻挡格时的位置（0 = 起点，1 = 终点）
+};
+
+class OccupancyGrid
+{
+public:
+  // 重置尺寸并清空为 Empty
+  void resize(int cols, int rows, float tileSize);
+
+  void set(int col, int row, CellBlock block);
+
+  // 越界视为 Empty（射线可以从地图外穿入）
+  CellBlock get(int col, int row) const
+  {
+    if (col < 0 || col >= m_cols || row < 0 || row >= m_rows)
+      return CellBlock::Empty;
+    std::size_t index = static_cast<std::size_t>(row) * m_cols + col;
+    return static_cast<CellBlock>((m_bits[index >> 5] >> ((index & 31) * 2)) & 3);
+  }
+
+  // Amanatides–Woo 网格遍历：按顺序精确访问线段经过的每个格子（含起点与终点格）
+  RayHit castRay(const RayQuery &ray, RayMode mode = RayMode::FirstHit) const;
+
+  // 批量检测：一次回答多条射线，out 至少有 count 个元素
+  void castRays(const RayQuery *rays, std::size_t count, RayHit *out, RayMode mode = RayMode::FirstHit) const;
+
+  int cols() const { return m_cols; }
+  int rows() const { return m_rows; }
+  float tileSize() const { return m_tileSize; }
+  std::size_t memoryBytes() const { return m_bits.size() * sizeof(uint64_t); }
+
+  void swap(OccupancyGrid &other);
+
+private:
+  int m_cols = 0;
+  int m_rows = 0;
+  float m_tileSize = 1.f;
+  float m_invTileSize = 1.f;
+  std::vector<uint64_t> m_bits;
+};
@@ -0,0 +1,107 @@
+#include "InterestManager.hpp"
+#include "Raycast.hpp"
+#include "Utils.hpp"
+#include <algorithm>
+#include <cmath>
+
+void InterestManager::reset()
+{
+  m_entries.clear();
+  m_hasObserver = false;
+  m_time = 0.f;
+  m_insideCount = 0;
+  m_outsideCount = 0;
+}
+
+void InterestManager::beginFrame(float dt, bool hasObserver, sf::Vector2f observer)
+{
+  m_time += dt;
+  m_hasObserver = hasObserver;
+  m_observer = observer;
+  m_insideCount = 0;
+  m_outsideCount = 0;
+}
+
+bool InterestManager::shouldSendUpdate(std::size_t index, sf::Vector2f position)
+{
+  if (index >= m_entries.size())
+    m_entries.resize(index + 1);
+  Entry &entry = m_entries[index];
+
+  bool inside = true;
+  if (m_hasObserver)
+  {
+    float dx = position.x - m_observer.x;
+    float dy = position.y - m_observer.y;
+    inside = dx * dx + dy * dy <= RADIUS * RADIUS;
+  }
+  bool entered = inside && !entry.inside;
+  entry.inside = inside;
+
+  if (entry.lastSent < 0.f)
+  {
+    // 第一次出现：发送一次，并按下标错开之后的低频发送时刻
+    entry.lastSent = m_time - FAR_INTERVAL * static_cast<float>(index % 8) / 8.f;
+    if (inside)
+    {
+      m_insideCount++;
+      m_stats.nearUpdates++;
+    }
+    else
+    {
+      m_outsideCount++;
+      m_stats.farUpdates++;
+    }
+    return true;
+  }
+
+  if (inside)
+  {
+    m_insideCount++;
+    entry.lastSent = m_time;
+    if (entered)
+      m_stats.forcedUpdates++;
+    else
+      m_stats.nearUpdates++;
+    return true;
+  }
+
+  m_outsideCount++;
+  if (m_time - entry.lastSent >= FAR_INTERVAL)
+  {
+    // 保持原有相位，不随帧长漂移到同一帧
+    entry.lastSent = std::max(entry.lastSent + FAR_INTERVAL, m_time - FAR_INTERVAL);
+    m_stats.farUpdates++;
+    return true;
+  }
+  m_stats.skippedUpdates++;
+  return false;
+}
+
+bool InterestManager::shouldSendShot(const OccupancyGrid &grid, sf::Vector2f start, float angleDegrees)
+{
+  if (!m_hasObserver)
+  {
+    m_stats.shotsSent++;
+    return true;
+  }
+
+  // 子弹停在第一堵墙：射线长度取地图对角线以上，保证一定出图或撞墙
+  float reach = static_cast<float>(grid.cols() + grid.rows()) * grid.tileSize();
+  float angleRad = (angleDegrees - 90.f) * Utils::PI / 180.f; // 与 Bullet 的角度约定一致（0 度朝上）
+  sf::Vector2f dir(std::cos(angleRad), std::sin(angleRad));
+  RayHit hit = grid.castRay({start.x, start.y, start.x + dir.x * reach, start.y + dir.y * reach}, RayMode::FirstHit);
+  float length = reach * hit.t + grid.tileSize(); // 多算一格：子弹半径与撞墙判定的余量
+
+  // 轨迹线段到接收方的最近距离
+  sf::Vector2f toObserver = m_observer - start;
+  float along = std::clamp(toObserver.x * dir.x + toObserver.y * dir.y, 0.f, length);
+  sf::Vector2f closest = start + dir * along - m_observer;
+  if (closest.x * closest.x + closest.y * closest.y <= RADIUS * RADIUS)
+  {
+    m_stats.shotsSent++;
+    return true;
+  }
+  m_stats.shotsCulled++;
+  return false;
+}
@@ -0,0 +1,100 @@
+#include "Lockstep.hpp"
+#include <iterator>
+
+void LockstepSession::start(int localSlot)
+{
+  m_active = true;
+  m_localSlot = localSlot;
+  m_tick = 0;
+  m_nextLocalTick = INPUT_DELAY;
+  for (uint32_t t = 0; t < WINDOW; t++)
+    m_inputs[t] = Slot{};
+  for (uint32_t t = 0; t < INPUT_DELAY; t++)
+  {
+    Slot &slot = m_inputs[t];
+    slot.tick = t;
+    slot.has[0] = slot.has[1] = true;
+  }
+  m_localHashes.clear();
+  m_remoteHashes.clear();
+  m_desynced = false;
+  m_desyncTick = 0;
+  m_stats = Stats{};
+}
+
+uint32_t LockstepSession::pushLocalInput(const LockstepInput &input)
+{
+  uint32_t tick = m_nextLocalTick++;
+  Slot &slot = m_inputs[tick % WINDOW];
+  if (slot.tick != tick)
+  {
+    slot = Slot{};
+    slot.tick = tick;
+  }
+  slot.input[m_localSlot] = input;
+  slot.has[m_localSlot] = true;
+  m_stats.inputsSent++;
+  return tick;
+}
+
+void LockstepSession::receiveRemoteInput(uint32_t tick, const LockstepInput &input)
+{
+  if (!m_active || tick < m_tick || tick >= m_tick + WINDOW)
+    return;
+  Slot &slot = m_inputs[tick % WINDOW];
+  if (slot.tick != tick)
+  {
+    slot = Slot{};
+    slot.tick = tick;
+  }
+  int remote = remoteSlot();
+  slot.input[remote] = input;
+  slot.has[remote] = true;
+  m_stats.inputsReceived++;
+}
+
+bool LockstepSession::ready() const
+{
+  const Slot &slot = m_inputs[m_tick % WINDOW];
+  return m_active && slot.tick == m_tick && slot.has[0] && slot.has[1];
+}
+
+void LockstepSession::advance()
+{
+  Slot &slot = m_inputs[m_tick % WINDOW];
+  slot.has[0] = slot.has[1] = false;
+  m_tick++;
+  m_stats.ticks++;
+}
+
+void LockstepSession::recordLocalHash(uint32_t tick, uint64_t hash)
+{
+  m_localHashes[tick] = hash;
+  compareHash(tick);
+}
+
+void LockstepSession::receiveRemoteHash(uint32_t tick, uint64_t hash)
+{
+  if (!m_active)
+    return;
+  m_remoteHashes[tick] = hash;
+  compareHash(tick);
+}
+
+void LockstepSession::compareHash(uint32_t tick)
+{
+  auto local = m_localHashes.find(tick);
+  auto remote = m_remoteHashes.find(tick);
+  if (local == m_localHashes.end() || remote == m_remoteHashes.end())
+    return;
+
+  m_stats.hashesCompared++;
+  if (local->second != remote->second && !m_desynced)
+  {
+    m_desynced = true;
+    m_desyncTick = tick;
+  }
+  // 双方按步号顺序产生哈希，配对后连同更早的一起清理
+  m_localHashes.erase(m_localHashes.begin(), std::next(local));
+  m_remoteHashes.erase(m_remoteHashes.begin(), std::next(remote));
+}
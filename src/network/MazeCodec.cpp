@@ -0,0 +1,309 @@
+#include "MazeCodec.hpp"
+#include "NetProtocol.hpp"
+#include <algorithm>
+
+namespace
+{
+  constexpr uint64_t FNV_OFFSET = 14695981039346656037ull;
+  constexpr uint64_t FNV_PRIME = 1099511628211ull;
+  constexpr std::size_t ENCODED_HEADER_SIZE = 5; // 宽(2) + 高(2) + 符号表长度(1)
+  constexpr std::size_t SHORT_RUN_MAX = 15;
+
+  void fnvByte(uint64_t &h, uint8_t b)
+  {
+    h ^= b;
+    h *= FNV_PRIME;
+  }
+
+  void writeU16(std::vector<uint8_t> &out, std::size_t value)
+  {
+    out.push_back(static_cast<uint8_t>(value & 0xFF));
+    out.push_back(static_cast<uint8_t>((value >> 8) & 0xFF));
+  }
+
+  // 读取一个游程；varint 截断或过长时返回 false
+  bool readRun(const uint8_t *data, std::size_t len, std::size_t &offset, std::size_t &symbol, std::size_t &run)
+  {
+    uint8_t byte = data[offset++];
+    symbol = byte >> 4;
+    run = (byte & 0x0F) + 1;
+    if (run <= SHORT_RUN_MAX)
+      return true;
+
+    std::size_t extra = 0;
+    int shift = 0;
+    uint8_t next;
+    do
+    {
+      if (offset >= len || shift > 28)
+        return false;
+      next = data[offset++];
+      extra |= static_cast<std::size_t>(next & 0x7F) << shift;
+      shift += 7;
+    } while (next & 0x80);
+    run = SHORT_RUN_MAX + 1 + extra;
+    return true;
+  }
+
+  void writeRun(std::vector<uint8_t> &out, uint8_t symbol, std::size_t run)
+  {
+    if (run <= SHORT_RUN_MAX)
+    {
+      out.push_back(static_cast<uint8_t>((symbol << 4) | (run - 1)));
+      return;
+    }
+    out.push_back(static_cast<uint8_t>((symbol << 4) | 0x0F));
+    std::size_t extra = run - SHORT_RUN_MAX - 1;
+    do
+    {
+      uint8_t byte = static_cast<uint8_t>(extra & 0x7F);
+      extra >>= 7;
+      out.push_back(extra ? (byte | 0x80) : byte);
+    } while (extra);
+  }
+}
+
+uint64_t MazeCodec::hash(const std::vector<std::string> &rows)
+{
+  uint64_t h = FNV_OFFSET;
+  std::size_t width = rows.empty() ? 0 : rows[0].size();
+  fnvByte(h, static_cast<uint8_t>(width & 0xFF));
+  fnvByte(h, static_cast<uint8_t>((width >> 8) & 0xFF));
+  fnvByte(h, static_cast<uint8_t>(rows.size() & 0xFF));
+  fnvByte(h, static_cast<uint8_t>((rows.size() >> 8) & 0xFF));
+  for (const auto &row : rows)
+  {
+    for (char c : row)
+      fnvByte(h, static_cast<uint8_t>(c));
+  }
+  return h;
+}
+
+bool MazeCodec::encode(const std::vector<std::string> &rows, std::vector<uint8_t> &out)
+{
+  out.clear();
+  std::size_t width = rows.empty() ? 0 : rows[0].size();
+  if (width > MAX_DIMENSION || rows.size() > MAX_DIMENSION)
+    return false;
+
+  // 符号表（按首次出现顺序）
+  std::vector<char> symbols;
+  uint8_t index[256];
+  std::fill(std::begin(index), std::end(index), 0xFF);
+  for (const auto &row : rows)
+  {
+    if (row.size() != width)
+      return false;
+    for (char c : row)
+    {
+      uint8_t &slot = index[static_cast<uint8_t>(c)];
+      if (slot != 0xFF)
+        continue;
+      if (symbols.size() >= MAX_SYMBOLS)
+        return false;
+      slot = static_cast<uint8_t>(symbols.size());
+      symbols.push_back(c);
+    }
+  }
+
+  writeU16(out, width);
+  writeU16(out, rows.size());
+  out.push_back(static_cast<uint8_t>(symbols.size()));
+  for (char c : symbols)
+    out.push_back(static_cast<uint8_t>(c));
+
+  // 按行优先展开为一维序列做游程编码（游程可以跨行）
+  uint8_t current = 0;
+  std::size_t run = 0;
+  for (const auto &row : rows)
+  {
+    for (char c : row)
+    {
+      uint8_t symbol = index[static_cast<uint8_t>(c)];
+      if (run > 0 && symbol == current)
+      {
+        run++;
+        continue;
+      }
+      if (run > 0)
+        writeRun(out, current, run);
+      current = symbol;
+      run = 1;
+    }
+  }
+  if (run > 0)
+    writeRun(out, current, run);
+  return true;
+}
+
+bool MazeCodec::decode(const uint8_t *data, std::size_t len, std::vector<std::string> &rows)
+{
+  rows.clear();
+  if (len < ENCODED_HEADER_SIZE)
+    return false;
+
+  // 宽高来自对端，先限制范围，再确认游程总长与宽高一致，之后才分配内存
+  std::size_t width = data[0] | (data[1] << 8);
+  std::size_t height = data[2] | (data[3] << 8);
+  if (width > MAX_DIMENSION || height > MAX_DIMENSION)
+    return false;
+  std::size_t symbolCount = data[4];
+  std::size_t offset = ENCODED_HEADER_SIZE;
+  if (symbolCount > MAX_SYMBOLS || offset + symbolCount > len)
+    return false;
+  const uint8_t *symbols = data + offset;
+  offset += symbolCount;
+
+  const std::size_t total = width * height;
+  const std::size_t runsOffset = offset;
+  std::size_t counted = 0;
+  std::size_t symbol, run;
+  while (offset < len)
+  {
+    if (!readRun(data, len, offset, symbol, run) || symbol >= symbolCount || run > total - counted)
+      return false;
+    counted += run;
+  }
+  if (counted != total)
+    return false;
+
+  std::string cells;
+  cells.reserve(total);
+  offset = runsOffset;
+  while (offset < len)
+  {
+    readRun(data, len, offset, symbol, run);
+    cells.append(run, static_cast<char>(symbols[symbol]));
+  }
+
+  rows.reserve(height);
+  for (std::size_t r = 0; r < height; r++)
+    rows.emplace_back(cells, r * width, width);
+  return true;
+}
+
+std::vector<std::vector<uint8_t>> MazeCodec::buildChunks(const std::vector<std::string> &rows, uint8_t modeFlags,
+                                                         uint64_t &hashOut)
+{
+  std::vector<std::vector<uint8_t>> chunks;
+  std::vector<uint8_t> encoded;
+  if (!encode(rows, encoded))
+    return chunks;
+
+  hashOut = hash(rows);
+  std::size_t count = (encoded.size() + CHUNK_PAYLOAD_SIZE - 1) / CHUNK_PAYLOAD_SIZE;
+  if (count > MAX_CHUNKS)
+    return chunks;
+
+  for (std::size_t i = 0; i < count; i++)
+  {
+    std::size_t begin = i * CHUNK_PAYLOAD_SIZE;
+    std::size_t end = std::min(encoded.size(), begin + CHUNK_PAYLOAD_SIZE);
+
+    std::vector<uint8_t> chunk;
+    chunk.reserve(CHUNK_HEADER_SIZE + end - begin);
+    chunk.push_back(static_cast<uint8_t>(NetMessageType::MazeChunk));
+    chunk.push_back(modeFlags);
+    writeHash(chunk, hashOut);
+    writeU16(chunk, i);
+    writeU16(chunk, count);
+    chunk.insert(chunk.end(), encoded.begin() + begin, encoded.begin() + end);
+    chunks.push_back(std::move(chunk));
+  }
+  return chunks;
+}
+
+std::vector<uint8_t> MazeCodec::buildSeedMessage(const MazeSeedParams &params, uint8_t modeFlags, uint64_t hash)
+{
+  std::vector<uint8_t> message;
+  message.reserve(SEED_MESSAGE_SIZE);
+  message.push_back(static_cast<uint8_t>(NetMessageType::MazeSeed));
+  message.push_back(modeFlags);
+  message.push_back(params.version);
+  for (int i = 0; i < 4; i++)
+    message.push_back(static_cast<uint8_t>((params.seed >> (i * 8)) & 0xFF));
+  writeU16(message, params.width);
+  writeU16(message, params.height);
+  writeU16(message, params.enemyCount);
+  writeHash(message, hash);
+  return message;
+}
+
+bool MazeCodec::parseSeedMessage(const std::vector<uint8_t> &message, MazeSeedParams &params, uint8_t &modeFlags,
+                                 uint64_t &hash)
+{
+  if (message.size() < SEED_MESSAGE_SIZE)
+    return false;
+
+  modeFlags = message[1];
+  params.version = message[2];
+  params.seed = 0;
+  for (int i = 0; i < 4; i++)
+    params.seed |= static_cast<uint32_t>(message[3 + i]) << (i * 8);
+  params.width = static_cast<uint16_t>(message[7] | (message[8] << 8));
+  params.height = static_cast<uint16_t>(message[9] | (message[10] << 8));
+  params.enemyCount = static_cast<uint16_t>(message[11] | (message[12] << 8));
+  hash = readHash(message.data() + 13);
+  return params.width <= MAX_DIMENSION && params.height <= MAX_DIMENSION; // 接收方会按该尺寸重新生成
+}
+
+void MazeCodec::writeHash(std::vector<uint8_t> &out, uint64_t hash)
+{
+  for (int i = 0; i < 8; i++)
+    out.push_back(static_cast<uint8_t>((hash >> (i * 8)) & 0xFF));
+}
+
+uint64_t MazeCodec::readHash(const uint8_t *data)
+{
+  uint64_t hash = 0;
+  for (int i = 0; i < 8; i++)
+    hash |= static_cast<uint64_t>(data[i]) << (i * 8);
+  return hash;
+}
+
+bool MazeChunkAssembler::add(const std::vector<uint8_t> &message)
+{
+  if (message.size() < MazeCodec::CHUNK_HEADER_SIZE)
+    return false;
+
+  uint8_t modeFlags = message[1];
+  uint64_t hash = MazeCodec::readHash(message.data() + 2);
+  std::size_t index = message[10] | (message[11] << 8);
+  std::size_t count = message[12] | (message[13] << 8);
+  if (count == 0 || count > MazeCodec::MAX_CHUNKS || index >= count)
+    return false;
+
+  // 新的迷宫：丢弃未完成或旧的分块
+  if (hash != m_hash || modeFlags != m_modeFlags || count != m_chunks.size())
+  {
+    clear();
+    m_hash = hash;
+    m_modeFlags = modeFlags;
+    m_chunks.resize(count);
+  }
+
+  if (m_chunks[index].empty())
+    m_received++;
+  m_chunks[index] = message;
+  return true;
+}
+
+void MazeChunkAssembler::clear()
+{
+  m_hash = 0;
+  m_modeFlags = 0;
+  m_chunks.clear();
+  m_received = 0;
+}
+
+bool MazeChunkAssembler::decode(std::vector<std::string> &rows) const
+{
+  if (!complete())
+    return false;
+
+  std::vector<uint8_t> encoded;
+  for (const auto &chunk : m_chunks)
+    encoded.insert(encoded.end(), chunk.begin() + MazeCodec::CHUNK_HEADER_SIZE, chunk.end());
+
+  return MazeCodec::decode(encoded.data(), encoded.size(), rows) && MazeCodec::hash(rows) == m_hash;
+}
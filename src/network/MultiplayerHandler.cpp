@@ -3,11 +3,80 @@
 #include "CollisionSystem.hpp"
 #include "Utils.hpp"
 #include "AudioManager.hpp"
+#include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <cstdio>
 #include <iostream>
 #include <limits>
 
+namespace
+{
+  // Escape 模式救援与终点确认
+  constexpr float RESCUE_DISTANCE = 60.f;
+  constexpr float RESCUE_TIME = 3.0f;    // 3秒救援时间
+  constexpr float EXIT_HOLD_TIME = 3.0f; // 按住E键3秒
+
+  // 帧同步模式下的 NPC 激活（与普通联机一致）
+  constexpr float AUTO_ACTIVATE_DISTANCE = 600.f; // Escape 模式 NPC 自动激活
+  constexpr float ACTIVATE_DISTANCE = 80.f;       // Battle 模式按 R 激活
+  constexpr int ACTIVATE_COST = 3;
+
+  // 卡顿后每帧最多追赶的步数
+  constexpr int MAX_LOCKSTEP_TICKS_PER_FRAME = 8;
+
+  // 服务器权威模拟：输入至少按服务器步长上报一次（按键变化时立即上报）
+  constexpr float INPUT_SEND_INTERVAL = 1.f / 30.f;
+  constexpr std::size_t MAX_PREDICTED_INPUTS = 128;
+  // 预测误差：小于死区不校正（服务器晚一步处理输入本身就有约一步的移动差），超过瞬移距离直接对齐
+  constexpr float RECONCILE_DEADZONE = 8.f;
+  constexpr float RECONCILE_SNAP_DISTANCE = 3.f * TILE_SIZE;
+  constexpr float RECONCILE_BLEND = 0.2f; // 每次收到服务器状态时消除的误差比例
+
+  // 网络诊断面板最多列出的消息类型数
+  constexpr int NET_STATS_MAX_TYPES = 8;
+
+  std::string formatBytesPerSec(float bytesPerSec)
+  {
+    char buffer[32];
+    if (bytesPerSec >= 1024.f)
+      std::snprintf(buffer, sizeof(buffer), "%.1f KB/s", bytesPerSec / 1024.f);
+    else
+      std::snprintf(buffer, sizeof(buffer), "%.0f B/s", bytesPerSec);
+    return buffer;
+  }
+
+  // 快照里的 NPC 激活者按槽位记录（0=房主，1=非房主），本地按 0=本方，1=对方
+  int activatorToSlot(int activatorId, int localSlot)
+  {
+    if (activatorId < 0)
+      return -1;
+    return activatorId == 0 ? localSlot : 1 - localSlot;
+  }
+
+  int slotToActivator(int slot, int localSlot)
+  {
+    if (slot < 0)
+      return -1;
+    return slot == localSlot ? 0 : 1;
+  }
+
+  void applyTankState(Tank &tank, const ResumePlayer &player)
+  {
+    tank.setPosition({player.x, player.y});
+    tank.setRotation(player.rotation);
+    tank.setTurretRotation(player.turretAngle);
+    tank.setHealth(player.health);
+  }
+}
+
 // 静态成员定义
+AIScheduler MultiplayerHandler::s_aiScheduler;
+CrowdSteering MultiplayerHandler::s_crowd;
+InterestManager MultiplayerHandler::s_interest;
+std::unique_ptr<UILayer> MultiplayerHandler::s_hudUI;
+std::unique_ptr<UILayer> MultiplayerHandler::s_minimapUI;
+std::unique_ptr<UILayer> MultiplayerHandler::s_netStatsUI;
 std::unique_ptr<sf::Texture> MultiplayerHandler::s_darkModeTexture;
 std::unique_ptr<sf::Sprite> MultiplayerHandler::s_darkModeSprite;
 bool MultiplayerHandler::s_darkModeTextureInitialized = false;
@@ -105,6 +174,9 @@ void MultiplayerHandler::initDarkModeTexture(unsigned int width, unsigned int he
 void MultiplayerHandler::cleanup()
 {
   // 释放静态资源（在窗口关闭前调用）
+  s_hudUI.reset();
+  s_minimapUI.reset();
+  s_netStatsUI.reset();
   s_darkModeSprite.reset();
   s_darkModeTexture.reset();
   s_darkModeTextureInitialized = false;
@@ -112,6 +184,177 @@ void MultiplayerHandler::cleanup()
   s_lastTextureHeight = 0;
 }
 
+void MultiplayerHandler::beginMatch(MultiplayerState &state)
+{
+  s_aiScheduler = AIScheduler();
+  s_crowd = CrowdSteering();
+  s_interest.reset();
+  state.hasRemotePlayerPos = false;
+  state.reportedDesyncTick = UINT32_MAX;
+  state.inputSeq = 0;
+  state.lastSentButtons = 0;
+  state.inputSendTimer = 0.f;
+  state.predictedPositions.clear();
+  state.hasServerPlayerState = false;
+  // 预算按耗时计，两端机器快慢不同会让思考时机不同；帧同步模式下不设上限
+  if (state.lockstep)
+    s_aiScheduler.setBudgetMs(std::numeric_limits<double>::infinity());
+}
+
+ResumePlayer MultiplayerHandler::captureLocalPlayer(
+    MultiplayerContext &ctx,
+    MultiplayerState &state)
+{
+  ResumePlayer self;
+  if (!ctx.player)
+    return self;
+  self.x = ctx.player->getPosition().x;
+  self.y = ctx.player->getPosition().y;
+  self.rotation = ctx.player->getRotation();
+  self.turretAngle = ctx.player->getTurretRotation();
+  self.health = ctx.player->getHealth();
+  self.reachedExit = state.localPlayerReachedExit;
+  self.isDead = state.localPlayerDead;
+  self.coins = static_cast<uint16_t>(std::clamp(ctx.player->getCoins(), 0, 0xFFFF));
+  self.wallsInBag = static_cast<uint16_t>(std::clamp(ctx.player->getWallsInBag(), 0, 0xFFFF));
+  return self;
+}
+
+void MultiplayerHandler::applyRemoteResumePlayer(
+    MultiplayerContext &ctx,
+    MultiplayerState &state,
+    const ResumePlayer &player)
+{
+  if (ctx.otherPlayer)
+  {
+    applyTankState(*ctx.otherPlayer, player);
+    ctx.otherPlayer->setCoins(player.coins);
+    ctx.otherPlayer->setWallsInBag(player.wallsInBag);
+  }
+  state.otherPlayerSnapshots.clear();
+  state.remotePlayerPos = {player.x, player.y};
+  state.hasRemotePlayerPos = true;
+  state.otherPlayerReachedExit = player.reachedExit;
+  state.otherPlayerDead = player.isDead;
+  state.peerDropped = false;
+}
+
+ResumeSnapshot MultiplayerHandler::captureResumeSnapshot(
+    MultiplayerContext &ctx,
+    MultiplayerState &state)
+{
+  ResumeSnapshot snapshot;
+  std::vector<std::string> mazeData = ctx.maze.getMazeData();
+  snapshot.modeFlags = static_cast<uint8_t>((state.isEscapeMode ? 1 : 0) | (state.isDarkMode ? 2 : 0));
+  snapshot.mazeHash = MazeCodec::hash(mazeData);
+  // 房主知道种子；非房主只有整图
+  if (state.isHost && state.generatedMazeData == mazeData)
+    snapshot.seed = state.generatedMazeSeed;
+  if (snapshot.seed.version == 0)
+    snapshot.mazeData = mazeData;
+  snapshot.rows = static_cast<uint16_t>(mazeData.size());
+  snapshot.cols = static_cast<uint16_t>(mazeData.empty() ? 0 : mazeData[0].size());
+
+  for (const auto &delta : ctx.maze.getWallDeltas())
+  {
+    ResumeWall wall;
+    wall.row = static_cast<uint16_t>(delta.row);
+    wall.col = static_cast<uint16_t>(delta.col);
+    wall.present = delta.present;
+    wall.attribute = static_cast<uint8_t>(delta.attribute);
+    wall.health = delta.health;
+    snapshot.walls.push_back(wall);
+  }
+
+  int localSlot = state.isHost ? 0 : 1;
+  for (const auto &enemy : ctx.enemies)
+  {
+    ResumeNpc npc;
+    npc.x = enemy->getPosition().x;
+    npc.y = enemy->getPosition().y;
+    npc.rotation = enemy->getRotation();
+    npc.turretAngle = enemy->getTurretRotation();
+    npc.health = enemy->getHealth();
+    npc.team = enemy->getTeam();
+    npc.activated = enemy->isActivated();
+    npc.activatorId = activatorToSlot(enemy->getActivatorId(), localSlot);
+    snapshot.npcs.push_back(npc);
+  }
+
+  snapshot.players[localSlot] = captureLocalPlayer(ctx, state);
+  ResumePlayer &other = snapshot.players[1 - localSlot];
+  if (ctx.otherPlayer)
+  {
+    other.x = ctx.otherPlayer->getPosition().x;
+    other.y = ctx.otherPlayer->getPosition().y;
+    other.rotation = ctx.otherPlayer->getRotation();
+    other.turretAngle = ctx.otherPlayer->getTurretRotation();
+    other.health = ctx.otherPlayer->getHealth();
+    other.coins = static_cast<uint16_t>(std::clamp(ctx.otherPlayer->getCoins(), 0, 0xFFFF));
+    other.wallsInBag = static_cast<uint16_t>(std::clamp(ctx.otherPlayer->getWallsInBag(), 0, 0xFFFF));
+  }
+  other.reachedExit = state.otherPlayerReachedExit;
+  other.isDead = state.otherPlayerDead;
+  return snapshot;
+}
+
+void MultiplayerHandler::applyResumeSnapshot(
+    MultiplayerContext &ctx,
+    MultiplayerState &state,
+    const ResumeSnapshot &snapshot)
+{
+  std::vector<WallDelta> deltas;
+  deltas.reserve(snapshot.walls.size());
+  for (const auto &wall : snapshot.walls)
+    deltas.push_back({wall.row, wall.col, wall.present, static_cast<WallAttribute>(wall.attribute), wall.health});
+  ctx.maze.restoreWallDeltas(deltas);
+
+  int localSlot = state.isHost ? 0 : 1;
+  for (std::size_t i = 0; i < snapshot.npcs.size() && i < ctx.enemies.size(); i++)
+  {
+    const ResumeNpc &npc = snapshot.npcs[i];
+    Enemy &enemy = *ctx.enemies[i];
+    enemy.setPosition({npc.x, npc.y});
+    enemy.setRotation(npc.rotation);
+    enemy.setTurretRotation(npc.turretAngle);
+    enemy.setHealth(npc.health);
+    if (npc.activated && !enemy.isActivated())
+      enemy.activate(npc.team, slotToActivator(npc.activatorId, localSlot));
+  }
+  state.npcSnapshots.assign(ctx.enemies.size(), SnapshotBuffer());
+
+  // 本方用对方保存的状态（掉线期间可能被 NPC 击中），金币与背包以本方上报为准
+  const ResumePlayer &self = snapshot.players[localSlot];
+  applyTankState(*ctx.player, self);
+  ctx.player->setCoins(self.coins);
+  ctx.player->setWallsInBag(self.wallsInBag);
+  state.localPlayerReachedExit = self.reachedExit;
+  state.localPlayerDead = self.isDead;
+
+  const ResumePlayer &other = snapshot.players[1 - localSlot];
+  if (ctx.otherPlayer)
+  {
+    applyTankState(*ctx.otherPlayer, other);
+    ctx.otherPlayer->setCoins(other.coins);
+    ctx.otherPlayer->setWallsInBag(other.wallsInBag);
+  }
+  state.otherPlayerSnapshots.clear();
+  state.remotePlayerPos = {other.x, other.y};
+  state.hasRemotePlayerPos = true;
+  state.otherPlayerReachedExit = other.reachedExit;
+  state.otherPlayerDead = other.isDead;
+
+  // 掉线前进行中的救援与终点确认不再继续
+  state.isRescuing = false;
+  state.beingRescued = false;
+  state.rescueProgress = 0.f;
+  state.isHoldingExit = false;
+  state.exitHoldProgress = 0.f;
+  state.reconnecting = false;
+  state.peerDropped = false;
+  ctx.bullets.clear();
+}
+
 void MultiplayerHandler::update(
     MultiplayerContext &ctx,
     MultiplayerState &state,
@@ -122,6 +365,22 @@ void MultiplayerHandler::update(
   if (!ctx.player)
     return;
 
+  state.frameTimeMs += (dt * 1000.f - state.frameTimeMs) * 0.1f;
+
+  // 对方掉线：对局继续，只倒数保留时间
+  if (state.peerDropped)
+    state.peerDropTimer = std::max(0.f, state.peerDropTimer - dt);
+
+  // 本方重连中：等待快照，暂停本地模拟
+  if (state.reconnecting)
+    return;
+
+  if (state.lockstep)
+  {
+    updateLockstep(ctx, state, dt, onVictory, onDefeat);
+    return;
+  }
+
   auto &net = NetworkManager::getInstance();
 
   // 检查本地玩家死亡状态
@@ -163,45 +422,15 @@ void MultiplayerHandler::update(
   {
     // 保存旧位置
     sf::Vector2f oldPos = ctx.player->getPosition();
-    sf::Vector2f movement = ctx.player->getMovement(dt);
 
     // 更新本地玩家
     ctx.player->update(dt, mouseWorldPos);
 
-    // 碰撞检测
-    sf::Vector2f newPos = ctx.player->getPosition();
-    float radius = ctx.player->getCollisionRadius();
-
-    if (ctx.maze.checkCollision(newPos, radius))
-    {
-      sf::Vector2f posX = {oldPos.x + movement.x, oldPos.y};
-      sf::Vector2f posY = {oldPos.x, oldPos.y + movement.y};
-
-      bool canMoveX = !ctx.maze.checkCollision(posX, radius);
-      bool canMoveY = !ctx.maze.checkCollision(posY, radius);
-
-      if (canMoveX && canMoveY)
-      {
-        if (std::abs(movement.x) > std::abs(movement.y))
-          ctx.player->setPosition(posX);
-        else
-          ctx.player->setPosition(posY);
-      }
-      else if (canMoveX)
-      {
-        ctx.player->setPosition(posX);
-      }
-      else if (canMoveY)
-      {
-        ctx.player->setPosition(posY);
-      }
-      else
-      {
-        ctx.player->setPosition(oldPos);
-      }
-    }
+    // 碰撞检测与墙壁滑动
+    ctx.player->setPosition(ctx.maze.resolveMovement(oldPos, ctx.player->getPosition(), ctx.player->getCollisionRadius()));
 
     // 处理射击（只有活着的玩家可以射击）
+    // 服务器权威模拟时这里的子弹只是预测显示，服务器按输入自行开火并通知对方
     if (ctx.player->hasFiredBullet())
     {
       sf::Vector2f bulletPos = ctx.player->getBulletSpawnPosition();
@@ -209,7 +438,8 @@ void MultiplayerHandler::update(
       auto bullet = std::make_unique<Bullet>(bulletPos.x, bulletPos.y, bulletAngle, true);
       bullet->setTeam(ctx.player->getTeam()); // 设置子弹阵营
       ctx.bullets.push_back(std::move(bullet));
-      net.sendShoot(bulletPos.x, bulletPos.y, bulletAngle);
+      if (!state.serverAuthoritative)
+        net.sendShoot(bulletPos.x, bulletPos.y, bulletAngle);
 
       // 播放射击音效
       AudioManager::getInstance().playSFX(SFXType::Shoot, bulletPos, ctx.player->getPosition());
@@ -224,9 +454,6 @@ void MultiplayerHandler::update(
     sf::Vector2f otherPos = ctx.otherPlayer->getPosition();
     float distToTeammate = std::hypot(myPos.x - otherPos.x, myPos.y - otherPos.y);
 
-    const float RESCUE_DISTANCE = 60.f;
-    const float RESCUE_TIME = 3.0f; // 3秒救援时间
-
     if (distToTeammate < RESCUE_DISTANCE)
     {
       state.canRescue = true;
@@ -338,23 +565,35 @@ void MultiplayerHandler::update(
     }
   }
 
-  // 更新NPC AI（仅房主执行）
+  // 更新NPC AI（仅房主执行；服务器权威模拟时由服务器执行）
   // 非房主的NPC位置通过网络回调直接设置，不需要本地更新
-  if (state.isHost)
+  if (state.ownsWorldSimulation())
   {
     updateNpcAI(ctx, state, dt);
   }
 
-  // 发送位置到服务器
-  PlayerState pstate;
-  pstate.x = ctx.player->getPosition().x;
-  pstate.y = ctx.player->getPosition().y;
-  pstate.rotation = ctx.player->getRotation();
-  pstate.turretAngle = ctx.player->getTurretRotation();
-  pstate.health = ctx.player->getHealth();
-  pstate.reachedExit = state.localPlayerReachedExit;
-  pstate.isDead = state.localPlayerDead;
-  net.sendPosition(pstate);
+  // 对方坦克与（非房主）NPC 按插值缓冲采样，须在碰撞检测之前
+  applyRemoteSnapshots(ctx, state);
+
+  if (state.serverAuthoritative)
+  {
+    // 服务器权威模拟：上报输入，位置与血量以服务器为准
+    sendServerInput(ctx, state, dt, mouseWorldPos);
+    reconcileWithServer(ctx, state);
+  }
+  else
+  {
+    // 发送位置到服务器
+    PlayerState pstate;
+    pstate.x = ctx.player->getPosition().x;
+    pstate.y = ctx.player->getPosition().y;
+    pstate.rotation = ctx.player->getRotation();
+    pstate.turretAngle = ctx.player->getTurretRotation();
+    pstate.health = ctx.player->getHealth();
+    pstate.reachedExit = state.localPlayerReachedExit;
+    pstate.isDead = state.localPlayerDead;
+    net.sendPosition(pstate);
+  }
 
   // 更新迷宫
   ctx.maze.update(dt);
@@ -367,7 +606,8 @@ void MultiplayerHandler::update(
 
   // 子弹碰撞检测
   CollisionSystem::checkMultiplayerCollisions(
-      ctx.player, ctx.otherPlayer, ctx.enemies, ctx.bullets, ctx.maze, state.isHost);
+      ctx.player, ctx.otherPlayer, ctx.enemies, ctx.bullets, ctx.maze, state.ownsWorldSimulation(),
+      !state.serverAuthoritative);
 
   // 删除超出范围的子弹
   ctx.bullets.erase(
@@ -377,7 +617,6 @@ void MultiplayerHandler::update(
       ctx.bullets.end());
 
   // 检查玩家是否到达终点（只有活着的玩家才能到达终点，需要按住E键3秒）
-  const float EXIT_HOLD_TIME = 3.0f;
   sf::Vector2f exitPos = ctx.maze.getExitPosition();
   if (!state.localPlayerDead)
   {
@@ -482,6 +721,470 @@ void MultiplayerHandler::update(
   ctx.gameView.setCenter(ctx.player->getPosition());
 }
 
+void MultiplayerHandler::sendServerInput(
+    MultiplayerContext &ctx,
+    MultiplayerState &state,
+    float dt,
+    sf::Vector2f aim)
+{
+  // 倒地时不再上报移动与射击
+  uint8_t buttons = state.localPlayerDead ? 0 : ctx.player->getInputBits();
+  state.inputSendTimer += dt;
+  if (buttons == state.lastSentButtons && state.inputSendTimer < INPUT_SEND_INTERVAL)
+    return;
+
+  state.inputSendTimer = 0.f;
+  state.lastSentButtons = buttons;
+  state.inputSeq++;
+  NetworkManager::getInstance().sendPlayerInput(state.inputSeq, buttons, aim, state.localPlayerReachedExit);
+
+  state.predictedPositions.emplace_back(state.inputSeq, ctx.player->getPosition());
+  if (state.predictedPositions.size() > MAX_PREDICTED_INPUTS)
+    state.predictedPositions.pop_front();
+}
+
+void MultiplayerHandler::reconcileWithServer(
+    MultiplayerContext &ctx,
+    MultiplayerState &state)
+{
+  if (!state.hasServerPlayerState)
+    return;
+  state.hasServerPlayerState = false;
+  const PlayerState &server = state.serverPlayerState;
+
+  // 血量完全以服务器为准；Escape 模式下服务器已复活本方时解除倒地
+  ctx.player->setHealth(server.health);
+  if (state.isEscapeMode && state.localPlayerDead && !server.isDead)
+  {
+    state.localPlayerDead = false;
+    state.beingRescued = false;
+  }
+
+  // 丢弃服务器已处理过的输入，取服务器处理到的那次输入时的预测位置比较
+  while (!state.predictedPositions.empty() &&
+         static_cast<int32_t>(state.predictedPositions.front().first - state.serverInputSeq) < 0)
+    state.predictedPositions.pop_front();
+  if (state.predictedPositions.empty() || state.predictedPositions.front().first != state.serverInputSeq)
+    return;
+
+  sf::Vector2f serverPos{server.x, server.y};
+  sf::Vector2f error = serverPos - state.predictedPositions.front().second;
+  float distance = std::hypot(error.x, error.y);
+  if (distance <= RECONCILE_DEADZONE)
+    return;
+
+  sf::Vector2f current = ctx.player->getPosition();
+  sf::Vector2f corrected;
+  if (distance > RECONCILE_SNAP_DISTANCE)
+    corrected = serverPos;
+  else
+    corrected = ctx.maze.resolveMovement(current, current + error * RECONCILE_BLEND, ctx.player->getCollisionRadius());
+  ctx.player->setPosition(corrected);
+
+  // 尚未确认的预测一并平移，避免下一次重复校正
+  sf::Vector2f shift = corrected - current;
+  for (auto &predicted : state.predictedPositions)
+    predicted.second += shift;
+}
+
+void MultiplayerHandler::updateLockstep(
+    MultiplayerContext &ctx,
+    MultiplayerState &state,
+    float dt,
+    const std::function<void()> &onVictory,
+    const std::function<void()> &onDefeat)
+{
+  auto &net = NetworkManager::getInstance();
+  LockstepSession &session = state.lockstepSession;
+  int local = session.localSlot();
+  Tank *const tanks[2] = {local == 0 ? ctx.player : ctx.otherPlayer, local == 0 ? ctx.otherPlayer : ctx.player};
+  if (!tanks[0] || !tanks[1] || !session.active())
+    return;
+
+  sf::Vector2i mousePixelPos = sf::Mouse::getPosition(ctx.window);
+  sf::Vector2f mouseWorldPos = ctx.window.mapPixelToCoords(mousePixelPos, ctx.gameView);
+
+  // 本地按键状态由事件维护；模拟时两辆坦克都改用各自那一步的输入，结束后恢复
+  uint8_t liveBits = ctx.player->getInputBits();
+
+  int outcome = 0;
+  int ticks = 0;
+  state.lockstepAccumulator += dt;
+  while (state.lockstepAccumulator >= LockstepSession::TICK_DT && outcome == 0)
+  {
+    // 采样本地输入（INPUT_DELAY 步之后生效）并发给对方
+    if (session.needsLocalInput())
+    {
+      LockstepInput input;
+      input.buttons = liveBits & LOCKSTEP_TANK_KEYS;
+      if (state.eKeyHeld)
+        input.buttons |= LOCKSTEP_KEY_EXIT;
+      if (state.fKeyHeld)
+        input.buttons |= LOCKSTEP_KEY_RESCUE;
+      if (state.rKeyJustPressed)
+        input.buttons |= LOCKSTEP_KEY_ACTIVATE;
+      state.rKeyJustPressed = false;
+      if (state.pendingPlaceCol >= 0 && state.pendingPlaceRow >= 0)
+      {
+        input.placeCol = static_cast<int16_t>(state.pendingPlaceCol);
+        input.placeRow = static_cast<int16_t>(state.pendingPlaceRow);
+        state.pendingPlaceCol = state.pendingPlaceRow = -1;
+      }
+      input.aimX = mouseWorldPos.x;
+      input.aimY = mouseWorldPos.y;
+      net.sendLockstepInput(session.pushLocalInput(input), input);
+    }
+
+    // 缺对方这一步的输入：停下等待，等待期间不累积欠下的步数
+    if (!session.ready())
+    {
+      session.noteStall();
+      state.lockstepAccumulator = LockstepSession::TICK_DT;
+      break;
+    }
+
+    state.lockstepAccumulator -= LockstepSession::TICK_DT;
+    outcome = simulateLockstepTick(ctx, state, tanks);
+    if (session.isHashTick())
+    {
+      uint64_t hash = hashLockstepState(ctx, state, tanks);
+      session.recordLocalHash(session.tick(), hash);
+      net.sendStateHash(session.tick(), hash);
+    }
+    session.advance();
+
+    if (++ticks == MAX_LOCKSTEP_TICKS_PER_FRAME)
+    {
+      state.lockstepAccumulator = 0.f;
+      break;
+    }
+  }
+  ctx.player->setInputBits(liveBits);
+
+  // 墙体颜色只影响显示，每帧更新一次即可
+  ctx.maze.update(dt);
+
+  if (session.desynced())
+  {
+    if (state.reportedDesyncTick != session.desyncTick())
+    {
+      state.reportedDesyncTick = session.desyncTick();
+      std::cerr << "[Lockstep] Desync detected at tick " << state.reportedDesyncTick << " (state hash mismatch)"
+                << std::endl;
+    }
+  }
+
+  // 胜负由双方各自按同一模拟结果判定，不需要 GameResult 消息
+  if (outcome != 0)
+  {
+    const auto &stats = session.getStats();
+    std::cout << "[Lockstep] Match ended at tick " << session.tick() << ": " << stats.inputsSent << " inputs sent, "
+              << stats.inputsReceived << " received, " << stats.stalledFrames << " stalled frames, "
+              << stats.hashesCompared << " hashes compared" << std::endl;
+    session.stop();
+    state.multiplayerWin = outcome > 0;
+    if (outcome > 0)
+      onVictory();
+    else
+      onDefeat();
+    return;
+  }
+
+  // 模拟状态映射到显示字段
+  const MultiplayerState::LockstepPlayer &self = state.lockstepPlayers[local];
+  const MultiplayerState::LockstepPlayer &other = state.lockstepPlayers[1 - local];
+  state.localPlayerDead = self.dead;
+  state.otherPlayerDead = other.dead;
+  state.localPlayerReachedExit = self.reachedExit;
+  state.otherPlayerReachedExit = other.reachedExit;
+  state.isRescuing = self.rescue > 0.f;
+  state.beingRescued = other.rescue > 0.f;
+  state.rescueProgress = state.isRescuing ? self.rescue : other.rescue;
+  sf::Vector2f myPos = ctx.player->getPosition();
+  sf::Vector2f otherPos = ctx.otherPlayer->getPosition();
+  state.canRescue = state.isEscapeMode && !self.dead && other.dead &&
+                    std::hypot(myPos.x - otherPos.x, myPos.y - otherPos.y) < RESCUE_DISTANCE;
+  sf::Vector2f exitPos = ctx.maze.getExitPosition();
+  state.isAtExitZone = !self.dead && std::hypot(myPos.x - exitPos.x, myPos.y - exitPos.y) < TILE_SIZE;
+  state.isHoldingExit = self.exitHold > 0.f;
+  state.exitHoldProgress = self.exitHold;
+  if (!state.isEscapeMode)
+    checkNearbyNpc(ctx, state);
+
+  // 更新相机
+  ctx.gameView.setCenter(myPos);
+}
+
+int MultiplayerHandler::simulateLockstepTick(
+    MultiplayerContext &ctx,
+    MultiplayerState &state,
+    Tank *const tanks[2])
+{
+  const float dt = LockstepSession::TICK_DT;
+  const LockstepSession &session = state.lockstepSession;
+  int local = session.localSlot();
+  auto &players = state.lockstepPlayers;
+  sf::Vector2f listenerPos = ctx.player->getPosition();
+
+  // 双方坦克：移动、射击、放置墙壁（按槽位顺序，两端生成子弹的顺序一致）
+  for (int slot = 0; slot < 2; slot++)
+  {
+    Tank *tank = tanks[slot];
+    const LockstepInput &input = session.input(slot);
+    tank->setInputBits(input.buttons & LOCKSTEP_TANK_KEYS);
+    if (players[slot].dead)
+      continue;
+
+    sf::Vector2f oldPos = tank->getPosition();
+    tank->update(dt, {input.aimX, input.aimY});
+    tank->setPosition(ctx.maze.resolveMovement(oldPos, tank->getPosition(), tank->getCollisionRadius()));
+
+    if (tank->hasFiredBullet())
+    {
+      sf::Vector2f bulletPos = tank->getBulletSpawnPosition();
+      float bulletAngle = tank->getTurretRotation();
+      // 颜色只影响显示：对方的子弹为紫色
+      auto bullet = slot == local
+                        ? std::make_unique<Bullet>(bulletPos.x, bulletPos.y, bulletAngle, true)
+                        : std::make_unique<Bullet>(bulletPos.x, bulletPos.y, bulletAngle, false, GameColors::EnemyPlayerBullet);
+      bullet->setOwner(slot == 0 ? BulletOwner::Player : BulletOwner::OtherPlayer);
+      bullet->setTeam(tank->getTeam());
+      ctx.bullets.push_back(std::move(bullet));
+      AudioManager::getInstance().playSFX(SFXType::Shoot, bulletPos, listenerPos);
+    }
+
+    // 放置墙壁：格子上有坦克或 NPC 时放弃
+    if (input.placeCol >= 0 && input.placeRow >= 0 && tank->getWallsInBag() > 0)
+    {
+      sf::Vector2f cell = ctx.maze.gridToWorld({input.placeCol, input.placeRow});
+      float checkRadius = ctx.maze.getTileSize() * 1.0f;
+      bool occupied = false;
+      for (int t = 0; t < 2; t++)
+      {
+        sf::Vector2f pos = tanks[t]->getPosition();
+        occupied = occupied || std::hypot(pos.x - cell.x, pos.y - cell.y) < checkRadius;
+      }
+      for (const auto &npc : ctx.enemies)
+      {
+        if (!occupied && !npc->isDead())
+          occupied = std::hypot(npc->getPosition().x - cell.x, npc->getPosition().y - cell.y) < checkRadius;
+      }
+      if (!occupied && ctx.maze.placeWall(cell))
+      {
+        tank->useWallFromBag();
+        AudioManager::getInstance().playSFX(SFXType::MenuConfirm, cell, listenerPos);
+      }
+    }
+  }
+
+  // Escape 模式救援：按住 F 站在倒地队友旁 3 秒，队友以 50 血复活
+  if (state.isEscapeMode)
+  {
+    for (int slot = 0; slot < 2; slot++)
+    {
+      int other = 1 - slot;
+      sf::Vector2f diff = tanks[slot]->getPosition() - tanks[other]->getPosition();
+      bool holding = (session.input(slot).buttons & LOCKSTEP_KEY_RESCUE) != 0;
+      if (!players[slot].dead && players[other].dead && holding && std::hypot(diff.x, diff.y) < RESCUE_DISTANCE)
+      {
+        players[slot].rescue += dt;
+        if (players[slot].rescue >= RESCUE_TIME)
+        {
+          players[slot].rescue = 0.f;
+          players[other].dead = false;
+          tanks[other]->setHealth(50.f);
+          std::cout << "[Lockstep] Player " << other << " rescued at tick " << session.tick() << std::endl;
+        }
+      }
+      else
+      {
+        players[slot].rescue = 0.f;
+      }
+    }
+  }
+
+  // NPC 激活：Escape 模式靠近自动激活，Battle 模式按 R 花金币激活（activatorId 相对本地：0=本地，1=对方）
+  for (int slot = 0; slot < 2; slot++)
+  {
+    if (players[slot].dead)
+      continue;
+    int activatorId = slot == local ? 0 : 1;
+    sf::Vector2f pos = tanks[slot]->getPosition();
+    if (state.isEscapeMode)
+    {
+      for (auto &npc : ctx.enemies)
+      {
+        sf::Vector2f diff = npc->getPosition() - pos;
+        if (!npc->isActivated() && !npc->isDead() && std::hypot(diff.x, diff.y) < AUTO_ACTIVATE_DISTANCE)
+          npc->activate(0, activatorId);
+      }
+    }
+    else if ((session.input(slot).buttons & LOCKSTEP_KEY_ACTIVATE) && tanks[slot]->getCoins() >= ACTIVATE_COST)
+    {
+      // 与 checkNearbyNpc 相同：范围内第一个未激活的 NPC
+      for (auto &npc : ctx.enemies)
+      {
+        sf::Vector2f diff = npc->getPosition() - pos;
+        if (!npc->isActivated() && std::hypot(diff.x, diff.y) < ACTIVATE_DISTANCE)
+        {
+          tanks[slot]->spendCoins(ACTIVATE_COST);
+          npc->activate(tanks[slot]->getTeam(), activatorId);
+          break;
+        }
+      }
+    }
+  }
+
+  // NPC AI 两端都运行，不发送同步消息
+  const bool dead[2] = {players[0].dead, players[1].dead};
+  simulateNpcs(ctx, state, dt, tanks, dead, false);
+
+  for (auto &bullet : ctx.bullets)
+  {
+    bullet->update(dt);
+  }
+  CollisionSystem::checkLockstepCollisions(tanks[0], tanks[1], ctx.enemies, ctx.bullets, ctx.maze, ctx.player);
+
+  // 死亡
+  for (int slot = 0; slot < 2; slot++)
+  {
+    if (!players[slot].dead && tanks[slot]->isDead())
+    {
+      players[slot].dead = true;
+      players[slot].exitHold = 0.f;
+      players[slot].rescue = 0.f;
+      std::cout << "[Lockstep] Player " << slot << " died at tick " << session.tick() << std::endl;
+    }
+  }
+
+  if (!state.isEscapeMode)
+  {
+    // Battle 模式：死亡即失败（同一步双方都死则都算失败）
+    if (players[local].dead)
+      return -1;
+    if (players[1 - local].dead)
+      return 1;
+  }
+  else if (players[0].dead && players[1].dead)
+  {
+    return -1;
+  }
+
+  // 终点：活着的玩家在终点区域按住 E 3 秒
+  sf::Vector2f exitPos = ctx.maze.getExitPosition();
+  for (int slot = 0; slot < 2; slot++)
+  {
+    MultiplayerState::LockstepPlayer &player = players[slot];
+    sf::Vector2f diff = tanks[slot]->getPosition() - exitPos;
+    bool holding = (session.input(slot).buttons & LOCKSTEP_KEY_EXIT) != 0;
+    if (player.dead || player.reachedExit || !holding || std::hypot(diff.x, diff.y) >= TILE_SIZE)
+    {
+      player.exitHold = 0.f;
+      continue;
+    }
+    player.exitHold += dt;
+    if (player.exitHold >= EXIT_HOLD_TIME)
+    {
+      player.reachedExit = true;
+      player.exitHold = 0.f;
+      // Battle 模式先到者胜（同一步都到达时房主胜）
+      if (!state.isEscapeMode)
+        return slot == local ? 1 : -1;
+    }
+  }
+
+  // Escape 模式：双方都活着到达终点才算胜利
+  if (state.isEscapeMode && players[0].reachedExit && players[1].reachedExit && !players[0].dead && !players[1].dead)
+    return 1;
+  return 0;
+}
+
+uint64_t MultiplayerHandler::hashLockstepState(
+    MultiplayerContext &ctx,
+    MultiplayerState &state,
+    Tank *const tanks[2])
+{
+  StateHasher hasher;
+  hasher.add(state.lockstepSession.tick());
+
+  // 坦克与 NPC：线性扫描实体存储
+  const EntityStore &store = ctx.entities;
+  for (EntityId id = 0; id < store.capacity(); id++)
+  {
+    if (!store.valid(id))
+      continue;
+    hasher.add(id);
+    hasher.add(store.kind[id]);
+    hasher.add(store.flags[id]);
+    hasher.add(store.team[id]);
+    hasher.add(store.x[id]);
+    hasher.add(store.y[id]);
+    hasher.add(store.hullAngle[id]);
+    hasher.add(store.turretAngle[id]);
+    hasher.add(store.health[id]);
+  }
+
+  for (const auto &bullet : ctx.bullets)
+  {
+    sf::Vector2f pos = bullet->getPosition();
+    hasher.add(pos.x);
+    hasher.add(pos.y);
+    hasher.add(bullet->getOwner());
+    hasher.add(bullet->getTeam());
+  }
+
+  for (int slot = 0; slot < 2; slot++)
+  {
+    const MultiplayerState::LockstepPlayer &player = state.lockstepPlayers[slot];
+    hasher.add(tanks[slot]->getCoins());
+    hasher.add(tanks[slot]->getWallsInBag());
+    hasher.add(player.dead);
+    hasher.add(player.reachedExit);
+    hasher.add(player.exitHold);
+    hasher.add(player.rescue);
+  }
+  return hasher.value();
+}
+
+void MultiplayerHandler::applyRemoteSnapshots(
+    MultiplayerContext &ctx,
+    MultiplayerState &state)
+{
+  float now = NetworkManager::getInstance().getNetworkTime();
+  EntitySnapshot snapshot;
+
+  // 外推位置撞墙时沿墙滑动（与本地移动共用同一个解算）
+  auto resolvePosition = [&ctx](sf::Vector2f current, sf::Vector2f target, float radius)
+  {
+    return ctx.maze.resolveMovement(current, target, radius);
+  };
+
+  if (ctx.otherPlayer && state.otherPlayerSnapshots.sample(now, snapshot))
+  {
+    ctx.otherPlayer->setPosition(resolvePosition(ctx.otherPlayer->getPosition(), snapshot.position,
+                                                 ctx.otherPlayer->getCollisionRadius()));
+    ctx.otherPlayer->setRotation(snapshot.rotation);
+    ctx.otherPlayer->setTurretRotation(snapshot.turretAngle);
+  }
+
+  if (state.ownsWorldSimulation())
+    return;
+
+  for (auto &npc : ctx.enemies)
+  {
+    int id = npc->getId();
+    if (npc->isDead() || id < 0 || id >= static_cast<int>(state.npcSnapshots.size()))
+      continue;
+
+    if (state.npcSnapshots[id].sample(now, snapshot))
+    {
+      npc->setPosition(resolvePosition(npc->getPosition(), snapshot.position, npc->getCollisionRadius()));
+      npc->setRotation(snapshot.rotation);
+      npc->setTurretRotation(snapshot.turretAngle);
+    }
+  }
+}
+
 void MultiplayerHandler::checkNearbyNpc(
     MultiplayerContext &ctx,
     MultiplayerState &state)
@@ -537,135 +1240,155 @@ void MultiplayerHandler::updateNpcAI(
     MultiplayerContext &ctx,
     MultiplayerState &state,
     float dt)
+{
+  Tank *const tanks[2] = {ctx.player, ctx.otherPlayer};
+  const bool dead[2] = {state.localPlayerDead, state.otherPlayerDead};
+  simulateNpcs(ctx, state, dt, tanks, dead, true);
+}
+
+void MultiplayerHandler::simulateNpcs(
+    MultiplayerContext &ctx,
+    MultiplayerState &state,
+    float dt,
+    Tank *const tanks[2],
+    const bool dead[2],
+    bool broadcast)
 {
   auto &net = NetworkManager::getInstance();
 
+  // 距离参考点：双方玩家
+  std::vector<sf::Vector2f> focus;
+  for (int slot = 0; slot < 2; slot++)
+  {
+    if (tanks[slot])
+      focus.push_back(tanks[slot]->getPosition());
+  }
+  s_aiScheduler.beginFrame(focus);
+
+  // 群体避让：用本帧开始时的位置建邻居网格
+  s_crowd.build(ctx.entities);
+
+  // 关注区域：以对方坦克为中心
+  if (broadcast)
+    s_interest.beginFrame(dt, state.hasRemotePlayerPos, state.remotePlayerPos);
+
   for (size_t i = 0; i < ctx.enemies.size(); ++i)
   {
     auto &npc = ctx.enemies[i];
-    if (npc->isDead())
+    if (npc->isDead() || !npc->isActivated())
       continue;
 
-    if (npc->isActivated())
+    int npcTeam = npc->getTeam();
+
+    // AI 分级：只有本帧思考的 NPC 才重新收集目标、寻路和做弹道检测
+    bool think = s_aiScheduler.shouldThink(i, npc->getPosition());
+    auto thinkStart = std::chrono::steady_clock::now();
+    if (think)
     {
-      int npcTeam = npc->getTeam();
+      // 收集敌对目标
+      std::vector<sf::Vector2f> targets;
 
-      // 只有房主执行NPC AI逻辑
-      if (state.isHost)
+      // Escape 模式：NPC (team=0) 攻击距离最近的活着的玩家
+      if (state.isEscapeMode && npcTeam == 0)
       {
-        // 收集敌对目标
-        std::vector<sf::Vector2f> targets;
+        sf::Vector2f npcPos = npc->getPosition();
+        float closestDist = std::numeric_limits<float>::max();
+        Tank *closestTarget = nullptr;
 
-        // Escape 模式：NPC (team=0) 攻击距离最近的活着的玩家
-        if (state.isEscapeMode && npcTeam == 0)
+        for (int slot = 0; slot < 2; slot++)
         {
-          sf::Vector2f npcPos = npc->getPosition();
-          float closestDist = std::numeric_limits<float>::max();
-          Tank *closestTarget = nullptr;
-
-          // 检查本地玩家
-          if (ctx.player && !state.localPlayerDead)
+          if (!tanks[slot] || dead[slot])
+            continue;
+          sf::Vector2f diff = tanks[slot]->getPosition() - npcPos;
+          float dist = std::sqrt(diff.x * diff.x + diff.y * diff.y);
+          if (dist < closestDist)
           {
-            sf::Vector2f diff = ctx.player->getPosition() - npcPos;
-            float dist = std::sqrt(diff.x * diff.x + diff.y * diff.y);
-            if (dist < closestDist)
-            {
-              closestDist = dist;
-              closestTarget = ctx.player;
-            }
-          }
-
-          // 检查其他玩家
-          if (ctx.otherPlayer && !state.otherPlayerDead)
-          {
-            sf::Vector2f diff = ctx.otherPlayer->getPosition() - npcPos;
-            float dist = std::sqrt(diff.x * diff.x + diff.y * diff.y);
-            if (dist < closestDist)
-            {
-              closestDist = dist;
-              closestTarget = ctx.otherPlayer;
-            }
+            closestDist = dist;
+            closestTarget = tanks[slot];
           }
+        }
 
-          // 设置最近的活着的玩家为攻击目标
-          if (closestTarget)
-          {
-            targets.push_back(closestTarget->getPosition());
-          }
+        // 设置最近的活着的玩家为攻击目标
+        if (closestTarget)
+        {
+          targets.push_back(closestTarget->getPosition());
         }
-        else
+      }
+      else
+      {
+        // Battle 模式或其他情况：敌对阵营的玩家
+        for (int slot = 0; slot < 2; slot++)
         {
-          // Battle 模式或其他情况：原有逻辑
-          if (ctx.player && ctx.player->getTeam() != npcTeam && npcTeam != 0)
+          if (tanks[slot] && tanks[slot]->getTeam() != npcTeam && npcTeam != 0)
           {
-            targets.push_back(ctx.player->getPosition());
-          }
-
-          if (ctx.otherPlayer && ctx.otherPlayer->getTeam() != npcTeam && npcTeam != 0)
-          {
-            targets.push_back(ctx.otherPlayer->getPosition());
-          }
-
-          for (const auto &otherNpc : ctx.enemies)
-          {
-            if (otherNpc.get() != npc.get() &&
-                otherNpc->isActivated() &&
-                !otherNpc->isDead() &&
-                otherNpc->getTeam() != npcTeam &&
-                otherNpc->getTeam() != 0)
-            {
-              targets.push_back(otherNpc->getPosition());
-            }
+            targets.push_back(tanks[slot]->getPosition());
           }
         }
 
-        if (!targets.empty())
+        // 敌对阵营的 NPC：直接线性扫描实体存储
+        const EntityStore &store = ctx.entities;
+        for (EntityId id = 0; id < store.capacity(); id++)
         {
-          npc->setTargets(targets);
-        }
-
-        npc->update(dt, ctx.maze);
-
-        // NPC射击
-        if (npc->shouldShoot())
-        {
-          sf::Vector2f bulletPos = npc->getGunPosition();
-          float bulletAngle = npc->getTurretAngle();
-          // NPC子弹颜色：Escape模式全红（敌方），Battle模式根据team判断
-          // 己方NPC（team与本地玩家相同）浅蓝色，敌方NPC红色
-          sf::Color bulletColor;
-          if (state.isEscapeMode)
-          {
-            bulletColor = GameColors::EnemyNpcBullet; // Escape模式所有NPC都是敌方
-          }
-          else
+          if (id != npc->getEntityId() && store.isActiveNpc(id) && store.team[id] != npcTeam &&
+              store.team[id] != 0)
           {
-            int localTeam = ctx.player ? ctx.player->getTeam() : 1;
-            bulletColor = (npcTeam == localTeam) ? GameColors::AllyNpcBullet : GameColors::EnemyNpcBullet;
+            targets.push_back({store.x[id], store.y[id]});
           }
-          auto bullet = std::make_unique<Bullet>(bulletPos.x, bulletPos.y, bulletAngle, false, bulletColor);
-          bullet->setTeam(npcTeam);
-          bullet->setDamage(12.5f); // NPC子弹伤害12.5%
-          ctx.bullets.push_back(std::move(bullet));
-          net.sendNpcShoot(static_cast<int>(i), bulletPos.x, bulletPos.y, bulletAngle);
-
-          // 播放NPC射击音效（基于本地玩家位置的距离衰减）
-          AudioManager::getInstance().playSFX(SFXType::Shoot, bulletPos, ctx.player->getPosition());
         }
+      }
 
-        // 每帧同步NPC状态
-        NpcState npcState;
-        npcState.id = static_cast<int>(i);
-        npcState.x = npc->getPosition().x;
-        npcState.y = npc->getPosition().y;
-        npcState.rotation = npc->getRotation();
-        npcState.turretAngle = npc->getTurretAngle();
-        npcState.health = npc->getHealth();
-        npcState.team = npc->getTeam();
-        npcState.activated = npc->isActivated();
-        net.sendNpcUpdate(npcState);
+      if (!targets.empty())
+      {
+        npc->setTargets(targets);
       }
     }
+
+    npc->update(dt, ctx.maze, think, &s_crowd);
+    if (think)
+      s_aiScheduler.endThink(thinkStart);
+
+    // NPC射击
+    if (npc->shouldShoot())
+    {
+      sf::Vector2f bulletPos = npc->getGunPosition();
+      float bulletAngle = npc->getTurretAngle();
+      // NPC子弹颜色：Escape模式全红（敌方），Battle模式根据team判断
+      // 己方NPC（team与本地玩家相同）浅蓝色，敌方NPC红色
+      sf::Color bulletColor;
+      if (state.isEscapeMode)
+      {
+        bulletColor = GameColors::EnemyNpcBullet; // Escape模式所有NPC都是敌方
+      }
+      else
+      {
+        int localTeam = ctx.player ? ctx.player->getTeam() : 1;
+        bulletColor = (npcTeam == localTeam) ? GameColors::AllyNpcBullet : GameColors::EnemyNpcBullet;
+      }
+      auto bullet = std::make_unique<Bullet>(bulletPos.x, bulletPos.y, bulletAngle, false, bulletColor);
+      bullet->setTeam(npcTeam);
+      bullet->setDamage(12.5f); // NPC子弹伤害12.5%
+      ctx.bullets.push_back(std::move(bullet));
+      if (broadcast && s_interest.shouldSendShot(ctx.maze.getOccupancy(), bulletPos, bulletAngle))
+        net.sendNpcShoot(static_cast<int>(i), bulletPos.x, bulletPos.y, bulletAngle);
+
+      // 播放NPC射击音效（基于本地玩家位置的距离衰减）
+      AudioManager::getInstance().playSFX(SFXType::Shoot, bulletPos, ctx.player->getPosition());
+    }
+
+    // 同步NPC状态：关注区域内每帧，区域外低频
+    if (broadcast && s_interest.shouldSendUpdate(i, npc->getPosition()))
+    {
+      NpcState npcState;
+      npcState.id = static_cast<int>(i);
+      npcState.x = npc->getPosition().x;
+      npcState.y = npc->getPosition().y;
+      npcState.rotation = npc->getRotation();
+      npcState.turretAngle = npc->getTurretAngle();
+      npcState.health = npc->getHealth();
+      npcState.team = npc->getTeam();
+      npcState.activated = npc->isActivated();
+      net.sendNpcUpdate(npcState);
+    }
   }
 }
 
@@ -954,7 +1677,6 @@ void MultiplayerHandler::renderMultiplayer(
     if (state.isHoldingExit)
     {
       // 显示确认进度条
-      const float EXIT_HOLD_TIME = 3.0f;
       float progress = state.exitHoldProgress / EXIT_HOLD_TIME;
 
       // 进度条背景
@@ -1069,6 +1791,10 @@ void MultiplayerHandler::renderUI(
     MultiplayerState &state)
 {
   ctx.window.setView(ctx.uiView);
+  if (!s_hudUI)
+    s_hudUI = std::make_unique<UILayer>(ctx.font);
+  UILayer &ui = *s_hudUI;
+  ui.begin();
 
   float barWidth = 150.f;
   float barHeight = 20.f;
@@ -1076,50 +1802,27 @@ void MultiplayerHandler::renderUI(
   float barY = 20.f;
 
   // Self 标签和血条
-  sf::Text selfLabel(ctx.font);
   if (state.isEscapeMode && state.localPlayerDead)
-  {
-    selfLabel.setString("Self [DOWNED]");
-    selfLabel.setFillColor(sf::Color::Red);
-  }
+    ui.text("selfLabel", "Self [DOWNED]", 18, sf::Color::Red, {barX, barY - 2.f});
   else
-  {
-    selfLabel.setString("Self");
-    selfLabel.setFillColor(sf::Color::White);
-  }
-  selfLabel.setCharacterSize(18);
-  selfLabel.setPosition({barX, barY - 2.f});
-  ctx.window.draw(selfLabel);
+    ui.text("selfLabel", "Self", 18, sf::Color::White, {barX, barY - 2.f});
 
   float selfHealthPercent = ctx.player ? (ctx.player->getHealth() / 100.f) : 0.f;
   sf::Color selfBarColor = (state.isEscapeMode && state.localPlayerDead) ? sf::Color(100, 100, 100) : sf::Color::Green;
-  UIHelper::drawHealthBar(ctx.window, barX + 50.f, barY, barWidth, barHeight,
+  UIHelper::drawHealthBar(ui, "selfHealth", barX + 50.f, barY, barWidth, barHeight,
                           selfHealthPercent, selfBarColor);
 
   // Other 标签和血条
-  sf::Text otherLabel(ctx.font);
   if (state.isEscapeMode && state.otherPlayerDead)
-  {
-    otherLabel.setString("Teammate [DOWNED]");
-    otherLabel.setFillColor(sf::Color::Red);
-  }
+    ui.text("otherLabel", "Teammate [DOWNED]", 18, sf::Color::Red, {barX, barY + 30.f - 2.f});
   else if (state.isEscapeMode)
-  {
-    otherLabel.setString("Teammate");
-    otherLabel.setFillColor(sf::Color::Cyan);
-  }
+    ui.text("otherLabel", "Teammate", 18, sf::Color::Cyan, {barX, barY + 30.f - 2.f});
   else
-  {
-    otherLabel.setString("Other");
-    otherLabel.setFillColor(sf::Color::White);
-  }
-  otherLabel.setCharacterSize(18);
-  otherLabel.setPosition({barX, barY + 30.f - 2.f});
-  ctx.window.draw(otherLabel);
+    ui.text("otherLabel", "Other", 18, sf::Color::White, {barX, barY + 30.f - 2.f});
 
   float otherHealthPercent = ctx.otherPlayer ? (ctx.otherPlayer->getHealth() / 100.f) : 0.f;
   sf::Color otherBarColor = (state.isEscapeMode && state.otherPlayerDead) ? sf::Color(100, 100, 100) : sf::Color::Cyan;
-  UIHelper::drawHealthBar(ctx.window, barX + 50.f, barY + 30.f, barWidth, barHeight,
+  UIHelper::drawHealthBar(ui, "otherHealth", barX + 50.f, barY + 30.f, barWidth, barHeight,
                           otherHealthPercent, otherBarColor);
 
   // Escape 模式显示到达终点状态
@@ -1128,66 +1831,32 @@ void MultiplayerHandler::renderUI(
     float statusY = barY + 60.f;
 
     // 本地玩家到达状态
-    sf::Text selfStatus(ctx.font);
     if (state.localPlayerReachedExit && !state.localPlayerDead)
-    {
-      selfStatus.setString("You: ESCAPED!");
-      selfStatus.setFillColor(sf::Color::Green);
-    }
+      ui.text("selfStatus", "You: ESCAPED!", 16, sf::Color::Green, {barX, statusY});
     else if (state.localPlayerDead)
-    {
-      selfStatus.setString("You: DOWNED - Wait for rescue!");
-      selfStatus.setFillColor(sf::Color::Red);
-    }
+      ui.text("selfStatus", "You: DOWNED - Wait for rescue!", 16, sf::Color::Red, {barX, statusY});
     else
-    {
-      selfStatus.setString("You: Reach the exit!");
-      selfStatus.setFillColor(sf::Color(180, 180, 180));
-    }
-    selfStatus.setCharacterSize(16);
-    selfStatus.setPosition({barX, statusY});
-    ctx.window.draw(selfStatus);
+      ui.text("selfStatus", "You: Reach the exit!", 16, sf::Color(180, 180, 180), {barX, statusY});
 
     // 队友到达状态
-    sf::Text otherStatus(ctx.font);
     if (state.otherPlayerReachedExit && !state.otherPlayerDead)
-    {
-      otherStatus.setString("Teammate: ESCAPED!");
-      otherStatus.setFillColor(sf::Color::Green);
-    }
+      ui.text("otherStatus", "Teammate: ESCAPED!", 16, sf::Color::Green, {barX, statusY + 22.f});
     else if (state.otherPlayerDead)
-    {
-      otherStatus.setString("Teammate: DOWNED - Go rescue!");
-      otherStatus.setFillColor(sf::Color::Red);
-    }
+      ui.text("otherStatus", "Teammate: DOWNED - Go rescue!", 16, sf::Color::Red, {barX, statusY + 22.f});
     else
-    {
-      otherStatus.setString("Teammate: Not escaped yet");
-      otherStatus.setFillColor(sf::Color(180, 180, 180));
-    }
-    otherStatus.setCharacterSize(16);
-    otherStatus.setPosition({barX, statusY + 22.f});
-    ctx.window.draw(otherStatus);
+      ui.text("otherStatus", "Teammate: Not escaped yet", 16, sf::Color(180, 180, 180), {barX, statusY + 22.f});
   }
   else
   {
     // Battle 模式：金币显示
-    sf::Text coinsText(ctx.font);
-    coinsText.setString("Coins: " + std::to_string(ctx.player ? ctx.player->getCoins() : 0));
-    coinsText.setCharacterSize(20);
-    coinsText.setFillColor(sf::Color::Yellow);
-    coinsText.setPosition({barX, barY + 60.f});
-    ctx.window.draw(coinsText);
+    ui.text("coins", "Coins: " + std::to_string(ctx.player ? ctx.player->getCoins() : 0), 20, sf::Color::Yellow,
+            {barX, barY + 60.f});
   }
 
   // 墙壁背包显示
   float wallsY = state.isEscapeMode ? barY + 110.f : barY + 85.f;
-  sf::Text wallsText(ctx.font);
-  wallsText.setString("Walls: " + std::to_string(ctx.player ? ctx.player->getWallsInBag() : 0));
-  wallsText.setCharacterSize(20);
-  wallsText.setFillColor(sf::Color(139, 90, 43)); // 棕色
-  wallsText.setPosition({barX, wallsY});
-  ctx.window.draw(wallsText);
+  ui.text("walls", "Walls: " + std::to_string(ctx.player ? ctx.player->getWallsInBag() : 0), 20,
+          sf::Color(139, 90, 43), {barX, wallsY}); // 棕色
 
   // Escape模式暗黑模式下显示剩余存活的敌人数量（Battle模式不显示）
   float enemyCountY = wallsY + 25.f;
@@ -1199,57 +1868,174 @@ void MultiplayerHandler::renderUI(
       if (!enemy->isDead())
         aliveEnemies++;
     }
-    sf::Text enemyCountText(ctx.font);
-    enemyCountText.setString("Enemies: " + std::to_string(aliveEnemies));
-    enemyCountText.setCharacterSize(20);
-    enemyCountText.setFillColor(sf::Color(255, 100, 100)); // 红色
-    enemyCountText.setPosition({barX, enemyCountY});
-    ctx.window.draw(enemyCountText);
+    ui.text("enemies", "Enemies: " + std::to_string(aliveEnemies), 20, sf::Color(255, 100, 100),
+            {barX, enemyCountY}); // 红色
     enemyCountY += 25.f;
   }
 
   // 墙壁放置模式提示
   if (ctx.placementMode)
   {
-    sf::Text placeHint(ctx.font);
-    placeHint.setString("[PLACEMENT MODE] Click to place wall, Space to cancel");
-    placeHint.setCharacterSize(20);
-    placeHint.setFillColor(sf::Color::Yellow);
-    sf::FloatRect hintBounds = placeHint.getLocalBounds();
-    placeHint.setPosition({(static_cast<float>(ctx.screenWidth) - hintBounds.size.x) / 2.f, 20.f});
-    ctx.window.draw(placeHint);
+    ui.text("placeHint", "[PLACEMENT MODE] Click to place wall, Space to cancel", 20, sf::Color::Yellow,
+            {static_cast<float>(ctx.screenWidth) / 2.f, 20.f}, UIAlign::Center);
   }
   else if (ctx.player && ctx.player->getWallsInBag() > 0)
   {
     // 提示可以按B进入放置模式
-    sf::Text bagHint(ctx.font);
-    bagHint.setString("Press SPACE to place walls");
-    bagHint.setCharacterSize(18);
-    bagHint.setFillColor(sf::Color(150, 150, 150));
-    bagHint.setPosition({barX, enemyCountY});
-    ctx.window.draw(bagHint);
+    ui.text("bagHint", "Press SPACE to place walls", 18, sf::Color(150, 150, 150), {barX, enemyCountY});
   }
 
+  // 帧同步模式：步号与失步提示
+  if (state.lockstep)
+  {
+    const LockstepSession &session = state.lockstepSession;
+    if (session.desynced())
+      ui.text("lockstep", "LOCKSTEP DESYNC at tick " + std::to_string(session.desyncTick()), 16, sf::Color::Red,
+              {static_cast<float>(ctx.screenWidth) - 20.f, 20.f}, UIAlign::Right);
+    else
+      ui.text("lockstep", "Lockstep tick " + std::to_string(session.tick()), 14, sf::Color(150, 150, 150),
+              {static_cast<float>(ctx.screenWidth) - 20.f, 20.f}, UIAlign::Right);
+  }
+
+  // 断线重连状态
+  if (state.reconnecting)
+    ui.text("resume", "Connection lost - reconnecting...", 24, sf::Color(255, 200, 80),
+            {static_cast<float>(ctx.screenWidth) / 2.f, 60.f}, UIAlign::Center);
+  else if (state.peerDropped)
+    ui.text("resume", "Other player disconnected - waiting " + std::to_string(static_cast<int>(std::ceil(state.peerDropTimer))) + "s",
+            20, sf::Color(255, 200, 80), {static_cast<float>(ctx.screenWidth) / 2.f, 60.f}, UIAlign::Center);
+
   // 显示操作提示
-  sf::Text controlHint(ctx.font);
-  if (state.isEscapeMode)
+  ui.text("controlHint",
+          state.isEscapeMode ? "WASD: Move | Mouse: Aim | Click: Shoot | F: Rescue teammate"
+                             : "WASD: Move | Mouse: Aim | Click: Shoot | R: Activate NPC",
+          14, sf::Color(150, 150, 150), {barX, static_cast<float>(ctx.screenHeight) - 30.f});
+  ui.draw(ctx.window);
+
+  // 渲染小地图（左下角）- 暗黑模式下隐藏
+  if (!ctx.isDarkMode)
   {
-    controlHint.setString("WASD: Move | Mouse: Aim | Click: Shoot | F: Rescue teammate");
+    renderMinimap(ctx, state);
+  }
+
+  if (state.showNetStats)
+  {
+    renderNetStats(ctx, state);
   }
+}
+
+void MultiplayerHandler::renderNetStats(
+    MultiplayerContext &ctx,
+    MultiplayerState &state)
+{
+  const NetworkManager &net = NetworkManager::getInstance();
+  const NetStats &stats = net.getStats();
+  const NetStats::Rtt &rtt = stats.rtt();
+
+  ctx.window.setView(ctx.uiView);
+  if (!s_netStatsUI)
+    s_netStatsUI = std::make_unique<UILayer>(ctx.font);
+  UILayer &ui = *s_netStatsUI;
+  ui.begin();
+
+  // 右上角面板（帧同步步号显示在它上方）
+  const float width = 380.f;
+  const float top = 45.f;
+  const float left = static_cast<float>(ctx.screenWidth) - width - 20.f;
+  const float textX = left + 10.f;
+  const float downX = left + width - 10.f; // 下行列右对齐
+  const float upX = downX - 120.f;         // 上行列右对齐
+  const float lineHeight = 18.f;
+  const sf::Color textColor(220, 220, 220);
+  const sf::Color dimColor(150, 150, 150);
+  char buffer[128];
+  float y = top + 6.f;
+
+  ui.text("title", "Network (F3)", 14, sf::Color::Yellow, {textX, y}, UIAlign::Left, true);
+  y += lineHeight + 2.f;
+
+  if (rtt.samples > 0)
+    std::snprintf(buffer, sizeof(buffer), "RTT %.1f ms (last %.1f, min %.1f, jitter %.1f)", rtt.smoothedMs,
+                  rtt.lastMs, rtt.minMs, rtt.jitterMs);
   else
+    std::snprintf(buffer, sizeof(buffer), "RTT -- (waiting for pong)");
+  ui.text("rtt", buffer, 13, textColor, {textX, y});
+  y += lineHeight;
+
+  std::snprintf(buffer, sizeof(buffer), "%s | frame %.1f ms", net.isUdpActive() ? "UDP + TCP" : "TCP only",
+                state.frameTimeMs);
+  ui.text("transport", buffer, 13, textColor, {textX, y});
+  y += lineHeight;
+
+  // 房主：NPC 同步的关注区域
+  if (state.ownsWorldSimulation() && !state.lockstep)
   {
-    controlHint.setString("WASD: Move | Mouse: Aim | Click: Shoot | R: Activate NPC");
+    const InterestManager::Stats &interest = s_interest.getStats();
+    std::snprintf(buffer, sizeof(buffer), "AOI: %d NPCs near, %d far, %llu shots culled", s_interest.insideCount(),
+                  s_interest.outsideCount(), static_cast<unsigned long long>(interest.shotsCulled));
+    ui.text("interest", buffer, 13, textColor, {textX, y});
+    y += lineHeight;
   }
-  controlHint.setCharacterSize(14);
-  controlHint.setFillColor(sf::Color(150, 150, 150));
-  controlHint.setPosition({barX, static_cast<float>(ctx.screenHeight) - 30.f});
-  ctx.window.draw(controlHint);
 
-  // 渲染小地图（左下角）- 暗黑模式下隐藏
-  if (!ctx.isDarkMode)
+  // 整体收发速率
+  const NetDirection directions[2] = {NetDirection::Sent, NetDirection::Received};
+  for (int i = 0; i < 2; i++)
   {
-    renderMinimap(ctx, state);
+    NetStats::Rate rate = stats.rate(directions[i]);
+    NetStats::Counter total = stats.total(directions[i]);
+    std::snprintf(buffer, sizeof(buffer), "%s %s, %.0f msg/s (total %.1f KB)", i == 0 ? "Up" : "Down",
+                  formatBytesPerSec(rate.bytesPerSec).c_str(), rate.messagesPerSec, total.bytes / 1024.0);
+    ui.text(i == 0 ? "up" : "down", buffer, 13, textColor, {textX, y});
+    y += lineHeight;
   }
+
+  // 按最近 1 秒的流量列出最多的几种消息
+  y += 4.f;
+  ui.text("typeHeader", "Type", 12, dimColor, {textX, y});
+  ui.text("upHeader", "Up", 12, dimColor, {upX, y}, UIAlign::Right);
+  ui.text("downHeader", "Down", 12, dimColor, {downX, y}, UIAlign::Right);
+  y += lineHeight - 2.f;
+
+  std::vector<std::pair<float, int>> busiest;
+  for (int type = 0; type < 256; type++)
+  {
+    float bytesPerSec = stats.rate(NetDirection::Sent, static_cast<uint8_t>(type)).bytesPerSec +
+                        stats.rate(NetDirection::Received, static_cast<uint8_t>(type)).bytesPerSec;
+    if (bytesPerSec > 0.f)
+      busiest.push_back({bytesPerSec, type});
+  }
+  std::size_t rows = std::min<std::size_t>(busiest.size(), NET_STATS_MAX_TYPES);
+  std::partial_sort(busiest.begin(), busiest.begin() + rows, busiest.end(),
+                    [](const auto &a, const auto &b)
+                    { return a.first > b.first; });
+
+  for (std::size_t i = 0; i < rows; i++)
+  {
+    uint8_t type = static_cast<uint8_t>(busiest[i].second);
+    std::string id = "type" + std::to_string(i);
+    ui.text(id, NetStats::typeName(type), 12, textColor, {textX, y});
+
+    for (int d = 0; d < 2; d++)
+    {
+      NetStats::Rate rate = stats.rate(directions[d], type);
+      std::string column = rate.messagesPerSec > 0.f ? formatBytesPerSec(rate.bytesPerSec) : "-";
+      if (rate.messagesPerSec > 0.f)
+      {
+        std::snprintf(buffer, sizeof(buffer), " %.0f/s", rate.messagesPerSec);
+        column += buffer;
+      }
+      ui.text(id + (d == 0 ? "up" : "down"), column, 12, textColor, {d == 0 ? upX : downX, y}, UIAlign::Right);
+    }
+    y += lineHeight - 2.f;
+  }
+  if (rows == 0)
+  {
+    ui.text("idle", "(no traffic in the last second)", 12, dimColor, {textX, y});
+    y += lineHeight - 2.f;
+  }
+
+  ui.panel("background", {left, top}, {width, y - top + 6.f}, sf::Color(0, 0, 0, 170), 6.f);
+  ui.draw(ctx.window);
 }
 
 void MultiplayerHandler::renderMinimap(
@@ -1262,13 +2048,14 @@ void MultiplayerHandler::renderMinimap(
   const float minimapX = minimapMargin;
   const float minimapY = static_cast<float>(ctx.screenHeight) - minimapSize - minimapMargin - 35.f; // 留出操作提示空间
 
-  // 绘制小地图背景
-  sf::RectangleShape minimapBg({minimapSize, minimapSize});
-  minimapBg.setPosition({minimapX, minimapY});
-  minimapBg.setFillColor(sf::Color(20, 20, 20, 200));
-  minimapBg.setOutlineColor(sf::Color(100, 100, 100, 255));
-  minimapBg.setOutlineThickness(2.f);
-  ctx.window.draw(minimapBg);
+  // 小地图背景和标签（保留模式，画在标记点下面）
+  if (!s_minimapUI)
+    s_minimapUI = std::make_unique<UILayer>(ctx.font);
+  s_minimapUI->begin();
+  s_minimapUI->panel("background", {minimapX, minimapY}, {minimapSize, minimapSize}, sf::Color(20, 20, 20, 200), 0.f,
+                     sf::Color(100, 100, 100, 255), 2.f);
+  s_minimapUI->text("label", "Minimap", 12, sf::Color(180, 180, 180), {minimapX + 5.f, minimapY + 3.f});
+  s_minimapUI->draw(ctx.window);
 
   // 计算地图范围（基于迷宫大小）
   sf::Vector2f mazeSize = ctx.maze.getSize();
@@ -1288,14 +2075,15 @@ void MultiplayerHandler::renderMinimap(
         offsetY + worldPos.y * scale);
   };
 
-  // 绘制NPC
-  for (const auto &npc : ctx.enemies)
+  // 绘制NPC（线性扫描实体存储）
+  const EntityStore &store = ctx.entities;
+  for (EntityId id = 0; id < store.capacity(); id++)
   {
-    if (npc->isDead())
+    if (!store.isAliveNpc(id))
       continue;
 
-    sf::Vector2f npcPos = npc->getPosition();
-    sf::Vector2f npcMiniPos = worldToMinimap(npcPos);
+    sf::Vector2f npcMiniPos = worldToMinimap({store.x[id], store.y[id]});
+    bool activated = store.isActiveNpc(id);
 
     sf::CircleShape npcDot(3.f);
     npcDot.setPosition({npcMiniPos.x - 3.f, npcMiniPos.y - 3.f});
@@ -1303,7 +2091,7 @@ void MultiplayerHandler::renderMinimap(
     if (state.isEscapeMode)
     {
       // Escape模式：未激活灰色，已激活是敌方（红色）
-      if (npc->isActivated())
+      if (activated)
       {
         npcDot.setFillColor(GameColors::MinimapEnemyNpc);
       }
@@ -1315,10 +2103,10 @@ void MultiplayerHandler::renderMinimap(
     else
     {
       // Battle模式：根据阵营显示
-      if (npc->isActivated())
+      if (activated)
       {
         int localTeam = ctx.player ? ctx.player->getTeam() : 1;
-        if (npc->getTeam() == localTeam)
+        if (store.team[id] == localTeam)
         {
           npcDot.setFillColor(GameColors::MinimapAllyNpc); // 己方NPC浅蓝色
         }
@@ -1383,14 +2171,6 @@ void MultiplayerHandler::renderMinimap(
     }
     ctx.window.draw(playerDot);
   }
-
-  // 小地图标签
-  sf::Text minimapLabel(ctx.font);
-  minimapLabel.setString("Minimap");
-  minimapLabel.setCharacterSize(12);
-  minimapLabel.setFillColor(sf::Color(180, 180, 180));
-  minimapLabel.setPosition({minimapX + 5.f, minimapY + 3.f});
-  ctx.window.draw(minimapLabel);
 }
 
 void MultiplayerHandler::renderDarkModeOverlay(MultiplayerContext &ctx)
@@ -0,0 +1,251 @@
+#include "NetStats.hpp"
+#include "NetProtocol.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace
+{
+  void appendNumber(std::string &out, const char *key, double value)
+  {
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), "\"%s\":%.2f", key, value);
+    out += buffer;
+  }
+
+  void appendCount(std::string &out, const char *key, uint64_t value)
+  {
+    out += '"';
+    out += key;
+    out += "\":";
+    out += std::to_string(value);
+  }
+}
+
+void NetStats::reset(float now)
+{
+  for (auto &dir : m_types)
+    for (auto &counters : dir)
+      counters = TypeCounters{};
+  m_udp[0] = m_udp[1] = Counter{};
+  m_bucket = 0;
+  m_bucketStart = now;
+  m_rtt = Rtt{};
+}
+
+void NetStats::advance(float now)
+{
+  if (now - m_bucketStart >= BUCKETS * BUCKET_SECONDS)
+  {
+    // 长时间没有推进：整个窗口都已过期
+    for (auto &dir : m_types)
+      for (auto &counters : dir)
+      {
+        std::fill(std::begin(counters.bucketMessages), std::end(counters.bucketMessages), 0u);
+        std::fill(std::begin(counters.bucketBytes), std::end(counters.bucketBytes), 0u);
+      }
+    m_bucketStart = now;
+    return;
+  }
+
+  while (now - m_bucketStart >= BUCKET_SECONDS)
+  {
+    m_bucket = (m_bucket + 1) % BUCKETS;
+    m_bucketStart += BUCKET_SECONDS;
+    for (auto &dir : m_types)
+      for (auto &counters : dir)
+      {
+        counters.bucketMessages[m_bucket] = 0;
+        counters.bucketBytes[m_bucket] = 0;
+      }
+  }
+}
+
+void NetStats::record(NetDirection dir, uint8_t type, std::size_t bytes, bool udp, float now)
+{
+  advance(now);
+
+  TypeCounters &counters = m_types[index(dir)][type];
+  counters.total.messages++;
+  counters.total.bytes += bytes;
+  counters.bucketMessages[m_bucket]++;
+  counters.bucketBytes[m_bucket] += static_cast<uint32_t>(bytes);
+  if (udp)
+  {
+    m_udp[index(dir)].messages++;
+    m_udp[index(dir)].bytes += bytes;
+  }
+}
+
+void NetStats::addRttSample(float rttMs)
+{
+  if (m_rtt.samples == 0)
+  {
+    m_rtt.smoothedMs = rttMs;
+    m_rtt.minMs = rttMs;
+  }
+  else
+  {
+    m_rtt.jitterMs += (std::fabs(rttMs - m_rtt.lastMs) - m_rtt.jitterMs) / 16.f;
+    m_rtt.smoothedMs += (rttMs - m_rtt.smoothedMs) / 8.f;
+    m_rtt.minMs = std::min(m_rtt.minMs, rttMs);
+  }
+  m_rtt.lastMs = rttMs;
+  m_rtt.samples++;
+}
+
+NetStats::Counter NetStats::total(NetDirection dir) const
+{
+  Counter sum;
+  for (const auto &counters : m_types[index(dir)])
+  {
+    sum.messages += counters.total.messages;
+    sum.bytes += counters.total.bytes;
+  }
+  return sum;
+}
+
+NetStats::Rate NetStats::rate(NetDirection dir, uint8_t type) const
+{
+  const TypeCounters &counters = m_types[index(dir)][type];
+  uint64_t messages = 0, bytes = 0;
+  for (int i = 0; i < BUCKETS; i++)
+  {
+    if (i == m_bucket)
+      continue;
+    messages += counters.bucketMessages[i];
+    bytes += counters.bucketBytes[i];
+  }
+  return {static_cast<float>(messages) / WINDOW_SECONDS, static_cast<float>(bytes) / WINDOW_SECONDS};
+}
+
+NetStats::Rate NetStats::rate(NetDirection dir) const
+{
+  Rate sum;
+  for (int type = 0; type < 256; type++)
+  {
+    if (m_types[index(dir)][type].total.messages == 0)
+      continue;
+    Rate r = rate(dir, static_cast<uint8_t>(type));
+    sum.messagesPerSec += r.messagesPerSec;
+    sum.bytesPerSec += r.bytesPerSec;
+  }
+  return sum;
+}
+
+void NetStats::appendDirectionJson(std::string &out, NetDirection dir) const
+{
+  Counter sum = total(dir);
+  Rate r = rate(dir);
+  out += '{';
+  appendCount(out, "msgs", sum.messages);
+  out += ',';
+  appendCount(out, "bytes", sum.bytes);
+  out += ',';
+  appendCount(out, "udpBytes", m_udp[index(dir)].bytes);
+  out += ',';
+  appendNumber(out, "msgsPerSec", r.messagesPerSec);
+  out += ',';
+  appendNumber(out, "bytesPerSec", r.bytesPerSec);
+  out += ",\"types\":{";
+  bool first = true;
+  for (int type = 0; type < 256; type++)
+  {
+    const Counter &t = m_types[index(dir)][type].total;
+    if (t.messages == 0)
+      continue;
+    Rate tr = rate(dir, static_cast<uint8_t>(type));
+    if (!first)
+      out += ',';
+    first = false;
+    out += '"';
+    out += typeName(static_cast<uint8_t>(type));
+    if (static_cast<NetMessageType>(type) > NetMessageType::WallBatch || type == 0)
+      out += std::to_string(type); // 未知类型带上编号，避免重复的键
+    out += "\":{";
+    appendCount(out, "msgs", t.messages);
+    out += ',';
+    appendCount(out, "bytes", t.bytes);
+    out += ',';
+    appendNumber(out, "msgsPerSec", tr.messagesPerSec);
+    out += ',';
+    appendNumber(out, "bytesPerSec", tr.bytesPerSec);
+    out += '}';
+  }
+  out += "}}";
+}
+
+std::string NetStats::toJson(float now) const
+{
+  std::string out = "{";
+  appendNumber(out, "time", now);
+  out += ",\"rtt\":{";
+  appendNumber(out, "lastMs", m_rtt.lastMs);
+  out += ',';
+  appendNumber(out, "smoothedMs", m_rtt.smoothedMs);
+  out += ',';
+  appendNumber(out, "jitterMs", m_rtt.jitterMs);
+  out += ',';
+  appendNumber(out, "minMs", m_rtt.minMs);
+  out += ',';
+  appendCount(out, "samples", m_rtt.samples);
+  out += "},\"sent\":";
+  appendDirectionJson(out, NetDirection::Sent);
+  out += ",\"received\":";
+  appendDirectionJson(out, NetDirection::Received);
+  out += '}';
+  return out;
+}
+
+const char *NetStats::typeName(uint8_t type)
+{
+  switch (static_cast<NetMessageType>(type))
+  {
+  case NetMessageType::Connect: return "Connect";
+  case NetMessageType::ConnectAck: return "ConnectAck";
+  case NetMessageType::Disconnect: return "Disconnect";
+  case NetMessageType::CreateRoom: return "CreateRoom";
+  case NetMessageType::JoinRoom: return "JoinRoom";
+  case NetMessageType::RoomCreated: return "RoomCreated";
+  case NetMessageType::RoomJoined: return "RoomJoined";
+  case NetMessageType::RoomError: return "RoomError";
+  case NetMessageType::GameStart: return "GameStart";
+  case NetMessageType::PlayerUpdate: return "PlayerUpdate";
+  case NetMessageType::PlayerShoot: return "PlayerShoot";
+  case NetMessageType::MazeData: return "MazeData";
+  case NetMessageType::RequestMaze: return "RequestMaze";
+  case NetMessageType::ReachExit: return "ReachExit";
+  case NetMessageType::GameWin: return "GameWin";
+  case NetMessageType::GameResult: return "GameResult";
+  case NetMessageType::RestartRequest: return "RestartRequest";
+  case NetMessageType::NpcActivate: return "NpcActivate";
+  case NetMessageType::NpcUpdate: return "NpcUpdate";
+  case NetMessageType::NpcShoot: return "NpcShoot";
+  case NetMessageType::NpcDamage: return "NpcDamage";
+  case NetMessageType::WallPlace: return "WallPlace";
+  case NetMessageType::ClimaxStart: return "ClimaxStart";
+  case NetMessageType::PlayerLeft: return "PlayerLeft";
+  case NetMessageType::RescueStart: return "RescueStart";
+  case NetMessageType::RescueProgress: return "RescueProgress";
+  case NetMessageType::RescueComplete: return "RescueComplete";
+  case NetMessageType::RescueCancel: return "RescueCancel";
+  case NetMessageType::PlayerReady: return "PlayerReady";
+  case NetMessageType::HostStartGame: return "HostStartGame";
+  case NetMessageType::RoomInfo: return "RoomInfo";
+  case NetMessageType::WallDamage: return "WallDamage";
+  case NetMessageType::UdpHello: return "UdpHello";
+  case NetMessageType::MazeChunk: return "MazeChunk";
+  case NetMessageType::MazeOffer: return "MazeOffer";
+  case NetMessageType::MazeSeed: return "MazeSeed";
+  case NetMessageType::InputFrame: return "InputFrame";
+  case NetMessageType::StateHash: return "StateHash";
+  case NetMessageType::Ping: return "Ping";
+  case NetMessageType::Pong: return "Pong";
+  case NetMessageType::ResumeSession: return "ResumeSession";
+  case NetMessageType::ResumeRequest: return "ResumeRequest";
+  case NetMessageType::ResumeSnapshot: return "ResumeSnapshot";
+  case NetMessageType::PeerDropped: return "PeerDropped";
+  case NetMessageType::WallBatch: return "WallBatch";
+  }
+  return "Unknown";
+}
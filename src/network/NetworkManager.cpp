@@ -1,6 +1,10 @@
 #include "NetworkManager.hpp"
+#include "MazeGenerator.hpp"
 #include <iostream>
 #include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <algorithm>
 
 NetworkManager &NetworkManager::getInstance()
 {
@@ -21,10 +25,7 @@ bool NetworkManager::connect(const std::string &host, unsigned short port)
     return false;
   }
 
-  sf::Socket::Status status = m_socket.connect(address.value(), port, sf::seconds(5));
-  m_socket.setBlocking(false);
-
-  if (status != sf::Socket::Status::Done)
+  if (!openSockets(address.value(), port, sf::seconds(5)))
   {
     if (m_onError)
     {
@@ -32,13 +33,53 @@ bool NetworkManager::connect(const std::string &host, unsigned short port)
     }
     return false;
   }
+  m_resuming = false;
+  m_resumeToken = 0;
 
-  m_connected = true;
+  // 开发调试：TANK_NET_SIM="丢包率,延迟ms,抖动ms"，TANK_NET_UDP=0 禁用 UDP，
+  // TANK_SERVER_SIM=1 创建房间时请求服务器权威模拟，TANK_LOCKSTEP=1 创建房间时请求帧同步模式，
+  // TANK_NET_STATS=路径 每秒追加一行网络统计 JSON
+  if (const char *sim = std::getenv("TANK_NET_SIM"))
+  {
+    float loss = 0.f, latency = 0.f, jitter = 0.f;
+    if (std::sscanf(sim, "%f,%f,%f", &loss, &latency, &jitter) >= 1)
+    {
+      setNetworkSimulation(loss, latency, jitter);
+    }
+  }
+  if (const char *udp = std::getenv("TANK_NET_UDP"))
+  {
+    m_udpEnabled = std::strcmp(udp, "0") != 0;
+  }
+  if (const char *serverSim = std::getenv("TANK_SERVER_SIM"))
+  {
+    m_serverSimRequested = std::strcmp(serverSim, "0") != 0;
+  }
+  if (const char *lockstep = std::getenv("TANK_LOCKSTEP"))
+  {
+    m_lockstepRequested = std::strcmp(lockstep, "0") != 0;
+  }
+  if (const char *statsPath = std::getenv("TANK_NET_STATS"))
+  {
+    m_statsDumpPath = statsPath;
+  }
+
+  // 网络诊断：统计从本次连接开始
+  m_stats.reset(getNetworkTime());
+  m_pingSeq = 0;
+  m_lastStatsDumpAt = getNetworkTime();
+  if (!m_statsDumpPath.empty() && !m_statsDump)
+  {
+    m_statsDump = std::fopen(m_statsDumpPath.c_str(), "a");
+    if (!m_statsDump)
+      std::cerr << "[Network] Failed to open stats dump " << m_statsDumpPath << std::endl;
+  }
 
   // 发送连接消息
   std::vector<uint8_t> data;
   data.push_back(static_cast<uint8_t>(NetMessageType::Connect));
   sendPacket(data);
+  sendPing();
 
   if (m_onConnected)
   {
@@ -48,6 +89,37 @@ bool NetworkManager::connect(const std::string &host, unsigned short port)
   return true;
 }
 
+bool NetworkManager::openSockets(const sf::IpAddress &address, unsigned short port, sf::Time timeout)
+{
+  m_socket.setBlocking(true);
+  sf::Socket::Status status = m_socket.connect(address, port, timeout);
+  m_socket.setBlocking(false);
+  if (status != sf::Socket::Status::Done)
+    return false;
+
+  m_connected = true;
+  m_serverAddress = address;
+  m_serverPort = port;
+  m_receiveBuffer.clear();
+
+  // 绑定 UDP 端口（随机），会话ID到达后再握手
+  m_udpSocket.unbind();
+  m_udpReady = false;
+  m_sessionId = 0;
+  m_udpSendSeq = 0;
+  m_udpHelloAttempts = 0;
+  m_lastUdpSeq.clear();
+  if (m_udpSocket.bind(sf::Socket::AnyPort) == sf::Socket::Status::Done)
+  {
+    m_udpSocket.setBlocking(false);
+  }
+  else
+  {
+    std::cerr << "[Network] Failed to bind UDP socket, using TCP only" << std::endl;
+  }
+  return true;
+}
+
 void NetworkManager::disconnect()
 {
   if (m_connected)
@@ -57,10 +129,26 @@ void NetworkManager::disconnect()
     sendPacket(data);
   }
 
+  if (m_statsDump)
+  {
+    writeStatsDump();
+    std::fclose(m_statsDump);
+    m_statsDump = nullptr;
+  }
+
   m_socket.disconnect();
+  m_udpSocket.unbind();
   m_connected = false;
+  m_udpReady = false;
+  m_sessionId = 0;
+  m_resuming = false;
+  m_resumeToken = 0;
   m_roomCode.clear();
   m_receiveBuffer.clear();
+  m_lastUdpSeq.clear();
+  m_delayedMessages.clear();
+  m_wallBatch.clear();
+  resetMazeTransfer();
 
   if (m_onDisconnected)
   {
@@ -85,6 +173,13 @@ void NetworkManager::createRoom(int mazeWidth, int mazeHeight, bool isDarkMode)
   // 添加暗黑模式标志
   data.push_back(static_cast<uint8_t>(isDarkMode ? 1 : 0));
 
+  // 请求服务器权威模拟（Node 服务器忽略此字节）
+  data.push_back(static_cast<uint8_t>(m_serverSimRequested ? 1 : 0));
+
+  // 请求帧同步模式
+  data.push_back(static_cast<uint8_t>(m_lockstepRequested ? 1 : 0));
+
+  resetMazeTransfer();
   sendPacket(data);
 }
 
@@ -101,6 +196,7 @@ void NetworkManager::joinRoom(const std::string &roomCode)
     data.push_back(static_cast<uint8_t>(c));
   }
 
+  resetMazeTransfer();
   sendPacket(data);
 }
 
@@ -127,8 +223,9 @@ void NetworkManager::sendPosition(const PlayerState &state)
   addFloat(state.health);
   data.push_back(state.reachedExit ? 1 : 0);
   data.push_back(state.isDead ? 1 : 0); // 添加死亡状态
+  addFloat(getNetworkTime());           // 快照时间戳（用于插值）
 
-  sendPacket(data);
+  sendStatePacket(data);
 }
 
 void NetworkManager::sendShoot(float x, float y, float angle)
@@ -150,7 +247,23 @@ void NetworkManager::sendShoot(float x, float y, float angle)
   addFloat(y);
   addFloat(angle);
 
-  sendPacket(data);
+  sendStatePacket(data);
+}
+
+void NetworkManager::sendPlayerInput(uint32_t seq, uint8_t buttons, sf::Vector2f aim, bool reachedExit)
+{
+  if (!m_connected)
+    return;
+
+  std::vector<uint8_t> data(15);
+  data[0] = static_cast<uint8_t>(NetMessageType::PlayerInput);
+  std::memcpy(&data[1], &seq, sizeof(uint32_t));
+  data[5] = buttons;
+  std::memcpy(&data[6], &aim.x, sizeof(float));
+  std::memcpy(&data[10], &aim.y, sizeof(float));
+  data[14] = reachedExit ? 1 : 0;
+
+  sendStatePacket(data);
 }
 
 void NetworkManager::sendReachExit()
@@ -172,6 +285,7 @@ void NetworkManager::sendGameResult(bool localWin)
   data.push_back(static_cast<uint8_t>(NetMessageType::GameResult));
   data.push_back(localWin ? 1 : 0); // 我赢了
   sendPacket(data);
+  m_resumeToken = 0; // 对局已结束，之后掉线不再重连
 }
 
 void NetworkManager::sendRestartRequest()
@@ -182,6 +296,21 @@ void NetworkManager::sendRestartRequest()
   std::vector<uint8_t> data;
   data.push_back(static_cast<uint8_t>(NetMessageType::RestartRequest));
   sendPacket(data);
+  m_resumeToken = 0;
+}
+
+void NetworkManager::sendResumeSnapshot(const ResumeSnapshot &snapshot)
+{
+  if (!m_connected)
+    return;
+
+  std::vector<uint8_t> data = ResumeCodec::buildSnapshot(snapshot);
+  if (data.empty())
+  {
+    std::cerr << "[Network] Resume snapshot too large, not sent" << std::endl;
+    return;
+  }
+  sendPacket(data);
 }
 
 void NetworkManager::sendClimaxStart()
@@ -194,57 +323,77 @@ void NetworkManager::sendClimaxStart()
   sendPacket(data);
 }
 
-void NetworkManager::sendWallPlace(float x, float y)
+void NetworkManager::queueWallPlace(int row, int col)
 {
   if (!m_connected)
     return;
+  m_wallBatch.addPlace(row, col);
+}
 
-  std::vector<uint8_t> data;
-  data.push_back(static_cast<uint8_t>(NetMessageType::WallPlace));
+void NetworkManager::queueWallDamage(int row, int col, float damage, bool destroyed, int attribute, int destroyerId)
+{
+  if (!m_connected)
+    return;
+  m_wallBatch.addDamage(row, col, damage, destroyed, attribute, destroyerId);
+}
 
-  auto addFloat = [&data](float value)
-  {
-    uint8_t *bytes = reinterpret_cast<uint8_t *>(&value);
-    for (int i = 0; i < 4; i++)
-      data.push_back(bytes[i]);
-  };
+void NetworkManager::flushWallBatch()
+{
+  if (m_wallBatch.empty())
+    return;
+  for (const auto &message : m_wallBatch.build())
+    sendPacket(message);
+  m_wallBatch.clear();
+}
 
-  addFloat(x);
-  addFloat(y);
+void NetworkManager::sendLockstepInput(uint32_t tick, const LockstepInput &input)
+{
+  if (!m_connected)
+    return;
 
+  std::vector<uint8_t> data(18);
+  data[0] = static_cast<uint8_t>(NetMessageType::InputFrame);
+  std::memcpy(&data[1], &tick, sizeof(uint32_t));
+  data[5] = input.buttons;
+  std::memcpy(&data[6], &input.placeCol, sizeof(int16_t));
+  std::memcpy(&data[8], &input.placeRow, sizeof(int16_t));
+  std::memcpy(&data[10], &input.aimX, sizeof(float));
+  std::memcpy(&data[14], &input.aimY, sizeof(float));
   sendPacket(data);
 }
 
-void NetworkManager::sendWallDamage(int row, int col, float damage, bool destroyed, int attribute, int destroyerId)
+void NetworkManager::sendStateHash(uint32_t tick, uint64_t hash)
 {
   if (!m_connected)
     return;
 
-  std::vector<uint8_t> data;
-  data.push_back(static_cast<uint8_t>(NetMessageType::WallDamage));
-
-  auto addInt = [&data](int value)
-  {
-    uint8_t *bytes = reinterpret_cast<uint8_t *>(&value);
-    for (int i = 0; i < 4; i++)
-      data.push_back(bytes[i]);
-  };
-
-  auto addFloat = [&data](float value)
-  {
-    uint8_t *bytes = reinterpret_cast<uint8_t *>(&value);
-    for (int i = 0; i < 4; i++)
-      data.push_back(bytes[i]);
-  };
-
-  addInt(row);
-  addInt(col);
-  addFloat(damage);
-  data.push_back(destroyed ? 1 : 0);
-  addInt(attribute);
-  addInt(destroyerId);
+  std::vector<uint8_t> data(13);
+  data[0] = static_cast<uint8_t>(NetMessageType::StateHash);
+  std::memcpy(&data[1], &tick, sizeof(uint32_t));
+  std::memcpy(&data[5], &hash, sizeof(uint64_t));
+  sendPacket(data);
+}
 
+void NetworkManager::sendPing()
+{
+  // 发送时间取网络时钟的微秒数（按 32 位回绕，只用于相减）
+  uint32_t seq = ++m_pingSeq;
+  uint32_t sentUs = static_cast<uint32_t>(m_netClock.getElapsedTime().asMicroseconds());
+  std::vector<uint8_t> data(9);
+  data[0] = static_cast<uint8_t>(NetMessageType::Ping);
+  std::memcpy(&data[1], &seq, sizeof(uint32_t));
+  std::memcpy(&data[5], &sentUs, sizeof(uint32_t));
   sendPacket(data);
+  m_lastPingAt = getNetworkTime();
+}
+
+void NetworkManager::writeStatsDump()
+{
+  float now = getNetworkTime();
+  std::string line = m_stats.toJson(now);
+  std::fprintf(m_statsDump, "%s\n", line.c_str());
+  std::fflush(m_statsDump);
+  m_lastStatsDumpAt = now;
 }
 
 void NetworkManager::sendRescueStart()
@@ -353,7 +502,8 @@ void NetworkManager::sendNpcUpdate(const NpcState &state)
   pushFloat(state.health);
   data.push_back(static_cast<uint8_t>(state.team));
   data.push_back(state.activated ? 1 : 0);
-  sendPacket(data);
+  pushFloat(getNetworkTime()); // 快照时间戳（用于插值）
+  sendStatePacket(data);
 }
 
 void NetworkManager::sendNpcShoot(int npcId, float x, float y, float angle)
@@ -378,7 +528,7 @@ void NetworkManager::sendNpcShoot(int npcId, float x, float y, float angle)
   pushFloat(x);
   pushFloat(y);
   pushFloat(angle);
-  sendPacket(data);
+  sendStatePacket(data);
 }
 
 void NetworkManager::sendNpcDamage(int npcId, float damage)
@@ -399,44 +549,203 @@ void NetworkManager::sendNpcDamage(int npcId, float damage)
   sendPacket(data);
 }
 
-void NetworkManager::sendMazeData(const std::vector<std::string> &mazeData, bool isEscapeMode, bool isDarkMode)
+void NetworkManager::sendMazeData(const std::vector<std::string> &mazeData, bool isEscapeMode, bool isDarkMode,
+                                  const MazeSeedParams &seed)
 {
   if (!m_connected)
     return;
 
-  std::vector<uint8_t> data;
-  data.push_back(static_cast<uint8_t>(NetMessageType::MazeData));
-
   // 游戏模式标志: bit 0 = isEscapeMode, bit 1 = isDarkMode
   uint8_t modeFlags = (isEscapeMode ? 1 : 0) | (isDarkMode ? 2 : 0);
-  data.push_back(modeFlags);
 
-  // 迷宫行数
-  uint16_t rows = static_cast<uint16_t>(mazeData.size());
-  data.push_back(static_cast<uint8_t>(rows & 0xFF));
-  data.push_back(static_cast<uint8_t>((rows >> 8) & 0xFF));
+  uint64_t hash = 0;
+  auto chunks = MazeCodec::buildChunks(mazeData, modeFlags, hash);
+  if (chunks.empty())
+  {
+    std::cerr << "[Network] Failed to encode maze data" << std::endl;
+    return;
+  }
 
-  // 每行数据
-  for (const auto &row : mazeData)
+  // 分块始终保留，对方重新生成失败时按 RequestMaze(哈希) 补发
+  if (hash != m_outgoingMazeHash || modeFlags != m_outgoingMazeFlags || m_outgoingMazeChunks.empty())
   {
-    uint16_t len = static_cast<uint16_t>(row.length());
-    data.push_back(static_cast<uint8_t>(len & 0xFF));
-    data.push_back(static_cast<uint8_t>((len >> 8) & 0xFF));
-    for (char c : row)
-    {
-      data.push_back(static_cast<uint8_t>(c));
-    }
+    m_outgoingMazeChunks = std::move(chunks);
+    m_outgoingMazeHash = hash;
+    m_outgoingMazeFlags = modeFlags;
+    m_mazeUploaded = false;
   }
 
-  sendPacket(data);
+  // 只发种子：对方用同一版本的 MazeGenerator 本地生成
+  if (seed.version != 0)
+  {
+    sendPacket(MazeCodec::buildSeedMessage(seed, modeFlags, hash));
+    return;
+  }
+
+  // 服务器已缓存同一迷宫：只发哈希，未命中时服务器会回复 RequestMaze
+  if (m_mazeUploaded)
+  {
+    std::vector<uint8_t> data;
+    data.push_back(static_cast<uint8_t>(NetMessageType::MazeOffer));
+    data.push_back(modeFlags);
+    MazeCodec::writeHash(data, hash);
+    sendPacket(data);
+    return;
+  }
+
+  sendMazeChunks();
+}
+
+void NetworkManager::sendMazeChunks()
+{
+  for (const auto &chunk : m_outgoingMazeChunks)
+  {
+    sendPacket(chunk);
+  }
+  m_mazeUploaded = !m_outgoingMazeChunks.empty();
+}
+
+void NetworkManager::handleMazeSeed(const std::vector<uint8_t> &data)
+{
+  MazeSeedParams params;
+  uint8_t modeFlags = 0;
+  uint64_t hash = 0;
+  if (!MazeCodec::parseSeedMessage(data, params, modeFlags, hash))
+    return;
+
+  // 版本一致时本地重新生成并校验哈希，否则请求分块传输
+  std::vector<std::string> mazeData;
+  if (params.version == MazeGenerator::ALGORITHM_VERSION && params.seed != 0)
+  {
+    MazeGenerator generator(params.width, params.height);
+    generator.setSeed(params.seed);
+    generator.setEnemyCount(params.enemyCount);
+    generator.setMultiplayerMode(true);
+    generator.setEscapeMode((modeFlags & 1) != 0);
+    mazeData = generator.generate();
+  }
+
+  if (mazeData.empty() || MazeCodec::hash(mazeData) != hash)
+  {
+    std::cerr << "[Network] Maze seed v" << static_cast<int>(params.version) << " could not be reproduced locally, "
+              << "requesting full maze" << std::endl;
+    std::vector<uint8_t> request;
+    request.push_back(static_cast<uint8_t>(NetMessageType::RequestMaze));
+    MazeCodec::writeHash(request, hash);
+    sendPacket(request);
+    return;
+  }
+
+  deliverMaze(mazeData, modeFlags);
+}
+
+void NetworkManager::deliverMaze(const std::vector<std::string> &mazeData, uint8_t modeFlags)
+{
+  // 先设置游戏模式，再回调迷宫数据
+  if (m_onGameModeReceived)
+  {
+    m_onGameModeReceived((modeFlags & 1) != 0);
+  }
+  if (m_onMazeData)
+  {
+    m_onMazeData(mazeData, (modeFlags & 2) != 0);
+  }
+}
+
+void NetworkManager::resetMazeTransfer()
+{
+  m_incomingMaze.clear();
+  m_outgoingMazeChunks.clear();
+  m_outgoingMazeHash = 0;
+  m_outgoingMazeFlags = 0;
+  m_mazeUploaded = false;
 }
 
 void NetworkManager::update()
 {
+  if (m_resuming)
+    updateResume();
   if (!m_connected)
     return;
 
   receiveData();
+  receiveDatagrams();
+  flushDelayedMessages();
+
+  // 网络诊断：滚动统计窗口、定时 Ping 与写出统计
+  float now = getNetworkTime();
+  m_stats.advance(now);
+  if (m_connected && now - m_lastPingAt >= PING_INTERVAL)
+  {
+    sendPing();
+  }
+  if (m_statsDump && now - m_lastStatsDumpAt >= STATS_DUMP_INTERVAL)
+  {
+    writeStatsDump();
+  }
+
+  // UDP 握手重试（数据报可能丢失），多次失败后保持 TCP 回退
+  if (m_connected && m_udpEnabled && !m_udpReady && m_sessionId != 0 && m_udpHelloAttempts < 10 &&
+      m_udpHelloClock.getElapsedTime().asSeconds() > 0.5f)
+  {
+    sendUdpHello();
+  }
+}
+
+void NetworkManager::beginResume()
+{
+  std::cout << "[Network] Connection lost, trying to resume room " << m_roomCode << std::endl;
+  m_socket.disconnect();
+  m_udpSocket.unbind();
+  m_connected = false;
+  m_udpReady = false;
+  m_receiveBuffer.clear();
+  m_delayedMessages.clear();
+  m_lastResumeAttemptAt = getNetworkTime() - RESUME_RETRY_INTERVAL;
+
+  // 重连后再次断开时沿用原来的期限
+  if (m_resuming)
+    return;
+  m_resuming = true;
+  m_resumeDeadline = getNetworkTime() + RESUME_GRACE_SECONDS;
+  if (m_onReconnecting)
+  {
+    m_onReconnecting();
+  }
+}
+
+void NetworkManager::updateResume()
+{
+  float now = getNetworkTime();
+  if (now >= m_resumeDeadline)
+  {
+    std::cout << "[Network] Resume window expired" << std::endl;
+    disconnect();
+    return;
+  }
+  if (m_connected || now - m_lastResumeAttemptAt < RESUME_RETRY_INTERVAL)
+    return;
+  m_lastResumeAttemptAt = now;
+
+  if (!m_serverAddress.has_value() || !openSockets(m_serverAddress.value(), m_serverPort, sf::seconds(RESUME_CONNECT_TIMEOUT)))
+    return;
+
+  // 重新握手后带令牌回到原房间，等待对方发来快照
+  std::vector<uint8_t> connectMsg;
+  connectMsg.push_back(static_cast<uint8_t>(NetMessageType::Connect));
+  sendPacket(connectMsg);
+  ResumePlayer self = m_resumePlayerProvider ? m_resumePlayerProvider() : ResumePlayer{};
+  sendPacket(ResumeCodec::buildSessionMessage(m_roomCode, m_resumeToken, self));
+  std::cout << "[Network] Reconnected, resuming room " << m_roomCode << std::endl;
+}
+
+void NetworkManager::setNetworkSimulation(float lossRate, float latencyMs, float jitterMs)
+{
+  m_simLossRate = std::clamp(lossRate, 0.f, 1.f);
+  m_simLatencyMs = std::max(0.f, latencyMs);
+  m_simJitterMs = std::max(0.f, jitterMs);
+  std::cout << "[Network] Simulation: loss=" << m_simLossRate << " latency=" << m_simLatencyMs
+            << "ms jitter=" << m_simJitterMs << "ms" << std::endl;
 }
 
 void NetworkManager::sendPacket(const std::vector<uint8_t> &data)
@@ -455,6 +764,156 @@ void NetworkManager::sendPacket(const std::vector<uint8_t> &data)
   std::size_t sent = 0;
   [[maybe_unused]] auto status = m_socket.send(packet.data(), packet.size(), sent);
   m_socket.setBlocking(false);
+
+  if (!data.empty())
+    m_stats.record(NetDirection::Sent, data[0], packet.size(), false, getNetworkTime());
+}
+
+void NetworkManager::sendStatePacket(const std::vector<uint8_t> &data)
+{
+  if (!m_connected)
+    return;
+
+  if (!isUdpActive() || !m_serverAddress.has_value())
+  {
+    sendPacket(data);
+    return;
+  }
+
+  // 数据报格式：类型(1) + 序号(4) + 原消息负载
+  uint32_t seq = ++m_udpSendSeq;
+  std::vector<uint8_t> datagram;
+  datagram.reserve(data.size() + 4);
+  datagram.push_back(data[0]);
+  datagram.push_back(static_cast<uint8_t>(seq & 0xFF));
+  datagram.push_back(static_cast<uint8_t>((seq >> 8) & 0xFF));
+  datagram.push_back(static_cast<uint8_t>((seq >> 16) & 0xFF));
+  datagram.push_back(static_cast<uint8_t>((seq >> 24) & 0xFF));
+  datagram.insert(datagram.end(), data.begin() + 1, data.end());
+
+  [[maybe_unused]] auto status = m_udpSocket.send(datagram.data(), datagram.size(), m_serverAddress.value(), m_serverPort);
+  m_stats.record(NetDirection::Sent, datagram[0], datagram.size(), true, getNetworkTime());
+}
+
+void NetworkManager::sendUdpHello()
+{
+  if (!m_serverAddress.has_value())
+    return;
+
+  uint8_t hello[5];
+  hello[0] = static_cast<uint8_t>(NetMessageType::UdpHello);
+  hello[1] = static_cast<uint8_t>(m_sessionId & 0xFF);
+  hello[2] = static_cast<uint8_t>((m_sessionId >> 8) & 0xFF);
+  hello[3] = static_cast<uint8_t>((m_sessionId >> 16) & 0xFF);
+  hello[4] = static_cast<uint8_t>((m_sessionId >> 24) & 0xFF);
+  [[maybe_unused]] auto status = m_udpSocket.send(hello, sizeof(hello), m_serverAddress.value(), m_serverPort);
+  m_stats.record(NetDirection::Sent, hello[0], sizeof(hello), true, getNetworkTime());
+
+  m_udpHelloAttempts++;
+  m_udpHelloClock.restart();
+}
+
+void NetworkManager::receiveDatagrams()
+{
+  uint8_t buffer[sf::UdpSocket::MaxDatagramSize];
+  std::size_t received = 0;
+  std::optional<sf::IpAddress> sender;
+  unsigned short senderPort = 0;
+
+  // 一帧内读空所有数据报
+  while (m_udpSocket.receive(buffer, sizeof(buffer), received, sender, senderPort) == sf::Socket::Status::Done)
+  {
+    // 只接受来自服务器的数据报
+    if (sender != m_serverAddress || senderPort != m_serverPort || received < 5)
+      continue;
+    m_stats.record(NetDirection::Received, buffer[0], received, true, getNetworkTime());
+
+    NetMessageType type = static_cast<NetMessageType>(buffer[0]);
+    uint32_t seq = buffer[1] | (buffer[2] << 8) | (buffer[3] << 16) | (static_cast<uint32_t>(buffer[4]) << 24);
+
+    if (type == NetMessageType::UdpHello)
+    {
+      if (seq == m_sessionId)
+        m_udpReady = true;
+      continue;
+    }
+
+    // 还原为与 TCP 相同的消息格式（去掉序号）
+    std::vector<uint8_t> message;
+    message.reserve(received - 4);
+    message.push_back(buffer[0]);
+    message.insert(message.end(), buffer + 5, buffer + received);
+    deliverMessage(std::move(message), true, seq);
+  }
+}
+
+void NetworkManager::deliverMessage(std::vector<uint8_t> &&data, bool fromUdp, uint32_t seq)
+{
+  bool simulating = m_simLossRate > 0.f || m_simLatencyMs > 0.f || m_simJitterMs > 0.f;
+  if (!simulating)
+  {
+    if (!fromUdp || !isStaleDatagram(data, seq))
+      processMessage(data);
+    return;
+  }
+
+  std::uniform_real_distribution<float> unit(0.f, 1.f);
+  bool lost = unit(m_simRng) < m_simLossRate;
+  float now = m_simClock.getElapsedTime().asSeconds();
+  float delay = (m_simLatencyMs + unit(m_simRng) * m_simJitterMs) / 1000.f;
+
+  float deliverAt;
+  if (fromUdp)
+  {
+    // UDP：丢包直接丢弃，抖动可能导致乱序（由序号过滤）
+    if (lost)
+      return;
+    deliverAt = now + delay;
+  }
+  else
+  {
+    // TCP：丢包表现为重传延迟，且后续消息必须等待（队头阻塞）
+    constexpr float retransmitTimeout = 0.2f;
+    deliverAt = std::max(now + delay + (lost ? retransmitTimeout : 0.f), m_lastReliableDeliverAt);
+    m_lastReliableDeliverAt = deliverAt;
+  }
+
+  m_delayedMessages.emplace(deliverAt, DelayedMessage{std::move(data), fromUdp, seq});
+}
+
+void NetworkManager::flushDelayedMessages()
+{
+  float now = m_simClock.getElapsedTime().asSeconds();
+  while (m_connected && !m_delayedMessages.empty() && m_delayedMessages.begin()->first <= now)
+  {
+    DelayedMessage msg = std::move(m_delayedMessages.begin()->second);
+    m_delayedMessages.erase(m_delayedMessages.begin());
+    if (!msg.fromUdp || !isStaleDatagram(msg.data, msg.seq))
+      processMessage(msg.data);
+  }
+}
+
+bool NetworkManager::isStaleDatagram(const std::vector<uint8_t> &data, uint32_t seq)
+{
+  // 射击是事件，不做过期丢弃；状态消息只保留最新的一份
+  NetMessageType type = static_cast<NetMessageType>(data[0]);
+  uint16_t key;
+  if (type == NetMessageType::PlayerUpdate)
+    key = static_cast<uint16_t>(data[0] << 8);
+  else if (type == NetMessageType::PlayerSnapshot && data.size() >= 2)
+    key = static_cast<uint16_t>((data[0] << 8) | data[1]);
+  else if (type == NetMessageType::NpcUpdate && data.size() >= 2)
+    key = static_cast<uint16_t>((data[0] << 8) | data[1]);
+  else
+    return false;
+
+  auto it = m_lastUdpSeq.find(key);
+  // 序号回绕安全比较
+  if (it != m_lastUdpSeq.end() && static_cast<int32_t>(seq - it->second) <= 0)
+    return true;
+
+  m_lastUdpSeq[key] = seq;
+  return false;
 }
 
 void NetworkManager::receiveData()
@@ -479,7 +938,9 @@ void NetworkManager::receiveData()
                                      m_receiveBuffer.begin() + 2 + len);
         m_receiveBuffer.erase(m_receiveBuffer.begin(),
                               m_receiveBuffer.begin() + 2 + len);
-        processMessage(message);
+        if (!message.empty())
+          m_stats.record(NetDirection::Received, message[0], 2 + len, false, getNetworkTime());
+        deliverMessage(std::move(message), false, 0);
       }
       else
       {
@@ -489,7 +950,14 @@ void NetworkManager::receiveData()
   }
   else if (status == sf::Socket::Status::Disconnected)
   {
+    // 对局中意外断开：保留房间码与令牌，尝试重连
+    if (m_resumeToken != 0 && !m_roomCode.empty())
+    {
+      beginResume();
+      return;
+    }
     m_connected = false;
+    m_resuming = false;
     if (m_onDisconnected)
     {
       m_onDisconnected();
@@ -515,6 +983,32 @@ void NetworkManager::processMessage(const std::vector<uint8_t> &data)
 
   switch (type)
   {
+  case NetMessageType::ConnectAck:
+  {
+    // 服务器下发会话ID，用于绑定 UDP 端点
+    if (data.size() >= 5)
+    {
+      m_sessionId = data[1] | (data[2] << 8) | (data[3] << 16) | (static_cast<uint32_t>(data[4]) << 24);
+      m_udpHelloAttempts = 0;
+      if (m_udpEnabled)
+      {
+        sendUdpHello();
+      }
+    }
+    break;
+  }
+  case NetMessageType::Pong:
+  {
+    // 服务器带回的发送时间，无符号相减在时钟回绕时也正确
+    if (data.size() >= 9)
+    {
+      uint32_t sentUs = 0;
+      std::memcpy(&sentUs, &data[5], sizeof(uint32_t));
+      uint32_t nowUs = static_cast<uint32_t>(m_netClock.getElapsedTime().asMicroseconds());
+      m_stats.addRttSample(static_cast<float>(nowUs - sentUs) / 1000.f);
+    }
+    break;
+  }
   case NetMessageType::RoomCreated:
   {
     if (data.size() > 2)
@@ -552,11 +1046,26 @@ void NetworkManager::processMessage(const std::vector<uint8_t> &data)
         m_onError(error);
       }
     }
+    // 服务器已不再保留位置：放弃重连
+    if (m_resuming)
+    {
+      std::cout << "[Network] Resume rejected by server" << std::endl;
+      disconnect();
+    }
     break;
   }
   case NetMessageType::GameStart:
   {
     // 新版本：GameStart 只是一个信号，迷宫数据已经通过 MazeData 传输
+    // 新一局对方序号可能重新开始
+    m_lastUdpSeq.clear();
+    // 原生服务器附带权威模拟标志，旧服务器只有类型字节；第 3 字节为帧同步标志
+    m_serverAuthoritative = data.size() >= 2 && data[1] != 0;
+    m_lockstep = data.size() >= 3 && data[2] != 0;
+    // 第 4-7 字节为断线重连令牌，旧服务器没有
+    m_resumeToken = 0;
+    if (data.size() >= 7)
+      std::memcpy(&m_resumeToken, &data[3], sizeof(uint32_t));
     if (m_onGameStart)
     {
       m_onGameStart();
@@ -565,7 +1074,7 @@ void NetworkManager::processMessage(const std::vector<uint8_t> &data)
   }
   case NetMessageType::MazeData:
   {
-    // 解析迷宫数据
+    // 解析迷宫数据（旧版整帧格式，兼容旧房主）
     if (data.size() >= 4)
     {
       size_t offset = 1;
@@ -605,8 +1114,39 @@ void NetworkManager::processMessage(const std::vector<uint8_t> &data)
     }
     break;
   }
+  case NetMessageType::MazeChunk:
+  {
+    // 迷宫分块：收齐后解码，校验哈希
+    if (!m_incomingMaze.add(data) || !m_incomingMaze.complete())
+      break;
+
+    std::vector<std::string> mazeData;
+    bool valid = m_incomingMaze.decode(mazeData);
+    uint8_t modeFlags = m_incomingMaze.modeFlags();
+    m_incomingMaze.clear();
+    if (!valid)
+    {
+      std::cerr << "[Network] Invalid maze chunks, dropped" << std::endl;
+      break;
+    }
+
+    deliverMaze(mazeData, modeFlags);
+    break;
+  }
+  case NetMessageType::MazeSeed:
+  {
+    handleMazeSeed(data);
+    break;
+  }
   case NetMessageType::RequestMaze:
   {
+    // 服务器缓存未命中（附带哈希）：直接重发当前迷宫的分块
+    if (data.size() >= 9 && !m_outgoingMazeChunks.empty() && MazeCodec::readHash(data.data() + 1) == m_outgoingMazeHash)
+    {
+      sendMazeChunks();
+      break;
+    }
+
     // 服务器请求房主发送迷宫数据
     if (m_onRequestMaze)
     {
@@ -626,6 +1166,7 @@ void NetworkManager::processMessage(const std::vector<uint8_t> &data)
       state.health = readFloat(17);
       state.reachedExit = data[21] != 0;
       state.isDead = (data.size() >= 23) ? (data[22] != 0) : false; // 读取死亡状态
+      state.timestamp = (data.size() >= 27) ? readFloat(23) : 0.f;
       if (m_onPlayerUpdate)
       {
         m_onPlayerUpdate(state);
@@ -647,6 +1188,29 @@ void NetworkManager::processMessage(const std::vector<uint8_t> &data)
     }
     break;
   }
+  case NetMessageType::PlayerSnapshot:
+  {
+    // 服务器权威模拟下发的坦克状态：对象 0=本方，1=对方
+    if (data.size() >= 31)
+    {
+      uint32_t inputSeq;
+      std::memcpy(&inputSeq, &data[2], sizeof(uint32_t));
+      PlayerState state;
+      state.x = readFloat(6);
+      state.y = readFloat(10);
+      state.rotation = readFloat(14);
+      state.turretAngle = readFloat(18);
+      state.health = readFloat(22);
+      state.reachedExit = (data[26] & 1) != 0;
+      state.isDead = state.health <= 0.f;
+      state.timestamp = readFloat(27);
+      if (data[1] == 0 && m_onServerPlayerState)
+        m_onServerPlayerState(inputSeq, state);
+      else if (data[1] != 0 && m_onPlayerUpdate)
+        m_onPlayerUpdate(state);
+    }
+    break;
+  }
   case NetMessageType::GameWin:
   {
     // 游戏胜利，两个玩家都到达终点
@@ -656,6 +1220,7 @@ void NetworkManager::processMessage(const std::vector<uint8_t> &data)
   case NetMessageType::GameResult:
   {
     // 游戏结果 - 对方发来的是对方自己的结果（true=对方赢了, false=对方输了）
+    m_resumeToken = 0;
     if (data.size() >= 2)
     {
       bool otherPlayerResult = data[1] != 0;
@@ -704,6 +1269,7 @@ void NetworkManager::processMessage(const std::vector<uint8_t> &data)
       state.health = readFloat(18);
       state.team = data[22];
       state.activated = data[23] != 0;
+      state.timestamp = (data.size() >= 28) ? readFloat(24) : 0.f;
       m_onNpcUpdate(state);
     }
     break;
@@ -735,6 +1301,8 @@ void NetworkManager::processMessage(const std::vector<uint8_t> &data)
   case NetMessageType::PlayerLeft:
   {
     // 对方玩家离开房间
+    m_lastUdpSeq.clear();
+    m_resumeToken = 0;
     if (m_onPlayerLeft)
     {
       bool becameHost = (data.size() >= 2) ? (data[1] != 0) : false;
@@ -742,6 +1310,49 @@ void NetworkManager::processMessage(const std::vector<uint8_t> &data)
     }
     break;
   }
+  case NetMessageType::PeerDropped:
+  {
+    // 对方掉线，服务器为其保留位置
+    if (m_onPeerDropped)
+    {
+      float grace = data.size() >= 2 ? static_cast<float>(data[1]) : RESUME_GRACE_SECONDS;
+      m_onPeerDropped(grace);
+    }
+    break;
+  }
+  case NetMessageType::ResumeRequest:
+  {
+    // 对方已重连：它的 UDP 序号从头开始
+    ResumePlayer player;
+    if (!ResumeCodec::parseRequestMessage(data, player))
+      break;
+    m_lastUdpSeq.clear();
+    if (m_onResumeRequest)
+    {
+      m_onResumeRequest(player);
+    }
+    break;
+  }
+  case NetMessageType::ResumeSnapshot:
+  {
+    if (!m_resuming)
+      break;
+    ResumeSnapshot snapshot;
+    if (!ResumeCodec::parseSnapshot(data, snapshot))
+    {
+      std::cerr << "[Network] Invalid resume snapshot" << std::endl;
+      disconnect();
+      break;
+    }
+    m_resuming = false;
+    m_lastUdpSeq.clear();
+    std::cout << "[Network] Session resumed in room " << m_roomCode << std::endl;
+    if (m_onResumeSnapshot)
+    {
+      m_onResumeSnapshot(snapshot);
+    }
+    break;
+  }
   case NetMessageType::ClimaxStart:
   {
     // 对方看到出口，开始播放高潮BGM
@@ -753,7 +1364,7 @@ void NetworkManager::processMessage(const std::vector<uint8_t> &data)
   }
   case NetMessageType::WallPlace:
   {
-    // 对方放置墙壁
+    // 对方放置墙壁（旧版本逐条发送，新版本走 WallBatch）
     if (data.size() >= 9 && m_onWallPlace)
     {
       float x, y;
@@ -763,6 +1374,16 @@ void NetworkManager::processMessage(const std::vector<uint8_t> &data)
     }
     break;
   }
+  case NetMessageType::WallBatch:
+  {
+    // 对方一帧内的墙体变化
+    std::vector<WallBatchEntry> entries;
+    if (WallBatch::parse(data.data(), data.size(), entries) && m_onWallBatch)
+    {
+      m_onWallBatch(entries);
+    }
+    break;
+  }
   case NetMessageType::WallDamage:
   {
     // 墙壁受到伤害同步
@@ -781,6 +1402,35 @@ void NetworkManager::processMessage(const std::vector<uint8_t> &data)
     }
     break;
   }
+  case NetMessageType::InputFrame:
+  {
+    // 对方某一步的输入
+    if (data.size() >= 18 && m_onLockstepInput)
+    {
+      uint32_t tick;
+      LockstepInput input;
+      std::memcpy(&tick, &data[1], sizeof(uint32_t));
+      input.buttons = data[5];
+      std::memcpy(&input.placeCol, &data[6], sizeof(int16_t));
+      std::memcpy(&input.placeRow, &data[8], sizeof(int16_t));
+      std::memcpy(&input.aimX, &data[10], sizeof(float));
+      std::memcpy(&input.aimY, &data[14], sizeof(float));
+      m_onLockstepInput(tick, input);
+    }
+    break;
+  }
+  case NetMessageType::StateHash:
+  {
+    if (data.size() >= 13 && m_onStateHash)
+    {
+      uint32_t tick;
+      uint64_t hash;
+      std::memcpy(&tick, &data[1], sizeof(uint32_t));
+      std::memcpy(&hash, &data[5], sizeof(uint64_t));
+      m_onStateHash(tick, hash);
+    }
+    break;
+  }
   case NetMessageType::RescueStart:
   {
     if (m_onRescueStart)
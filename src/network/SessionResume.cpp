@@ -0,0 +1,296 @@
+#include "SessionResume.hpp"
+#include "NetProtocol.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+  constexpr std::size_t SNAPSHOT_HEADER_SIZE = 1 + 1 + 1 + 8 + 11 + 2; // 到整图长度为止
+  constexpr uint8_t WALL_PRESENT = 0x80;                              // 格子状态的最高位，低位为属性
+
+  void writeU16(std::vector<uint8_t> &out, uint32_t value)
+  {
+    out.push_back(static_cast<uint8_t>(value & 0xFF));
+    out.push_back(static_cast<uint8_t>((value >> 8) & 0xFF));
+  }
+
+  void writeU32(std::vector<uint8_t> &out, uint32_t value)
+  {
+    for (int i = 0; i < 4; i++)
+      out.push_back(static_cast<uint8_t>((value >> (8 * i)) & 0xFF));
+  }
+
+  void writeFloat(std::vector<uint8_t> &out, float value)
+  {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(float));
+    writeU32(out, bits);
+  }
+
+  // 带边界检查的顺序读取，越界后所有读取返回 0 并置 ok 为 false
+  struct Reader
+  {
+    const uint8_t *data;
+    std::size_t size;
+    std::size_t offset = 0;
+    bool ok = true;
+
+    const uint8_t *take(std::size_t n)
+    {
+      if (!ok || offset + n > size)
+      {
+        ok = false;
+        return nullptr;
+      }
+      const uint8_t *p = data + offset;
+      offset += n;
+      return p;
+    }
+
+    uint8_t u8()
+    {
+      const uint8_t *p = take(1);
+      return p ? p[0] : 0;
+    }
+
+    uint16_t u16()
+    {
+      const uint8_t *p = take(2);
+      return p ? static_cast<uint16_t>(p[0] | (p[1] << 8)) : 0;
+    }
+
+    uint32_t u32()
+    {
+      const uint8_t *p = take(4);
+      return p ? (p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24)) : 0;
+    }
+
+    float f32()
+    {
+      uint32_t bits = u32();
+      float value;
+      std::memcpy(&value, &bits, sizeof(float));
+      return value;
+    }
+  };
+
+  void writeNpc(std::vector<uint8_t> &out, const ResumeNpc &npc)
+  {
+    writeFloat(out, npc.x);
+    writeFloat(out, npc.y);
+    writeFloat(out, npc.rotation);
+    writeFloat(out, npc.turretAngle);
+    writeFloat(out, npc.health);
+    out.push_back(static_cast<uint8_t>(npc.team));
+    out.push_back(npc.activated ? 1 : 0);
+    out.push_back(static_cast<uint8_t>(npc.activatorId + 128)); // +128 以支持负数
+  }
+
+  void readNpc(Reader &in, ResumeNpc &npc)
+  {
+    npc.x = in.f32();
+    npc.y = in.f32();
+    npc.rotation = in.f32();
+    npc.turretAngle = in.f32();
+    npc.health = in.f32();
+    npc.team = in.u8();
+    npc.activated = (in.u8() & 1) != 0;
+    npc.activatorId = static_cast<int>(in.u8()) - 128;
+  }
+
+  void writeSnapshot(std::vector<uint8_t> &out, const ResumeSnapshot &snapshot, bool withGrid)
+  {
+    out.clear();
+    out.push_back(static_cast<uint8_t>(NetMessageType::ResumeSnapshot));
+    out.push_back(ResumeCodec::FORMAT_VERSION);
+    out.push_back(snapshot.modeFlags);
+    MazeCodec::writeHash(out, snapshot.mazeHash);
+    out.push_back(snapshot.seed.version);
+    writeU32(out, snapshot.seed.seed);
+    writeU16(out, snapshot.seed.width);
+    writeU16(out, snapshot.seed.height);
+    writeU16(out, snapshot.seed.enemyCount);
+
+    // 整图：有种子时不带
+    std::vector<uint8_t> grid;
+    if (withGrid && snapshot.seed.version == 0 && !MazeCodec::encode(snapshot.mazeData, grid))
+      grid.clear();
+    if (grid.size() > 0xFFFF)
+      grid.clear();
+    writeU16(out, static_cast<uint32_t>(grid.size()));
+    out.insert(out.end(), grid.begin(), grid.end());
+
+    // 变化位图（行优先，每格 1 位）+ 按同一顺序排列的格子状态
+    writeU16(out, snapshot.rows);
+    writeU16(out, snapshot.cols);
+    std::size_t bitmapOffset = out.size();
+    out.resize(out.size() + (static_cast<std::size_t>(snapshot.rows) * snapshot.cols + 7) / 8, 0);
+    std::vector<ResumeWall> walls = snapshot.walls;
+    std::sort(walls.begin(), walls.end(), [](const ResumeWall &a, const ResumeWall &b)
+              { return a.row != b.row ? a.row < b.row : a.col < b.col; });
+    std::size_t lastBit = SIZE_MAX;
+    for (const auto &wall : walls)
+    {
+      if (wall.row >= snapshot.rows || wall.col >= snapshot.cols)
+        continue;
+      std::size_t bit = static_cast<std::size_t>(wall.row) * snapshot.cols + wall.col;
+      if (bit == lastBit)
+        continue;
+      lastBit = bit;
+      out[bitmapOffset + bit / 8] |= static_cast<uint8_t>(1u << (bit % 8));
+      if (wall.present)
+      {
+        out.push_back(static_cast<uint8_t>(WALL_PRESENT | (wall.attribute & 0x7F)));
+        out.push_back(static_cast<uint8_t>(std::clamp(std::ceil(wall.health), 1.f, 255.f)));
+      }
+      else
+      {
+        out.push_back(0);
+      }
+    }
+
+    std::size_t npcCount = std::min(snapshot.npcs.size(), ResumeCodec::MAX_NPCS);
+    out.push_back(static_cast<uint8_t>(npcCount));
+    for (std::size_t i = 0; i < npcCount; i++)
+      writeNpc(out, snapshot.npcs[i]);
+
+    ResumeCodec::writePlayer(out, snapshot.players[0]);
+    ResumeCodec::writePlayer(out, snapshot.players[1]);
+  }
+}
+
+std::vector<uint8_t> ResumeCodec::buildSnapshot(const ResumeSnapshot &snapshot)
+{
+  std::vector<uint8_t> out;
+  writeSnapshot(out, snapshot, true);
+  if (out.size() > NET_MAX_FRAME_PAYLOAD)
+    writeSnapshot(out, snapshot, false);
+  if (out.size() > NET_MAX_FRAME_PAYLOAD)
+    out.clear();
+  return out;
+}
+
+bool ResumeCodec::parseSnapshot(const std::vector<uint8_t> &message, ResumeSnapshot &snapshot)
+{
+  if (message.size() < SNAPSHOT_HEADER_SIZE || message[0] != static_cast<uint8_t>(NetMessageType::ResumeSnapshot) ||
+      message[1] != FORMAT_VERSION)
+    return false;
+
+  Reader in{message.data(), message.size(), 2};
+  snapshot = ResumeSnapshot{};
+  snapshot.modeFlags = in.u8();
+  const uint8_t *hash = in.take(8);
+  snapshot.mazeHash = hash ? MazeCodec::readHash(hash) : 0;
+  snapshot.seed.version = in.u8();
+  snapshot.seed.seed = in.u32();
+  snapshot.seed.width = in.u16();
+  snapshot.seed.height = in.u16();
+  snapshot.seed.enemyCount = in.u16();
+  if (snapshot.seed.width > MazeCodec::MAX_DIMENSION || snapshot.seed.height > MazeCodec::MAX_DIMENSION)
+    return false; // 接收方会按种子尺寸重新生成
+
+  uint16_t gridSize = in.u16();
+  if (gridSize > 0)
+  {
+    const uint8_t *grid = in.take(gridSize);
+    if (!grid || !MazeCodec::decode(grid, gridSize, snapshot.mazeData) || MazeCodec::hash(snapshot.mazeData) != snapshot.mazeHash)
+      return false;
+  }
+
+  snapshot.rows = in.u16();
+  snapshot.cols = in.u16();
+  std::size_t cells = static_cast<std::size_t>(snapshot.rows) * snapshot.cols;
+  const uint8_t *bitmap = in.take((cells + 7) / 8);
+  if (!bitmap)
+    return false;
+  for (std::size_t bit = 0; bit < cells && in.ok; bit++)
+  {
+    if ((bitmap[bit / 8] & (1u << (bit % 8))) == 0)
+      continue;
+    ResumeWall wall;
+    wall.row = static_cast<uint16_t>(bit / snapshot.cols);
+    wall.col = static_cast<uint16_t>(bit % snapshot.cols);
+    uint8_t state = in.u8();
+    wall.present = (state & WALL_PRESENT) != 0;
+    if (wall.present)
+    {
+      wall.attribute = state & 0x7F;
+      wall.health = in.u8();
+    }
+    snapshot.walls.push_back(wall);
+  }
+
+  snapshot.npcs.resize(in.u8());
+  for (auto &npc : snapshot.npcs)
+    readNpc(in, npc);
+
+  const uint8_t *players = in.take(2 * PLAYER_SIZE);
+  if (!in.ok || !players)
+    return false;
+  readPlayer(players, snapshot.players[0]);
+  readPlayer(players + PLAYER_SIZE, snapshot.players[1]);
+  return true;
+}
+
+std::vector<uint8_t> ResumeCodec::buildSessionMessage(const std::string &roomCode, uint32_t token, const ResumePlayer &self)
+{
+  std::vector<uint8_t> out;
+  out.push_back(static_cast<uint8_t>(NetMessageType::ResumeSession));
+  out.push_back(static_cast<uint8_t>(roomCode.size()));
+  out.insert(out.end(), roomCode.begin(), roomCode.end());
+  writeU32(out, token);
+  writePlayer(out, self);
+  return out;
+}
+
+bool ResumeCodec::parseSessionHeader(const std::vector<uint8_t> &message, std::string &roomCode, uint32_t &token,
+                                     std::size_t &payloadOffset)
+{
+  if (message.size() < 2)
+    return false;
+  Reader in{message.data(), message.size(), 1};
+  uint8_t codeLen = in.u8();
+  const uint8_t *code = in.take(codeLen);
+  token = in.u32();
+  if (!in.ok || !in.take(PLAYER_SIZE))
+    return false;
+  roomCode.assign(code, code + codeLen);
+  payloadOffset = 2 + codeLen + 4;
+  return true;
+}
+
+bool ResumeCodec::parseRequestMessage(const std::vector<uint8_t> &message, ResumePlayer &player)
+{
+  if (message.size() < 1 + PLAYER_SIZE)
+    return false;
+  readPlayer(message.data() + 1, player);
+  return true;
+}
+
+void ResumeCodec::writePlayer(std::vector<uint8_t> &out, const ResumePlayer &player)
+{
+  writeFloat(out, player.x);
+  writeFloat(out, player.y);
+  writeFloat(out, player.rotation);
+  writeFloat(out, player.turretAngle);
+  writeFloat(out, player.health);
+  out.push_back(static_cast<uint8_t>((player.reachedExit ? 1 : 0) | (player.isDead ? 2 : 0)));
+  writeU16(out, player.coins);
+  writeU16(out, player.wallsInBag);
+}
+
+void ResumeCodec::readPlayer(const uint8_t *data, ResumePlayer &player)
+{
+  Reader in{data, PLAYER_SIZE};
+  player.x = in.f32();
+  player.y = in.f32();
+  player.rotation = in.f32();
+  player.turretAngle = in.f32();
+  player.health = in.f32();
+  uint8_t flags = in.u8();
+  player.reachedExit = (flags & 1) != 0;
+  player.isDead = (flags & 2) != 0;
+  player.coins = in.u16();
+  player.wallsInBag = in.u16();
+}
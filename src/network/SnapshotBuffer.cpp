@@ -0,0 +1,100 @@
+#include "SnapshotBuffer.hpp"
+#include "Utils.hpp"
+#include <algorithm>
+
+void SnapshotBuffer::push(float remoteTime, float localTime, sf::Vector2f position, float rotation, float turretAngle)
+{
+  float time = localTime;
+  if (remoteTime > 0.f)
+  {
+    // 用发送方时间戳消除网络抖动；偏移缓慢上浮以适应路由变化
+    float offset = localTime - remoteTime;
+    if (!m_hasClockOffset)
+    {
+      m_clockOffset = offset;
+      m_hasClockOffset = true;
+    }
+    else
+    {
+      m_clockOffset = std::min(offset, m_clockOffset + 0.0005f);
+    }
+    time = remoteTime + m_clockOffset;
+  }
+
+  // 乱序或重复的快照直接丢弃
+  if (m_count > 0 && time <= at(m_count - 1).time)
+    return;
+
+  EntitySnapshot snapshot;
+  snapshot.time = time;
+  snapshot.position = position;
+  snapshot.rotation = rotation;
+  snapshot.turretAngle = turretAngle;
+
+  if (m_count == CAPACITY)
+  {
+    // 缓冲已满，覆盖最旧的快照
+    m_snapshots[m_head] = snapshot;
+    m_head = (m_head + 1) % CAPACITY;
+  }
+  else
+  {
+    m_snapshots[(m_head + m_count) % CAPACITY] = snapshot;
+    m_count++;
+  }
+}
+
+bool SnapshotBuffer::sample(float localTime, EntitySnapshot &out) const
+{
+  if (m_count == 0)
+    return false;
+
+  float renderTime = localTime - INTERP_DELAY;
+
+  // 早于最旧快照：停在最旧快照
+  if (renderTime <= at(0).time)
+  {
+    out = at(0);
+    return true;
+  }
+
+  // 在两帧快照之间：插值
+  for (std::size_t i = 1; i < m_count; ++i)
+  {
+    const EntitySnapshot &b = at(i);
+    if (renderTime <= b.time)
+    {
+      const EntitySnapshot &a = at(i - 1);
+      float t = (renderTime - a.time) / (b.time - a.time);
+      out.time = renderTime;
+      out.position = a.position + (b.position - a.position) * t;
+      out.rotation = Utils::lerpAngle(a.rotation, b.rotation, t);
+      out.turretAngle = Utils::lerpAngle(a.turretAngle, b.turretAngle, t);
+      return true;
+    }
+  }
+
+  // 晚于最新快照：按最后速度外推（有上限）
+  const EntitySnapshot &last = at(m_count - 1);
+  out = last;
+  if (m_count >= 2)
+  {
+    const EntitySnapshot &prev = at(m_count - 2);
+    float span = last.time - prev.time;
+    float extrapolation = std::min(renderTime - last.time, MAX_EXTRAPOLATION);
+    if (span > 0.f)
+    {
+      sf::Vector2f velocity = (last.position - prev.position) / span;
+      out.position = last.position + velocity * extrapolation;
+    }
+  }
+  out.time = renderTime;
+  return true;
+}
+
+void SnapshotBuffer::clear()
+{
+  m_head = 0;
+  m_count = 0;
+  m_hasClockOffset = false;
+}
@@ -0,0 +1,109 @@
+#include "WallBatch.hpp"
+#include "NetProtocol.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+  constexpr uint8_t FLAG_PLACED = 1;
+  constexpr uint8_t FLAG_DESTROYED = 2;
+
+  uint32_t tileKey(int row, int col)
+  {
+    return (static_cast<uint32_t>(row & 0xFFFF) << 16) | static_cast<uint32_t>(col & 0xFFFF);
+  }
+}
+
+void WallBatch::addDamage(int row, int col, float damage, bool destroyed, int attribute, int destroyer)
+{
+  auto it = m_open.find(tileKey(row, col));
+  if (it == m_open.end())
+  {
+    WallBatchEntry entry;
+    entry.row = static_cast<uint16_t>(row);
+    entry.col = static_cast<uint16_t>(col);
+    it = m_open.emplace(tileKey(row, col), m_entries.size()).first;
+    m_entries.push_back(entry);
+  }
+
+  WallBatchEntry &entry = m_entries[it->second];
+  entry.damage += damage;
+  entry.destroyer = destroyer;
+  if (destroyed)
+  {
+    entry.destroyed = true;
+    entry.attribute = static_cast<uint8_t>(attribute);
+    m_open.erase(it); // 之后的变化另起条目
+  }
+}
+
+void WallBatch::addPlace(int row, int col)
+{
+  WallBatchEntry entry;
+  entry.row = static_cast<uint16_t>(row);
+  entry.col = static_cast<uint16_t>(col);
+  entry.placed = true;
+  m_open[tileKey(row, col)] = m_entries.size();
+  m_entries.push_back(entry);
+}
+
+void WallBatch::clear()
+{
+  m_entries.clear();
+  m_open.clear();
+}
+
+std::vector<std::vector<uint8_t>> WallBatch::build() const
+{
+  std::vector<std::vector<uint8_t>> messages;
+  for (std::size_t begin = 0; begin < m_entries.size(); begin += MAX_ENTRIES_PER_MESSAGE)
+  {
+    std::size_t count = std::min(MAX_ENTRIES_PER_MESSAGE, m_entries.size() - begin);
+    std::vector<uint8_t> out;
+    out.reserve(3 + count * ENTRY_SIZE);
+    out.push_back(static_cast<uint8_t>(NetMessageType::WallBatch));
+    out.push_back(static_cast<uint8_t>(count & 0xFF));
+    out.push_back(static_cast<uint8_t>((count >> 8) & 0xFF));
+    for (std::size_t i = begin; i < begin + count; i++)
+    {
+      const WallBatchEntry &entry = m_entries[i];
+      out.push_back(static_cast<uint8_t>(entry.row & 0xFF));
+      out.push_back(static_cast<uint8_t>(entry.row >> 8));
+      out.push_back(static_cast<uint8_t>(entry.col & 0xFF));
+      out.push_back(static_cast<uint8_t>(entry.col >> 8));
+      out.push_back(static_cast<uint8_t>((entry.placed ? FLAG_PLACED : 0) | (entry.destroyed ? FLAG_DESTROYED : 0)));
+      out.push_back(entry.attribute);
+      out.push_back(static_cast<uint8_t>(entry.destroyer + 128)); // +128 以支持负数
+      uint8_t damage[4];
+      std::memcpy(damage, &entry.damage, sizeof(float));
+      out.insert(out.end(), damage, damage + 4);
+    }
+    messages.push_back(std::move(out));
+  }
+  return messages;
+}
+
+bool WallBatch::parse(const uint8_t *data, std::size_t size, std::vector<WallBatchEntry> &entries)
+{
+  entries.clear();
+  if (size < 3 || data[0] != static_cast<uint8_t>(NetMessageType::WallBatch))
+    return false;
+  std::size_t count = data[1] | (data[2] << 8);
+  if (size < 3 + count * ENTRY_SIZE)
+    return false;
+
+  entries.resize(count);
+  const uint8_t *p = data + 3;
+  for (auto &entry : entries)
+  {
+    entry.row = static_cast<uint16_t>(p[0] | (p[1] << 8));
+    entry.col = static_cast<uint16_t>(p[2] | (p[3] << 8));
+    entry.placed = (p[4] & FLAG_PLACED) != 0;
+    entry.destroyed = (p[4] & FLAG_DESTROYED) != 0;
+    entry.attribute = p[5];
+    entry.destroyer = static_cast<int>(p[6]) - 128;
+    std::memcpy(&entry.damage, p + 7, sizeof(float));
+    p += ENTRY_SIZE;
+  }
+  return true;
+}
@@ -0,0 +1,513 @@
+// 负载生成器：模拟 N 个房间，每个房间一个房主机器人和一个加入者机器人
+// 用法：tank_loadgen [--host 127.0.0.1] [--port 9999] [--rooms 100] [--seconds 30] [--rate 30] [--npcs 10] [--udp] [--sim]
+#include "MazeCodec.hpp"
+#include "NetProtocol.hpp"
+#include "RingBuffer.hpp"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <memory>
+#include <netinet/tcp.h>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+  using Clock = std::chrono::steady_clock;
+
+  struct Options
+  {
+    std::string host = "127.0.0.1";
+    unsigned short port = 9999;
+    int rooms = 100;
+    float seconds = 30.f;
+    float rate = 30.f; // 每个机器人每秒状态包数
+    int npcs = 10;     // 房主每次同步的 NPC 数量
+    bool udp = false;
+    bool sim = false; // 请求服务器权威模拟
+  };
+
+  enum class BotPhase
+  {
+    Connecting,
+    InLobby,
+    Playing
+  };
+
+  struct Bot
+  {
+    int fd = -1;
+    int udpFd = -1;
+    bool isHost = false;
+    Bot *partner = nullptr;
+    BotPhase phase = BotPhase::Connecting;
+    uint32_t sessionId = 0;
+    uint32_t udpSeq = 0;
+    bool udpReady = false;
+    bool closed = false;
+    std::string roomCode;
+    RingBuffer input{128 * 1024};
+    Clock::time_point nextSend;
+  };
+
+  struct Stats
+  {
+    uint64_t framesSent = 0;
+    uint64_t framesReceived = 0;
+    uint64_t datagramsSent = 0;
+    uint64_t datagramsReceived = 0;
+    uint64_t errors = 0;
+    int roomsStarted = 0;
+    std::vector<float> latenciesMs;
+  };
+
+  Clock::time_point s_startTime;
+  Stats s_stats;
+  Options s_options;
+  sockaddr_in s_serverAddr{};
+  int s_epollFd = -1;
+
+  float nowSeconds()
+  {
+    return std::chrono::duration<float>(Clock::now() - s_startTime).count();
+  }
+
+  void pushFloat(std::vector<uint8_t> &data, float value)
+  {
+    uint8_t bytes[4];
+    std::memcpy(bytes, &value, sizeof(float));
+    data.insert(data.end(), bytes, bytes + 4);
+  }
+
+  float readFloat(const uint8_t *data)
+  {
+    float value;
+    std::memcpy(&value, data, sizeof(float));
+    return value;
+  }
+
+  void sendFrame(Bot &bot, const std::vector<uint8_t> &data)
+  {
+    std::vector<uint8_t> packet;
+    packet.reserve(NET_FRAME_HEADER_SIZE + data.size());
+    packet.push_back(static_cast<uint8_t>(data.size() & 0xFF));
+    packet.push_back(static_cast<uint8_t>((data.size() >> 8) & 0xFF));
+    packet.insert(packet.end(), data.begin(), data.end());
+
+    // 负载很小，发送缓冲区满时直接计为错误
+    ssize_t n = send(bot.fd, packet.data(), packet.size(), MSG_NOSIGNAL);
+    if (n != static_cast<ssize_t>(packet.size()))
+      s_stats.errors++;
+    else
+      s_stats.framesSent++;
+  }
+
+  void sendState(Bot &bot, const std::vector<uint8_t> &data)
+  {
+    if (!bot.udpReady)
+    {
+      sendFrame(bot, data);
+      return;
+    }
+
+    std::vector<uint8_t> datagram;
+    datagram.reserve(data.size() + 4);
+    uint32_t seq = ++bot.udpSeq;
+    datagram.push_back(data[0]);
+    for (int i = 0; i < 4; i++)
+      datagram.push_back(static_cast<uint8_t>((seq >> (i * 8)) & 0xFF));
+    datagram.insert(datagram.end(), data.begin() + 1, data.end());
+    if (send(bot.udpFd, datagram.data(), datagram.size(), 0) > 0)
+      s_stats.datagramsSent++;
+  }
+
+  void sendUdpHello(Bot &bot)
+  {
+    uint8_t hello[NET_DATAGRAM_HEADER_SIZE] = {static_cast<uint8_t>(NetMessageType::UdpHello)};
+    for (int i = 0; i < 4; i++)
+      hello[1 + i] = static_cast<uint8_t>((bot.sessionId >> (i * 8)) & 0xFF);
+    [[maybe_unused]] auto n = send(bot.udpFd, hello, sizeof(hello), 0);
+  }
+
+  // 一个最小的迷宫（与客户端 sendMazeData 相同的分块格式）
+  std::vector<std::vector<uint8_t>> buildMazeChunks()
+  {
+    const int rows = 21;
+    const int cols = 31;
+    std::vector<std::string> maze(rows, std::string(cols, '.'));
+    for (int r = 0; r < rows; r++)
+    {
+      for (int c = 0; c < cols; c++)
+      {
+        if (r == 0 || c == 0 || r == rows - 1 || c == cols - 1)
+          maze[r][c] = '#';
+      }
+    }
+    uint64_t hash = 0;
+    return MazeCodec::buildChunks(maze, 0, hash);
+  }
+
+  void sendTick(Bot &bot)
+  {
+    // PlayerUpdate：时间戳字段填发送时刻，接收方据此统计端到端延迟
+    std::vector<uint8_t> update = {static_cast<uint8_t>(NetMessageType::PlayerUpdate)};
+    float t = nowSeconds();
+    pushFloat(update, 100.f + 10.f * t);
+    pushFloat(update, 100.f);
+    pushFloat(update, t * 30.f);
+    pushFloat(update, t * 45.f);
+    pushFloat(update, 100.f);
+    update.push_back(0);
+    update.push_back(0);
+    pushFloat(update, t);
+    sendState(bot, update);
+
+    if (!bot.isHost)
+      return;
+
+    for (int id = 0; id < s_options.npcs; id++)
+    {
+      std::vector<uint8_t> npc = {static_cast<uint8_t>(NetMessageType::NpcUpdate), static_cast<uint8_t>(id)};
+      pushFloat(npc, 200.f + id);
+      pushFloat(npc, 200.f);
+      pushFloat(npc, 0.f);
+      pushFloat(npc, 0.f);
+      pushFloat(npc, 100.f);
+      npc.push_back(0);
+      npc.push_back(1);
+      pushFloat(npc, t);
+      sendState(bot, npc);
+    }
+  }
+
+  void handleMessage(Bot &bot, const uint8_t *data, std::size_t len)
+  {
+    const auto msgType = static_cast<NetMessageType>(data[0]);
+
+    switch (msgType)
+    {
+    case NetMessageType::ConnectAck:
+    {
+      if (len >= 5)
+        bot.sessionId = data[1] | (data[2] << 8) | (data[3] << 16) | (static_cast<uint32_t>(data[4]) << 24);
+      if (s_options.udp)
+        sendUdpHello(bot);
+
+      if (bot.isHost)
+      {
+        sendFrame(bot, {static_cast<uint8_t>(NetMessageType::CreateRoom), 31, 0, 21, 0, 0, static_cast<uint8_t>(s_options.sim ? 1 : 0)});
+      }
+      else if (!bot.partner->roomCode.empty())
+      {
+        std::vector<uint8_t> join = {static_cast<uint8_t>(NetMessageType::JoinRoom),
+                                     static_cast<uint8_t>(bot.partner->roomCode.size())};
+        join.insert(join.end(), bot.partner->roomCode.begin(), bot.partner->roomCode.end());
+        sendFrame(bot, join);
+      }
+      break;
+    }
+
+    case NetMessageType::RoomCreated:
+    {
+      bot.roomCode.assign(reinterpret_cast<const char *>(data + 2), data[1]);
+      bot.phase = BotPhase::InLobby;
+      for (const auto &chunk : buildMazeChunks())
+        sendFrame(bot, chunk);
+
+      // 加入者已连上则立即加入
+      Bot &guest = *bot.partner;
+      if (guest.sessionId != 0 && guest.phase == BotPhase::Connecting)
+      {
+        std::vector<uint8_t> join = {static_cast<uint8_t>(NetMessageType::JoinRoom),
+                                     static_cast<uint8_t>(bot.roomCode.size())};
+        join.insert(join.end(), bot.roomCode.begin(), bot.roomCode.end());
+        sendFrame(guest, join);
+      }
+      break;
+    }
+
+    case NetMessageType::RoomJoined:
+      bot.phase = BotPhase::InLobby;
+      sendFrame(bot, {static_cast<uint8_t>(NetMessageType::PlayerReady), 1});
+      break;
+
+    case NetMessageType::PlayerReady:
+      if (bot.isHost && len >= 2 && data[1] != 0)
+        sendFrame(bot, {static_cast<uint8_t>(NetMessageType::HostStartGame)});
+      break;
+
+    case NetMessageType::GameStart:
+      bot.phase = BotPhase::Playing;
+      bot.nextSend = Clock::now();
+      if (bot.isHost)
+        s_stats.roomsStarted++;
+      break;
+
+    case NetMessageType::RoomError:
+      std::cerr << "[LoadGen] Room error: " << std::string(reinterpret_cast<const char *>(data + 2), data[1]) << std::endl;
+      s_stats.errors++;
+      break;
+
+    case NetMessageType::PlayerUpdate:
+      if (len >= 27)
+        s_stats.latenciesMs.push_back((nowSeconds() - readFloat(data + 23)) * 1000.f);
+      break;
+
+    default:
+      break;
+    }
+  }
+
+  void handleReadable(Bot &bot)
+  {
+    while (true)
+    {
+      auto [ptr, space] = bot.input.writableSpan();
+      if (space == 0)
+        break;
+      ssize_t n = recv(bot.fd, ptr, space, 0);
+      if (n <= 0)
+      {
+        if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+        {
+          s_stats.errors++;
+          bot.closed = true;
+          bot.phase = BotPhase::Connecting;
+          epoll_ctl(s_epollFd, EPOLL_CTL_DEL, bot.fd, nullptr);
+        }
+        break;
+      }
+      bot.input.commitWrite(static_cast<std::size_t>(n));
+    }
+
+    std::vector<uint8_t> frame;
+    uint8_t header[NET_FRAME_HEADER_SIZE];
+    while (bot.input.size() >= NET_FRAME_HEADER_SIZE)
+    {
+      bot.input.peek(header, NET_FRAME_HEADER_SIZE);
+      std::size_t len = header[0] | (header[1] << 8);
+      if (bot.input.size() < NET_FRAME_HEADER_SIZE + len)
+        break;
+      frame.resize(len);
+      bot.input.peek(frame.data(), len, NET_FRAME_HEADER_SIZE);
+      bot.input.consume(NET_FRAME_HEADER_SIZE + len);
+      s_stats.framesReceived++;
+      if (len > 0)
+        handleMessage(bot, frame.data(), len);
+    }
+  }
+
+  void handleDatagrams(Bot &bot)
+  {
+    uint8_t buffer[2048];
+    while (true)
+    {
+      ssize_t n = recv(bot.udpFd, buffer, sizeof(buffer), 0);
+      if (n < static_cast<ssize_t>(NET_DATAGRAM_HEADER_SIZE))
+        break;
+
+      if (buffer[0] == static_cast<uint8_t>(NetMessageType::UdpHello))
+      {
+        bot.udpReady = true;
+        continue;
+      }
+
+      s_stats.datagramsReceived++;
+      if (buffer[0] == static_cast<uint8_t>(NetMessageType::PlayerUpdate) && n >= 31)
+        s_stats.latenciesMs.push_back((nowSeconds() - readFloat(buffer + 4 + 23)) * 1000.f);
+    }
+  }
+
+  int connectBot(Bot &bot, int index)
+  {
+    bot.fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (bot.fd < 0 || connect(bot.fd, reinterpret_cast<sockaddr *>(&s_serverAddr), sizeof(s_serverAddr)) < 0)
+    {
+      std::cerr << "[LoadGen] connect failed: " << std::strerror(errno) << std::endl;
+      return -1;
+    }
+    int one = 1;
+    setsockopt(bot.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = static_cast<uint64_t>(index) << 1;
+    epoll_ctl(s_epollFd, EPOLL_CTL_ADD, bot.fd, &ev);
+
+    if (s_options.udp)
+    {
+      bot.udpFd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+      connect(bot.udpFd, reinterpret_cast<sockaddr *>(&s_serverAddr), sizeof(s_serverAddr));
+      ev.data.u64 = (static_cast<uint64_t>(index) << 1) | 1;
+      epoll_ctl(s_epollFd, EPOLL_CTL_ADD, bot.udpFd, &ev);
+    }
+
+    // 连接建立后切换为非阻塞
+    sendFrame(bot, {static_cast<uint8_t>(NetMessageType::Connect)});
+    fcntl(bot.fd, F_SETFL, fcntl(bot.fd, F_GETFL) | O_NONBLOCK);
+    return 0;
+  }
+
+  // 整个参数必须是 [minValue, maxValue] 内的整数，否则按用法错误处理
+  bool parseInt(const char *text, long minValue, long maxValue, int &value)
+  {
+    char *end = nullptr;
+    errno = 0;
+    long parsed = std::strtol(text, &end, 10);
+    if (end == text || *end != '\0' || errno == ERANGE || parsed < minValue || parsed > maxValue)
+      return false;
+    value = static_cast<int>(parsed);
+    return true;
+  }
+
+  // 整个参数必须是 [minValue, maxValue] 内的有限数
+  bool parseFloat(const char *text, float minValue, float maxValue, float &value)
+  {
+    char *end = nullptr;
+    float parsed = std::strtof(text, &end);
+    if (end == text || *end != '\0' || !std::isfinite(parsed) || parsed < minValue || parsed > maxValue)
+      return false;
+    value = parsed;
+    return true;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  for (int i = 1; i < argc; i++)
+  {
+    std::string arg = argv[i];
+    int portValue = 0;
+    if (arg == "--host" && i + 1 < argc)
+      s_options.host = argv[++i];
+    else if (arg == "--port" && i + 1 < argc && parseInt(argv[i + 1], 1, 65535, portValue))
+    {
+      s_options.port = static_cast<unsigned short>(portValue);
+      i++;
+    }
+    else if (arg == "--rooms" && i + 1 < argc && parseInt(argv[i + 1], 1, 100000, s_options.rooms))
+      i++;
+    else if (arg == "--seconds" && i + 1 < argc && parseFloat(argv[i + 1], 0.1f, 86400.f, s_options.seconds))
+      i++;
+    else if (arg == "--rate" && i + 1 < argc && parseFloat(argv[i + 1], 1.f, 10000.f, s_options.rate))
+      i++;
+    else if (arg == "--npcs" && i + 1 < argc && parseInt(argv[i + 1], 0, 255, s_options.npcs))
+      i++;
+    else if (arg == "--udp")
+      s_options.udp = true;
+    else if (arg == "--sim")
+      s_options.sim = true;
+    else
+    {
+      std::cout << "Usage: tank_loadgen [--host 127.0.0.1] [--port 1-65535] [--rooms 1-100000] [--seconds 0.1-86400] "
+                   "[--rate 1-10000] [--npcs 0-255] [--udp] [--sim]"
+                << std::endl;
+      return arg == "--help" ? 0 : 1;
+    }
+  }
+
+  s_serverAddr.sin_family = AF_INET;
+  s_serverAddr.sin_port = htons(s_options.port);
+  if (inet_pton(AF_INET, s_options.host.c_str(), &s_serverAddr.sin_addr) != 1)
+  {
+    std::cerr << "[LoadGen] Invalid host: " << s_options.host << std::endl;
+    return 1;
+  }
+
+  s_startTime = Clock::now();
+  s_epollFd = epoll_create1(EPOLL_CLOEXEC);
+
+  // 每个房间两个机器人：偶数下标为房主，奇数为加入者
+  std::vector<std::unique_ptr<Bot>> bots;
+  for (int i = 0; i < s_options.rooms * 2; i++)
+  {
+    bots.push_back(std::make_unique<Bot>());
+    bots.back()->isHost = (i % 2 == 0);
+  }
+  for (int i = 0; i < s_options.rooms * 2; i += 2)
+  {
+    bots[i]->partner = bots[i + 1].get();
+    bots[i + 1]->partner = bots[i].get();
+  }
+  for (int i = 0; i < static_cast<int>(bots.size()); i++)
+  {
+    if (connectBot(*bots[i], i) < 0)
+      return 1;
+  }
+
+  std::cout << "[LoadGen] " << s_options.rooms << " rooms (" << bots.size() << " bots) connected to "
+            << s_options.host << ":" << s_options.port << (s_options.udp ? " [UDP]" : " [TCP]") << std::endl;
+
+  const auto interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(1.f / s_options.rate));
+  const auto deadline = s_startTime + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(s_options.seconds));
+  auto nextHelloRetry = Clock::now() + std::chrono::milliseconds(500);
+  epoll_event events[256];
+
+  while (Clock::now() < deadline)
+  {
+    int count = epoll_wait(s_epollFd, events, 256, 1);
+    for (int i = 0; i < count; i++)
+    {
+      Bot &bot = *bots[events[i].data.u64 >> 1];
+      if (events[i].data.u64 & 1)
+        handleDatagrams(bot);
+      else
+        handleReadable(bot);
+    }
+
+    auto now = Clock::now();
+    for (auto &bot : bots)
+    {
+      if (!bot->closed && bot->phase == BotPhase::Playing && now >= bot->nextSend)
+      {
+        sendTick(*bot);
+        bot->nextSend += interval;
+      }
+    }
+
+    // UDP 握手重试
+    if (s_options.udp && now >= nextHelloRetry)
+    {
+      for (auto &bot : bots)
+      {
+        if (bot->sessionId != 0 && !bot->udpReady)
+          sendUdpHello(*bot);
+      }
+      nextHelloRetry = now + std::chrono::milliseconds(500);
+    }
+  }
+
+  // 汇总
+  auto &lat = s_stats.latenciesMs;
+  std::sort(lat.begin(), lat.end());
+  auto percentile = [&lat](float p)
+  {
+    return lat.empty() ? 0.f : lat[std::min(lat.size() - 1, static_cast<std::size_t>(p * lat.size()))];
+  };
+
+  std::cout << "[LoadGen] rooms started: " << s_stats.roomsStarted << "/" << s_options.rooms << std::endl;
+  std::cout << "[LoadGen] frames sent=" << s_stats.framesSent << " received=" << s_stats.framesReceived
+            << " datagrams sent=" << s_stats.datagramsSent << " received=" << s_stats.datagramsReceived
+            << " errors=" << s_stats.errors << std::endl;
+  std::cout << "[LoadGen] PlayerUpdate latency ms: p50=" << percentile(0.5f) << " p99=" << percentile(0.99f)
+            << " max=" << (lat.empty() ? 0.f : lat.back()) << " (" << lat.size() << " samples)" << std::endl;
+
+  for (auto &bot : bots)
+  {
+    close(bot->fd);
+    if (bot->udpFd >= 0)
+      close(bot->udpFd);
+  }
+  close(s_epollFd);
+  return s_stats.roomsStarted == s_options.rooms ? 0 : 1;
+}
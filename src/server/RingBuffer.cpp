@@ -0,0 +1,52 @@
+#include "RingBuffer.hpp"
+#include <algorithm>
+#include <cstring>
+
+RingBuffer::RingBuffer(std::size_t capacity)
+{
+  std::size_t size = 1;
+  while (size < capacity)
+    size <<= 1;
+  m_data.resize(size);
+  m_mask = size - 1;
+}
+
+bool RingBuffer::write(const uint8_t *data, std::size_t len)
+{
+  if (len > freeSpace())
+    return false;
+
+  std::size_t pos = static_cast<std::size_t>(m_tail) & m_mask;
+  std::size_t first = std::min(len, capacity() - pos);
+  std::memcpy(&m_data[pos], data, first);
+  std::memcpy(&m_data[0], data + first, len - first);
+  m_tail += len;
+  return true;
+}
+
+void RingBuffer::peek(uint8_t *out, std::size_t len, std::size_t offset) const
+{
+  std::size_t pos = static_cast<std::size_t>(m_head + offset) & m_mask;
+  std::size_t first = std::min(len, capacity() - pos);
+  std::memcpy(out, &m_data[pos], first);
+  std::memcpy(out + first, &m_data[0], len - first);
+}
+
+void RingBuffer::consume(std::size_t len)
+{
+  m_head += std::min(len, size());
+}
+
+std::pair<uint8_t *, std::size_t> RingBuffer::writableSpan()
+{
+  std::size_t pos = static_cast<std::size_t>(m_tail) & m_mask;
+  std::size_t len = std::min(freeSpace(), capacity() - pos);
+  return {m_data.data() + pos, len};
+}
+
+std::pair<const uint8_t *, std::size_t> RingBuffer::readableSpan() const
+{
+  std::size_t pos = static_cast<std::size_t>(m_head) & m_mask;
+  std::size_t len = std::min(size(), capacity() - pos);
+  return {m_data.data() + pos, len};
+}
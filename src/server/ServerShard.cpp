@@ -0,0 +1,1282 @@
+#include "ServerShard.hpp"
+#include "TankServer.hpp"
+#include "NetProtocol.hpp"
+#include "SessionResume.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#ifdef TANK_SERVER_SIMULATION
+#include "ServerSimulation.hpp"
+#include "MazeGenerator.hpp"
+#endif
+
+namespace
+{
+  constexpr int MAX_EVENTS = 256;
+
+  // 是否为仅在游戏开始后转发的消息
+  bool isInGameRelayType(NetMessageType type)
+  {
+    switch (type)
+    {
+    case NetMessageType::PlayerUpdate:
+    case NetMessageType::PlayerShoot:
+    case NetMessageType::GameResult:
+    case NetMessageType::RescueStart:
+    case NetMessageType::RescueProgress:
+    case NetMessageType::RescueComplete:
+    case NetMessageType::RescueCancel:
+    case NetMessageType::NpcActivate:
+    case NetMessageType::NpcUpdate:
+    case NetMessageType::NpcShoot:
+    case NetMessageType::NpcDamage:
+    case NetMessageType::ClimaxStart:
+    case NetMessageType::WallPlace:
+    case NetMessageType::WallDamage:
+    case NetMessageType::WallBatch:
+    case NetMessageType::InputFrame:
+    case NetMessageType::StateHash:
+    case NetMessageType::ResumeSnapshot:
+    case NetMessageType::PlayerInput:
+      return true;
+    default:
+      return false;
+    }
+  }
+}
+
+ServerShard::ServerShard(TankServer &server, int index, int shardCount)
+    : m_server(server), m_index(index), m_shardCount(shardCount),
+      m_rngState(0x9E3779B9u * static_cast<uint32_t>(index + 1) ^ static_cast<uint32_t>(time(nullptr)))
+{
+  m_frame.reserve(NET_MAX_FRAME_PAYLOAD);
+}
+
+ServerShard::~ServerShard()
+{
+  stop();
+  for (auto &[fd, conn] : m_connections)
+  {
+    close(fd);
+  }
+  if (m_wakeFd >= 0)
+    close(m_wakeFd);
+  if (m_epollFd >= 0)
+    close(m_epollFd);
+}
+
+bool ServerShard::start()
+{
+  m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+  m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (m_epollFd < 0 || m_wakeFd < 0)
+  {
+    std::cerr << "[Server] Shard " << m_index << ": epoll/eventfd failed: " << std::strerror(errno) << std::endl;
+    return false;
+  }
+
+  epoll_event ev{};
+  ev.events = EPOLLIN;
+  ev.data.fd = m_wakeFd;
+  epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_wakeFd, &ev);
+
+  m_running = true;
+  m_thread = std::thread(&ServerShard::run, this);
+  return true;
+}
+
+void ServerShard::stop()
+{
+  if (!m_running.exchange(false))
+    return;
+
+  uint64_t one = 1;
+  [[maybe_unused]] auto n = write(m_wakeFd, &one, sizeof(one));
+  if (m_thread.joinable())
+    m_thread.join();
+}
+
+void ServerShard::post(ShardEvent &&event)
+{
+  bool wasEmpty;
+  {
+    std::lock_guard<std::mutex> lock(m_inboxMutex);
+    wasEmpty = m_inbox.empty();
+    m_inbox.push_back(std::move(event));
+  }
+
+  // 收件箱由空变为非空时才唤醒，避免每个数据报一次系统调用
+  if (wasEmpty)
+  {
+    uint64_t one = 1;
+    [[maybe_unused]] auto n = write(m_wakeFd, &one, sizeof(one));
+  }
+}
+
+void ServerShard::run()
+{
+  epoll_event events[MAX_EVENTS];
+
+  while (m_running)
+  {
+    int count = epoll_wait(m_epollFd, events, MAX_EVENTS, nextTickTimeout(500));
+    if (count < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      std::cerr << "[Server] Shard " << m_index << ": epoll_wait failed: " << std::strerror(errno) << std::endl;
+      break;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+      int fd = events[i].data.fd;
+      if (fd == m_wakeFd)
+      {
+        uint64_t value;
+        [[maybe_unused]] auto n = read(m_wakeFd, &value, sizeof(value));
+        drainInbox();
+        continue;
+      }
+
+      auto it = m_connections.find(fd);
+      if (it == m_connections.end())
+        continue;
+
+      ServerConnection &conn = *it->second;
+      if (conn.closing || conn.migrateTo >= 0)
+        continue;
+
+      if (events[i].events & (EPOLLHUP | EPOLLERR))
+      {
+        requestClose(conn);
+        continue;
+      }
+      if (events[i].events & EPOLLOUT)
+        handleWritable(conn);
+      if (events[i].events & EPOLLIN)
+        handleReadable(conn);
+    }
+
+    tickSimulations();
+    expireHeldSlots();
+    flushPendingClosures();
+  }
+}
+
+void ServerShard::drainInbox()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_inboxMutex);
+    m_inboxSwap.swap(m_inbox);
+  }
+
+  for (auto &event : m_inboxSwap)
+  {
+    switch (event.type)
+    {
+    case ShardEventType::Adopt:
+      adopt(std::move(event.conn), std::move(event.data));
+      break;
+    case ShardEventType::Datagram:
+      relayDatagram(event.sessionId, event.data);
+      break;
+    case ShardEventType::UdpBind:
+      bindUdp(event.sessionId, event.addr, event.data);
+      break;
+    }
+  }
+  m_inboxSwap.clear();
+}
+
+void ServerShard::adopt(std::unique_ptr<ServerConnection> conn, std::vector<uint8_t> &&replay)
+{
+  ServerConnection &ref = *conn;
+  ref.migrateTo = -1;
+  ref.wantWrite = !ref.output.empty();
+
+  epoll_event ev{};
+  ev.events = EPOLLIN | (ref.wantWrite ? EPOLLOUT : 0u);
+  ev.data.fd = ref.fd;
+  if (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, ref.fd, &ev) < 0)
+  {
+    std::cerr << "[Server] Shard " << m_index << ": epoll_ctl add failed: " << std::strerror(errno) << std::endl;
+    close(ref.fd);
+    m_server.removeSession(ref.sessionId);
+    return;
+  }
+
+  m_sessions[ref.sessionId] = &ref;
+  m_connections[ref.fd] = std::move(conn);
+  connectionCount++;
+
+  // 迁移过来的连接：先重放触发迁移的那一帧，再处理缓冲区中剩余的数据
+  if (!replay.empty())
+  {
+    handleMessage(ref, replay);
+  }
+  processInput(ref);
+}
+
+void ServerShard::handleReadable(ServerConnection &conn)
+{
+  while (true)
+  {
+    auto [ptr, len] = conn.input.writableSpan();
+    if (len == 0)
+      break; // 缓冲区已满，先处理完整帧
+
+    ssize_t n = recv(conn.fd, ptr, len, 0);
+    if (n > 0)
+    {
+      conn.input.commitWrite(static_cast<std::size_t>(n));
+      if (static_cast<std::size_t>(n) < len)
+        break;
+      continue;
+    }
+    if (n == 0)
+    {
+      processInput(conn);
+      requestClose(conn);
+      return;
+    }
+    if (errno == EINTR)
+      continue;
+    if (errno != EAGAIN && errno != EWOULDBLOCK)
+    {
+      requestClose(conn);
+      return;
+    }
+    break;
+  }
+
+  processInput(conn);
+}
+
+void ServerShard::processInput(ServerConnection &conn)
+{
+  uint8_t header[NET_FRAME_HEADER_SIZE];
+  while (!conn.closing && conn.migrateTo < 0 && conn.input.size() >= NET_FRAME_HEADER_SIZE)
+  {
+    conn.input.peek(header, NET_FRAME_HEADER_SIZE);
+    std::size_t len = static_cast<std::size_t>(header[0]) | (static_cast<std::size_t>(header[1]) << 8);
+    if (conn.input.size() < NET_FRAME_HEADER_SIZE + len)
+      break;
+
+    m_frame.resize(len);
+    conn.input.peek(m_frame.data(), len, NET_FRAME_HEADER_SIZE);
+    conn.input.consume(NET_FRAME_HEADER_SIZE + len);
+    framesIn.fetch_add(1, std::memory_order_relaxed);
+
+    if (!m_frame.empty())
+      handleMessage(conn, m_frame);
+  }
+}
+
+void ServerShard::handleWritable(ServerConnection &conn)
+{
+  while (!conn.output.empty())
+  {
+    auto [ptr, len] = conn.output.readableSpan();
+    ssize_t n = send(conn.fd, ptr, len, MSG_NOSIGNAL);
+    if (n > 0)
+    {
+      conn.output.consume(static_cast<std::size_t>(n));
+      continue;
+    }
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      break;
+    requestClose(conn);
+    return;
+  }
+  updateWriteInterest(conn);
+}
+
+void ServerShard::updateWriteInterest(ServerConnection &conn)
+{
+  bool want = !conn.output.empty();
+  if (want == conn.wantWrite || conn.migrateTo >= 0)
+    return;
+
+  conn.wantWrite = want;
+  epoll_event ev{};
+  ev.events = EPOLLIN | (want ? EPOLLOUT : 0u);
+  ev.data.fd = conn.fd;
+  epoll_ctl(m_epollFd, EPOLL_CTL_MOD, conn.fd, &ev);
+}
+
+void ServerShard::sendFrame(ServerConnection &conn, const uint8_t *data, std::size_t len)
+{
+  if (conn.closing || len > NET_MAX_FRAME_PAYLOAD)
+    return;
+
+  uint8_t header[NET_FRAME_HEADER_SIZE] = {static_cast<uint8_t>(len & 0xFF), static_cast<uint8_t>((len >> 8) & 0xFF)};
+  std::size_t total = NET_FRAME_HEADER_SIZE + len;
+  std::size_t written = 0;
+  framesOut.fetch_add(1, std::memory_order_relaxed);
+
+  // 输出缓冲为空时直接 writev，避免一次拷贝（迁移中的连接只写缓冲区）
+  if (conn.output.empty() && conn.migrateTo < 0)
+  {
+    iovec iov[2];
+    iov[0].iov_base = header;
+    iov[0].iov_len = NET_FRAME_HEADER_SIZE;
+    iov[1].iov_base = const_cast<uint8_t *>(data);
+    iov[1].iov_len = len;
+
+    ssize_t n;
+    do
+    {
+      n = writev(conn.fd, iov, 2);
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0)
+    {
+      if (errno != EAGAIN && errno != EWOULDBLOCK)
+      {
+        requestClose(conn);
+        return;
+      }
+      n = 0;
+    }
+    written = static_cast<std::size_t>(n);
+    if (written == total)
+      return;
+  }
+
+  // 剩余部分进入输出环形缓冲区；对端长期不读导致缓冲区满时断开
+  if (conn.output.freeSpace() < total - written)
+  {
+    std::cerr << "[Server] Session " << conn.sessionId << " output buffer full, closing" << std::endl;
+    requestClose(conn);
+    return;
+  }
+  if (written < NET_FRAME_HEADER_SIZE)
+  {
+    conn.output.write(header + written, NET_FRAME_HEADER_SIZE - written);
+    conn.output.write(data, len);
+  }
+  else
+  {
+    std::size_t offset = written - NET_FRAME_HEADER_SIZE;
+    conn.output.write(data + offset, len - offset);
+  }
+  updateWriteInterest(conn);
+}
+
+void ServerShard::broadcastToRoom(Room &room, ServerConnection *sender, const std::vector<uint8_t> &data)
+{
+  for (auto &player : room.players)
+  {
+    if (player.conn != sender)
+      sendFrame(*player.conn, data);
+  }
+}
+
+void ServerShard::sendRoomInfo(Room &room)
+{
+  const RoomPlayer *host = nullptr;
+  const RoomPlayer *guest = nullptr;
+  for (const auto &player : room.players)
+  {
+    if (player.isHost && !host)
+      host = &player;
+    else if (!player.isHost && !guest)
+      guest = &player;
+  }
+
+  const std::string hostIP = host ? host->conn->ip : "";
+  const std::string guestIP = guest ? guest->conn->ip : "";
+
+  // RoomInfo + hostIPLen + hostIP + guestIPLen + guestIP + guestReady + isDarkMode
+  std::vector<uint8_t> response;
+  response.reserve(5 + hostIP.size() + guestIP.size());
+  response.push_back(static_cast<uint8_t>(NetMessageType::RoomInfo));
+  response.push_back(static_cast<uint8_t>(hostIP.size()));
+  response.insert(response.end(), hostIP.begin(), hostIP.end());
+  response.push_back(static_cast<uint8_t>(guestIP.size()));
+  response.insert(response.end(), guestIP.begin(), guestIP.end());
+  response.push_back(guest && guest->ready ? 1 : 0);
+  response.push_back(room.isDarkMode ? 1 : 0);
+
+  for (auto &player : room.players)
+  {
+    sendFrame(*player.conn, response);
+  }
+}
+
+void ServerShard::sendRoomError(ServerConnection &conn, const std::string &error)
+{
+  std::vector<uint8_t> response;
+  response.push_back(static_cast<uint8_t>(NetMessageType::RoomError));
+  response.push_back(static_cast<uint8_t>(error.size()));
+  response.insert(response.end(), error.begin(), error.end());
+  sendFrame(conn, response);
+}
+
+ServerShard::Room *ServerShard::findRoom(const ServerConnection &conn)
+{
+  if (conn.roomCode.empty())
+    return nullptr;
+  auto it = m_rooms.find(conn.roomCode);
+  return it != m_rooms.end() ? &it->second : nullptr;
+}
+
+ServerShard::RoomPlayer *ServerShard::findPlayer(Room &room, const ServerConnection &conn)
+{
+  for (auto &player : room.players)
+  {
+    if (player.conn == &conn)
+      return &player;
+  }
+  return nullptr;
+}
+
+std::string ServerShard::generateRoomCode()
+{
+  // 4 位数字且 code % shardCount == 本分片下标，加入时可直接定位分片
+  for (int attempt = 0; attempt < 10000; attempt++)
+  {
+    m_rngState ^= m_rngState << 13;
+    m_rngState ^= m_rngState >> 17;
+    m_rngState ^= m_rngState << 5;
+
+    int code = 1000 + static_cast<int>(m_rngState % 9000);
+    code = code - code % m_shardCount + m_index;
+    if (code < 1000)
+      code += m_shardCount;
+    if (code > 9999)
+      code -= m_shardCount;
+
+    std::string result = std::to_string(code);
+    if (m_rooms.find(result) == m_rooms.end())
+      return result;
+  }
+  return "";
+}
+
+uint32_t ServerShard::generateResumeToken()
+{
+  // 持有令牌即可接管掉线玩家的位置，不能用可预测的 m_rngState
+  uint32_t token = 0;
+  while (token == 0)
+    token = static_cast<uint32_t>(m_tokenSource());
+  return token;
+}
+
+void ServerShard::handleMessage(ServerConnection &conn, const std::vector<uint8_t> &data)
+{
+  const auto msgType = static_cast<NetMessageType>(data[0]);
+
+  switch (msgType)
+  {
+  case NetMessageType::Connect:
+  {
+    // 连接确认（附带会话ID，客户端用它完成 UDP 握手）
+    uint8_t response[5] = {static_cast<uint8_t>(NetMessageType::ConnectAck),
+                           static_cast<uint8_t>(conn.sessionId & 0xFF),
+                           static_cast<uint8_t>((conn.sessionId >> 8) & 0xFF),
+                           static_cast<uint8_t>((conn.sessionId >> 16) & 0xFF),
+                           static_cast<uint8_t>((conn.sessionId >> 24) & 0xFF)};
+    sendFrame(conn, response, sizeof(response));
+    break;
+  }
+
+  case NetMessageType::Disconnect:
+    // 主动离开不保留位置
+    leaveRoom(conn);
+    requestClose(conn);
+    break;
+
+  case NetMessageType::Ping:
+  {
+    // 原样带回负载，客户端据此计算 RTT（data 可能就是 m_frame，另拷一份）
+    std::vector<uint8_t> pong(data);
+    pong[0] = static_cast<uint8_t>(NetMessageType::Pong);
+    sendFrame(conn, pong);
+    break;
+  }
+
+  case NetMessageType::CreateRoom:
+  {
+    if (data.size() < 5)
+      break;
+
+    leaveRoom(conn);
+    std::string code = generateRoomCode();
+    if (code.empty())
+    {
+      sendRoomError(conn, "Server is full");
+      break;
+    }
+
+    Room &room = m_rooms[code];
+    room.code = code;
+    room.mazeWidth = data[1] | (data[2] << 8);
+    room.mazeHeight = data[3] | (data[4] << 8);
+    room.isDarkMode = data.size() > 5 && data[5] != 0;
+    // 帧同步模式下双方各自模拟，不再需要服务器权威模拟
+    room.lockstep = data.size() > 7 && data[7] != 0;
+    room.simulated = data.size() > 6 && data[6] != 0 && !room.lockstep && simulationAvailable();
+    room.players.push_back({&conn, false, true, true});
+    roomCount++;
+
+    conn.roomCode = code;
+    conn.isHost = true;
+
+    if (m_server.verbose())
+      std::cout << "[Server] Room created: " << code << " (" << room.mazeWidth << "x" << room.mazeHeight
+                << ") on shard " << m_index << std::endl;
+
+    std::vector<uint8_t> response;
+    response.push_back(static_cast<uint8_t>(NetMessageType::RoomCreated));
+    response.push_back(static_cast<uint8_t>(code.size()));
+    response.insert(response.end(), code.begin(), code.end());
+    sendFrame(conn, response);
+    sendRoomInfo(room);
+    break;
+  }
+
+  case NetMessageType::MazeChunk:
+  {
+    // 只有房主可以发送迷宫数据
+    Room *room = findRoom(conn);
+    if (!room || !conn.isHost || !room->maze.add(data))
+      break;
+
+    room->isEscapeMode = (room->maze.modeFlags() & 1) != 0;
+
+    // 分块与种子描述的不是同一张迷宫时，以分块为准
+    MazeSeedParams params;
+    uint8_t seedFlags = 0;
+    uint64_t seedHash = 0;
+    if (MazeCodec::parseSeedMessage(room->mazeSeed, params, seedFlags, seedHash) && seedHash != room->maze.hash())
+      room->mazeSeed.clear();
+
+    // 如果有第二个玩家在房间，转发分块给他（但不开始游戏）
+    for (auto &player : room->players)
+    {
+      if (!player.isHost)
+        sendFrame(*player.conn, data);
+    }
+    break;
+  }
+
+  case NetMessageType::MazeSeed:
+  {
+    // 只转发种子，由对方本地重新生成
+    Room *room = findRoom(conn);
+    if (!room || !conn.isHost || data.size() < MazeCodec::SEED_MESSAGE_SIZE)
+      break;
+
+    room->mazeSeed = data;
+    room->isEscapeMode = (data[1] & 1) != 0;
+    for (auto &player : room->players)
+    {
+      if (!player.isHost)
+        sendFrame(*player.conn, data);
+    }
+    break;
+  }
+
+  case NetMessageType::RequestMaze:
+  {
+    // 对方无法按种子重新生成：有缓存分块则直接发送，否则转给房主补发分块
+    Room *room = findRoom(conn);
+    if (!room || conn.isHost)
+      break;
+
+    uint64_t hash = data.size() >= 9 ? MazeCodec::readHash(data.data() + 1) : 0;
+    if (room->maze.complete() && room->maze.hash() == hash)
+    {
+      for (const auto &chunk : room->maze.chunks())
+        sendFrame(conn, chunk);
+      break;
+    }
+    for (auto &player : room->players)
+    {
+      if (player.isHost)
+        sendFrame(*player.conn, data);
+    }
+    break;
+  }
+
+  case NetMessageType::MazeOffer:
+  {
+    // 房主声明迷宫哈希：缓存命中则直接转发缓存，否则请求上传
+    Room *room = findRoom(conn);
+    if (!room || !conn.isHost || data.size() < 10)
+      break;
+
+    uint64_t hash = MazeCodec::readHash(data.data() + 2);
+    if (room->maze.complete() && room->maze.hash() == hash && room->maze.modeFlags() == data[1])
+    {
+      for (auto &player : room->players)
+      {
+        if (player.isHost)
+          continue;
+        for (const auto &chunk : room->maze.chunks())
+          sendFrame(*player.conn, chunk);
+      }
+      break;
+    }
+
+    std::vector<uint8_t> request;
+    request.push_back(static_cast<uint8_t>(NetMessageType::RequestMaze));
+    MazeCodec::writeHash(request, hash);
+    sendFrame(conn, request);
+    break;
+  }
+
+  case NetMessageType::JoinRoom:
+  {
+    if (data.size() < 2 || data.size() < 2u + data[1])
+      break;
+    std::string code(data.begin() + 2, data.begin() + 2 + data[1]);
+
+    // 房间属于其他分片：连接连同这一帧迁移过去处理
+    int owner = ownerShard(code);
+    if (owner >= 0 && owner != m_index)
+    {
+      leaveRoom(conn);
+      conn.migrateTo = owner;
+      conn.replayFrame = data;
+      m_pendingMigrate.push_back(&conn);
+      break;
+    }
+
+    auto it = m_rooms.find(code);
+    if (it == m_rooms.end())
+    {
+      sendRoomError(conn, "Room not found");
+      break;
+    }
+    Room &room = it->second;
+    if (findPlayer(room, conn))
+      break;
+    // 掉线玩家的位置在保留期内也算占用
+    if (room.players.size() >= 2 || room.held)
+    {
+      sendRoomError(conn, "Room is full");
+      break;
+    }
+
+    leaveRoom(conn);
+    room.players.push_back({&conn, false, false, false});
+    conn.roomCode = code;
+    conn.isHost = false;
+
+    if (m_server.verbose())
+      std::cout << "[Server] Player joined room: " << code << std::endl;
+
+    std::vector<uint8_t> response;
+    response.push_back(static_cast<uint8_t>(NetMessageType::RoomJoined));
+    response.push_back(static_cast<uint8_t>(code.size()));
+    response.insert(response.end(), code.begin(), code.end());
+    sendFrame(conn, response);
+
+    // 发送迷宫数据给新玩家（如果已有，优先只发种子），否则请求房主发送
+    if (!room.mazeSeed.empty())
+    {
+      sendFrame(conn, room.mazeSeed);
+    }
+    else if (room.maze.complete())
+    {
+      for (const auto &chunk : room.maze.chunks())
+        sendFrame(conn, chunk);
+    }
+    else
+    {
+      for (auto &player : room.players)
+      {
+        if (player.isHost)
+        {
+          uint8_t request = static_cast<uint8_t>(NetMessageType::RequestMaze);
+          sendFrame(*player.conn, &request, 1);
+        }
+      }
+    }
+
+    sendRoomInfo(room);
+    break;
+  }
+
+  case NetMessageType::PlayerReady:
+  {
+    Room *room = findRoom(conn);
+    RoomPlayer *player = room ? findPlayer(*room, conn) : nullptr;
+    if (!player || data.size() < 2)
+      break;
+
+    player->ready = data[1] != 0;
+    broadcastToRoom(*room, &conn, data);
+    sendRoomInfo(*room);
+    break;
+  }
+
+  case NetMessageType::HostStartGame:
+  {
+    Room *room = findRoom(conn);
+    if (!room || !conn.isHost || room->players.size() < 2)
+      break;
+
+    // 检查是否满足开始条件：对方已准备
+    bool guestReady = false;
+    for (const auto &player : room->players)
+    {
+      if (!player.isHost)
+        guestReady = player.ready;
+    }
+    if (!guestReady)
+      break;
+
+    room->started = true;
+
+    // 游戏开始后重置所有玩家的 ready 状态，返回房间时需要重新准备
+    for (auto &player : room->players)
+    {
+      player.ready = false;
+    }
+
+    // GameStart 附带是否由服务器权威模拟、是否为帧同步模式，以及断线重连令牌
+    // （帧同步与权威模拟下中途重连需要对齐双方或服务器的模拟，不支持，令牌为 0）
+    startSimulation(*room);
+    bool resumable = !room->lockstep && !room->simulation;
+    for (auto &player : room->players)
+    {
+      player.token = resumable ? generateResumeToken() : 0;
+      uint8_t gameStart[7] = {static_cast<uint8_t>(NetMessageType::GameStart), static_cast<uint8_t>(room->simulation ? 1 : 0),
+                              static_cast<uint8_t>(room->lockstep ? 1 : 0)};
+      std::memcpy(&gameStart[3], &player.token, sizeof(uint32_t));
+      sendFrame(*player.conn, gameStart, sizeof(gameStart));
+    }
+    if (m_server.verbose())
+      std::cout << "[Server] Game started in room: " << room->code << std::endl;
+    break;
+  }
+
+  case NetMessageType::ReachExit:
+  {
+    Room *room = findRoom(conn);
+    if (!room || !room->started)
+      break;
+
+    if (RoomPlayer *player = findPlayer(*room, conn))
+    {
+      player->reachedExit = true;
+
+      // 所有玩家都到达终点时发送胜利消息
+      bool allReached = std::all_of(room->players.begin(), room->players.end(),
+                                    [](const RoomPlayer &p)
+                                    { return p.reachedExit; });
+      if (allReached)
+      {
+        uint8_t win = static_cast<uint8_t>(NetMessageType::GameWin);
+        for (auto &p : room->players)
+        {
+          sendFrame(*p.conn, &win, 1);
+        }
+      }
+    }
+    broadcastToRoom(*room, &conn, data);
+    break;
+  }
+
+  case NetMessageType::RestartRequest:
+  {
+    Room *room = findRoom(conn);
+    if (!room)
+      break;
+
+    // 对方掉线后留下的一方返回房间：不再等待重连
+    if (room->held)
+    {
+      bool wasHost = room->held->isHost;
+      room->held.reset();
+      m_heldCount--;
+      resetAfterLeave(*room, wasHost);
+    }
+
+    // 重置房间状态，发送者返回房间：房主自动 ready，非房主保持 not ready
+    room->started = false;
+    stopSimulation(*room);
+    for (auto &player : room->players)
+    {
+      player.reachedExit = false;
+      player.token = 0;
+      if (player.conn == &conn)
+        player.ready = player.isHost;
+    }
+
+    broadcastToRoom(*room, &conn, data);
+    sendRoomInfo(*room);
+    break;
+  }
+
+  case NetMessageType::ResumeSession:
+  {
+    std::string code;
+    uint32_t token = 0;
+    std::size_t payloadOffset = 0;
+    if (!ResumeCodec::parseSessionHeader(data, code, token, payloadOffset))
+      break;
+
+    // 与 JoinRoom 相同：房间属于其他分片时迁移过去处理
+    int owner = ownerShard(code);
+    if (owner >= 0 && owner != m_index)
+    {
+      leaveRoom(conn);
+      conn.migrateTo = owner;
+      conn.replayFrame = data;
+      m_pendingMigrate.push_back(&conn);
+      break;
+    }
+
+    auto it = m_rooms.find(code);
+    if (it == m_rooms.end() || !it->second.held || it->second.held->token != token || !conn.roomCode.empty())
+    {
+      sendRoomError(conn, "Session expired");
+      break;
+    }
+
+    // 回到原来的位置，请留下的一方发送快照
+    Room &room = it->second;
+    HeldSlot held = *room.held;
+    room.held.reset();
+    m_heldCount--;
+    room.players.push_back({&conn, held.reachedExit, held.isHost, false, token});
+    conn.roomCode = code;
+    conn.isHost = held.isHost;
+
+    if (m_server.verbose())
+      std::cout << "[Server] Player resumed session in room " << code << std::endl;
+
+    std::vector<uint8_t> request;
+    request.push_back(static_cast<uint8_t>(NetMessageType::ResumeRequest));
+    request.insert(request.end(), data.begin() + payloadOffset, data.end());
+    broadcastToRoom(room, &conn, request);
+    break;
+  }
+
+  default:
+  {
+    if (!isInGameRelayType(msgType))
+      break;
+
+    Room *room = findRoom(conn);
+    if (!room || !room->started)
+      break;
+
+    // 对局已分出结果，之后掉线不再保留位置
+    if (msgType == NetMessageType::GameResult)
+    {
+      for (auto &player : room->players)
+        player.token = 0;
+    }
+    if (feedSimulation(*room, conn, data))
+      broadcastToRoom(*room, &conn, data);
+    break;
+  }
+  }
+}
+
+void ServerShard::relayDatagram(uint32_t sessionId, const std::vector<uint8_t> &datagram)
+{
+  auto it = m_sessions.find(sessionId);
+  if (it == m_sessions.end())
+    return;
+
+  ServerConnection &sender = *it->second;
+  Room *room = findRoom(sender);
+  if (!room || !room->started)
+    return;
+
+  // 去掉序号后的消息（TCP 回退和权威模拟使用）
+  m_frame.clear();
+  m_frame.push_back(datagram[0]);
+  m_frame.insert(m_frame.end(), datagram.begin() + NET_DATAGRAM_HEADER_SIZE, datagram.end());
+  if (!feedSimulation(*room, sender, m_frame))
+    return;
+
+  for (auto &player : room->players)
+  {
+    ServerConnection &peer = *player.conn;
+    if (&peer == &sender)
+      continue;
+
+    if (peer.hasUdp)
+    {
+      sendto(m_server.udpFd(), datagram.data(), datagram.size(), 0,
+             reinterpret_cast<const sockaddr *>(&peer.udpAddr), sizeof(peer.udpAddr));
+    }
+    else
+    {
+      // 对方没有 UDP 端点：去掉序号走 TCP
+      sendFrame(peer, m_frame);
+    }
+  }
+  datagramsRelayed.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ServerShard::bindUdp(uint32_t sessionId, const sockaddr_in &addr, const std::vector<uint8_t> &hello)
+{
+  // 会话已迁移到其他分片时不回复，客户端会重试握手
+  auto it = m_sessions.find(sessionId);
+  if (it == m_sessions.end())
+    return;
+
+  ServerConnection &conn = *it->second;
+  conn.hasUdp = true;
+  conn.udpAddr = addr;
+  sendto(m_server.udpFd(), hello.data(), hello.size(), 0,
+         reinterpret_cast<const sockaddr *>(&addr), sizeof(addr));
+}
+
+int ServerShard::ownerShard(const std::string &code) const
+{
+  if (code.size() != 4 || !std::all_of(code.begin(), code.end(), [](unsigned char c)
+                                       { return std::isdigit(c) != 0; }))
+    return -1;
+  return std::stoi(code) % m_shardCount;
+}
+
+void ServerShard::leaveRoom(ServerConnection &conn, bool allowResume)
+{
+  auto it = m_rooms.find(conn.roomCode);
+  conn.roomCode.clear();
+  if (it == m_rooms.end())
+    return;
+
+  Room &room = it->second;
+  const bool wasHost = conn.isHost;
+  conn.isHost = false;
+  RoomPlayer leaving;
+  if (RoomPlayer *player = findPlayer(room, conn))
+    leaving = *player;
+  room.players.erase(std::remove_if(room.players.begin(), room.players.end(),
+                                    [&conn](const RoomPlayer &p)
+                                    { return p.conn == &conn; }),
+                     room.players.end());
+
+  if (room.players.empty())
+  {
+    stopSimulation(room);
+    if (room.held)
+      m_heldCount--;
+    if (m_server.verbose())
+      std::cout << "[Server] Room " << room.code << " deleted" << std::endl;
+    m_rooms.erase(it);
+    roomCount--;
+    return;
+  }
+
+  // 对局中意外掉线：保留位置等待重连，对局继续
+  if (allowResume && room.started && leaving.token != 0 && !room.held)
+  {
+    auto grace = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<float>(RESUME_GRACE_SECONDS));
+    room.held = HeldSlot{leaving.token, wasHost, leaving.reachedExit, std::chrono::steady_clock::now() + grace};
+    m_heldCount++;
+
+    uint8_t dropped[2] = {static_cast<uint8_t>(NetMessageType::PeerDropped), static_cast<uint8_t>(RESUME_GRACE_SECONDS)};
+    for (auto &player : room.players)
+      sendFrame(*player.conn, dropped, sizeof(dropped));
+    if (m_server.verbose())
+      std::cout << "[Server] Player dropped from room " << room.code << ", holding slot" << std::endl;
+    return;
+  }
+
+  resetAfterLeave(room, wasHost);
+}
+
+void ServerShard::resetAfterLeave(Room &room, bool wasHost)
+{
+  // 重置房间状态，让剩余玩家回到房间大厅
+  room.started = false;
+  stopSimulation(room);
+  for (auto &player : room.players)
+  {
+    player.reachedExit = false;
+    player.token = 0;
+    if (wasHost)
+      player.ready = true;
+  }
+
+  // 如果离开的是房主，让剩余玩家成为新房主
+  if (wasHost)
+  {
+    room.players[0].isHost = true;
+    room.players[0].conn->isHost = true;
+  }
+
+  // 通知剩余玩家对方已离开，并告知是否成为新房主
+  for (auto &player : room.players)
+  {
+    uint8_t playerLeft[2] = {static_cast<uint8_t>(NetMessageType::PlayerLeft), static_cast<uint8_t>(player.isHost ? 1 : 0)};
+    sendFrame(*player.conn, playerLeft, sizeof(playerLeft));
+  }
+  sendRoomInfo(room);
+}
+
+void ServerShard::expireHeldSlots()
+{
+  if (m_heldCount == 0)
+    return;
+
+  // 保留期已过仍未重连：按普通离开处理
+  auto now = std::chrono::steady_clock::now();
+  for (auto &[code, room] : m_rooms)
+  {
+    if (!room.held || room.held->expires > now)
+      continue;
+    bool wasHost = room.held->isHost;
+    room.held.reset();
+    m_heldCount--;
+    if (m_server.verbose())
+      std::cout << "[Server] Resume window expired in room " << code << std::endl;
+    resetAfterLeave(room, wasHost);
+  }
+}
+
+void ServerShard::requestClose(ServerConnection &conn)
+{
+  if (conn.closing)
+    return;
+  conn.closing = true;
+  m_pendingClose.push_back(&conn);
+}
+
+void ServerShard::flushPendingClosures()
+{
+  // 迁移：离开本分片的 epoll，更新会话路由后投递给目标分片
+  for (ServerConnection *conn : m_pendingMigrate)
+  {
+    if (conn->closing)
+      continue;
+
+    epoll_ctl(m_epollFd, EPOLL_CTL_DEL, conn->fd, nullptr);
+    m_sessions.erase(conn->sessionId);
+    connectionCount--;
+
+    auto it = m_connections.find(conn->fd);
+    ShardEvent event;
+    event.type = ShardEventType::Adopt;
+    event.data = std::move(conn->replayFrame);
+    event.conn = std::move(it->second);
+    m_connections.erase(it);
+
+    int target = event.conn->migrateTo;
+    m_server.setSessionShard(event.conn->sessionId, target);
+    m_server.postToShard(target, std::move(event));
+  }
+  m_pendingMigrate.clear();
+
+  // 关闭：离开房间时可能触发其他连接关闭，循环直到为空
+  while (!m_pendingClose.empty())
+  {
+    ServerConnection *conn = m_pendingClose.back();
+    m_pendingClose.pop_back();
+
+    leaveRoom(*conn, true);
+    epoll_ctl(m_epollFd, EPOLL_CTL_DEL, conn->fd, nullptr);
+    close(conn->fd);
+    m_sessions.erase(conn->sessionId);
+    m_server.removeSession(conn->sessionId);
+    connectionCount--;
+    m_connections.erase(conn->fd);
+  }
+}
+
+bool ServerShard::simulationAvailable()
+{
+#ifdef TANK_SERVER_SIMULATION
+  return true;
+#else
+  return false;
+#endif
+}
+
+void ServerShard::stopSimulation(Room &room)
+{
+  if (!room.simulation)
+    return;
+  room.simulation.reset();
+  m_simulationCount--;
+}
+
+int ServerShard::nextTickTimeout(int defaultMs) const
+{
+  if (m_simulationCount == 0)
+    return defaultMs;
+
+  // 所有模拟房间共用同一步长，取最早的下一帧
+  auto now = std::chrono::steady_clock::now();
+  auto earliest = now + std::chrono::milliseconds(defaultMs);
+  for (const auto &[code, room] : m_rooms)
+  {
+    if (room.simulation && room.nextTick < earliest)
+      earliest = room.nextTick;
+  }
+  auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(earliest - now).count();
+  return static_cast<int>(std::clamp<long long>(wait, 0, defaultMs));
+}
+
+#ifdef TANK_SERVER_SIMULATION
+
+void ServerShard::startSimulation(Room &room)
+{
+  stopSimulation(room);
+  if (!room.simulated)
+    return;
+
+  // 优先按种子重新生成，否则使用缓存的分块
+  std::vector<std::string> mazeData;
+  bool isEscapeMode = false;
+  MazeSeedParams params;
+  uint8_t modeFlags = 0;
+  uint64_t hash = 0;
+  if (MazeCodec::parseSeedMessage(room.mazeSeed, params, modeFlags, hash))
+  {
+    if (params.version == MazeGenerator::ALGORITHM_VERSION && params.seed != 0)
+    {
+      MazeGenerator generator(params.width, params.height);
+      generator.setSeed(params.seed);
+      generator.setEnemyCount(params.enemyCount);
+      generator.setMultiplayerMode(true);
+      generator.setEscapeMode((modeFlags & 1) != 0);
+      mazeData = generator.generate();
+      isEscapeMode = (modeFlags & 1) != 0;
+    }
+    if (MazeCodec::hash(mazeData) != hash)
+      mazeData.clear();
+  }
+  if (mazeData.empty() && room.maze.complete() && room.maze.decode(mazeData))
+    isEscapeMode = (room.maze.modeFlags() & 1) != 0;
+
+  auto simulation = std::make_shared<ServerSimulation>();
+  if (mazeData.empty() || !simulation->init(mazeData, isEscapeMode))
+  {
+    std::cerr << "[Server] Room " << room.code << ": invalid maze data, simulation disabled" << std::endl;
+    return;
+  }
+
+  room.simulation = std::move(simulation);
+  room.nextTick = std::chrono::steady_clock::now();
+  m_simulationCount++;
+  if (m_server.verbose())
+    std::cout << "[Server] Room " << room.code << ": server simulation started (" << room.simulation->npcCount()
+              << " NPCs)" << std::endl;
+}
+
+bool ServerShard::feedSimulation(Room &room, const ServerConnection &sender, const std::vector<uint8_t> &data)
+{
+  // 输入只对权威模拟有意义，其余消息照常转发
+  if (!room.simulation)
+    return static_cast<NetMessageType>(data[0]) != NetMessageType::PlayerInput;
+
+  switch (static_cast<NetMessageType>(data[0]))
+  {
+  // 世界状态由服务器产生，客户端发来的不再转发
+  case NetMessageType::NpcUpdate:
+  case NetMessageType::NpcShoot:
+  case NetMessageType::NpcDamage:
+  case NetMessageType::WallDamage:
+  // 玩家状态与射击也由服务器按输入产生
+  case NetMessageType::PlayerUpdate:
+  case NetMessageType::PlayerShoot:
+    return false;
+  // 输入只交给模拟，不转发给对方
+  case NetMessageType::PlayerInput:
+    room.simulation->handleClientMessage(sender.isHost ? ServerSimulation::HOST : ServerSimulation::GUEST,
+                                         data.data(), data.size());
+    return false;
+  default:
+    room.simulation->handleClientMessage(sender.isHost ? ServerSimulation::HOST : ServerSimulation::GUEST,
+                                         data.data(), data.size());
+    return true;
+  }
+}
+
+void ServerShard::tickSimulations()
+{
+  if (m_simulationCount == 0)
+    return;
+
+  const auto now = std::chrono::steady_clock::now();
+  const auto step = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+      std::chrono::duration<float>(ServerSimulation::TICK_INTERVAL));
+
+  for (auto &[code, room] : m_rooms)
+  {
+    if (!room.simulation)
+      continue;
+
+    // 固定步长追帧，最多追 5 步，落后过多时丢弃积压
+    int steps = 0;
+    while (room.nextTick <= now && steps < 5)
+    {
+      room.simulation->tick();
+      room.nextTick += step;
+      steps++;
+    }
+    if (room.nextTick <= now)
+      room.nextTick = now + step;
+
+    for (auto &msg : room.simulation->outgoing())
+    {
+      for (auto &player : room.players)
+      {
+        int index = player.isHost ? ServerSimulation::HOST : ServerSimulation::GUEST;
+        if (msg.target != ServerSimulation::BOTH && msg.target != index)
+          continue;
+
+        ServerConnection &peer = *player.conn;
+        if (msg.isState && peer.hasUdp)
+        {
+          // 数据报格式：类型(1) + 序号(4) + 负载
+          uint32_t seq = ++peer.udpSendSeq;
+          m_frame.clear();
+          m_frame.push_back(msg.data[0]);
+          for (int i = 0; i < 4; i++)
+            m_frame.push_back(static_cast<uint8_t>((seq >> (i * 8)) & 0xFF));
+          m_frame.insert(m_frame.end(), msg.data.begin() + 1, msg.data.end());
+          sendto(m_server.udpFd(), m_frame.data(), m_frame.size(), 0,
+                 reinterpret_cast<const sockaddr *>(&peer.udpAddr), sizeof(peer.udpAddr));
+        }
+        else
+        {
+          sendFrame(peer, msg.data);
+        }
+      }
+    }
+    room.simulation->outgoing().clear();
+  }
+}
+
+#else
+
+void ServerShard::startSimulation(Room &)
+{
+}
+
+bool ServerShard::feedSimulation(Room &, const ServerConnection &, const std::vector<uint8_t> &data)
+{
+  return static_cast<NetMessageType>(data[0]) != NetMessageType::PlayerInput;
+}
+
+void ServerShard::tickSimulations()
+{
+}
+
+#endif
@@ -0,0 +1,396 @@
+#include "ServerSimulation.hpp"
+#include "CollisionSystem.hpp"
+#include "NetProtocol.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <string>
+
+namespace
+{
+  constexpr float TANK_SCALE = 0.4f; // 与客户端 Game::m_tankScale 一致
+
+  void pushFloat(std::vector<uint8_t> &data, float value)
+  {
+    uint8_t bytes[4];
+    std::memcpy(bytes, &value, sizeof(float));
+    data.insert(data.end(), bytes, bytes + 4);
+  }
+
+  float readFloat(const uint8_t *data)
+  {
+    float value;
+    std::memcpy(&value, data, sizeof(float));
+    return value;
+  }
+
+  void pushUint32(std::vector<uint8_t> &data, uint32_t value)
+  {
+    for (int i = 0; i < 4; i++)
+      data.push_back(static_cast<uint8_t>((value >> (i * 8)) & 0xFF));
+  }
+
+  uint32_t readUint32(const uint8_t *data)
+  {
+    return data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<uint32_t>(data[3]) << 24);
+  }
+}
+
+bool ServerSimulation::init(const std::vector<std::string> &mazeData, bool isEscapeMode)
+{
+  if (mazeData.empty())
+    return false;
+
+  m_isEscapeMode = isEscapeMode;
+  m_maze.loadFromString(mazeData);
+
+  // 玩家代理：出生点与阵营规则同客户端 onGameStart
+  sf::Vector2f spawns[2] = {m_maze.getSpawn1Position(), m_maze.getSpawn2Position()};
+  for (int i = 0; i < 2; i++)
+  {
+    if (spawns[i].x == 0 && spawns[i].y == 0)
+      spawns[i] = m_maze.getPlayerStartPosition();
+    m_players[i].setScale(TANK_SCALE);
+    m_players[i].setPosition(spawns[i]);
+    m_players[i].setHealth(100.f);
+    m_players[i].setTeam(m_isEscapeMode ? 1 : i + 1);
+  }
+
+  // NPC：与客户端 spawnEnemies 相同的顺序和 ID
+  m_enemies.clear();
+  m_bullets.clear();
+  for (const auto &pos : m_maze.getEnemySpawnPoints())
+  {
+    auto enemy = std::make_unique<Enemy>(m_entities);
+    enemy->initHeadless();
+    enemy->setPosition(pos);
+    enemy->setBounds(m_maze.getSize());
+    enemy->setId(static_cast<int>(m_enemies.size()));
+    m_enemies.push_back(std::move(enemy));
+  }
+
+  m_time = 0.f;
+  m_outgoing.clear();
+  for (int i = 0; i < 2; i++)
+  {
+    m_interest[i].reset();
+    m_reported[i] = false;
+    m_inputs[i] = InputState{};
+  }
+  return true;
+}
+
+void ServerSimulation::handleClientMessage(int playerIndex, const uint8_t *data, std::size_t len)
+{
+  if (len < 1 || playerIndex < 0 || playerIndex > 1)
+    return;
+
+  switch (static_cast<NetMessageType>(data[0]))
+  {
+  case NetMessageType::PlayerInput:
+  {
+    if (len < 15)
+      break;
+    // UDP 可能乱序：只接受更新的输入序号
+    InputState &input = m_inputs[playerIndex];
+    uint32_t seq = readUint32(data + 1);
+    if (m_reported[playerIndex] && static_cast<int32_t>(seq - input.seq) <= 0)
+      break;
+    m_reported[playerIndex] = true;
+    input.seq = seq;
+    input.buttons = data[5] & (Tank::INPUT_UP | Tank::INPUT_DOWN | Tank::INPUT_LEFT | Tank::INPUT_RIGHT | Tank::INPUT_FIRE);
+    input.aim = {readFloat(data + 6), readFloat(data + 10)};
+    input.reachedExit = (data[14] & 1) != 0;
+    break;
+  }
+
+  case NetMessageType::RescueComplete:
+  {
+    // 救援方完成救援：复活对方（与客户端一致，恢复 50 血量）
+    Tank &other = m_players[1 - playerIndex];
+    if (m_isEscapeMode && other.isDead())
+      other.setHealth(50.f);
+    break;
+  }
+
+  case NetMessageType::NpcActivate:
+  {
+    if (len < 4)
+      break;
+    int npcId = data[1];
+    int activatorId = static_cast<int>(data[3]) - 128;
+    if (npcId < static_cast<int>(m_enemies.size()) && !m_enemies[npcId]->isActivated())
+    {
+      // Battle 模式的激活者 ID 相对发送方（0=自己），转换为绝对下标
+      if (!m_isEscapeMode && activatorId == 0)
+        activatorId = playerIndex;
+      m_enemies[npcId]->activate(data[2], activatorId);
+    }
+    break;
+  }
+
+  case NetMessageType::WallPlace:
+  {
+    if (len < 9)
+      break;
+    m_maze.placeWall({readFloat(data + 1), readFloat(data + 5)});
+    break;
+  }
+
+  case NetMessageType::WallBatch:
+  {
+    // 客户端只会上报放置；墙体伤害由服务器负责
+    std::vector<WallBatchEntry> entries;
+    if (!WallBatch::parse(data, len, entries))
+      break;
+    std::vector<WallChange> changes;
+    for (const auto &entry : entries)
+    {
+      if (entry.placed)
+        changes.push_back({entry.row, entry.col, true, false, 0.f});
+    }
+    m_maze.applyWallChanges(changes);
+    break;
+  }
+
+  default:
+    break;
+  }
+}
+
+void ServerSimulation::tick()
+{
+  const float dt = TICK_INTERVAL;
+  m_time += dt;
+
+  updatePlayers(dt);
+  updateNpcAI(dt);
+
+  m_maze.update(dt);
+  for (auto &bullet : m_bullets)
+  {
+    bullet->update(dt);
+  }
+
+  CollisionSystem::checkServerCollisions(
+      &m_players[HOST], &m_players[GUEST], m_enemies, m_bullets, m_maze,
+      [this](const WallDestroyResult &result, const Bullet &bullet)
+      { queueWallDamage(result, bullet); },
+      [this](Enemy &npc, float damage)
+      {
+        std::vector<uint8_t> msg = {static_cast<uint8_t>(NetMessageType::NpcDamage), static_cast<uint8_t>(npc.getId())};
+        pushFloat(msg, damage);
+        m_outgoing.push_back({BOTH, false, std::move(msg)});
+      });
+  flushWallBatches();
+  sendPlayerSnapshots();
+}
+
+void ServerSimulation::updatePlayers(float dt)
+{
+  // 与客户端 MultiplayerHandler::update 的本地玩家移动一致，倒地的玩家不能移动和射击
+  for (int i : {HOST, GUEST})
+  {
+    Tank &player = m_players[i];
+    if (player.isDead())
+      continue;
+
+    sf::Vector2f oldPos = player.getPosition();
+    player.setInputBits(m_inputs[i].buttons);
+    player.update(dt, m_inputs[i].aim);
+    player.setPosition(m_maze.resolveMovement(oldPos, player.getPosition(), player.getCollisionRadius()));
+
+    if (player.hasFiredBullet())
+    {
+      sf::Vector2f bulletPos = player.getBulletSpawnPosition();
+      float bulletAngle = player.getTurretRotation();
+      auto bullet = std::make_unique<Bullet>(bulletPos.x, bulletPos.y, bulletAngle, true);
+      bullet->setOwner(i == HOST ? BulletOwner::Player : BulletOwner::OtherPlayer);
+      bullet->setTeam(player.getTeam());
+      m_bullets.push_back(std::move(bullet));
+
+      // 开枪方本地已预测出子弹，只通知对方
+      std::vector<uint8_t> msg = {static_cast<uint8_t>(NetMessageType::PlayerShoot)};
+      pushFloat(msg, bulletPos.x);
+      pushFloat(msg, bulletPos.y);
+      pushFloat(msg, bulletAngle);
+      m_outgoing.push_back({1 - i, true, std::move(msg)});
+    }
+  }
+}
+
+void ServerSimulation::sendPlayerSnapshots()
+{
+  // 每个接收方收到两条：自己的坦克（带已处理的输入序号，用于校正预测）和对方的坦克
+  for (int target : {HOST, GUEST})
+  {
+    for (int subject : {HOST, GUEST})
+    {
+      const Tank &player = m_players[subject];
+      std::vector<uint8_t> msg = {static_cast<uint8_t>(NetMessageType::PlayerSnapshot),
+                                  static_cast<uint8_t>(subject == target ? 0 : 1)};
+      pushUint32(msg, m_inputs[subject].seq);
+      pushFloat(msg, player.getPosition().x);
+      pushFloat(msg, player.getPosition().y);
+      pushFloat(msg, player.getRotation());
+      pushFloat(msg, player.getTurretRotation());
+      pushFloat(msg, player.getHealth());
+      msg.push_back(m_inputs[subject].reachedExit ? 1 : 0);
+      pushFloat(msg, m_time);
+      m_outgoing.push_back({target, true, std::move(msg)});
+    }
+  }
+}
+
+void ServerSimulation::updateNpcAI(float dt)
+{
+  // 与 MultiplayerHandler::updateNpcAI 房主分支一致，双方玩家均为远程代理
+  std::vector<sf::Vector2f> focus;
+  for (const Tank &player : m_players)
+    focus.push_back(player.getPosition());
+  m_aiScheduler.beginFrame(focus);
+
+  // 群体避让：用本帧开始时的位置建邻居网格
+  m_crowd.build(m_entities);
+
+  // 关注区域：每个接收方以自己的坦克为中心
+  for (int i = 0; i < 2; i++)
+    m_interest[i].beginFrame(dt, m_reported[i], m_players[i].getPosition());
+
+  for (std::size_t i = 0; i < m_enemies.size(); ++i)
+  {
+    auto &npc = m_enemies[i];
+    if (npc->isDead() || !npc->isActivated())
+      continue;
+
+    int npcTeam = npc->getTeam();
+
+    // AI 分级：只有本帧思考的 NPC 才重新收集目标、寻路和做弹道检测
+    bool think = m_aiScheduler.shouldThink(i, npc->getPosition());
+    auto thinkStart = std::chrono::steady_clock::now();
+    if (think)
+    {
+      std::vector<sf::Vector2f> targets;
+
+      if (m_isEscapeMode && npcTeam == 0)
+      {
+        // Escape 模式：攻击距离最近的活着的玩家
+        float closestDist = std::numeric_limits<float>::max();
+        const Tank *closest = nullptr;
+        for (const Tank &player : m_players)
+        {
+          if (player.isDead())
+            continue;
+          sf::Vector2f diff = player.getPosition() - npc->getPosition();
+          float dist = std::sqrt(diff.x * diff.x + diff.y * diff.y);
+          if (dist < closestDist)
+          {
+            closestDist = dist;
+            closest = &player;
+          }
+        }
+        if (closest)
+          targets.push_back(closest->getPosition());
+      }
+      else
+      {
+        for (const Tank &player : m_players)
+        {
+          if (player.getTeam() != npcTeam && npcTeam != 0)
+            targets.push_back(player.getPosition());
+        }
+
+        // 敌对阵营的 NPC：直接线性扫描实体存储
+        for (EntityId id = 0; id < m_entities.capacity(); id++)
+        {
+          if (id != npc->getEntityId() && m_entities.isActiveNpc(id) && m_entities.team[id] != npcTeam &&
+              m_entities.team[id] != 0)
+          {
+            targets.push_back({m_entities.x[id], m_entities.y[id]});
+          }
+        }
+      }
+
+      if (!targets.empty())
+        npc->setTargets(targets);
+    }
+
+    npc->update(dt, m_maze, think, &m_crowd);
+    if (think)
+      m_aiScheduler.endThink(thinkStart);
+
+    if (npc->shouldShoot())
+    {
+      sf::Vector2f bulletPos = npc->getGunPosition();
+      float bulletAngle = npc->getTurretAngle();
+      auto bullet = std::make_unique<Bullet>(bulletPos.x, bulletPos.y, bulletAngle, false);
+      bullet->setTeam(npcTeam);
+      bullet->setDamage(12.5f); // NPC子弹伤害12.5%
+      m_bullets.push_back(std::move(bullet));
+
+      std::vector<uint8_t> msg = {static_cast<uint8_t>(NetMessageType::NpcShoot), static_cast<uint8_t>(npc->getId())};
+      pushFloat(msg, bulletPos.x);
+      pushFloat(msg, bulletPos.y);
+      pushFloat(msg, bulletAngle);
+      bool toHost = m_interest[HOST].shouldSendShot(m_maze.getOccupancy(), bulletPos, bulletAngle);
+      bool toGuest = m_interest[GUEST].shouldSendShot(m_maze.getOccupancy(), bulletPos, bulletAngle);
+      pushToInterested(toHost, toGuest, true, std::move(msg));
+    }
+
+    sendNpcState(i, *npc);
+  }
+}
+
+void ServerSimulation::sendNpcState(std::size_t index, const Enemy &npc)
+{
+  bool toHost = m_interest[HOST].shouldSendUpdate(index, npc.getPosition());
+  bool toGuest = m_interest[GUEST].shouldSendUpdate(index, npc.getPosition());
+  if (!toHost && !toGuest)
+    return;
+
+  std::vector<uint8_t> msg = {static_cast<uint8_t>(NetMessageType::NpcUpdate), static_cast<uint8_t>(npc.getId())};
+  pushFloat(msg, npc.getPosition().x);
+  pushFloat(msg, npc.getPosition().y);
+  pushFloat(msg, npc.getRotation());
+  pushFloat(msg, npc.getTurretAngle());
+  pushFloat(msg, npc.getHealth());
+  msg.push_back(static_cast<uint8_t>(npc.getTeam()));
+  msg.push_back(npc.isActivated() ? 1 : 0);
+  pushFloat(msg, m_time);
+  pushToInterested(toHost, toGuest, true, std::move(msg));
+}
+
+void ServerSimulation::pushToInterested(bool toHost, bool toGuest, bool isState, std::vector<uint8_t> &&msg)
+{
+  if (toHost && toGuest)
+    m_outgoing.push_back({BOTH, isState, std::move(msg)});
+  else if (toHost || toGuest)
+    m_outgoing.push_back({toHost ? HOST : GUEST, isState, std::move(msg)});
+}
+
+void ServerSimulation::queueWallDamage(const WallDestroyResult &result, const Bullet &bullet)
+{
+  // destroyerId 对接收方而言：1=接收方自己，0=对方，-1=NPC（与非房主端的解释一致）
+  int shooter = bullet.getOwner() == BulletOwner::Player        ? HOST
+                : bullet.getOwner() == BulletOwner::OtherPlayer ? GUEST
+                                                                : -1;
+  // 玩家血量由服务器结算：治疗墙的增益在这里生效（金币与背包仍由客户端处理）
+  if (result.destroyed && result.attribute == WallAttribute::Heal && shooter >= 0)
+    m_players[shooter].heal(0.25f);
+  for (int target : {HOST, GUEST})
+  {
+    m_wallBatches[target].addDamage(result.gridY, result.gridX, bullet.getDamage(), result.destroyed,
+                                    static_cast<int>(result.attribute), shooter < 0 ? -1 : (shooter == target ? 1 : 0));
+  }
+}
+
+void ServerSimulation::flushWallBatches()
+{
+  for (int target : {HOST, GUEST})
+  {
+    for (auto &msg : m_wallBatches[target].build())
+      m_outgoing.push_back({target, false, std::move(msg)});
+    m_wallBatches[target].clear();
+  }
+}
@@ -0,0 +1,308 @@
+#include "TankServer.hpp"
+#include "NetProtocol.hpp"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+TankServer::TankServer(unsigned short port, int shardCount, bool verbose)
+    : m_port(port), m_verbose(verbose)
+{
+  for (int i = 0; i < shardCount; i++)
+  {
+    m_shards.push_back(std::make_unique<ServerShard>(*this, i, shardCount));
+  }
+}
+
+TankServer::~TankServer()
+{
+  stop();
+  if (m_listenFd >= 0)
+    close(m_listenFd);
+  if (m_udpFd >= 0)
+    close(m_udpFd);
+  if (m_epollFd >= 0)
+    close(m_epollFd);
+}
+
+bool TankServer::start()
+{
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(m_port);
+
+  // TCP 监听
+  m_listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  int one = 1;
+  setsockopt(m_listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  if (m_listenFd < 0 || bind(m_listenFd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 ||
+      listen(m_listenFd, SOMAXCONN) < 0)
+  {
+    std::cerr << "[Server] Failed to listen on TCP port " << m_port << ": " << std::strerror(errno) << std::endl;
+    return false;
+  }
+
+  // UDP 中继（与 TCP 同端口）
+  m_udpFd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (m_udpFd < 0 || bind(m_udpFd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0)
+  {
+    std::cerr << "[Server] Failed to bind UDP port " << m_port << ": " << std::strerror(errno) << std::endl;
+    return false;
+  }
+
+  m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+  epoll_event ev{};
+  ev.events = EPOLLIN;
+  ev.data.fd = m_listenFd;
+  epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_listenFd, &ev);
+  ev.data.fd = m_udpFd;
+  epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_udpFd, &ev);
+
+  for (auto &shard : m_shards)
+  {
+    if (!shard->start())
+      return false;
+  }
+
+  std::cout << "[Server] Tank Maze Server running on port " << m_port << " with " << m_shards.size()
+            << " shard(s)" << std::endl;
+  return true;
+}
+
+void TankServer::run(const std::atomic<bool> &stopFlag)
+{
+  epoll_event events[16];
+  auto lastStats = std::chrono::steady_clock::now();
+
+  while (!stopFlag)
+  {
+    int count = epoll_wait(m_epollFd, events, 16, 1000);
+    if (count < 0 && errno != EINTR)
+    {
+      std::cerr << "[Server] epoll_wait failed: " << std::strerror(errno) << std::endl;
+      break;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+      if (events[i].data.fd == m_listenFd)
+        acceptConnections();
+      else if (events[i].data.fd == m_udpFd)
+        receiveDatagrams();
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    float elapsed = std::chrono::duration<float>(now - lastStats).count();
+    if (elapsed >= 10.f)
+    {
+      printStats(elapsed);
+      lastStats = now;
+    }
+  }
+}
+
+void TankServer::stop()
+{
+  for (auto &shard : m_shards)
+  {
+    shard->stop();
+  }
+}
+
+void TankServer::acceptConnections()
+{
+  while (true)
+  {
+    sockaddr_in peer{};
+    socklen_t peerLen = sizeof(peer);
+    int fd = accept4(m_listenFd, reinterpret_cast<sockaddr *>(&peer), &peerLen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      if (errno != EAGAIN && errno != EWOULDBLOCK)
+        std::cerr << "[Server] accept failed: " << std::strerror(errno) << std::endl;
+      return;
+    }
+
+    // 小包实时转发，关闭 Nagle
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    auto conn = std::make_unique<ServerConnection>();
+    conn->fd = fd;
+
+    char ip[INET_ADDRSTRLEN] = {};
+    inet_ntop(AF_INET, &peer.sin_addr, ip, sizeof(ip));
+    conn->ip = ip;
+
+    // 新连接轮询分配；创建/加入房间后按房间码归属分片
+    int shard = m_nextShard;
+    m_nextShard = (m_nextShard + 1) % shardCount();
+    conn->sessionId = registerSession(shard);
+
+    if (m_verbose)
+      std::cout << "[Server] Client connected from " << conn->ip << " (session " << conn->sessionId << ")" << std::endl;
+
+    ShardEvent event;
+    event.type = ShardEventType::Adopt;
+    event.conn = std::move(conn);
+    postToShard(shard, std::move(event));
+  }
+}
+
+void TankServer::receiveDatagrams()
+{
+  uint8_t buffer[NET_MAX_FRAME_PAYLOAD];
+
+  while (true)
+  {
+    sockaddr_in from{};
+    socklen_t fromLen = sizeof(from);
+    ssize_t n = recvfrom(m_udpFd, buffer, sizeof(buffer), 0, reinterpret_cast<sockaddr *>(&from), &fromLen);
+    if (n < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      return;
+    }
+    if (static_cast<std::size_t>(n) < NET_DATAGRAM_HEADER_SIZE)
+      continue;
+
+    const uint64_t endpoint = (static_cast<uint64_t>(from.sin_addr.s_addr) << 16) | from.sin_port;
+    const auto msgType = static_cast<NetMessageType>(buffer[0]);
+
+    if (msgType == NetMessageType::UdpHello)
+    {
+      // 握手：绑定会话与 UDP 端点，由所属分片回复确认
+      uint32_t sessionId = buffer[1] | (buffer[2] << 8) | (buffer[3] << 16) | (static_cast<uint32_t>(buffer[4]) << 24);
+      int shard = bindUdpEndpoint(endpoint, sessionId);
+      if (shard < 0)
+        continue;
+
+      ShardEvent event;
+      event.type = ShardEventType::UdpBind;
+      event.sessionId = sessionId;
+      event.addr = from;
+      event.data.assign(buffer, buffer + n);
+      postToShard(shard, std::move(event));
+      continue;
+    }
+
+    if (msgType != NetMessageType::PlayerUpdate && msgType != NetMessageType::PlayerShoot &&
+        msgType != NetMessageType::NpcUpdate && msgType != NetMessageType::NpcShoot &&
+        msgType != NetMessageType::PlayerInput)
+      continue;
+
+    uint32_t sessionId = 0;
+    int shard = findEndpointShard(endpoint, sessionId);
+    if (shard < 0)
+      continue;
+
+    ShardEvent event;
+    event.type = ShardEventType::Datagram;
+    event.sessionId = sessionId;
+    event.data.assign(buffer, buffer + n);
+    postToShard(shard, std::move(event));
+  }
+}
+
+void TankServer::postToShard(int shard, ShardEvent &&event)
+{
+  m_shards[shard]->post(std::move(event));
+}
+
+void TankServer::setSessionShard(uint32_t sessionId, int shard)
+{
+  std::lock_guard<std::mutex> lock(m_sessionMutex);
+  m_sessionShards[sessionId] = shard;
+}
+
+void TankServer::removeSession(uint32_t sessionId)
+{
+  std::lock_guard<std::mutex> lock(m_sessionMutex);
+  m_sessionShards.erase(sessionId);
+  auto it = m_sessionEndpoints.find(sessionId);
+  if (it != m_sessionEndpoints.end())
+  {
+    m_udpEndpoints.erase(it->second);
+    m_sessionEndpoints.erase(it);
+  }
+}
+
+uint32_t TankServer::registerSession(int shard)
+{
+  std::lock_guard<std::mutex> lock(m_sessionMutex);
+  uint32_t sessionId = 0;
+  while (sessionId == 0 || m_sessionShards.count(sessionId))
+    sessionId = static_cast<uint32_t>(m_sessionIdSource());
+  m_sessionShards[sessionId] = shard;
+  return sessionId;
+}
+
+int TankServer::bindUdpEndpoint(uint64_t endpoint, uint32_t sessionId)
+{
+  std::lock_guard<std::mutex> lock(m_sessionMutex);
+  auto shard = m_sessionShards.find(sessionId);
+  if (shard == m_sessionShards.end())
+    return -1;
+
+  // 会话换了端点（NAT 重映射）或端点换了会话：先解除旧的绑定
+  auto oldEndpoint = m_sessionEndpoints.find(sessionId);
+  if (oldEndpoint != m_sessionEndpoints.end() && oldEndpoint->second != endpoint)
+    m_udpEndpoints.erase(oldEndpoint->second);
+  auto oldSession = m_udpEndpoints.find(endpoint);
+  if (oldSession != m_udpEndpoints.end() && oldSession->second != sessionId)
+    m_sessionEndpoints.erase(oldSession->second);
+
+  m_udpEndpoints[endpoint] = sessionId;
+  m_sessionEndpoints[sessionId] = endpoint;
+  return shard->second;
+}
+
+int TankServer::findEndpointShard(uint64_t endpoint, uint32_t &sessionId)
+{
+  std::lock_guard<std::mutex> lock(m_sessionMutex);
+  auto it = m_udpEndpoints.find(endpoint);
+  if (it == m_udpEndpoints.end())
+    return -1;
+  auto shard = m_sessionShards.find(it->second);
+  if (shard == m_sessionShards.end())
+    return -1;
+  sessionId = it->second;
+  return shard->second;
+}
+
+void TankServer::printStats(float elapsed)
+{
+  int connections = 0;
+  int rooms = 0;
+  uint64_t framesIn = 0;
+  uint64_t framesOut = 0;
+  uint64_t datagrams = 0;
+  for (auto &shard : m_shards)
+  {
+    connections += shard->connectionCount;
+    rooms += shard->roomCount;
+    framesIn += shard->framesIn;
+    framesOut += shard->framesOut;
+    datagrams += shard->datagramsRelayed;
+  }
+
+  if (connections == 0 && framesIn == m_lastFramesIn)
+    return;
+
+  std::cout << "[Server] connections=" << connections << " rooms=" << rooms
+            << " in=" << static_cast<int>((framesIn - m_lastFramesIn) / elapsed) << "/s"
+            << " out=" << static_cast<int>((framesOut - m_lastFramesOut) / elapsed) << "/s"
+            << " udpRelayed=" << datagrams << std::endl;
+  m_lastFramesIn = framesIn;
+  m_lastFramesOut = framesOut;
+}
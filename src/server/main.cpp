@@ -0,0 +1,71 @@
+#include "TankServer.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+
+namespace
+{
+  std::atomic<bool> s_stopRequested{false};
+
+  void handleSignal(int)
+  {
+    s_stopRequested = true;
+  }
+
+  // 整个参数必须是 [minValue, maxValue] 内的整数，否则按用法错误处理
+  bool parseInt(const char *text, long minValue, long maxValue, int &value)
+  {
+    char *end = nullptr;
+    errno = 0;
+    long parsed = std::strtol(text, &end, 10);
+    if (end == text || *end != '\0' || errno == ERANGE || parsed < minValue || parsed > maxValue)
+      return false;
+    value = static_cast<int>(parsed);
+    return true;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  unsigned short port = 9999;
+  int threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+  bool verbose = false;
+
+  for (int i = 1; i < argc; i++)
+  {
+    std::string arg = argv[i];
+    int portValue = 0;
+    if (arg == "--port" && i + 1 < argc && parseInt(argv[i + 1], 1, 65535, portValue))
+    {
+      port = static_cast<unsigned short>(portValue);
+      i++;
+    }
+    else if (arg == "--threads" && i + 1 < argc && parseInt(argv[i + 1], 1, 64, threads))
+      i++;
+    else if (arg == "--verbose")
+      verbose = true;
+    else
+    {
+      std::cout << "Usage: tank_server [--port 1-65535] [--threads 1-64] [--verbose]" << std::endl;
+      return arg == "--help" ? 0 : 1;
+    }
+  }
+
+  std::signal(SIGINT, handleSignal);
+  std::signal(SIGTERM, handleSignal);
+  std::signal(SIGPIPE, SIG_IGN);
+
+  TankServer server(port, threads, verbose);
+  if (!server.start())
+    return 1;
+
+  server.run(s_stopRequested);
+  server.stop();
+  std::cout << "[Server] Stopped" << std::endl;
+  return 0;
+}
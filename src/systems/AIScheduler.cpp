@@ -0,0 +1,75 @@
+#include "AIScheduler.hpp"
+#include <algorithm>
+
+void AIScheduler::beginFrame(const std::vector<sf::Vector2f> &focus)
+{
+  m_focus = focus;
+  m_frame++;
+  m_spentMs = 0.0;
+}
+
+int AIScheduler::periodFor(sf::Vector2f position) const
+{
+  if (m_focus.empty())
+    return 1;
+
+  float closest = -1.f;
+  for (const auto &focus : m_focus)
+  {
+    float dx = focus.x - position.x;
+    float dy = focus.y - position.y;
+    float dist2 = dx * dx + dy * dy;
+    if (closest < 0.f || dist2 < closest)
+      closest = dist2;
+  }
+
+  if (closest < NEAR_DISTANCE * NEAR_DISTANCE)
+    return 1;
+  if (closest < MID_DISTANCE * MID_DISTANCE)
+    return MID_PERIOD;
+  return FAR_PERIOD;
+}
+
+bool AIScheduler::shouldThink(std::size_t index, sf::Vector2f position)
+{
+  if (index >= m_staleFrames.size())
+    m_staleFrames.resize(index + 1, 0);
+  int &stale = m_staleFrames[index];
+
+  // 近处每帧思考，不受预算限制
+  int period = periodFor(position);
+  bool think = period == 1;
+  if (!think)
+  {
+    // 轮转分桶：下标错开，同一级别的 NPC 均匀分布到各帧
+    bool due = (index + m_frame) % static_cast<uint64_t>(period) == 0 || stale >= period;
+    if (!due)
+    {
+      m_stats.skipped++;
+    }
+    else if (m_spentMs >= m_budgetMs && stale < MAX_STALE_FRAMES)
+    {
+      m_stats.deferred++;
+    }
+    else
+    {
+      think = true;
+    }
+  }
+
+  if (think)
+  {
+    stale = 0;
+    m_stats.thinks++;
+  }
+  else
+  {
+    stale++;
+  }
+  return think;
+}
+
+void AIScheduler::endThink(std::chrono::steady_clock::time_point start)
+{
+  m_spentMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
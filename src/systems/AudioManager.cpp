@@ -3,6 +3,16 @@
 #include <algorithm>
 #include <iostream>
 
+namespace
+{
+  bool isNear(sf::Vector2f a, sf::Vector2f b, float radius)
+  {
+    float dx = a.x - b.x;
+    float dy = a.y - b.y;
+    return dx * dx + dy * dy <= radius * radius;
+  }
+}
+
 AudioManager &AudioManager::getInstance()
 {
   static AudioManager instance;
@@ -10,12 +20,52 @@ AudioManager &AudioManager::getInstance()
 }
 
 bool AudioManager::init(const std::string &assetPath)
+{
+  initAsync(assetPath).wait();
+  return pollLoader();
+}
+
+std::shared_future<bool> AudioManager::initAsync(const std::string &assetPath)
+{
+  if (!m_loader.valid())
+  {
+    std::cout << "[Audio] Loading audio assets in background..." << std::endl;
+    m_loadClock.restart();
+    m_loader = std::async(std::launch::async, &AudioManager::loadAssets, this, assetPath).share();
+  }
+  return m_loader;
+}
+
+bool AudioManager::pollLoader()
 {
   if (m_initialized)
     return true;
+  if (m_loadFailed || !m_loader.valid() ||
+      m_loader.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    return false;
 
-  std::cout << "[Audio] Initializing audio system..." << std::endl;
+  if (!m_loader.get())
+  {
+    m_loadFailed = true;
+    std::cerr << "[Audio] Audio assets failed to load, running without sound" << std::endl;
+    return false;
+  }
 
+  m_initialized = true;
+  std::cout << "[Audio] Audio system ready after " << m_loadClock.getElapsedTime().asMilliseconds() << " ms"
+            << std::endl;
+
+  if (m_pendingBGM)
+  {
+    BGMType type = *m_pendingBGM;
+    m_pendingBGM.reset();
+    playBGM(type);
+  }
+  return true;
+}
+
+bool AudioManager::loadAssets(const std::string &assetPath)
+{
   // 加载背景音乐
   if (!m_bgmMenu.openFromFile(assetPath + "menu.mp3"))
   {
@@ -111,13 +161,19 @@ bool AudioManager::init(const std::string &assetPath)
   }
   m_sfxBuffers[SFXType::MenuConfirm] = buffer;
 
-  m_initialized = true;
-  std::cout << "[Audio] Audio system initialized successfully" << std::endl;
   return true;
 }
 
 void AudioManager::playBGM(BGMType type)
 {
+  // 资源还在加载：记下请求，就绪后再播放
+  if (!m_initialized)
+  {
+    m_pendingBGM = type;
+    m_currentBGM = type;
+    return;
+  }
+
   // 如果已经在播放相同的BGM，不做任何事
   if (m_currentBGMPlayer != nullptr && m_currentBGM == type)
   {
@@ -156,6 +212,7 @@ void AudioManager::playBGM(BGMType type)
 
 void AudioManager::stopBGM()
 {
+  m_pendingBGM.reset();
   if (m_currentBGMPlayer)
   {
     m_currentBGMPlayer->stop();
@@ -186,40 +243,194 @@ float AudioManager::calculateVolume(sf::Vector2f soundPos, sf::Vector2f listener
   return m_sfxVolume * volumeRatio;
 }
 
-void AudioManager::playSFX(SFXType type, sf::Vector2f soundPos, sf::Vector2f listenerPos)
+int AudioManager::voiceLimit(SFXType type)
 {
-  float volume = calculateVolume(soundPos, listenerPos);
+  switch (type)
+  {
+  case SFXType::Shoot:
+    return 8;
+  case SFXType::BulletHitWall:
+  case SFXType::BulletHitTank:
+    return 6;
+  case SFXType::Explode:
+  case SFXType::WallBroken:
+    return 4;
+  case SFXType::CollectCoins:
+  case SFXType::Bingo:
+    return 3;
+  case SFXType::MenuSelect:
+  case SFXType::MenuConfirm:
+    return 2;
+  }
+  return 4;
+}
 
-  if (volume <= 0.f)
-    return; // 超出听音范围，不播放
+bool AudioManager::isVoiceBusy(const Voice &voice) const
+{
+  return voice.sound && voice.sound->getStatus() != sf::Sound::Status::Stopped;
+}
 
+float AudioManager::voicePriority(const Voice &voice) const
+{
+  float duration = voice.sound->getBuffer().getDuration().asSeconds();
+  if (duration <= 0.f)
+    return voice.priority;
+  float progress = std::clamp(voice.sound->getPlayingOffset().asSeconds() / duration, 0.f, 1.f);
+  return voice.priority * (1.f - progress);
+}
+
+void AudioManager::playVoice(const SFXEvent &event)
+{
+  SFXType type = event.type;
+  float volume = event.volume;
   auto it = m_sfxBuffers.find(type);
   if (it == m_sfxBuffers.end())
     return;
 
-  // 创建新的Sound实例
-  auto sound = std::make_unique<sf::Sound>(it->second);
-  sound->setVolume(volume);
-  sound->play();
+  // 统计同类语音，同时找出同类与全局优先级最低的语音
+  Voice *freeVoice = nullptr;
+  Voice *weakestSameType = nullptr;
+  Voice *weakest = nullptr;
+  float weakestSameTypePriority = 0.f;
+  float weakestPriority = 0.f;
+  int sameTypeCount = 0;
+  for (auto &voice : m_voices)
+  {
+    if (!isVoiceBusy(voice))
+    {
+      if (!freeVoice)
+        freeVoice = &voice;
+      continue;
+    }
+
+    float priority = voicePriority(voice);
+    if (!weakest || priority < weakestPriority)
+    {
+      weakest = &voice;
+      weakestPriority = priority;
+    }
+    if (voice.type == type)
+    {
+      sameTypeCount++;
+      if (!weakestSameType || priority < weakestSameTypePriority)
+      {
+        weakestSameType = &voice;
+        weakestSameTypePriority = priority;
+      }
+    }
+  }
+
+  Voice *target = freeVoice;
+  if (sameTypeCount >= voiceLimit(type))
+  {
+    target = weakestSameTypePriority < volume ? weakestSameType : nullptr;
+  }
+  else if (!target)
+  {
+    target = weakestPriority < volume ? weakest : nullptr;
+  }
+
+  if (!target)
+  {
+    m_sfxStats.dropped++;
+    return;
+  }
+  if (isVoiceBusy(*target))
+  {
+    target->sound->stop();
+    m_sfxStats.stolen++;
+  }
 
-  m_activeSounds.push_back(std::move(sound));
+  if (target->sound)
+    target->sound->setBuffer(it->second);
+  else
+    target->sound.emplace(it->second);
+  target->type = type;
+  target->priority = volume;
+  target->position = event.position;
+  target->positional = event.positional;
+  target->startTime = m_audioClock.getElapsedTime().asSeconds();
+  target->sound->setVolume(volume);
+  target->sound->play();
+  m_sfxStats.played++;
 }
 
-void AudioManager::playSFXGlobal(SFXType type)
+float AudioManager::combineVolume(float a, float b) const
 {
-  auto it = m_sfxBuffers.find(type);
-  if (it == m_sfxBuffers.end())
+  return std::min(std::sqrt(a * a + b * b), std::max({a, b, m_sfxVolume}));
+}
+
+void AudioManager::queueSFX(SFXType type, sf::Vector2f position, bool positional, float volume)
+{
+  // 未就绪（后台加载中、加载失败或服务器模拟）时直接丢弃
+  if (!m_initialized)
     return;
 
-  auto sound = std::make_unique<sf::Sound>(it->second);
-  sound->setVolume(m_sfxVolume);
-  sound->play();
+  // 同帧内同类且相近的请求合并（位置取较响的一个）
+  for (auto &event : m_sfxQueue)
+  {
+    if (event.type != type || event.positional != positional ||
+        (positional && !isNear(event.position, position, MERGE_RADIUS)))
+      continue;
+    if (volume > event.volume)
+      event.position = position;
+    event.volume = combineVolume(event.volume, volume);
+    m_sfxStats.merged++;
+    return;
+  }
+  m_sfxQueue.push_back({type, position, positional, volume});
+}
 
-  m_activeSounds.push_back(std::move(sound));
+void AudioManager::flushSFXQueue()
+{
+  float now = m_audioClock.getElapsedTime().asSeconds();
+  for (const auto &event : m_sfxQueue)
+  {
+    // 同类语音刚开始播放且位置相近：加大它的音量，不再叠加一个新语音
+    Voice *recent = nullptr;
+    for (auto &voice : m_voices)
+    {
+      if (voice.type == event.type && voice.positional == event.positional && isVoiceBusy(voice) &&
+          now - voice.startTime < MERGE_WINDOW &&
+          (!event.positional || isNear(voice.position, event.position, MERGE_RADIUS)))
+      {
+        recent = &voice;
+        break;
+      }
+    }
+
+    if (recent)
+    {
+      recent->priority = combineVolume(recent->priority, event.volume);
+      recent->sound->setVolume(recent->priority);
+      m_sfxStats.merged++;
+      continue;
+    }
+    playVoice(event);
+  }
+  m_sfxQueue.clear();
+}
+
+void AudioManager::playSFX(SFXType type, sf::Vector2f soundPos, sf::Vector2f listenerPos)
+{
+  float volume = calculateVolume(soundPos, listenerPos);
+
+  if (volume <= 0.f)
+    return; // 超出听音范围，不播放
+
+  queueSFX(type, soundPos, true, volume);
+}
+
+void AudioManager::playSFXGlobal(SFXType type)
+{
+  queueSFX(type, {}, false, m_sfxVolume);
 }
 
 void AudioManager::playLoopSFX(SFXType type)
 {
+  if (!m_initialized)
+    return;
+
   // 如果已经在播放，不重复创建
   auto it = m_loopSounds.find(type);
   if (it != m_loopSounds.end() && it->second->getStatus() == sf::Sound::Status::Playing)
@@ -262,6 +473,9 @@ void AudioManager::setSFXVolume(float volume)
 
 void AudioManager::update()
 {
+  if (!pollLoader())
+    return;
+
   // 检查 start BGM 是否播放完毕，自动切换到 middle
   if (m_currentBGM == BGMType::Start && m_currentBGMPlayer != nullptr)
   {
@@ -271,24 +485,25 @@ void AudioManager::update()
     }
   }
 
-  // 清理已播放完的音效
-  m_activeSounds.erase(
-      std::remove_if(m_activeSounds.begin(), m_activeSounds.end(),
-                     [](const std::unique_ptr<sf::Sound> &sound)
-                     {
-                       return sound->getStatus() == sf::Sound::Status::Stopped;
-                     }),
-      m_activeSounds.end());
+  flushSFXQueue();
 }
 
 void AudioManager::stopAllSFX()
 {
-  // 停止并清空所有活跃音效
-  for (auto &sound : m_activeSounds)
+  // 丢弃未播放的请求，停止语音池中的所有音效（语音本身保留复用）
+  m_sfxQueue.clear();
+  for (auto &voice : m_voices)
   {
-    sound->stop();
+    if (voice.sound)
+      voice.sound->stop();
+  }
+
+  if (m_sfxStats.dropped > 0 || m_sfxStats.stolen > 0 || m_sfxStats.merged > 0)
+  {
+    std::cout << "[Audio] SFX voices: played=" << m_sfxStats.played << " merged=" << m_sfxStats.merged
+              << " dropped=" << m_sfxStats.dropped << " stolen=" << m_sfxStats.stolen << std::endl;
   }
-  m_activeSounds.clear();
+  m_sfxStats = SFXStats();
 
   // 停止所有循环音效
   for (auto &[type, sound] : m_loopSounds)
@@ -305,11 +520,11 @@ void AudioManager::pauseAll()
     m_currentBGMPlayer->pause();
   }
 
-  for (auto &sound : m_activeSounds)
+  for (auto &voice : m_voices)
   {
-    if (sound->getStatus() == sf::Sound::Status::Playing)
+    if (voice.sound && voice.sound->getStatus() == sf::Sound::Status::Playing)
     {
-      sound->pause();
+      voice.sound->pause();
     }
   }
 }
@@ -321,11 +536,11 @@ void AudioManager::resumeAll()
     m_currentBGMPlayer->play();
   }
 
-  for (auto &sound : m_activeSounds)
+  for (auto &voice : m_voices)
   {
-    if (sound->getStatus() == sf::Sound::Status::Paused)
+    if (voice.sound && voice.sound->getStatus() == sf::Sound::Status::Paused)
     {
-      sound->play();
+      voice.sound->play();
     }
   }
 }
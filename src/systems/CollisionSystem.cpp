@@ -2,6 +2,7 @@
 #include "AudioManager.hpp"
 #include <cmath>
 #include <algorithm>
+#include <utility>
 
 bool CollisionSystem::checkBulletWallCollision(Bullet *bullet, Maze &maze)
 {
@@ -64,6 +65,36 @@ bool CollisionSystem::checkBulletNpcCollision(Bullet *bullet, Enemy *npc, float
   return dist < npc->getCollisionRadius() + extraRadius;
 }
 
+bool CollisionSystem::bulletCanHitTank(const Bullet &bullet, const Tank &tank, BulletOwner tankBullets)
+{
+  // 自己的子弹不伤自己；team=0（中立 NPC）的子弹攻击所有玩家，其余只攻击不同阵营
+  if (tank.isDead() || bullet.getOwner() == tankBullets)
+    return false;
+  int bulletTeam = bullet.getTeam();
+  return bulletTeam == 0 || bulletTeam != tank.getTeam();
+}
+
+bool CollisionSystem::bulletCanHitNpc(const Bullet &bullet, const Enemy &npc)
+{
+  if (!npc.isActivated() || npc.isDead())
+    return false;
+
+  int bulletTeam = bullet.getTeam();
+  int npcTeam = npc.getTeam();
+  if (bullet.getOwner() != BulletOwner::Enemy)
+  {
+    // 玩家子弹：可以打不同阵营的 NPC，或者 team=0 的 NPC（Escape 模式敌人）
+    return npcTeam != bulletTeam || npcTeam == 0;
+  }
+  if (bulletTeam == 0)
+  {
+    // NPC (team=0) 的子弹：可以打玩家阵营的 NPC
+    return npcTeam != 0;
+  }
+  // 其他阵营 NPC 的子弹：可以打不同阵营的 NPC
+  return bulletTeam != npcTeam;
+}
+
 void CollisionSystem::checkSinglePlayerCollisions(
     Tank *player,
     std::vector<std::unique_ptr<Enemy>> &enemies,
@@ -151,12 +182,12 @@ void CollisionSystem::checkMultiplayerCollisions(
     std::vector<std::unique_ptr<Enemy>> &enemies,
     std::vector<std::unique_ptr<Bullet>> &bullets,
     Maze &maze,
-    bool isHost)
+    bool isHost,
+    bool ownsPlayerDamage)
 {
   if (!player || !otherPlayer)
     return;
 
-  int localTeam = player->getTeam();
   sf::Vector2f listenerPos = player->getPosition();
 
   for (auto &bullet : bullets)
@@ -165,7 +196,6 @@ void CollisionSystem::checkMultiplayerCollisions(
       continue;
 
     sf::Vector2f bulletPos = bullet->getPosition();
-    int bulletTeam = bullet->getTeam();
 
     // 墙壁碰撞检测：只有房主处理伤害和同步
     // 非房主只检测是否击中（用于播放音效和销毁子弹），不处理墙壁伤害
@@ -188,8 +218,8 @@ void CollisionSystem::checkMultiplayerCollisions(
         int destroyerId = (owner == BulletOwner::Player) ? 0 : (owner == BulletOwner::OtherPlayer) ? 1
                                                                                                    : -1;
 
-        // 同步墙壁伤害给非房主（包含摧毁者ID）
-        NetworkManager::getInstance().sendWallDamage(
+        // 同步墙壁伤害给非房主（包含摧毁者ID），本帧内同一格子的命中合并发送
+        NetworkManager::getInstance().queueWallDamage(
             wallResult.gridY, wallResult.gridX,
             bullet->getDamage(),
             wallResult.destroyed,
@@ -233,15 +263,14 @@ void CollisionSystem::checkMultiplayerCollisions(
     // 判断子弹是否是本地玩家发射的
     bool isLocalPlayerBullet = bullet->getOwner() == BulletOwner::Player;
 
-    // 检查与本地玩家的碰撞（跳过已死亡的玩家）
-    bool canHitLocalPlayer = !player->isDead() &&
-                             !isLocalPlayerBullet &&
-                             (bulletTeam == 0 || bulletTeam != localTeam);
-    if (canHitLocalPlayer)
+    // 检查与本地玩家的碰撞（阵营规则见 bulletCanHitTank）
+    if (bulletCanHitTank(*bullet, *player, BulletOwner::Player))
     {
       if (checkBulletTankCollision(bullet.get(), player))
       {
-        player->takeDamage(bullet->getDamage());
+        // 服务器权威模拟时血量由服务器快照同步，这里只播放音效并销毁子弹
+        if (ownsPlayerDamage)
+          player->takeDamage(bullet->getDamage());
         // 播放子弹击中坦克音效
         AudioManager::getInstance().playSFX(SFXType::BulletHitTank, bulletPos, listenerPos);
 
@@ -255,31 +284,8 @@ void CollisionSystem::checkMultiplayerCollisions(
       }
     }
 
-    // 检查与对方玩家的碰撞（跳过已死亡的玩家）
-    // 只有当本地玩家和对方玩家是敌对关系时才能击中
-    int otherTeam = otherPlayer->getTeam();
-    bool canHitOtherPlayer = false;
-
-    // 跳过已死亡的玩家
-    if (otherPlayer->isDead())
-    {
-      canHitOtherPlayer = false;
-    }
-    else if (isLocalPlayerBullet)
-    {
-      // 本地玩家的子弹：只有当对方是敌人（不同阵营）时才能击中
-      // Escape 模式下双方都是 team=1，不能互相伤害
-      canHitOtherPlayer = (localTeam != otherTeam);
-    }
-    else
-    {
-      // NPC子弹（bulletTeam）：
-      // team=0 的 NPC 可以攻击任何玩家
-      // 其他阵营的 NPC 可以攻击不同阵营的玩家
-      canHitOtherPlayer = (bulletTeam == 0) || (bulletTeam != otherTeam);
-    }
-
-    if (canHitOtherPlayer)
+    // 检查与对方玩家的碰撞：伤害由对方判定，这里只销毁子弹
+    if (bulletCanHitTank(*bullet, *otherPlayer, BulletOwner::OtherPlayer))
     {
       if (checkBulletTankCollision(bullet.get(), otherPlayer))
       {
@@ -291,34 +297,10 @@ void CollisionSystem::checkMultiplayerCollisions(
     }
 
     // 检查与NPC的碰撞
+    bool isNpcBullet = (bullet->getOwner() == BulletOwner::Enemy);
     for (auto &npc : enemies)
     {
-      if (!npc->isActivated() || npc->isDead())
-        continue;
-
-      int npcTeam = npc->getTeam();
-
-      // 判断子弹是否能击中这个NPC
-      bool canHitNpc = false;
-      bool isNpcBullet = (bullet->getOwner() == BulletOwner::Enemy);
-
-      if (isLocalPlayerBullet)
-      {
-        // 玩家子弹：可以打不同阵营的 NPC，或者 team=0 的 NPC（Escape 模式敌人）
-        canHitNpc = (npcTeam != localTeam) || (npcTeam == 0);
-      }
-      else if (bulletTeam == 0)
-      {
-        // NPC (team=0) 的子弹：可以打玩家阵营的 NPC
-        canHitNpc = (npcTeam != 0);
-      }
-      else
-      {
-        // 其他阵营 NPC 的子弹：可以打不同阵营的 NPC
-        canHitNpc = (bulletTeam != npcTeam);
-      }
-
-      if (canHitNpc)
+      if (bulletCanHitNpc(*bullet, *npc))
       {
         if (checkBulletNpcCollision(bullet.get(), npc.get()))
         {
@@ -373,3 +355,142 @@ void CollisionSystem::checkMultiplayerCollisions(
                      { return !b->isAlive(); }),
       bullets.end());
 }
+
+void CollisionSystem::checkServerCollisions(
+    Tank *hostPlayer,
+    Tank *guestPlayer,
+    std::vector<std::unique_ptr<Enemy>> &enemies,
+    std::vector<std::unique_ptr<Bullet>> &bullets,
+    Maze &maze,
+    const std::function<void(const WallDestroyResult &, const Bullet &)> &onWallHit,
+    const std::function<void(Enemy &, float damage)> &onNpcDamage)
+{
+  for (auto &bullet : bullets)
+  {
+    if (!bullet->isAlive())
+      continue;
+
+    // 墙壁碰撞
+    WallDestroyResult wallResult = checkBulletWallCollisionWithResult(bullet.get(), maze);
+    if (wallResult.position.x != 0 || wallResult.position.y != 0 || wallResult.destroyed)
+    {
+      onWallHit(wallResult, *bullet);
+      bullet->setInactive();
+      continue;
+    }
+
+    // 玩家碰撞：服务器结算伤害，血量随 PlayerSnapshot 下发
+    bool hitPlayer = false;
+    const std::pair<Tank *, BulletOwner> tanks[] = {{hostPlayer, BulletOwner::Player}, {guestPlayer, BulletOwner::OtherPlayer}};
+    for (auto [tank, tankBullets] : tanks)
+    {
+      if (tank && bulletCanHitTank(*bullet, *tank, tankBullets) && checkBulletTankCollision(bullet.get(), tank))
+      {
+        tank->takeDamage(bullet->getDamage());
+        hitPlayer = true;
+        break;
+      }
+    }
+    if (hitPlayer)
+    {
+      bullet->setInactive();
+      continue;
+    }
+
+    // NPC 碰撞
+    for (auto &npc : enemies)
+    {
+      if (bulletCanHitNpc(*bullet, *npc) && checkBulletNpcCollision(bullet.get(), npc.get()))
+      {
+        npc->takeDamage(bullet->getDamage());
+        onNpcDamage(*npc, bullet->getDamage());
+        bullet->setInactive();
+        break;
+      }
+    }
+  }
+
+  // 删除无效子弹
+  bullets.erase(
+      std::remove_if(bullets.begin(), bullets.end(),
+                     [](const std::unique_ptr<Bullet> &b)
+                     { return !b->isAlive(); }),
+      bullets.end());
+}
+
+void CollisionSystem::checkLockstepCollisions(
+    Tank *hostPlayer,
+    Tank *guestPlayer,
+    std::vector<std::unique_ptr<Enemy>> &enemies,
+    std::vector<std::unique_ptr<Bullet>> &bullets,
+    Maze &maze,
+    const Tank *listener)
+{
+  sf::Vector2f listenerPos = listener ? listener->getPosition() : sf::Vector2f{};
+
+  for (auto &bullet : bullets)
+  {
+    if (!bullet->isAlive())
+      continue;
+
+    sf::Vector2f bulletPos = bullet->getPosition();
+    BulletOwner owner = bullet->getOwner();
+
+    // 墙壁碰撞：墙被打掉时增益给开枪的玩家（NPC 打掉的墙不给奖励）
+    WallDestroyResult wallResult = checkBulletWallCollisionWithResult(bullet.get(), maze);
+    if (wallResult.position.x != 0 || wallResult.position.y != 0 || wallResult.destroyed)
+    {
+      AudioManager::getInstance().playSFX(SFXType::BulletHitWall, bulletPos, listenerPos);
+      if (wallResult.destroyed)
+      {
+        Tank *shooter = (owner == BulletOwner::Player) ? hostPlayer : (owner == BulletOwner::OtherPlayer) ? guestPlayer
+                                                                                                          : nullptr;
+        handleWallDestroyEffect(wallResult, shooter, maze);
+      }
+      bullet->setInactive();
+      continue;
+    }
+
+    // 玩家碰撞（阵营规则与其他联机路径共用，这里同时结算伤害）
+    bool hitPlayer = false;
+    const std::pair<Tank *, BulletOwner> tanks[] = {{hostPlayer, BulletOwner::Player}, {guestPlayer, BulletOwner::OtherPlayer}};
+    for (auto [tank, tankBullets] : tanks)
+    {
+      if (tank && bulletCanHitTank(*bullet, *tank, tankBullets) && checkBulletTankCollision(bullet.get(), tank))
+      {
+        tank->takeDamage(bullet->getDamage());
+        AudioManager::getInstance().playSFX(SFXType::BulletHitTank, bulletPos, listenerPos);
+        if (tank->isDead())
+          AudioManager::getInstance().playSFX(SFXType::Explode, tank->getPosition(), listenerPos);
+        hitPlayer = true;
+        break;
+      }
+    }
+    if (hitPlayer)
+    {
+      bullet->setInactive();
+      continue;
+    }
+
+    // NPC 碰撞
+    for (auto &npc : enemies)
+    {
+      if (bulletCanHitNpc(*bullet, *npc) && checkBulletNpcCollision(bullet.get(), npc.get()))
+      {
+        npc->takeDamage(bullet->getDamage());
+        AudioManager::getInstance().playSFX(SFXType::BulletHitTank, bulletPos, listenerPos);
+        if (npc->isDead())
+          AudioManager::getInstance().playSFX(SFXType::Explode, npc->getPosition(), listenerPos);
+        bullet->setInactive();
+        break;
+      }
+    }
+  }
+
+  // 删除无效子弹
+  bullets.erase(
+      std::remove_if(bullets.begin(), bullets.end(),
+                     [](const std::unique_ptr<Bullet> &b)
+                     { return !b->isAlive(); }),
+      bullets.end());
+}
@@ -0,0 +1,269 @@
+#include "CrowdSteering.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+  // 网格最大边长（格数），超出的个体压到边缘格（只影响查询速度，不影响结果）
+  constexpr int MAX_GRID_SIDE = 1024;
+
+  // 速度障碍的候选方向：相对期望方向的旋转角（弧度）
+  constexpr float CANDIDATE_ANGLES[] = {0.35f, -0.35f, 0.79f, -0.79f, 1.22f, -1.22f, 1.75f, -1.75f};
+
+  // 分离力增益：完全重合时的推开速度为 maxSpeed 的这么多倍（之后再截断到 maxSpeed）
+  constexpr float SEPARATION_GAIN = 2.f;
+
+  // 碰撞惩罚权重：越大越倾向于绕开，越小越倾向于保持期望速度
+  constexpr float AVOID_WEIGHT = 1.f;
+
+  // 以 relVx/relVy 相对运动时两圆首次接触的时间；不会接触返回 horizon
+  float timeToCollision(float px, float py, float relVx, float relVy, float reach, float horizon)
+  {
+    // p 为自身指向邻居的相对位置
+    float b = px * relVx + py * relVy; // 接近速度 * |p|
+    float c = px * px + py * py - reach * reach;
+    if (c < 0.f)
+      return b > 0.f ? 0.f : horizon; // 已经重叠：继续靠近立即算碰撞，远离则不惩罚
+    if (b <= 0.f)
+      return horizon;
+
+    float a = relVx * relVx + relVy * relVy;
+    float disc = b * b - a * c;
+    if (disc < 0.f)
+      return horizon;
+    float t = (b - std::sqrt(disc)) / a;
+    return std::min(t, horizon);
+  }
+}
+
+int CrowdSteering::cellIndex(float x, float y) const
+{
+  int col = std::clamp(static_cast<int>((x - m_originX) / NEIGHBOR_RANGE), 0, m_cols - 1);
+  int row = std::clamp(static_cast<int>((y - m_originY) / NEIGHBOR_RANGE), 0, m_rows - 1);
+  return row * m_cols + col;
+}
+
+void CrowdSteering::build()
+{
+  // 网格范围取本帧所有个体的包围盒
+  float minX = 0.f, minY = 0.f, maxX = 0.f, maxY = 0.f;
+  bool any = false;
+  for (const auto &agent : m_agents)
+  {
+    if (agent.radius <= 0.f)
+      continue;
+    if (!any)
+    {
+      minX = maxX = agent.x;
+      minY = maxY = agent.y;
+      any = true;
+      continue;
+    }
+    minX = std::min(minX, agent.x);
+    maxX = std::max(maxX, agent.x);
+    minY = std::min(minY, agent.y);
+    maxY = std::max(maxY, agent.y);
+  }
+
+  m_sorted.clear();
+  if (!any)
+  {
+    m_cols = m_rows = 0;
+    m_cellStart.clear();
+    return;
+  }
+
+  m_originX = minX;
+  m_originY = minY;
+  m_cols = std::min(MAX_GRID_SIDE, static_cast<int>((maxX - minX) / NEIGHBOR_RANGE) + 1);
+  m_rows = std::min(MAX_GRID_SIDE, static_cast<int>((maxY - minY) / NEIGHBOR_RANGE) + 1);
+
+  // 计数排序：统计每格个数 -> 前缀和 -> 回填
+  std::size_t cellCount = static_cast<std::size_t>(m_cols) * m_rows;
+  m_cellStart.assign(cellCount + 1, 0);
+  for (const auto &agent : m_agents)
+  {
+    if (agent.radius > 0.f)
+      m_cellStart[cellIndex(agent.x, agent.y) + 1]++;
+  }
+  for (std::size_t c = 0; c < cellCount; c++)
+    m_cellStart[c + 1] += m_cellStart[c];
+
+  m_sorted.resize(m_cellStart[cellCount]);
+  std::vector<uint32_t> cursor(m_cellStart.begin(), m_cellStart.end() - 1);
+  for (std::size_t i = 0; i < m_agents.size(); i++)
+  {
+    const auto &agent = m_agents[i];
+    if (agent.radius > 0.f)
+      m_sorted[cursor[cellIndex(agent.x, agent.y)]++] = static_cast<uint32_t>(i);
+  }
+}
+
+void CrowdSteering::build(const EntityStore &store)
+{
+  m_agents.assign(store.capacity(), CrowdAgent{});
+  for (std::size_t id = 0; id < store.capacity(); id++)
+  {
+    if (!store.isAliveNpc(static_cast<EntityId>(id)))
+      continue;
+    CrowdAgent &agent = m_agents[id];
+    agent.x = store.x[id];
+    agent.y = store.y[id];
+    if (store.flags[id] & ENTITY_ACTIVATED)
+    {
+      agent.vx = store.vx[id];
+      agent.vy = store.vy[id];
+    }
+    agent.radius = store.radius[id];
+  }
+  build();
+}
+
+std::size_t CrowdSteering::queryNeighbors(float x, float y, float range, std::size_t self, std::size_t *out,
+                                          std::size_t maxCount) const
+{
+  if (m_cols == 0 || maxCount == 0)
+    return 0;
+  maxCount = std::min<std::size_t>(maxCount, MAX_NEIGHBORS);
+
+  int col0 = std::clamp(static_cast<int>(std::floor((x - range - m_originX) / NEIGHBOR_RANGE)), 0, m_cols - 1);
+  int col1 = std::clamp(static_cast<int>(std::floor((x + range - m_originX) / NEIGHBOR_RANGE)), 0, m_cols - 1);
+  int row0 = std::clamp(static_cast<int>(std::floor((y - range - m_originY) / NEIGHBOR_RANGE)), 0, m_rows - 1);
+  int row1 = std::clamp(static_cast<int>(std::floor((y + range - m_originY) / NEIGHBOR_RANGE)), 0, m_rows - 1);
+
+  // 按距离插入排序，只保留最近的 maxCount 个
+  float dist2[MAX_NEIGHBORS];
+  std::size_t count = 0;
+  float range2 = range * range;
+  for (int row = row0; row <= row1; row++)
+  {
+    for (int col = col0; col <= col1; col++)
+    {
+      std::size_t cell = static_cast<std::size_t>(row) * m_cols + col;
+      for (uint32_t k = m_cellStart[cell]; k < m_cellStart[cell + 1]; k++)
+      {
+        std::size_t j = m_sorted[k];
+        if (j == self)
+          continue;
+        m_stats.neighborsVisited++;
+
+        float dx = m_agents[j].x - x;
+        float dy = m_agents[j].y - y;
+        float d2 = dx * dx + dy * dy;
+        if (d2 >= range2 || (count == maxCount && d2 >= dist2[count - 1]))
+          continue;
+
+        std::size_t pos = count < maxCount ? count++ : count - 1;
+        while (pos > 0 && dist2[pos - 1] > d2)
+        {
+          dist2[pos] = dist2[pos - 1];
+          out[pos] = out[pos - 1];
+          pos--;
+        }
+        dist2[pos] = d2;
+        out[pos] = j;
+      }
+    }
+  }
+  return count;
+}
+
+void CrowdSteering::steer(std::size_t index, float &vx, float &vy, float maxSpeed) const
+{
+  if (index >= m_agents.size() || m_agents[index].radius <= 0.f || maxSpeed <= 0.f)
+    return;
+  const CrowdAgent &self = m_agents[index];
+  m_stats.steered++;
+
+  std::size_t neighbors[MAX_NEIGHBORS];
+  std::size_t count = queryNeighbors(self.x, self.y, NEIGHBOR_RANGE, index, neighbors, MAX_NEIGHBORS);
+  if (count == 0)
+    return;
+
+  // 分离：与每个过近的邻居按重叠程度互相推开
+  float sepX = 0.f, sepY = 0.f;
+  for (std::size_t n = 0; n < count; n++)
+  {
+    const CrowdAgent &other = m_agents[neighbors[n]];
+    float dx = self.x - other.x;
+    float dy = self.y - other.y;
+    float dist = std::sqrt(dx * dx + dy * dy);
+    float reach = self.radius + other.radius + SEPARATION_MARGIN;
+    if (dist >= reach)
+      continue;
+    if (dist < 1e-4f)
+    {
+      // 完全重合：按下标大小往相反方向推，保证两边结果对称
+      dx = index < neighbors[n] ? 1.f : -1.f;
+      dy = 0.f;
+      dist = 1.f;
+    }
+    float weight = (reach - dist) / reach;
+    sepX += dx / dist * weight;
+    sepY += dy / dist * weight;
+  }
+
+  float prefX = vx + sepX * maxSpeed * SEPARATION_GAIN;
+  float prefY = vy + sepY * maxSpeed * SEPARATION_GAIN;
+  float prefSpeed = std::sqrt(prefX * prefX + prefY * prefY);
+  if (prefSpeed > maxSpeed)
+  {
+    prefX *= maxSpeed / prefSpeed;
+    prefY *= maxSpeed / prefSpeed;
+    prefSpeed = maxSpeed;
+  }
+
+  // 速度障碍（互惠）：对方也在移动时各承担一半避让，相对速度取 2v - v自身 - v对方
+  auto cost = [&](float cx, float cy)
+  {
+    float tMin = TIME_HORIZON;
+    for (std::size_t n = 0; n < count && tMin > 0.f; n++)
+    {
+      const CrowdAgent &other = m_agents[neighbors[n]];
+      bool reciprocal = other.vx != 0.f || other.vy != 0.f;
+      float relVx = (reciprocal ? 2.f * cx - self.vx : cx) - other.vx;
+      float relVy = (reciprocal ? 2.f * cy - self.vy : cy) - other.vy;
+      tMin = std::min(tMin, timeToCollision(other.x - self.x, other.y - self.y, relVx, relVy,
+                                            self.radius + other.radius, TIME_HORIZON));
+    }
+    float deviation = std::sqrt((cx - prefX) * (cx - prefX) + (cy - prefY) * (cy - prefY));
+    if (tMin >= TIME_HORIZON)
+      return deviation;
+    return deviation + AVOID_WEIGHT * maxSpeed * (1.f / std::max(tMin, 0.02f) - 1.f / TIME_HORIZON);
+  };
+
+  float bestCost = cost(prefX, prefY);
+  float bestX = prefX, bestY = prefY;
+  if (bestCost > 0.f)
+  {
+    // 期望速度会撞上：在期望方向两侧的若干方向、减速与停下中取代价最小的
+    float dirX = 1.f, dirY = 0.f;
+    if (prefSpeed > 1e-3f)
+    {
+      dirX = prefX / prefSpeed;
+      dirY = prefY / prefSpeed;
+    }
+    auto consider = [&](float cx, float cy)
+    {
+      float c = cost(cx, cy);
+      if (c < bestCost)
+      {
+        bestCost = c;
+        bestX = cx;
+        bestY = cy;
+      }
+    };
+    for (float angle : CANDIDATE_ANGLES)
+    {
+      float cs = std::cos(angle), sn = std::sin(angle);
+      consider((dirX * cs - dirY * sn) * maxSpeed, (dirX * sn + dirY * cs) * maxSpeed);
+    }
+    consider(prefX * 0.5f, prefY * 0.5f);
+    consider(0.f, 0.f);
+    if (bestX != prefX || bestY != prefY)
+      m_stats.avoided++;
+  }
+
+  vx = bestX;
+  vy = bestY;
+}
@@ -0,0 +1,138 @@
+#include "ReplayFile.hpp"
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+bool ReplayWriter::open(const std::string &path, const ReplayHeader &header)
+{
+  close();
+  m_file = std::fopen(path.c_str(), "wb");
+  if (!m_file)
+    return false;
+
+  ReplayHeader h = header;
+  h.headerSize = sizeof(ReplayHeader);
+  if (std::fwrite(&h, sizeof(h), 1, m_file) != 1)
+  {
+    close();
+    return false;
+  }
+  std::fflush(m_file);
+  m_ticks = 0;
+  return true;
+}
+
+void ReplayWriter::append(const ReplayTick &tick)
+{
+  if (!m_file)
+    return;
+  std::fwrite(&tick, sizeof(tick), 1, m_file);
+  if (++m_ticks % FLUSH_INTERVAL == 0)
+    std::fflush(m_file);
+}
+
+void ReplayWriter::close()
+{
+  if (m_file)
+  {
+    std::fclose(m_file);
+    m_file = nullptr;
+  }
+}
+
+bool ReplayReader::open(const std::string &path)
+{
+  close();
+  m_error.clear();
+
+#ifndef _WIN32
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    m_error = "cannot open " + path;
+    return false;
+  }
+  struct stat st{};
+  if (::fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(ReplayHeader)))
+  {
+    ::close(fd);
+    m_error = "file too small";
+    return false;
+  }
+  void *mapped = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (mapped == MAP_FAILED)
+  {
+    m_error = "mmap failed";
+    return false;
+  }
+  m_data = static_cast<const unsigned char *>(mapped);
+  m_size = static_cast<std::size_t>(st.st_size);
+  m_mapped = true;
+#else
+  std::FILE *file = std::fopen(path.c_str(), "rb");
+  if (!file)
+  {
+    m_error = "cannot open " + path;
+    return false;
+  }
+  unsigned char chunk[4096];
+  std::size_t got;
+  while ((got = std::fread(chunk, 1, sizeof(chunk), file)) > 0)
+    m_buffer.insert(m_buffer.end(), chunk, chunk + got);
+  std::fclose(file);
+  if (m_buffer.size() < sizeof(ReplayHeader))
+  {
+    m_buffer.clear();
+    m_error = "file too small";
+    return false;
+  }
+  m_data = m_buffer.data();
+  m_size = m_buffer.size();
+#endif
+
+  std::memcpy(&m_header, m_data, sizeof(ReplayHeader));
+  if (std::memcmp(m_header.magic, REPLAY_MAGIC, sizeof(REPLAY_MAGIC)) != 0)
+    m_error = "not a replay file";
+  else if (m_header.version != REPLAY_VERSION)
+    m_error = "unsupported replay version " + std::to_string(m_header.version);
+  else if (m_header.headerSize < sizeof(ReplayHeader) || m_header.headerSize > m_size)
+    m_error = "corrupt header";
+  else if (m_header.tickRate == 0)
+    m_error = "invalid tick rate";
+  if (!m_error.empty())
+  {
+    close();
+    return false;
+  }
+
+  // 末尾不完整的记录直接丢弃
+  m_tickCount = (m_size - m_header.headerSize) / sizeof(ReplayTick);
+  return true;
+}
+
+void ReplayReader::close()
+{
+#ifndef _WIN32
+  if (m_mapped && m_data)
+    ::munmap(const_cast<unsigned char *>(m_data), m_size);
+#endif
+  m_buffer.clear();
+  m_data = nullptr;
+  m_size = 0;
+  m_mapped = false;
+  m_tickCount = 0;
+}
+
+ReplayTick ReplayReader::tick(std::size_t index) const
+{
+  ReplayTick t;
+  if (index < m_tickCount)
+    std::memcpy(&t, m_data + m_header.headerSize + index * sizeof(ReplayTick), sizeof(ReplayTick));
+  return t;
+}
@@ -0,0 +1,794 @@
+// tank_bench：不依赖 SFML 的性能基准（迷宫生成、射线检测、碰撞、群体避让、实体遍历、录像文件等纯逻辑部分）
+// 用法：tank_bench [--max 1001] [--runs 5] [--seed 1]
+// 固定种子的迷宫哈希与记录值不符、或录像文件读回与写入不一致时退出码为 1
+
+#include "MazeGenerator.hpp"
+#include "ChunkedMaze.hpp"
+#include "DistanceField.hpp"
+#include "CrowdSteering.hpp"
+#include "EntityStore.hpp"
+#include "MazeRandom.hpp"
+#include "Raycast.hpp"
+#include "ReplayFile.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+  struct Options
+  {
+    int maxSize = 1001;
+    int runs = 5;
+    unsigned int seed = 1;
+  };
+
+  using Clock = std::chrono::steady_clock;
+
+  double elapsedMs(Clock::time_point start)
+  {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+  }
+
+  // FNV-1a，用于确认相同种子输出一致
+  uint64_t hashMaze(const std::vector<std::string> &rows)
+  {
+    uint64_t h = 14695981039346656037ull;
+    for (const auto &row : rows)
+    {
+      for (char c : row)
+      {
+        h ^= static_cast<uint8_t>(c);
+        h *= 1099511628211ull;
+      }
+    }
+    return h;
+  }
+
+  void benchMazeGeneration(const Options &options)
+  {
+    std::cout << "[Bench] MazeGenerator::generate (" << options.runs << " runs, seed " << options.seed << ")"
+              << std::endl;
+    std::cout << std::setw(12) << "size" << std::setw(12) << "best ms" << std::setw(12) << "avg ms"
+              << std::setw(20) << "hash" << std::endl;
+
+    const int sizes[][2] = {{41, 31}, {151, 101}, {301, 301}, {501, 501}, {1001, 1001}};
+    for (const auto &size : sizes)
+    {
+      if (size[0] > options.maxSize || size[1] > options.maxSize)
+        continue;
+
+      double best = 0.0;
+      double total = 0.0;
+      uint64_t hashes[2] = {0, 0}; // 单人 / 联机各自的首次输出
+      bool deterministic = true;
+      for (int run = 0; run < options.runs; run++)
+      {
+        MazeGenerator generator(size[0], size[1]);
+        generator.setSeed(options.seed);
+        generator.setEnemyCount(size[0] * size[1] / 100);
+        generator.setMultiplayerMode(run % 2 == 1);
+
+        auto start = Clock::now();
+        auto maze = generator.generate();
+        double ms = elapsedMs(start);
+
+        // 单人与联机交替运行，相同种子的输出必须一致
+        uint64_t h = hashMaze(maze);
+        if (run < 2)
+          hashes[run] = h;
+        else if (hashes[run % 2] != h)
+          deterministic = false;
+
+        best = run == 0 ? ms : std::min(best, ms);
+        total += ms;
+      }
+
+      std::string label = std::to_string(size[0]) + "x" + std::to_string(size[1]);
+      std::cout << std::setw(12) << label << std::setw(12) << std::fixed << std::setprecision(2) << best
+                << std::setw(12) << total / options.runs << std::setw(20) << std::hex << hashes[0] << std::dec
+                << (deterministic ? "" : "  (non-deterministic!)") << std::endl;
+    }
+  }
+
+  // 流式分块迷宫：焦点沿直线穿过很大的世界，常驻内存只取决于焦点附近的区块数
+  void benchChunkedMaze(const Options &options)
+  {
+    const int steps = 20000;
+    const int stride = ChunkedMaze::CHUNK_TILES / 4; // 每步前进 1/4 区块
+    std::cout << "[Bench] ChunkedMaze streaming (" << steps << " steps, seed " << options.seed << ")" << std::endl;
+
+    ChunkedMaze world(options.seed);
+    std::size_t peakResident = 0;
+    uint64_t unloaded = 0;
+    world.setOnChunkUnloaded([&](const ChunkedMaze::Chunk &)
+                             { unloaded++; });
+
+    std::vector<std::pair<int, int>> focus(2);
+    auto start = Clock::now();
+    for (int step = 0; step < steps; step++)
+    {
+      // 两个焦点（类似两辆坦克）朝相反方向移动
+      focus[0] = {step * stride, step * stride / 3};
+      focus[1] = {-step * stride, step * stride / 2};
+      world.updateResidency(focus);
+      peakResident = std::max(peakResident, world.residentChunks());
+    }
+    double ms = elapsedMs(start);
+
+    // 同一区块单独重新生成必须一致（区块只由种子与坐标决定）
+    std::vector<char> a;
+    std::vector<char> b;
+    ChunkedMaze::generateChunk(options.seed, {123456, -654321}, 2, 0.15f, a);
+    ChunkedMaze::generateChunk(options.seed, {123456, -654321}, 2, 0.15f, b);
+
+    double span = static_cast<double>(steps) * stride * 2;
+    std::cout << "  span " << std::fixed << std::setprecision(0) << span << " tiles, generated "
+              << world.chunksGenerated() << " chunks (" << std::setprecision(3)
+              << ms * 1000.0 / std::max<uint64_t>(1, world.chunksGenerated()) << " us/chunk), unloaded " << unloaded
+              << ", peak resident " << peakResident << " chunks / " << peakResident * ChunkedMaze::CHUNK_TILES *
+                                                                          ChunkedMaze::CHUNK_TILES
+              << " bytes" << (a == b ? "" : "  (non-deterministic!)") << std::endl;
+  }
+
+  // 旧版 Maze::checkBulletPath：沿射线以 0.05 格为步长采样（0 = 无阻挡, 1 = 可破坏墙, 2 = 不可破坏墙）
+  // 这里直接读字符网格，比原先读完整 Wall 结构还省内存带宽，对比结果偏向旧版
+  int steppedBulletPath(const std::vector<std::string> &rows, float tileSize, const RayQuery &ray)
+  {
+    float dx = ray.x1 - ray.x0;
+    float dy = ray.y1 - ray.y0;
+    float distance = std::sqrt(dx * dx + dy * dy);
+    if (distance < 1.f)
+      return 0;
+    dx /= distance;
+    dy /= distance;
+
+    const float stepSize = tileSize * 0.05f;
+    int steps = static_cast<int>(distance / stepSize) + 1;
+    for (int i = 1; i <= steps; ++i)
+    {
+      float t = std::min(static_cast<float>(i) * stepSize, distance);
+      float x = ray.x0 + dx * t;
+      float y = ray.y0 + dy * t;
+      int c = static_cast<int>(x / tileSize);
+      int r = static_cast<int>(y / tileSize);
+      if (r < 0 || r >= static_cast<int>(rows.size()) || c < 0 || c >= static_cast<int>(rows[r].size()))
+        continue;
+
+      char ch = rows[r][c];
+      if (ch == '#')
+        return 2;
+      if (ch == '*' || ch == 'G' || ch == 'H')
+        return 1;
+
+      float remainX = ray.x1 - x;
+      float remainY = ray.y1 - y;
+      if (std::sqrt(remainX * remainX + remainY * remainY) < stepSize)
+        break;
+    }
+    return 0;
+  }
+
+  // 射线检测：旧的步进采样 vs 占用网格上的精确格子遍历（单条 / 批量）
+  void benchRaycast(const Options &options)
+  {
+    const float tileSize = 60.f; // 与游戏的 TILE_SIZE 一致
+    const int rayCount = 200000;
+    const float maxRange = 15.f * tileSize; // 约为 NPC 的交战距离
+
+    MazeGenerator generator(151, 101);
+    generator.setSeed(options.seed);
+    generator.setEnemyCount(20);
+    generator.setMultiplayerMode(true);
+    auto rows = generator.generate();
+
+    OccupancyGrid grid;
+    grid.resize(static_cast<int>(rows[0].size()), static_cast<int>(rows.size()), tileSize);
+    std::vector<std::pair<int, int>> openCells;
+    for (int r = 0; r < static_cast<int>(rows.size()); r++)
+    {
+      for (int c = 0; c < static_cast<int>(rows[r].size()); c++)
+      {
+        char ch = rows[r][c];
+        if (ch == '#')
+          grid.set(c, r, CellBlock::Solid);
+        else if (ch == '*' || ch == 'G' || ch == 'H')
+          grid.set(c, r, CellBlock::Destructible);
+        else
+          openCells.push_back({c, r});
+      }
+    }
+
+    // 从随机空地出发，射向交战距离内的随机点
+    MazeRandom rng(options.seed);
+    std::vector<RayQuery> rays(rayCount);
+    for (auto &ray : rays)
+    {
+      auto cell = openCells[rng.below(static_cast<uint32_t>(openCells.size()))];
+      ray.x0 = (cell.first + rng.unit()) * tileSize;
+      ray.y0 = (cell.second + rng.unit()) * tileSize;
+      float angle = rng.unit() * 6.2831853f;
+      float range = rng.unit() * maxRange;
+      ray.x1 = ray.x0 + std::cos(angle) * range;
+      ray.y1 = ray.y0 + std::sin(angle) * range;
+    }
+
+    std::cout << "[Bench] Raycast 151x101 (" << rayCount << " rays, " << options.runs << " runs, seed "
+              << options.seed << ", occupancy " << grid.memoryBytes() << " bytes)" << std::endl;
+    std::cout << std::setw(12) << "method" << std::setw(12) << "best ms" << std::setw(12) << "ns/ray"
+              << std::setw(12) << "blocked" << std::endl;
+
+    std::vector<int> stepped(rayCount);
+    std::vector<RayHit> single(rayCount);
+    std::vector<RayHit> batched(rayCount);
+    double best[3] = {0.0, 0.0, 0.0};
+    for (int run = 0; run < options.runs; run++)
+    {
+      auto start = Clock::now();
+      for (int i = 0; i < rayCount; i++)
+        stepped[i] = steppedBulletPath(rows, tileSize, rays[i]);
+      double ms[3];
+      ms[0] = elapsedMs(start);
+
+      start = Clock::now();
+      for (int i = 0; i < rayCount; i++)
+        single[i] = grid.castRay(rays[i]);
+      ms[1] = elapsedMs(start);
+
+      start = Clock::now();
+      grid.castRays(rays.data(), rays.size(), batched.data());
+      ms[2] = elapsedMs(start);
+
+      for (int m = 0; m < 3; m++)
+        best[m] = run == 0 ? ms[m] : std::min(best[m], ms[m]);
+    }
+
+    // 步进采样可能从墙角擦过而漏检，精确遍历只会多报这种情况，不会少报
+    int blocked[3] = {0, 0, 0};
+    int missedCorners = 0;
+    int disagreements = 0;
+    for (int i = 0; i < rayCount; i++)
+    {
+      float dx = rays[i].x1 - rays[i].x0;
+      float dy = rays[i].y1 - rays[i].y0;
+      int exact = dx * dx + dy * dy < 1.f ? 0 : static_cast<int>(single[i].block);
+      blocked[0] += stepped[i] != 0;
+      blocked[1] += exact != 0;
+      blocked[2] += batched[i].block != CellBlock::Empty;
+      if (stepped[i] == 0 && exact != 0)
+        missedCorners++;
+      else if (stepped[i] != exact)
+        disagreements++;
+    }
+
+    const char *labels[3] = {"stepped", "dda", "dda batch"};
+    for (int m = 0; m < 3; m++)
+    {
+      std::cout << std::setw(12) << labels[m] << std::setw(12) << std::fixed << std::setprecision(2) << best[m]
+                << std::setw(12) << best[m] * 1e6 / rayCount << std::setw(12) << blocked[m] << std::endl;
+    }
+    std::cout << "  corner grazes missed by stepping: " << missedCorners << ", other disagreements: " << disagreements
+              << std::endl;
+  }
+
+  // 与 Maze::calculateRoundedCorners 相同的圆角规则（地图外视为墙）
+  std::vector<uint8_t> buildWallCells(const std::vector<std::string> &rows)
+  {
+    int height = static_cast<int>(rows.size());
+    int width = static_cast<int>(rows[0].size());
+    auto blocking = [&](int r, int c)
+    { return rows[r][c] == '#' || rows[r][c] == '*' || rows[r][c] == 'G' || rows[r][c] == 'H'; };
+    auto isWall = [&](int r, int c)
+    { return r < 0 || r >= height || c < 0 || c >= width || blocking(r, c) || rows[r][c] == 'E'; };
+
+    std::vector<uint8_t> cells(static_cast<std::size_t>(width) * height, 0);
+    for (int r = 0; r < height; r++)
+    {
+      for (int c = 0; c < width; c++)
+      {
+        if (!blocking(r, c))
+          continue;
+        bool top = isWall(r - 1, c), bottom = isWall(r + 1, c), left = isWall(r, c - 1), right = isWall(r, c + 1);
+        uint8_t cell = DistanceField::CELL_BLOCKING;
+        if (!top && !left)
+          cell |= DistanceField::cornerBit(0);
+        if (!top && !right)
+          cell |= DistanceField::cornerBit(1);
+        if (!bottom && !right)
+          cell |= DistanceField::cornerBit(2);
+        if (!bottom && !left)
+          cell |= DistanceField::cornerBit(3);
+        cells[static_cast<std::size_t>(r) * width + c] = cell;
+      }
+    }
+    return cells;
+  }
+
+  // 旧版 Maze::checkCollision：遍历圆覆盖的格子，逐个做圆角矩形与圆的检测
+  bool exactCollision(const std::vector<uint8_t> &cells, int width, int height, float tileSize, float x, float y,
+                      float radius)
+  {
+    const float cornerRadius = 12.f; // WALL_CORNER_RADIUS
+    int minC = std::max(0, static_cast<int>((x - radius) / tileSize));
+    int maxC = std::min(width - 1, static_cast<int>((x + radius) / tileSize));
+    int minR = std::max(0, static_cast<int>((y - radius) / tileSize));
+    int maxR = std::min(height - 1, static_cast<int>((y + radius) / tileSize));
+    for (int r = minR; r <= maxR; ++r)
+    {
+      for (int c = minC; c <= maxC; ++c)
+      {
+        uint8_t cell = cells[static_cast<std::size_t>(r) * width + c];
+        if (!(cell & DistanceField::CELL_BLOCKING))
+          continue;
+        float wallLeft = c * tileSize + 1.f;
+        float wallRight = wallLeft + tileSize - 2.f;
+        float wallTop = r * tileSize + 1.f;
+        float wallBottom = wallTop + tileSize - 2.f;
+        float innerLeft = wallLeft + cornerRadius;
+        float innerRight = wallRight - cornerRadius;
+        float innerTop = wallTop + cornerRadius;
+        float innerBottom = wallBottom - cornerRadius;
+        bool inLeft = x < innerLeft, inRight = x > innerRight, inTop = y < innerTop, inBottom = y > innerBottom;
+        int corner = -1;
+        if (inLeft && inTop)
+          corner = 0;
+        else if (inRight && inTop)
+          corner = 1;
+        else if (inRight && inBottom)
+          corner = 2;
+        else if (inLeft && inBottom)
+          corner = 3;
+
+        if (corner >= 0 && (cell & DistanceField::cornerBit(corner)))
+        {
+          float dx = x - (inLeft ? innerLeft : innerRight);
+          float dy = y - (inTop ? innerTop : innerBottom);
+          if (dx * dx + dy * dy < (radius + cornerRadius) * (radius + cornerRadius))
+            return true;
+        }
+        else
+        {
+          float dx = x - std::max(wallLeft, std::min(x, wallRight));
+          float dy = y - std::max(wallTop, std::min(y, wallBottom));
+          if (dx * dx + dy * dy < radius * radius)
+            return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  // 坦克与墙的碰撞：逐墙精确检测 vs 距离场查询，以及距离场的构建/局部修补耗时
+  void benchDistanceField(const Options &options)
+  {
+    const float tileSize = 60.f;
+    const float radius = 19.2f; // 玩家坦克（缩放 0.4）的碰撞半径
+    const int queryCount = 1000000;
+
+    MazeGenerator generator(151, 101);
+    generator.setSeed(options.seed);
+    generator.setEnemyCount(20);
+    auto rows = generator.generate();
+    int width = static_cast<int>(rows[0].size());
+    int height = static_cast<int>(rows.size());
+    auto cells = buildWallCells(rows);
+
+    DistanceField field;
+    double buildMs = 0.0;
+    for (int run = 0; run < options.runs; run++)
+    {
+      auto start = Clock::now();
+      field.reset(width, height, tileSize, 1.f, 12.f);
+      for (int r = 0; r < height; r++)
+      {
+        for (int c = 0; c < width; c++)
+          field.setCell(c, r, cells[static_cast<std::size_t>(r) * width + c]);
+      }
+      field.rebuild();
+      double ms = elapsedMs(start);
+      buildMs = run == 0 ? ms : std::min(buildMs, ms);
+    }
+
+    MazeRandom rng(options.seed);
+    std::vector<float> points(queryCount * 2);
+    for (auto &v : points)
+      v = rng.unit();
+    for (int i = 0; i < queryCount; i++)
+    {
+      points[i * 2] *= width * tileSize;
+      points[i * 2 + 1] *= height * tileSize;
+    }
+
+    double best[2] = {0.0, 0.0};
+    int hits[2] = {0, 0};
+    int mismatches = 0;
+    float worstError = 0.f;
+    for (int run = 0; run < options.runs; run++)
+    {
+      int count[2] = {0, 0};
+      auto start = Clock::now();
+      for (int i = 0; i < queryCount; i++)
+        count[0] += exactCollision(cells, width, height, tileSize, points[i * 2], points[i * 2 + 1], radius);
+      double exactMs = elapsedMs(start);
+
+      start = Clock::now();
+      for (int i = 0; i < queryCount; i++)
+        count[1] += field.distance(points[i * 2], points[i * 2 + 1]) < radius;
+      double fieldMs = elapsedMs(start);
+
+      best[0] = run == 0 ? exactMs : std::min(best[0], exactMs);
+      best[1] = run == 0 ? fieldMs : std::min(best[1], fieldMs);
+      hits[0] = count[0];
+      hits[1] = count[1];
+    }
+
+    // 判定不一致的点都落在墙边附近：用插值距离与半径之差估计误差
+    for (int i = 0; i < queryCount; i++)
+    {
+      float x = points[i * 2], y = points[i * 2 + 1];
+      float d = field.distance(x, y);
+      if ((d < radius) != exactCollision(cells, width, height, tileSize, x, y, radius))
+      {
+        mismatches++;
+        worstError = std::max(worstError, std::abs(d - radius));
+      }
+    }
+
+    // 摧毁一面墙后的局部修补
+    int patches = 0;
+    auto start = Clock::now();
+    for (int r = 1; r < height - 1 && patches < 1000; r++)
+    {
+      for (int c = 1; c < width - 1 && patches < 1000; c++)
+      {
+        if (rows[r][c] != '*')
+          continue;
+        field.setCell(c, r, 0);
+        field.patch(c, r);
+        patches++;
+      }
+    }
+    double patchMs = elapsedMs(start);
+
+    std::cout << "[Bench] Tank-vs-wall collision 151x101 (" << queryCount << " queries, radius " << radius << ")"
+              << std::endl;
+    std::cout << "  exact walls   " << std::fixed << std::setprecision(2) << best[0] << " ms ("
+              << best[0] * 1e6 / queryCount << " ns/query), " << hits[0] << " hits" << std::endl;
+    std::cout << "  distance field " << best[1] << " ms (" << best[1] * 1e6 / queryCount << " ns/query), " << hits[1]
+              << " hits, " << mismatches << " disagree (within " << worstError << " px)" << std::endl;
+    std::cout << "  build " << buildMs << " ms, " << field.memoryBytes() / 1024 << " KB, patch after wall change "
+              << std::setprecision(3) << patchMs * 1000.0 / std::max(1, patches) << " us" << std::endl;
+  }
+
+  // 重叠的个体对数（两圆相交超过 1 像素）
+  int countOverlaps(const std::vector<CrowdAgent> &agents)
+  {
+    int overlaps = 0;
+    for (std::size_t i = 0; i < agents.size(); i++)
+    {
+      for (std::size_t j = i + 1; j < agents.size(); j++)
+      {
+        float dx = agents[i].x - agents[j].x;
+        float dy = agents[i].y - agents[j].y;
+        float reach = agents[i].radius + agents[j].radius - 1.f;
+        overlaps += dx * dx + dy * dy < reach * reach;
+      }
+    }
+    return overlaps;
+  }
+
+  // NPC 群体避让：一群 NPC 从四周汇向同一点（模拟挤向同一个路径点），
+  // 比较不避让 / 避让后的重叠对数，以及网格邻居查询与逐个遍历的耗时
+  void benchCrowd(const Options &options)
+  {
+    const float speed = 120.f; // Enemy::m_moveSpeed
+    const float dt = 1.f / 60.f;
+    const int frames = 600;
+
+    std::cout << "[Bench] NPC crowd converging on one waypoint (" << frames << " frames)" << std::endl;
+    std::cout << "  npcs  overlaps(raw)  overlaps(steered)  steer us/frame  grid query us  brute-force query us"
+              << std::endl;
+    for (int npcCount : {100, 400, 1600})
+    {
+      MazeRandom rng(options.seed);
+      std::vector<CrowdAgent> start(npcCount);
+      float extent = 60.f * std::sqrt(static_cast<float>(npcCount)) * 2.f;
+      for (auto &agent : start)
+      {
+        agent.x = rng.unit() * extent;
+        agent.y = rng.unit() * extent;
+        agent.radius = 18.f; // Enemy::getCollisionRadius
+      }
+      float goalX = extent / 2.f, goalY = extent / 2.f;
+
+      auto simulate = [&](bool steerOn, double &frameUs)
+      {
+        std::vector<CrowdAgent> agents = start;
+        CrowdSteering crowd;
+        auto begin = Clock::now();
+        for (int frame = 0; frame < frames; frame++)
+        {
+          crowd.clear();
+          for (const auto &agent : agents)
+            crowd.add(agent);
+          crowd.build();
+          for (std::size_t i = 0; i < agents.size(); i++)
+          {
+            auto &agent = agents[i];
+            float dx = goalX - agent.x, dy = goalY - agent.y;
+            float dist = std::sqrt(dx * dx + dy * dy);
+            float vx = dist > 5.f ? dx / dist * speed : 0.f;
+            float vy = dist > 5.f ? dy / dist * speed : 0.f;
+            if (steerOn)
+              crowd.steer(i, vx, vy, speed);
+            agent.x += vx * dt;
+            agent.y += vy * dt;
+            agent.vx = vx;
+            agent.vy = vy;
+          }
+        }
+        frameUs = elapsedMs(begin) * 1000.0 / frames;
+        return countOverlaps(agents);
+      };
+
+      double rawUs = 0.0, steerUs = 0.0;
+      int rawOverlaps = simulate(false, rawUs);
+      int steeredOverlaps = simulate(true, steerUs);
+
+      // 邻居查询：网格（建表 + 每个 NPC 查 k 个）与逐个遍历全部 NPC 的对照
+      CrowdSteering crowd;
+      std::size_t neighbors[CrowdSteering::MAX_NEIGHBORS];
+      std::size_t gridFound = 0;
+      auto begin = Clock::now();
+      for (int run = 0; run < options.runs; run++)
+      {
+        crowd.clear();
+        for (const auto &agent : start)
+          crowd.add(agent);
+        crowd.build();
+        for (int i = 0; i < npcCount; i++)
+          gridFound += crowd.queryNeighbors(start[i].x, start[i].y, CrowdSteering::NEIGHBOR_RANGE, i, neighbors,
+                                            CrowdSteering::MAX_NEIGHBORS);
+      }
+      double gridUs = elapsedMs(begin) * 1000.0 / options.runs;
+
+      begin = Clock::now();
+      std::size_t found = 0;
+      for (int run = 0; run < options.runs; run++)
+      {
+        for (int i = 0; i < npcCount; i++)
+        {
+          float best[CrowdSteering::MAX_NEIGHBORS];
+          int count = 0;
+          for (int j = 0; j < npcCount; j++)
+          {
+            float dx = start[j].x - start[i].x, dy = start[j].y - start[i].y;
+            float d2 = dx * dx + dy * dy;
+            if (j == i || d2 >= CrowdSteering::NEIGHBOR_RANGE * CrowdSteering::NEIGHBOR_RANGE)
+              continue;
+            if (count < CrowdSteering::MAX_NEIGHBORS)
+              best[count++] = d2;
+            else
+              *std::max_element(best, best + count) = std::min(d2, *std::max_element(best, best + count));
+          }
+          found += count;
+        }
+      }
+      double bruteUs = elapsedMs(begin) * 1000.0 / options.runs;
+
+      std::cout << "  " << std::setw(4) << npcCount << std::setw(15) << rawOverlaps << std::setw(19) << steeredOverlaps
+                << std::setw(16) << std::fixed << std::setprecision(1) << steerUs << std::setw(15) << gridUs
+                << std::setw(22) << bruteUs << (found != gridFound ? "  (neighbour count mismatch)" : "")
+                << std::endl;
+    }
+  }
+
+  // 旧布局的近似：每个 NPC 一个约 1 KB 的堆对象（贴图、精灵、血条图形、时钟与路径都在里面），
+  // 热字段分散在对象各处，通过 unique_ptr 访问
+  struct FatNpc
+  {
+    float x = 0.f, y = 0.f;
+    unsigned char render[480] = {};
+    float health = 100.f;
+    unsigned char clocks[64] = {};
+    int team = 0;
+    bool activated = false;
+    unsigned char path[400] = {};
+  };
+
+  // 实体遍历：每帧对全部 NPC 做一次“收集存活的已激活敌对 NPC”扫描（选目标、小地图都是这种循环）
+  void benchEntityScan(const Options &options, int npcCount, int passes)
+  {
+    MazeRandom rng(options.seed);
+    EntityStore store;
+    std::vector<std::unique_ptr<FatNpc>> fat;
+    std::vector<std::unique_ptr<unsigned char[]>> interleaved; // 模拟运行中其他分配夹在 NPC 对象之间
+    for (int i = 0; i < npcCount; i++)
+    {
+      float x = rng.unit() * 9000.f, y = rng.unit() * 6000.f;
+      int team = static_cast<int>(rng.unit() * 3.f);
+      bool activated = rng.unit() < 0.7f;
+      float health = rng.unit() < 0.9f ? 100.f : 0.f;
+
+      auto npc = std::make_unique<FatNpc>();
+      npc->x = x;
+      npc->y = y;
+      npc->team = team;
+      npc->activated = activated;
+      npc->health = health;
+      fat.push_back(std::move(npc));
+      interleaved.push_back(std::make_unique<unsigned char[]>(64 + static_cast<int>(rng.unit() * 512.f)));
+
+      EntityId id = store.create(EntityKind::Npc);
+      store.x[id] = x;
+      store.y[id] = y;
+      store.team[id] = static_cast<int8_t>(team);
+      store.flags[id] = activated ? ENTITY_ACTIVATED : 0;
+      store.health[id] = health;
+    }
+
+    // 列表顺序与分配顺序不一致（NPC 死亡、重生、关卡切换后的常态）
+    for (int i = npcCount - 1; i > 0; i--)
+      std::swap(fat[i], fat[static_cast<int>(rng.unit() * (i + 1)) % (i + 1)]);
+
+    double best[2] = {0.0, 0.0};
+    double checksum[2] = {0.0, 0.0};
+    for (int run = 0; run < options.runs; run++)
+    {
+      double sum = 0.0;
+      auto start = Clock::now();
+      for (int pass = 0; pass < passes; pass++)
+      {
+        int team = 1 + pass % 2;
+        for (const auto &npc : fat)
+        {
+          if (npc->activated && npc->health > 0.f && npc->team != team && npc->team != 0)
+            sum += npc->x + npc->y;
+        }
+      }
+      double fatMs = elapsedMs(start);
+      checksum[0] = sum;
+
+      sum = 0.0;
+      start = Clock::now();
+      for (int pass = 0; pass < passes; pass++)
+      {
+        int team = 1 + pass % 2;
+        for (EntityId id = 0; id < store.capacity(); id++)
+        {
+          if (store.isActiveNpc(id) && store.team[id] != team && store.team[id] != 0)
+            sum += store.x[id] + store.y[id];
+        }
+      }
+      double storeMs = elapsedMs(start);
+      checksum[1] = sum;
+
+      best[0] = run == 0 ? fatMs : std::min(best[0], fatMs);
+      best[1] = run == 0 ? storeMs : std::min(best[1], storeMs);
+    }
+
+    double scans = static_cast<double>(passes) * npcCount;
+    std::cout << "  " << std::setw(6) << npcCount << " NPCs: heap objects " << std::fixed << std::setprecision(2)
+              << best[0] * 1e6 / scans << " ns/entity (" << sizeof(FatNpc) << " B each), entity store "
+              << best[1] * 1e6 / scans << " ns/entity (" << store.memoryBytes() / npcCount << " B each)"
+              << (checksum[0] != checksum[1] ? "  (checksum mismatch)" : "") << std::endl;
+  }
+
+  void benchEntityScan(const Options &options)
+  {
+    std::cout << "[Bench] Entity scan (collect live, activated, hostile NPCs)" << std::endl;
+    for (int npcCount : {2000, 50000})
+      benchEntityScan(options, npcCount, npcCount >= 10000 ? 10 : 200);
+  }
+
+  // 录像文件：写入一小时的输入（60 步/秒），映射读回逐条比对；末尾追加半条记录模拟录制中途崩溃
+  bool benchReplayFile(const Options &options)
+  {
+    std::cout << "[Bench] Replay file (1 hour at 60 ticks/s)" << std::endl;
+    const std::size_t tickCount = 60 * 60 * 60;
+    std::string path = (std::filesystem::temp_directory_path() / "tank_bench_replay.tkrp").string();
+
+    MazeRandom rng(options.seed);
+    std::vector<ReplayTick> ticks(tickCount);
+    for (auto &tick : ticks)
+    {
+      tick.buttons = static_cast<uint8_t>(rng.unit() * 128.f);
+      tick.placeCol = static_cast<int16_t>(rng.unit() * 150.f);
+      tick.placeRow = static_cast<int16_t>(rng.unit() * 100.f);
+      tick.aimX = rng.unit() * 9000.f;
+      tick.aimY = rng.unit() * 6000.f;
+    }
+
+    ReplayHeader header;
+    header.mazeSeed = options.seed;
+    header.mazeWidth = 151;
+    header.mazeHeight = 101;
+
+    auto start = Clock::now();
+    ReplayWriter writer;
+    if (!writer.open(path, header))
+    {
+      std::cout << "  cannot write " << path << std::endl;
+      return false;
+    }
+    for (const auto &tick : ticks)
+      writer.append(tick);
+    writer.close();
+    double writeMs = elapsedMs(start);
+
+    // 半条记录
+    if (std::FILE *file = std::fopen(path.c_str(), "ab"))
+    {
+      std::fwrite(&ticks[0], sizeof(ReplayTick) / 2, 1, file);
+      std::fclose(file);
+    }
+
+    start = Clock::now();
+    ReplayReader reader;
+    bool opened = reader.open(path);
+    double openMs = elapsedMs(start);
+
+    start = Clock::now();
+    std::size_t mismatches = 0;
+    if (opened)
+    {
+      for (std::size_t i = 0; i < reader.tickCount() && i < tickCount; i++)
+      {
+        ReplayTick tick = reader.tick(i);
+        if (std::memcmp(&tick, &ticks[i], sizeof(ReplayTick)) != 0)
+          mismatches++;
+      }
+    }
+    double readMs = elapsedMs(start);
+
+    bool ok = opened && reader.tickCount() == tickCount && mismatches == 0 &&
+              reader.header().mazeSeed == options.seed && reader.header().mazeWidth == 151;
+    double megabytes = static_cast<double>(sizeof(ReplayHeader) + tickCount * sizeof(ReplayTick)) / (1024.0 * 1024.0);
+    std::cout << "  " << tickCount << " ticks, " << std::fixed << std::setprecision(2) << megabytes << " MB ("
+              << sizeof(ReplayTick) << " B/tick): write " << writeMs << " ms, open " << openMs << " ms, read "
+              << readMs << " ms" << (ok ? "" : "  (ROUND TRIP FAILED: " + reader.error() + ")") << std::endl;
+
+    reader.close();
+    std::filesystem::remove(path);
+    return ok;
+  }
+}
+
+int main(int argc, char **argv)
+{
+  Options options;
+  for (int i = 1; i < argc; i++)
+  {
+    auto next = [&](int fallback)
+    { return i + 1 < argc ? std::atoi(argv[++i]) : fallback; };
+    if (std::strcmp(argv[i], "--max") == 0)
+      options.maxSize = next(options.maxSize);
+    else if (std::strcmp(argv[i], "--runs") == 0)
+      options.runs = std::max(1, next(options.runs));
+    else if (std::strcmp(argv[i], "--seed") == 0)
+      options.seed = static_cast<unsigned int>(next(static_cast<int>(options.seed)));
+    else
+    {
+      std::cout << "Usage: tank_bench [--max N] [--runs N] [--seed N]" << std::endl;
+      return 1;
+    }
+  }
+
+  benchMazeGeneration(options);
+  benchChunkedMaze(options);
+  benchRaycast(options);
+  benchDistanceField(options);
+  benchCrowd(options);
+  benchEntityScan(options);
+  bool replayOk = benchReplayFile(options);
+  return replayOk ? 0 : 1;
+}
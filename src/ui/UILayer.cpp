@@ -0,0 +1,269 @@
+#include "UILayer.hpp"
+#include "RoundedRectangle.hpp"
+#include <algorithm>
+
+namespace
+{
+  // 与 sf::Text 一致：字形四周各留 1 像素，避免平滑纹理采样时裁掉边缘
+  constexpr float GLYPH_PADDING = 1.f;
+
+  void addGlyphQuad(std::vector<sf::Vertex> &out, sf::Vector2f pen, const sf::Glyph &glyph, sf::Color color)
+  {
+    float left = glyph.bounds.position.x - GLYPH_PADDING;
+    float top = glyph.bounds.position.y - GLYPH_PADDING;
+    float right = glyph.bounds.position.x + glyph.bounds.size.x + GLYPH_PADDING;
+    float bottom = glyph.bounds.position.y + glyph.bounds.size.y + GLYPH_PADDING;
+
+    float u1 = static_cast<float>(glyph.textureRect.position.x) - GLYPH_PADDING;
+    float v1 = static_cast<float>(glyph.textureRect.position.y) - GLYPH_PADDING;
+    float u2 = static_cast<float>(glyph.textureRect.position.x + glyph.textureRect.size.x) + GLYPH_PADDING;
+    float v2 = static_cast<float>(glyph.textureRect.position.y + glyph.textureRect.size.y) + GLYPH_PADDING;
+
+    out.push_back({{pen.x + left, pen.y + top}, color, {u1, v1}});
+    out.push_back({{pen.x + right, pen.y + top}, color, {u2, v1}});
+    out.push_back({{pen.x + left, pen.y + bottom}, color, {u1, v2}});
+    out.push_back({{pen.x + left, pen.y + bottom}, color, {u1, v2}});
+    out.push_back({{pen.x + right, pen.y + top}, color, {u2, v1}});
+    out.push_back({{pen.x + right, pen.y + bottom}, color, {u2, v2}});
+  }
+
+  // 圆角矩形按扇形三角化（形状为凸多边形）
+  void addRoundedRect(std::vector<sf::Vertex> &out, sf::Vector2f origin, sf::Vector2f size, float radius,
+                      sf::Color color)
+  {
+    if (color.a == 0 || size.x <= 0.f || size.y <= 0.f)
+      return;
+
+    SelectiveRoundedRectShape shape(size, radius, 6);
+    if (radius > 0.f)
+      shape.setRoundedCorners(true, true, true, true);
+
+    sf::Vector2f center = origin + sf::Vector2f{size.x / 2.f, size.y / 2.f};
+    std::size_t count = shape.getPointCount();
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      out.push_back({center, color, {}});
+      out.push_back({origin + shape.getPoint(i), color, {}});
+      out.push_back({origin + shape.getPoint((i + 1) % count), color, {}});
+    }
+  }
+}
+
+void UILayer::begin()
+{
+  m_frameId++;
+  m_frame.clear();
+}
+
+UILayer::Widget &UILayer::submit(const std::string &id)
+{
+  Widget &widget = m_widgets[id];
+  if (widget.frame != m_frameId)
+  {
+    widget.frame = m_frameId;
+    m_frame.push_back(&widget);
+  }
+  return widget;
+}
+
+sf::FloatRect UILayer::text(const std::string &id, const std::string &str, unsigned int size, sf::Color color,
+                            sf::Vector2f position, UIAlign align, bool bold)
+{
+  Widget &widget = submit(id);
+  if (!widget.hasGeometry || !widget.isText || widget.str != str || widget.size != size || widget.bold != bold)
+  {
+    widget.isText = true;
+    widget.str = str;
+    widget.size = size;
+    widget.bold = bold;
+    widget.color = color;
+    buildText(widget);
+    m_dirty = true;
+  }
+  else if (widget.color != color)
+  {
+    widget.color = color;
+    recolor(widget);
+    m_dirty = true;
+  }
+
+  sf::Vector2f offset = position;
+  if (align == UIAlign::Center)
+    offset.x -= widget.bounds.size.x / 2.f;
+  else if (align == UIAlign::Right)
+    offset.x -= widget.bounds.size.x;
+  if (offset != widget.offset)
+  {
+    widget.offset = offset;
+    m_dirty = true;
+  }
+  return {offset + widget.bounds.position, widget.bounds.size};
+}
+
+void UILayer::panel(const std::string &id, sf::Vector2f position, sf::Vector2f size, sf::Color fill, float radius,
+                    sf::Color outline, float outlineThickness)
+{
+  Widget &widget = submit(id);
+  if (!widget.hasGeometry || widget.isText || widget.panelSize != size || widget.radius != radius ||
+      widget.color != fill || widget.outline != outline || widget.outlineThickness != outlineThickness)
+  {
+    widget.isText = false;
+    widget.panelSize = size;
+    widget.radius = radius;
+    widget.color = fill;
+    widget.outline = outline;
+    widget.outlineThickness = outlineThickness;
+    buildPanel(widget);
+    m_dirty = true;
+  }
+
+  if (position != widget.offset)
+  {
+    widget.offset = position;
+    m_dirty = true;
+  }
+}
+
+void UILayer::draw(sf::RenderTarget &target)
+{
+  if (m_dirty || m_frame != m_lastFrame)
+    rebuildBatches();
+
+  for (const auto &batch : m_batches)
+  {
+    if (batch.vertices.empty())
+      continue;
+    sf::RenderStates states;
+    states.texture = batch.texture;
+    target.draw(batch.vertices.data(), batch.vertices.size(), sf::PrimitiveType::Triangles, states);
+    m_stats.drawCalls++;
+  }
+}
+
+void UILayer::clear()
+{
+  m_widgets.clear();
+  m_frame.clear();
+  m_lastFrame.clear();
+  m_batches.clear();
+  m_dirty = true;
+}
+
+void UILayer::buildText(Widget &widget)
+{
+  // 排版规则与 sf::Text 相同（不含描边、下划线与斜体）
+  widget.vertices.clear();
+  widget.texture = &m_font->getTexture(widget.size);
+  widget.hasGeometry = true;
+  m_stats.geometryBuilds++;
+
+  sf::String str = sf::String::fromUtf8(widget.str.begin(), widget.str.end());
+  if (str.getSize() == 0)
+  {
+    widget.bounds = {};
+    return;
+  }
+
+  float whitespaceWidth = m_font->getGlyph(U' ', widget.size, widget.bold).advance;
+  float lineSpacing = m_font->getLineSpacing(widget.size);
+  float x = 0.f;
+  float y = static_cast<float>(widget.size);
+  float minX = static_cast<float>(widget.size);
+  float minY = static_cast<float>(widget.size);
+  float maxX = 0.f;
+  float maxY = 0.f;
+  std::uint32_t prevChar = 0;
+  for (char32_t curChar : str)
+  {
+    if (curChar == U'\r')
+      continue;
+
+    x += m_font->getKerning(prevChar, curChar, widget.size, widget.bold);
+    prevChar = curChar;
+
+    if (curChar == U' ' || curChar == U'\n' || curChar == U'\t')
+    {
+      minX = std::min(minX, x);
+      minY = std::min(minY, y);
+      if (curChar == U' ')
+        x += whitespaceWidth;
+      else if (curChar == U'\t')
+        x += whitespaceWidth * 4.f;
+      else
+      {
+        y += lineSpacing;
+        x = 0.f;
+      }
+      maxX = std::max(maxX, x);
+      maxY = std::max(maxY, y);
+      continue;
+    }
+
+    const sf::Glyph &glyph = m_font->getGlyph(curChar, widget.size, widget.bold);
+    addGlyphQuad(widget.vertices, {x, y}, glyph, widget.color);
+
+    minX = std::min(minX, x + glyph.bounds.position.x);
+    maxX = std::max(maxX, x + glyph.bounds.position.x + glyph.bounds.size.x);
+    minY = std::min(minY, y + glyph.bounds.position.y);
+    maxY = std::max(maxY, y + glyph.bounds.position.y + glyph.bounds.size.y);
+    x += glyph.advance;
+  }
+  widget.bounds = {{minX, minY}, {maxX - minX, maxY - minY}};
+}
+
+void UILayer::buildPanel(Widget &widget)
+{
+  widget.vertices.clear();
+  widget.texture = nullptr;
+  widget.hasGeometry = true;
+  m_stats.geometryBuilds++;
+
+  // 描边：先画一块向外扩展 thickness 的底板，再盖上填充
+  float t = widget.outlineThickness;
+  if (t > 0.f)
+  {
+    addRoundedRect(widget.vertices, {-t, -t}, widget.panelSize + sf::Vector2f{2.f * t, 2.f * t},
+                   widget.radius > 0.f ? widget.radius + t : 0.f, widget.outline);
+    widget.bounds = {{-t, -t}, widget.panelSize + sf::Vector2f{2.f * t, 2.f * t}};
+  }
+  else
+  {
+    widget.bounds = {{0.f, 0.f}, widget.panelSize};
+  }
+  addRoundedRect(widget.vertices, {0.f, 0.f}, widget.panelSize, widget.radius, widget.color);
+}
+
+void UILayer::recolor(Widget &widget)
+{
+  for (auto &vertex : widget.vertices)
+    vertex.color = widget.color;
+}
+
+void UILayer::rebuildBatches()
+{
+  // 下标 0 固定为无纹理的面板批次，文字按字形纹理（字号）各占一批
+  if (m_batches.empty())
+    m_batches.push_back({nullptr, {}});
+  for (auto &batch : m_batches)
+    batch.vertices.clear();
+
+  for (const Widget *widget : m_frame)
+  {
+    auto it = std::find_if(m_batches.begin(), m_batches.end(), [&](const Batch &batch)
+                           { return batch.texture == widget->texture; });
+    if (it == m_batches.end())
+    {
+      m_batches.push_back({widget->texture, {}});
+      it = m_batches.end() - 1;
+    }
+    for (sf::Vertex vertex : widget->vertices)
+    {
+      vertex.position += widget->offset;
+      it->vertices.push_back(vertex);
+    }
+  }
+
+  m_lastFrame = m_frame;
+  m_dirty = false;
+  m_stats.batchBuilds++;
+}
@@ -0,0 +1,145 @@
+#include "ChunkStreamer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace
+{
+  constexpr int T = ChunkedMaze::CHUNK_TILES;
+}
+
+ChunkStreamer::ChunkStreamer(uint64_t seed, int enemiesPerChunk)
+    : m_chunks(seed, enemiesPerChunk)
+{
+  m_chunks.setOnChunkLoaded([this](const ChunkedMaze::Chunk &chunk)
+                            { onChunkLoaded(chunk); });
+}
+
+sf::Vector2f ChunkStreamer::start(Maze &maze)
+{
+  auto [startX, startY] = ChunkedMaze::startTile();
+  m_center = ChunkedMaze::chunkOf(startX, startY);
+  m_tileSize = maze.getTileSize();
+  loadWindow(maze);
+  return maze.getStartPosition();
+}
+
+bool ChunkStreamer::update(sf::Vector2f focus, Maze &maze, sf::Vector2f &shift)
+{
+  int focusX = m_originX + static_cast<int>(std::floor(focus.x / m_tileSize));
+  int focusY = m_originY + static_cast<int>(std::floor(focus.y / m_tileSize));
+
+  // 超出中心区块的格数
+  int minX = m_center.x * T;
+  int minY = m_center.y * T;
+  int outX = std::max({minX - focusX, focusX - (minX + T - 1), 0});
+  int outY = std::max({minY - focusY, focusY - (minY + T - 1), 0});
+  if (std::max(outX, outY) < RECENTER_MARGIN)
+    return false;
+
+  captureWalls(maze);
+  int oldX = m_originX;
+  int oldY = m_originY;
+  m_center = ChunkedMaze::chunkOf(focusX, focusY);
+  loadWindow(maze);
+  shift = {(oldX - m_originX) * m_tileSize, (oldY - m_originY) * m_tileSize};
+  return true;
+}
+
+bool ChunkStreamer::contains(sf::Vector2f position) const
+{
+  float size = WINDOW_TILES * m_tileSize;
+  return position.x >= 0.f && position.y >= 0.f && position.x < size && position.y < size;
+}
+
+void ChunkStreamer::pageOut(sf::Vector2f position, float health)
+{
+  float cellX = std::floor(position.x / m_tileSize);
+  float cellY = std::floor(position.y / m_tileSize);
+  NpcRecord record;
+  record.tileX = m_originX + static_cast<int>(cellX);
+  record.tileY = m_originY + static_cast<int>(cellY);
+  record.offset = {position.x - cellX * m_tileSize, position.y - cellY * m_tileSize};
+  record.health = health;
+  m_records[ChunkedMaze::chunkOf(record.tileX, record.tileY)].npcs.push_back(record);
+}
+
+std::vector<ChunkStreamer::NpcSpawn> ChunkStreamer::takeArrivals()
+{
+  std::vector<NpcSpawn> spawns;
+  spawns.reserve(m_arrivals.size());
+  for (const auto &record : m_arrivals)
+  {
+    sf::Vector2f position((record.tileX - m_originX) * m_tileSize + record.offset.x,
+                          (record.tileY - m_originY) * m_tileSize + record.offset.y);
+    spawns.push_back({position, record.health});
+  }
+  m_arrivals.clear();
+  return spawns;
+}
+
+void ChunkStreamer::onChunkLoaded(const ChunkedMaze::Chunk &chunk)
+{
+  auto [it, firstVisit] = m_records.try_emplace(chunk.coord);
+  if (!firstVisit)
+  {
+    m_arrivals.insert(m_arrivals.end(), it->second.npcs.begin(), it->second.npcs.end());
+    it->second.npcs.clear();
+    return;
+  }
+
+  // 第一次到达：按生成结果放置 NPC（被消灭的不会在再次进入时复活）
+  for (int y = 0; y < T; ++y)
+  {
+    for (int x = 0; x < T; ++x)
+    {
+      if (chunk.tiles[static_cast<std::size_t>(y) * T + x] != 'X')
+        continue;
+      NpcRecord record;
+      record.tileX = chunk.coord.x * T + x;
+      record.tileY = chunk.coord.y * T + y;
+      record.offset = {m_tileSize / 2.f, m_tileSize / 2.f};
+      m_arrivals.push_back(record);
+    }
+  }
+}
+
+void ChunkStreamer::captureWalls(const Maze &maze)
+{
+  for (int oy = -WINDOW_RADIUS; oy <= WINDOW_RADIUS; ++oy)
+  {
+    for (int ox = -WINDOW_RADIUS; ox <= WINDOW_RADIUS; ++ox)
+      m_records[{m_center.x + ox, m_center.y + oy}].walls.clear();
+  }
+  for (WallDelta delta : maze.getWallDeltas())
+  {
+    delta.col += m_originX;
+    delta.row += m_originY;
+    m_records[ChunkedMaze::chunkOf(delta.col, delta.row)].walls.push_back(delta);
+  }
+}
+
+void ChunkStreamer::loadWindow(Maze &maze)
+{
+  m_originX = (m_center.x - WINDOW_RADIUS) * T;
+  m_originY = (m_center.y - WINDOW_RADIUS) * T;
+  m_chunks.updateResidency({{m_center.x * T, m_center.y * T}}, WINDOW_RADIUS);
+
+  std::vector<WallDelta> deltas;
+  for (int oy = -WINDOW_RADIUS; oy <= WINDOW_RADIUS; ++oy)
+  {
+    for (int ox = -WINDOW_RADIUS; ox <= WINDOW_RADIUS; ++ox)
+    {
+      auto it = m_records.find({m_center.x + ox, m_center.y + oy});
+      if (it == m_records.end())
+        continue;
+      for (WallDelta delta : it->second.walls)
+      {
+        delta.col -= m_originX;
+        delta.row -= m_originY;
+        deltas.push_back(delta);
+      }
+    }
+  }
+  maze.loadChunkWindow(m_chunks, m_originX, m_originY, WINDOW_TILES, deltas);
+}
@@ -0,0 +1,195 @@
+#include "ChunkedMaze.hpp"
+#include "MazeRandom.hpp"
+#include <algorithm>
+#include <array>
+
+namespace
+{
+  uint64_t hashCoord(uint64_t seed, int x, int y, uint64_t salt)
+  {
+    uint64_t h = MazeRandom::mix(seed ^ salt);
+    h = MazeRandom::mix(h ^ static_cast<uint32_t>(x));
+    return MazeRandom::mix(h ^ static_cast<uint32_t>(y));
+  }
+
+  constexpr uint64_t SALT_CHUNK = 0x43484E4Bull;  // 区块内容
+  constexpr uint64_t SALT_WEST = 0x57455354ull;   // 西侧门
+  constexpr uint64_t SALT_NORTH = 0x4E525448ull;  // 北侧门
+  constexpr uint64_t SALT_EXIT = 0x45584954ull;   // 出口方向
+
+  int floorDiv(int value, int divisor)
+  {
+    int q = value / divisor;
+    return (value % divisor != 0 && (value < 0) != (divisor < 0)) ? q - 1 : q;
+  }
+}
+
+ChunkedMaze::ChunkedMaze(uint64_t seed, int enemiesPerChunk, float destructibleRatio)
+    : m_seed(seed), m_enemiesPerChunk(enemiesPerChunk), m_destructibleRatio(destructibleRatio)
+{
+}
+
+void ChunkedMaze::generateChunk(uint64_t seed, ChunkCoord coord, int enemiesPerChunk, float destructibleRatio,
+                                std::vector<char> &tiles)
+{
+  constexpr int T = CHUNK_TILES;
+  constexpr int R = CHUNK_ROOMS;
+  tiles.assign(static_cast<std::size_t>(T) * T, '#');
+  auto tile = [&](int x, int y) -> char &
+  { return tiles[static_cast<std::size_t>(y) * T + x]; };
+
+  MazeRandom rng(hashCoord(seed, coord.x, coord.y, SALT_CHUNK));
+
+  // 房间网格上的回溯挖掘（显式栈，房间 (rx, ry) 对应格子 (2rx+1, 2ry+1)）
+  static constexpr int dx[] = {0, 1, 0, -1};
+  static constexpr int dy[] = {-1, 0, 1, 0};
+  std::array<bool, R * R> visited{};
+  struct Frame
+  {
+    int rx, ry;
+    std::array<int, 4> dirs;
+    int next;
+  };
+  std::vector<Frame> stack;
+  stack.reserve(R * R);
+
+  auto enter = [&](int rx, int ry)
+  {
+    Frame frame{rx, ry, {0, 1, 2, 3}, 0};
+    rng.shuffle(frame.dirs.begin(), frame.dirs.end());
+    visited[ry * R + rx] = true;
+    tile(2 * rx + 1, 2 * ry + 1) = '.';
+    stack.push_back(frame);
+  };
+
+  enter(rng.below(R), rng.below(R));
+  while (!stack.empty())
+  {
+    Frame &frame = stack.back();
+    if (frame.next >= 4)
+    {
+      stack.pop_back();
+      continue;
+    }
+    int dir = frame.dirs[frame.next++];
+    int rx = frame.rx;
+    int ry = frame.ry;
+    int nx = rx + dx[dir];
+    int ny = ry + dy[dir];
+    if (nx < 0 || nx >= R || ny < 0 || ny >= R || visited[ny * R + nx])
+      continue;
+    tile(2 * rx + 1 + dx[dir], 2 * ry + 1 + dy[dir]) = '.';
+    enter(nx, ny);
+  }
+
+  // 西侧与北侧的门：由边的哈希决定，相邻区块得到同一位置
+  int westRow = static_cast<int>(hashCoord(seed, coord.x, coord.y, SALT_WEST) % R);
+  int northCol = static_cast<int>(hashCoord(seed, coord.x, coord.y, SALT_NORTH) % R);
+  tile(0, 2 * westRow + 1) = '.';
+  tile(2 * northCol + 1, 0) = '.';
+
+  // 可破坏墙：只考虑区块内部、与通道相邻的墙（边界墙保持不变，门的位置不受影响）
+  for (int y = 1; y < T; ++y)
+  {
+    for (int x = 1; x < T; ++x)
+    {
+      if (tile(x, y) != '#')
+        continue;
+      bool adjacent = false;
+      for (int d = 0; d < 4 && !adjacent; ++d)
+      {
+        int ax = x + dx[d];
+        int ay = y + dy[d];
+        adjacent = ax >= 0 && ax < T && ay >= 0 && ay < T && tile(ax, ay) == '.';
+      }
+      if (adjacent && rng.unit() < destructibleRatio)
+        tile(x, y) = '*';
+    }
+  }
+
+  // 敌人：随机房间（世界原点所在房间留给起点）
+  for (int i = 0; i < enemiesPerChunk; ++i)
+  {
+    int rx = rng.below(R);
+    int ry = rng.below(R);
+    if (coord.x == 0 && coord.y == 0 && rx == 0 && ry == 0)
+      continue;
+    tile(2 * rx + 1, 2 * ry + 1) = 'X';
+  }
+  if (coord.x == 0 && coord.y == 0)
+    tile(1, 1) = 'S';
+
+  auto [exitX, exitY] = exitTile(seed);
+  if (chunkOf(exitX, exitY) == coord)
+    tile(exitX - coord.x * T, exitY - coord.y * T) = 'E';
+}
+
+std::pair<int, int> ChunkedMaze::exitTile(uint64_t seed)
+{
+  // 8 个方向之一（排除原点）
+  static constexpr int dirX[] = {1, 1, 0, -1, -1, -1, 0, 1};
+  static constexpr int dirY[] = {0, 1, 1, 1, 0, -1, -1, -1};
+  int dir = static_cast<int>(hashCoord(seed, 0, 0, SALT_EXIT) % 8);
+  int center = CHUNK_ROOMS / 2 * 2 + 1;
+  return {dirX[dir] * EXIT_DISTANCE * CHUNK_TILES + center, dirY[dir] * EXIT_DISTANCE * CHUNK_TILES + center};
+}
+
+ChunkedMaze::ChunkCoord ChunkedMaze::chunkOf(int tileX, int tileY)
+{
+  return {floorDiv(tileX, CHUNK_TILES), floorDiv(tileY, CHUNK_TILES)};
+}
+
+void ChunkedMaze::updateResidency(const std::vector<std::pair<int, int>> &focusTiles, int radius)
+{
+  m_wanted.clear();
+  for (const auto &[tx, ty] : focusTiles)
+  {
+    ChunkCoord center = chunkOf(tx, ty);
+    for (int oy = -radius; oy <= radius; ++oy)
+    {
+      for (int ox = -radius; ox <= radius; ++ox)
+      {
+        ChunkCoord coord{center.x + ox, center.y + oy};
+        if (std::find(m_wanted.begin(), m_wanted.end(), coord) == m_wanted.end())
+          m_wanted.push_back(coord);
+      }
+    }
+  }
+
+  // 换出不再需要的区块
+  for (auto it = m_chunks.begin(); it != m_chunks.end();)
+  {
+    if (std::find(m_wanted.begin(), m_wanted.end(), it->first) != m_wanted.end())
+    {
+      ++it;
+      continue;
+    }
+    if (m_onChunkUnloaded)
+      m_onChunkUnloaded(it->second);
+    it = m_chunks.erase(it);
+  }
+
+  // 换入缺失的区块
+  for (const auto &coord : m_wanted)
+  {
+    if (m_chunks.count(coord))
+      continue;
+    Chunk &chunk = m_chunks[coord];
+    chunk.coord = coord;
+    generateChunk(m_seed, coord, m_enemiesPerChunk, m_destructibleRatio, chunk.tiles);
+    m_chunksGenerated++;
+    if (m_onChunkLoaded)
+      m_onChunkLoaded(chunk);
+  }
+}
+
+char ChunkedMaze::tileAt(int x, int y) const
+{
+  ChunkCoord coord = chunkOf(x, y);
+  auto it = m_chunks.find(coord);
+  if (it == m_chunks.end())
+    return '#';
+  int lx = x - coord.x * CHUNK_TILES;
+  int ly = y - coord.y * CHUNK_TILES;
+  return it->second.tiles[static_cast<std::size_t>(ly) * CHUNK_TILES + lx];
+}
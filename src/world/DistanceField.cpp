@@ -0,0 +1,131 @@
+#include "DistanceField.hpp"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+void DistanceField::reset(int cols, int rows, float tileSize, float inset, float cornerRadius)
+{
+  m_cols = std::max(0, cols);
+  m_rows = std::max(0, rows);
+  m_tileSize = tileSize;
+  m_inset = inset;
+  m_cornerRadius = cornerRadius;
+  m_spacing = tileSize / SAMPLES_PER_TILE;
+  m_sampleCols = m_cols * SAMPLES_PER_TILE + 1;
+  m_sampleRows = m_rows * SAMPLES_PER_TILE + 1;
+  m_cells.assign(static_cast<std::size_t>(m_cols) * m_rows, 0);
+  m_samples.assign(static_cast<std::size_t>(m_sampleCols) * m_sampleRows, m_tileSize);
+}
+
+void DistanceField::setCell(int col, int row, uint8_t value)
+{
+  if (col < 0 || col >= m_cols || row < 0 || row >= m_rows)
+    return;
+  m_cells[static_cast<std::size_t>(row) * m_cols + col] = value;
+}
+
+void DistanceField::rebuild()
+{
+  computeSamples(0, 0, m_sampleCols - 1, m_sampleRows - 1);
+}
+
+void DistanceField::patch(int col, int row)
+{
+  // 相邻格的圆角也可能变化，它们影响一格距离内的采样点：重算 5x5 格范围
+  int sx0 = std::max(0, (col - 2) * SAMPLES_PER_TILE);
+  int sy0 = std::max(0, (row - 2) * SAMPLES_PER_TILE);
+  int sx1 = std::min(m_sampleCols - 1, (col + 3) * SAMPLES_PER_TILE);
+  int sy1 = std::min(m_sampleRows - 1, (row + 3) * SAMPLES_PER_TILE);
+  computeSamples(sx0, sy0, sx1, sy1);
+}
+
+void DistanceField::computeSamples(int sx0, int sy0, int sx1, int sy1)
+{
+  for (int sy = sy0; sy <= sy1; sy++)
+  {
+    float *row = m_samples.data() + static_cast<std::size_t>(sy) * m_sampleCols;
+    for (int sx = sx0; sx <= sx1; sx++)
+      row[sx] = exactDistance(sx * m_spacing, sy * m_spacing);
+  }
+}
+
+float DistanceField::exactDistance(float x, float y) const
+{
+  int col0 = static_cast<int>(std::floor(x / m_tileSize));
+  int row0 = static_cast<int>(std::floor(y / m_tileSize));
+  float halfSize = (m_tileSize - 2.f * m_inset) / 2.f;
+  float best = m_tileSize;
+
+  for (int r = row0 - 1; r <= row0 + 1; r++)
+  {
+    for (int c = col0 - 1; c <= col0 + 1; c++)
+    {
+      uint8_t value = cell(c, r);
+      if (!(value & CELL_BLOCKING))
+        continue;
+
+      // 圆角矩形的有符号距离：按所在象限取对应角的圆角半径
+      float px = x - (c + 0.5f) * m_tileSize;
+      float py = y - (r + 0.5f) * m_tileSize;
+      int corner = py < 0.f ? (px < 0.f ? 0 : 1) : (px < 0.f ? 3 : 2);
+      float radius = (value & cornerBit(corner)) ? m_cornerRadius : 0.f;
+
+      float qx = std::abs(px) - halfSize + radius;
+      float qy = std::abs(py) - halfSize + radius;
+      float outside = std::hypot(std::max(qx, 0.f), std::max(qy, 0.f));
+      float inside = std::min(std::max(qx, qy), 0.f);
+      best = std::min(best, outside + inside - radius);
+    }
+  }
+  return best;
+}
+
+float DistanceField::distance(float x, float y, float *gradX, float *gradY) const
+{
+  if (m_samples.empty())
+  {
+    if (gradX)
+      *gradX = 0.f;
+    if (gradY)
+      *gradY = 0.f;
+    return m_tileSize;
+  }
+
+  // 地图外按边缘采样点处理
+  float fx = std::clamp(x / m_spacing, 0.f, static_cast<float>(m_sampleCols - 1));
+  float fy = std::clamp(y / m_spacing, 0.f, static_cast<float>(m_sampleRows - 1));
+  int ix = std::min(static_cast<int>(fx), m_sampleCols - 2);
+  int iy = std::min(static_cast<int>(fy), m_sampleRows - 2);
+  float tx = fx - ix;
+  float ty = fy - iy;
+
+  const float *row0 = m_samples.data() + static_cast<std::size_t>(iy) * m_sampleCols + ix;
+  const float *row1 = row0 + m_sampleCols;
+  float d00 = row0[0];
+  float d10 = row0[1];
+  float d01 = row1[0];
+  float d11 = row1[1];
+
+  if (gradX)
+    *gradX = ((d10 - d00) * (1.f - ty) + (d11 - d01) * ty) / m_spacing;
+  if (gradY)
+    *gradY = ((d01 - d00) * (1.f - tx) + (d11 - d10) * tx) / m_spacing;
+
+  float top = d00 + (d10 - d00) * tx;
+  float bottom = d01 + (d11 - d01) * tx;
+  return top + (bottom - top) * ty;
+}
+
+void DistanceField::swap(DistanceField &other)
+{
+  std::swap(m_cols, other.m_cols);
+  std::swap(m_rows, other.m_rows);
+  std::swap(m_tileSize, other.m_tileSize);
+  std::swap(m_inset, other.m_inset);
+  std::swap(m_cornerRadius, other.m_cornerRadius);
+  std::swap(m_spacing, other.m_spacing);
+  std::swap(m_sampleCols, other.m_sampleCols);
+  std::swap(m_sampleRows, other.m_sampleRows);
+  m_cells.swap(other.m_cells);
+  m_samples.swap(other.m_samples);
+}
@@ -1,4 +1,5 @@
 #include "Maze.hpp"
+#include "ChunkedMaze.hpp"
 #include <cmath>
 #include <cstdint>
 #include <algorithm>
@@ -14,6 +15,7 @@ void Maze::loadFromString(const std::vector<std::string> &map)
 
   // 保存原始迷宫数据用于网络传输
   m_mazeData = map;
+  m_seed = 0;
 
   m_rows = static_cast<int>(map.size());
   m_cols = 0;
@@ -116,6 +118,16 @@ void Maze::loadFromString(const std::vector<std::string> &map)
 
   // 计算每个墙体的圆角
   calculateRoundedCorners();
+
+  // 构建射线检测用的占用网格与碰撞用的距离场（依赖圆角）
+  m_occupancy.resize(m_cols, m_rows, m_tileSize);
+  m_distanceField.reset(m_cols, m_rows, m_tileSize, 1.f, WALL_CORNER_RADIUS);
+  for (int r = 0; r < m_rows; ++r)
+  {
+    for (int c = 0; c < m_cols; ++c)
+      syncOccupancy(r, c);
+  }
+  m_distanceField.rebuild();
 }
 
 void Maze::generateRandomMaze(int width, int height, unsigned int seed, int enemyCount, bool multiplayerMode, bool escapeMode)
@@ -133,6 +145,24 @@ void Maze::generateRandomMaze(int width, int height, unsigned int seed, int enem
   generator.setEscapeMode(escapeMode);
   std::vector<std::string> mazeData = generator.generate();
   loadFromString(mazeData);
+  m_seed = generator.getSeed();
+}
+
+void Maze::swap(Maze &other)
+{
+  std::swap(m_walls, other.m_walls);
+  m_occupancy.swap(other.m_occupancy);
+  m_distanceField.swap(other.m_distanceField);
+  std::swap(m_mazeData, other.m_mazeData);
+  std::swap(m_startPosition, other.m_startPosition);
+  std::swap(m_exitPosition, other.m_exitPosition);
+  std::swap(m_enemySpawnPoints, other.m_enemySpawnPoints);
+  std::swap(m_spawn1Position, other.m_spawn1Position);
+  std::swap(m_spawn2Position, other.m_spawn2Position);
+  std::swap(m_rows, other.m_rows);
+  std::swap(m_cols, other.m_cols);
+  std::swap(m_tileSize, other.m_tileSize);
+  std::swap(m_seed, other.m_seed);
 }
 
 void Maze::update(float dt)
@@ -202,6 +232,76 @@ void Maze::draw(sf::RenderWindow &window) const
 }
 
 bool Maze::checkCollision(sf::Vector2f position, float radius) const
+{
+  // 距离场在一格以外截断，且插值有 1~2 像素误差：只用于小半径
+  if (!m_distanceField.empty() && radius < m_distanceField.maxDistance() * 0.5f)
+    return m_distanceField.distance(position.x, position.y) < radius;
+  return checkCollisionExact(position, radius);
+}
+
+float Maze::getWallDistance(sf::Vector2f position, sf::Vector2f *normal) const
+{
+  float gx = 0.f;
+  float gy = 0.f;
+  float d = m_distanceField.distance(position.x, position.y, &gx, &gy);
+  if (normal)
+  {
+    float len = std::sqrt(gx * gx + gy * gy);
+    *normal = len > 1e-4f ? sf::Vector2f{gx / len, gy / len} : sf::Vector2f{0.f, 0.f};
+  }
+  return d;
+}
+
+sf::Vector2f Maze::resolveMovement(sf::Vector2f from, sf::Vector2f to, float radius) const
+{
+  if (!checkCollision(to, radius))
+    return to;
+
+  // 沿法线把圆心推到离墙 radius 处（最多两次，拐角处法线会变）
+  auto pushOut = [&](sf::Vector2f pos)
+  {
+    for (int i = 0; i < 2; ++i)
+    {
+      sf::Vector2f normal;
+      float d = getWallDistance(pos, &normal);
+      if (d >= radius || (normal.x == 0.f && normal.y == 0.f))
+        break;
+      pos += normal * (radius - d + 0.01f);
+    }
+    return pos;
+  };
+
+  // 原本就卡在墙里（新放的墙、外推的远端位置）：直接推出，避免永远卡住
+  if (checkCollision(from, radius))
+    return pushOut(to);
+
+  // 去掉撞向墙面的分量，剩下的切向分量就是滑动方向
+  sf::Vector2f movement = to - from;
+  sf::Vector2f normal;
+  getWallDistance(to, &normal);
+  float into = movement.x * normal.x + movement.y * normal.y;
+  if (into < 0.f)
+  {
+    sf::Vector2f slid = pushOut(from + movement - normal * into);
+    if (!checkCollision(slid, radius))
+      return slid;
+  }
+
+  // 兜底：只沿 X 或只沿 Y 移动
+  sf::Vector2f posX = {to.x, from.y};
+  sf::Vector2f posY = {from.x, to.y};
+  bool canMoveX = !checkCollision(posX, radius);
+  bool canMoveY = !checkCollision(posY, radius);
+  if (canMoveX && canMoveY)
+    return std::abs(movement.x) > std::abs(movement.y) ? posX : posY;
+  if (canMoveX)
+    return posX;
+  if (canMoveY)
+    return posY;
+  return from;
+}
+
+bool Maze::checkCollisionExact(sf::Vector2f position, float radius) const
 {
   // 检查位置周围的墙体
   int minC = std::max(0, static_cast<int>((position.x - radius) / m_tileSize));
@@ -303,6 +403,7 @@ bool Maze::bulletHit(sf::Vector2f bulletPos, float damage)
     if (wall.health <= 0)
     {
       wall.type = WallType::None; // 墙被摧毁
+      onWallChanged(r, c);
     }
     return true;
   }
@@ -348,6 +449,7 @@ WallDestroyResult Maze::bulletHitWithResult(sf::Vector2f bulletPos, float damage
 
       // 清除当前墙格
       wall.type = WallType::None;
+      onWallChanged(r, c);
     }
     else
     {
@@ -386,6 +488,7 @@ WallDestroyResult Maze::applyWallDamage(int row, int col, float damage, bool for
       result.gridX = col;
       result.gridY = row;
       wall.type = WallType::None;
+      onWallChanged(row, col);
     }
     else
     {
@@ -398,6 +501,7 @@ WallDestroyResult Maze::applyWallDamage(int row, int col, float damage, bool for
         result.gridX = col;
         result.gridY = row;
         wall.type = WallType::None;
+        onWallChanged(row, col);
       }
       else
       {
@@ -413,6 +517,50 @@ WallDestroyResult Maze::applyWallDamage(int row, int col, float damage, bool for
   return result;
 }
 
+std::vector<WallDestroyResult> Maze::applyWallChanges(const std::vector<WallChange> &changes)
+{
+  std::vector<WallDestroyResult> results(changes.size());
+  std::vector<GridPos> changed;
+  bool placed = false;
+
+  for (std::size_t i = 0; i < changes.size(); ++i)
+  {
+    const WallChange &change = changes[i];
+    if (change.row < 0 || change.row >= m_rows || change.col < 0 || change.col >= m_cols)
+      continue;
+
+    Wall &wall = m_walls[change.row][change.col];
+    if (change.placed && wall.type == WallType::None)
+    {
+      setPlacedWall(change.row, change.col);
+      changed.push_back({change.col, change.row});
+      placed = true;
+    }
+    if (wall.type != WallType::Destructible || (change.damage <= 0.f && !change.destroyed))
+      continue;
+
+    WallDestroyResult &result = results[i];
+    result.position = {change.col * m_tileSize + m_tileSize / 2.f, change.row * m_tileSize + m_tileSize / 2.f};
+    result.gridX = change.col;
+    result.gridY = change.row;
+    wall.health -= change.damage;
+    if (change.destroyed || wall.health <= 0)
+    {
+      result.destroyed = true;
+      result.attribute = wall.attribute;
+      wall.type = WallType::None;
+      changed.push_back({change.col, change.row});
+    }
+  }
+
+  // 放置会改变相邻墙体的圆角，整批只重算一次
+  if (placed)
+    calculateRoundedCorners();
+  for (const GridPos &pos : changed)
+    onWallChanged(pos.y, pos.x);
+  return results;
+}
+
 bool Maze::isAtExit(sf::Vector2f position, float radius) const
 {
   float dx = position.x - m_exitPosition.x;
@@ -466,7 +614,18 @@ bool Maze::placeWall(sf::Vector2f worldPos)
   int c = static_cast<int>(worldPos.x / m_tileSize);
   int r = static_cast<int>(worldPos.y / m_tileSize);
 
-  Wall &wall = m_walls[r][c];
+  setPlacedWall(r, c);
+
+  // 重新计算圆角
+  calculateRoundedCorners();
+  onWallChanged(r, c);
+
+  return true;
+}
+
+void Maze::setPlacedWall(int row, int col)
+{
+  Wall &wall = m_walls[row][col];
 
   // 设置为可破坏的棕色墙
   wall.type = WallType::Destructible;
@@ -475,19 +634,104 @@ bool Maze::placeWall(sf::Vector2f worldPos)
   wall.maxHealth = 100.f;
 
   // 设置形状
-  float x = c * m_tileSize;
-  float y = r * m_tileSize;
+  float x = col * m_tileSize;
+  float y = row * m_tileSize;
   wall.shape.setSize({m_tileSize - 2.f, m_tileSize - 2.f});
   wall.shape.setCornerRadius(WALL_CORNER_RADIUS);
   wall.shape.setPosition({x + 1.f, y + 1.f});
   wall.shape.setFillColor(m_destructibleColor);
   wall.shape.setOutlineColor(sf::Color(100, 60, 20));
   wall.shape.setOutlineThickness(1.f);
+}
 
-  // 重新计算圆角
-  calculateRoundedCorners();
+std::vector<WallDelta> Maze::getWallDeltas() const
+{
+  std::vector<WallDelta> deltas;
+  for (int r = 0; r < m_rows; ++r)
+  {
+    for (int c = 0; c < m_cols; ++c)
+    {
+      char ch = c < static_cast<int>(m_mazeData[r].size()) ? m_mazeData[r][c] : '.';
+      bool original = ch == '*' || ch == 'G' || ch == 'H';
+      const Wall &wall = m_walls[r][c];
 
-  return true;
+      if (wall.type == WallType::Destructible)
+      {
+        if (!original || wall.health < wall.maxHealth)
+          deltas.push_back({r, c, true, wall.attribute, wall.health});
+      }
+      else if (original)
+      {
+        deltas.push_back({r, c, false, WallAttribute::None, 0.f});
+      }
+    }
+  }
+  return deltas;
+}
+
+void Maze::restoreWallDeltas(const std::vector<WallDelta> &deltas)
+{
+  // 重新载入原始地图（loadFromString 会清零种子）
+  unsigned int seed = m_seed;
+  std::vector<std::string> original = m_mazeData;
+  loadFromString(original);
+  m_seed = seed;
+  applyWallDeltas(deltas);
+}
+
+void Maze::loadChunkWindow(const ChunkedMaze &chunks, int originX, int originY, int size,
+                           const std::vector<WallDelta> &deltas)
+{
+  std::vector<std::string> window(size, std::string(size, '#'));
+  for (int r = 0; r < size; ++r)
+  {
+    for (int c = 0; c < size; ++c)
+    {
+      char ch = chunks.tileAt(originX + c, originY + r);
+      window[r][c] = (ch == 'X' || ch == 'S') ? '.' : ch;
+    }
+  }
+  loadFromString(window);
+
+  auto toWindow = [&](std::pair<int, int> tile)
+  {
+    return sf::Vector2f((tile.first - originX + 0.5f) * m_tileSize, (tile.second - originY + 0.5f) * m_tileSize);
+  };
+  m_startPosition = toWindow(ChunkedMaze::startTile());
+  m_exitPosition = toWindow(ChunkedMaze::exitTile(chunks.getSeed()));
+
+  if (!deltas.empty())
+    applyWallDeltas(deltas);
+}
+
+void Maze::applyWallDeltas(const std::vector<WallDelta> &deltas)
+{
+  for (const auto &delta : deltas)
+  {
+    if (delta.row < 0 || delta.row >= m_rows || delta.col < 0 || delta.col >= m_cols)
+      continue;
+
+    Wall &wall = m_walls[delta.row][delta.col];
+    if (!delta.present)
+    {
+      if (wall.type == WallType::Destructible)
+        wall.type = WallType::None;
+      continue;
+    }
+
+    if (wall.type == WallType::None)
+      setPlacedWall(delta.row, delta.col);
+    if (wall.type == WallType::Destructible)
+      wall.health = std::min(delta.health, wall.maxHealth);
+  }
+
+  calculateRoundedCorners();
+  for (int r = 0; r < m_rows; ++r)
+  {
+    for (int c = 0; c < m_cols; ++c)
+      syncOccupancy(r, c);
+  }
+  m_distanceField.rebuild();
 }
 
 GridPos Maze::worldToGrid(sf::Vector2f pos) const
@@ -722,159 +966,57 @@ Maze::PathResult Maze::findPathThroughDestructible(sf::Vector2f start, sf::Vecto
 
 int Maze::checkLineOfSight(sf::Vector2f start, sf::Vector2f end) const
 {
-  // 使用 Bresenham 线段算法检查视线
   // 返回值：0 = 无阻挡, 1 = 有可拆墙阻挡, 2 = 有不可拆墙阻挡
-
-  GridPos startGrid = worldToGrid(start);
-  GridPos endGrid = worldToGrid(end);
-
-  int x0 = startGrid.x, y0 = startGrid.y;
-  int x1 = endGrid.x, y1 = endGrid.y;
-
-  int dx = std::abs(x1 - x0);
-  int dy = std::abs(y1 - y0);
-  int sx = x0 < x1 ? 1 : -1;
-  int sy = y0 < y1 ? 1 : -1;
-  int err = dx - dy;
-
-  int result = 0; // 无阻挡
-
-  while (true)
-  {
-    // 检查当前格子
-    if (y0 >= 0 && y0 < m_rows && x0 >= 0 && x0 < m_cols)
-    {
-      WallType type = m_walls[y0][x0].type;
-      if (type == WallType::Solid)
-      {
-        return 2; // 不可拆墙阻挡
-      }
-      else if (type == WallType::Destructible)
-      {
-        result = 1; // 可拆墙阻挡（继续检查是否有不可拆墙）
-      }
-    }
-
-    if (x0 == x1 && y0 == y1)
-      break;
-
-    int e2 = 2 * err;
-    if (e2 > -dy)
-    {
-      err -= dy;
-      x0 += sx;
-    }
-    if (e2 < dx)
-    {
-      err += dx;
-      y0 += sy;
-    }
-  }
-
-  return result;
+  RayHit hit = m_occupancy.castRay({start.x, start.y, end.x, end.y}, RayMode::LineOfSight);
+  return static_cast<int>(hit.block);
 }
 
 int Maze::checkBulletPath(sf::Vector2f start, sf::Vector2f target) const
 {
-  // 使用射线步进法更精确地检测子弹路径
-  // 每次步进一小段距离，检查是否碰到墙壁
-
+  // 精确遍历子弹经过的每个格子，子弹停在第一个墙格
   sf::Vector2f direction = target - start;
-  float distance = std::sqrt(direction.x * direction.x + direction.y * direction.y);
-
-  if (distance < 1.f)
+  if (direction.x * direction.x + direction.y * direction.y < 1.f)
     return 0; // 起点和终点太近
 
-  // 归一化方向
-  direction /= distance;
-
-  // 步进大小（小于格子大小的一半，确保不会跳过墙壁）
-  const float stepSize = m_tileSize * 0.05f;
-  int steps = static_cast<int>(distance / stepSize) + 1;
+  RayHit hit = m_occupancy.castRay({start.x, start.y, target.x, target.y}, RayMode::FirstHit);
+  return static_cast<int>(hit.block);
+}
 
-  int result = 0; // 默认无阻挡
+sf::Vector2f Maze::getFirstBlockedPosition(sf::Vector2f start, sf::Vector2f end) const
+{
+  // 找到视线上第一个被阻挡的格子
+  RayHit hit = m_occupancy.castRay({start.x, start.y, end.x, end.y}, RayMode::FirstHit);
+  if (hit.block == CellBlock::Empty)
+    return end; // 没有阻挡，返回目标位置
+  return gridToWorld({hit.col, hit.row});
+}
 
-  for (int i = 1; i <= steps; ++i)
+void Maze::syncOccupancy(int row, int col)
+{
+  const Wall &wall = m_walls[row][col];
+  CellBlock block = wall.type == WallType::Solid          ? CellBlock::Solid
+                    : wall.type == WallType::Destructible ? CellBlock::Destructible
+                                                          : CellBlock::Empty;
+  m_occupancy.set(col, row, block);
+
+  uint8_t cell = block == CellBlock::Empty ? 0 : DistanceField::CELL_BLOCKING;
+  for (int corner = 0; corner < 4; ++corner)
   {
-    float t = std::min(static_cast<float>(i) * stepSize, distance);
-    sf::Vector2f checkPos = start + direction * t;
-
-    GridPos grid = worldToGrid(checkPos);
-
-    // 边界检查
-    if (grid.y < 0 || grid.y >= m_rows || grid.x < 0 || grid.x >= m_cols)
-      continue;
-
-    WallType type = m_walls[grid.y][grid.x].type;
-
-    if (type == WallType::Solid)
-    {
-      return 2; // 会先命中不可破坏墙
-    }
-    else if (type == WallType::Destructible)
-    {
-      if (result == 0)
-      {
-        result = 1; // 记录会命中可破坏墙，但继续检查后面是否有不可破坏墙
-      }
-      // 一旦碰到可破坏墙，子弹就会停止，所以后面的墙不会被击中
-      return result;
-    }
-
-    // 检查是否已经到达目标附近
-    float remainDist = std::sqrt((target.x - checkPos.x) * (target.x - checkPos.x) +
-                                 (target.y - checkPos.y) * (target.y - checkPos.y));
-    if (remainDist < stepSize)
-      break;
+    if (wall.roundedCorners[corner])
+      cell |= DistanceField::cornerBit(corner);
   }
-
-  return result;
+  m_distanceField.setCell(col, row, cell);
 }
 
-sf::Vector2f Maze::getFirstBlockedPosition(sf::Vector2f start, sf::Vector2f end) const
+void Maze::onWallChanged(int row, int col)
 {
-  // 找到视线上第一个被阻挡的位置
-  GridPos startGrid = worldToGrid(start);
-  GridPos endGrid = worldToGrid(end);
-
-  int x0 = startGrid.x, y0 = startGrid.y;
-  int x1 = endGrid.x, y1 = endGrid.y;
-
-  int dx = std::abs(x1 - x0);
-  int dy = std::abs(y1 - y0);
-  int sx = x0 < x1 ? 1 : -1;
-  int sy = y0 < y1 ? 1 : -1;
-  int err = dx - dy;
-
-  while (true)
+  // 放置墙壁会重算相邻墙体的圆角，一并同步
+  for (int r = std::max(0, row - 1); r <= std::min(m_rows - 1, row + 1); ++r)
   {
-    // 检查当前格子
-    if (y0 >= 0 && y0 < m_rows && x0 >= 0 && x0 < m_cols)
-    {
-      WallType type = m_walls[y0][x0].type;
-      if (type == WallType::Solid || type == WallType::Destructible)
-      {
-        return gridToWorld({x0, y0});
-      }
-    }
-
-    if (x0 == x1 && y0 == y1)
-      break;
-
-    int e2 = 2 * err;
-    if (e2 > -dy)
-    {
-      err -= dy;
-      x0 += sx;
-    }
-    if (e2 < dx)
-    {
-      err += dx;
-      y0 += sy;
-    }
+    for (int c = std::max(0, col - 1); c <= std::min(m_cols - 1, col + 1); ++c)
+      syncOccupancy(r, c);
   }
-
-  return end; // 没有阻挡，返回目标位置
+  m_distanceField.patch(col, row);
 }
 
 bool Maze::isWall(int row, int col) const
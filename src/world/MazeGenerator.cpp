@@ -1,7 +1,8 @@
 #include "MazeGenerator.hpp"
 #include <algorithm>
-#include <ctime>
+#include <random>
 #include <set>
+#include <tuple>
 
 MazeGenerator::MazeGenerator(int width, int height)
     : m_width(width), m_height(height), m_seed(0), m_seedSet(false)
@@ -21,39 +22,43 @@ void MazeGenerator::setSeed(unsigned int seed)
 
 std::vector<std::string> MazeGenerator::generate()
 {
-  // 在生成开始时设置随机数种子，确保相同种子产生相同结果
-  if (m_seedSet)
-  {
-    m_rng.seed(m_seed);
-  }
-  else
+  // 未指定种子时随机选一个并记录下来（联机时只需发送种子即可让对方重新生成）
+  if (!m_seedSet)
   {
-    m_rng.seed(static_cast<unsigned int>(std::time(nullptr)));
+    std::random_device device;
+    do
+    {
+      m_seed = device();
+    } while (m_seed == 0);
+    m_seedSet = true;
   }
+  // 在生成开始时设置随机数种子，确保相同种子产生相同结果
+  m_rng.seed(m_seed);
 
   // 初始化网格，全部填充墙
-  m_grid.clear();
-  m_grid.resize(m_height, std::vector<char>(m_width, '#'));
+  m_grid.assign(static_cast<std::size_t>(m_width) * m_height, '#');
+
+  // 使用回溯法生成迷宫（显式栈），从 (1,1) 开始挖通道
+  carvePassages(1, 1);
 
-  // 使用递归回溯法生成迷宫
-  // 从 (1,1) 开始挖通道
-  carvePassage(1, 1);
+  // 空地列表只收集一次，供所有放置步骤共用
+  collectOpenCells();
 
-  // 根据模式放置起点/出生点和终点
+  // 根据模式放置起点/出生点和终点（距离图同时用于选点和连通性检查）
   if (m_multiplayerMode)
   {
     // 多人模式：放置两个出生点和终点
     placeMultiplayerSpawns();
     // 确保两个出生点到终点都有路径
-    ensurePath(m_spawn1X, m_spawn1Y, m_endX, m_endY);
-    ensurePath(m_spawn2X, m_spawn2Y, m_endX, m_endY);
+    ensurePath(m_spawn1X, m_spawn1Y, m_endX, m_endY, m_distance[0]);
+    ensurePath(m_spawn2X, m_spawn2Y, m_endX, m_endY, m_distance[1]);
   }
   else
   {
     // 单人模式：放置起点和终点
     placeStartAndEnd();
     // 确保起点到终点有路径
-    ensurePath(m_startX, m_startY, m_endX, m_endY);
+    ensurePath(m_startX, m_startY, m_endX, m_endY, m_distance[0]);
   }
 
   // 放置敌人
@@ -67,61 +72,116 @@ std::vector<std::string> MazeGenerator::generate()
   result.reserve(m_height);
   for (int y = 0; y < m_height; ++y)
   {
-    result.push_back(std::string(m_grid[y].begin(), m_grid[y].end()));
+    auto row = m_grid.begin() + static_cast<std::ptrdiff_t>(y) * m_width;
+    result.emplace_back(row, row + m_width);
   }
 
   return result;
 }
 
-void MazeGenerator::carvePassage(int cx, int cy)
+void MazeGenerator::carvePassages(int startX, int startY)
 {
   // 四个方向：上、右、下、左
-  int dx[] = {0, 2, 0, -2};
-  int dy[] = {-2, 0, 2, 0};
+  static constexpr int dx[] = {0, 2, 0, -2};
+  static constexpr int dy[] = {-2, 0, 2, 0};
 
-  // 随机打乱方向
-  std::vector<int> dirs = {0, 1, 2, 3};
-  std::shuffle(dirs.begin(), dirs.end(), m_rng);
+  // 与递归版本逐步等价：进入格子时打乱方向，按顺序尝试，遇到未挖的邻格就压栈
+  // 相同种子生成的迷宫与递归版本完全一致，栈深度不再受调用栈限制
+  auto enter = [this](int x, int y)
+  {
+    CarveFrame frame{x, y, {0, 1, 2, 3}, 0};
+    m_rng.shuffle(frame.dirs.begin(), frame.dirs.end());
+    cell(x, y) = '.';
+    m_carveStack.push_back(frame);
+  };
 
-  m_grid[cy][cx] = '.';
+  m_carveStack.clear();
+  m_carveStack.reserve(static_cast<std::size_t>(m_width / 2) * (m_height / 2));
+  enter(startX, startY);
 
-  for (int dir : dirs)
+  while (!m_carveStack.empty())
   {
+    CarveFrame &frame = m_carveStack.back();
+    if (frame.next >= 4)
+    {
+      m_carveStack.pop_back();
+      continue;
+    }
+
+    int dir = frame.dirs[frame.next++];
+    int cx = frame.x;
+    int cy = frame.y;
     int nx = cx + dx[dir];
     int ny = cy + dy[dir];
 
     // 检查边界
-    if (nx > 0 && nx < m_width - 1 && ny > 0 && ny < m_height - 1)
+    if (nx > 0 && nx < m_width - 1 && ny > 0 && ny < m_height - 1 && cell(nx, ny) == '#')
     {
-      if (m_grid[ny][nx] == '#')
-      {
-        // 打通中间的墙
-        m_grid[cy + dy[dir] / 2][cx + dx[dir] / 2] = '.';
-        carvePassage(nx, ny);
-      }
+      // 打通中间的墙（frame 引用在 push_back 后可能失效，先取出坐标）
+      cell(cx + dx[dir] / 2, cy + dy[dir] / 2) = '.';
+      enter(nx, ny);
     }
   }
 }
 
-std::vector<std::pair<int, int>> MazeGenerator::getEmptySpaces()
+void MazeGenerator::collectOpenCells()
 {
-  std::vector<std::pair<int, int>> spaces;
+  m_openCells.clear();
   for (int y = 1; y < m_height - 1; ++y)
   {
     for (int x = 1; x < m_width - 1; ++x)
     {
-      if (m_grid[y][x] == '.')
+      if (cell(x, y) == '.')
       {
-        spaces.push_back({x, y});
+        m_openCells.push_back({x, y});
       }
     }
   }
-  return spaces;
+}
+
+void MazeGenerator::computeDistances(int fromX, int fromY, std::vector<int> &distance)
+{
+  // BFS：队列预分配为格子总数，每个格子最多入队一次，头尾下标只增不减
+  const std::size_t cellCount = static_cast<std::size_t>(m_width) * m_height;
+  distance.assign(cellCount, -1);
+  m_bfsQueue.resize(cellCount);
+
+  std::size_t head = 0;
+  std::size_t tail = 0;
+  int start = fromY * m_width + fromX;
+  distance[start] = 0;
+  m_bfsQueue[tail++] = start;
+
+  auto visit = [&](int next, int dist)
+  {
+    if (distance[next] >= 0 || m_grid[next] == '#')
+      return;
+    distance[next] = dist;
+    m_bfsQueue[tail++] = next;
+  };
+
+  while (head < tail)
+  {
+    int index = m_bfsQueue[head++];
+    int x = index % m_width;
+    int y = index / m_width;
+    int dist = distance[index] + 1;
+
+    // 只在内部格子间移动（不进入边框）
+    if (y > 1)
+      visit(index - m_width, dist);
+    if (x < m_width - 2)
+      visit(index + 1, dist);
+    if (y < m_height - 2)
+      visit(index + m_width, dist);
+    if (x > 1)
+      visit(index - 1, dist);
+  }
 }
 
 void MazeGenerator::placeStartAndEnd()
 {
-  auto emptySpaces = getEmptySpaces();
+  auto emptySpaces = m_openCells;
   if (emptySpaces.size() < 2)
   {
     // 回退到默认位置
@@ -129,81 +189,67 @@ void MazeGenerator::placeStartAndEnd()
     m_startY = 1;
     m_endX = m_width - 2;
     m_endY = m_height - 2;
-    m_grid[m_startY][m_startX] = 'S';
-    m_grid[m_endY][m_endX] = 'E';
+    cell(m_startX, m_startY) = 'S';
+    cell(m_endX, m_endY) = 'E';
+    computeDistances(m_startX, m_startY, m_distance[0]);
     return;
   }
 
-  std::shuffle(emptySpaces.begin(), emptySpaces.end(), m_rng);
+  m_rng.shuffle(emptySpaces.begin(), emptySpaces.end());
 
   // 随机选一个起点
   auto [sx, sy] = emptySpaces[0];
+  computeDistances(sx, sy, m_distance[0]);
 
-  // 计算所有点与起点的距离，并排序
+  // 按到起点的实际路径长度排序（不可达的点不参与）
   std::vector<std::pair<int, std::pair<int, int>>> distancePoints;
   for (size_t i = 1; i < emptySpaces.size(); ++i)
   {
     auto [ex, ey] = emptySpaces[i];
-    int dist = std::abs(ex - sx) + std::abs(ey - sy);
-    distancePoints.push_back({dist, {ex, ey}});
+    int dist = m_distance[0][ey * m_width + ex];
+    if (dist >= 0)
+    {
+      distancePoints.push_back({dist, {ex, ey}});
+    }
+  }
+  if (distancePoints.empty())
+  {
+    auto [ex, ey] = emptySpaces[1];
+    distancePoints.push_back({0, {ex, ey}});
   }
 
-  // 按距离排序（从远到近）
+  // 按距离排序（从远到近）；同距离按行、列排序，保证各标准库实现结果一致
   std::sort(distancePoints.begin(), distancePoints.end(),
             [](const auto &a, const auto &b)
-            { return a.first > b.first; });
+            {
+              if (a.first != b.first)
+                return a.first > b.first;
+              if (a.second.second != b.second.second)
+                return a.second.second < b.second.second;
+              return a.second.first < b.second.first;
+            });
 
   // 从距离最远的前 40% 中随机选一个作为终点
   // 确保起点离终点足够远
   int topCount = std::max(1, static_cast<int>(distancePoints.size() * 0.4));
-  int selectedIdx = m_rng() % topCount;
+  int selectedIdx = m_rng.below(topCount);
 
   m_startX = sx;
   m_startY = sy;
   m_endX = distancePoints[selectedIdx].second.first;
   m_endY = distancePoints[selectedIdx].second.second;
 
-  m_grid[m_startY][m_startX] = 'S';
-  m_grid[m_endY][m_endX] = 'E';
+  cell(m_startX, m_startY) = 'S';
+  cell(m_endX, m_endY) = 'E';
 }
 
-void MazeGenerator::ensurePath(int startX, int startY, int endX, int endY)
+void MazeGenerator::ensurePath(int startX, int startY, int endX, int endY, const std::vector<int> &distance)
 {
-  // 使用 BFS 确保起点到终点有路径
+  // 距离图在选点时已从起点算好，终点可达就无需处理
   // 如果没有路径，打通一些墙
-
-  std::vector<std::vector<bool>> visited(m_height, std::vector<bool>(m_width, false));
-  std::vector<std::pair<int, int>> queue;
-  queue.push_back({startX, startY});
-  visited[startY][startX] = true;
-
-  int dx[] = {0, 1, 0, -1};
-  int dy[] = {-1, 0, 1, 0};
-
-  while (!queue.empty())
+  if (!distance.empty() && distance[endY * m_width + endX] >= 0)
   {
-    auto [x, y] = queue.front();
-    queue.erase(queue.begin());
-
-    if (x == endX && y == endY)
-    {
-      return; // 找到路径
-    }
-
-    for (int i = 0; i < 4; ++i)
-    {
-      int nx = x + dx[i];
-      int ny = y + dy[i];
-
-      if (nx > 0 && nx < m_width - 1 && ny > 0 && ny < m_height - 1 && !visited[ny][nx])
-      {
-        if (m_grid[ny][nx] != '#')
-        {
-          visited[ny][nx] = true;
-          queue.push_back({nx, ny});
-        }
-      }
-    }
+    return;
   }
 
   // 如果没有找到路径，创建一条随机弯曲的路径
@@ -211,7 +257,7 @@ void MazeGenerator::ensurePath(int startX, int startY, int endX, int endY)
   while (x != endX || y != endY)
   {
     // 随机决定先走X还是Y
-    bool moveX = (m_rng() % 2 == 0);
+    bool moveX = (m_rng.below(2) == 0);
 
     if (moveX && x != endX)
     {
@@ -226,9 +272,12 @@ void MazeGenerator::ensurePath(int startX, int startY, int endX, int endY)
       x += (endX > x) ? 1 : -1;
     }
 
-    if (m_grid[y][x] == '#')
-      m_grid[y][x] = '.';
+    if (cell(x, y) == '#')
+      cell(x, y) = '.';
   }
+
+  // 新打通的格子加入空地列表
+  collectOpenCells();
 }
 
 void MazeGenerator::placeEnemies()
@@ -237,33 +286,30 @@ void MazeGenerator::placeEnemies()
 
   // 收集所有空地（排除起点和终点附近）
   int minDistFromStart = 5; // 距离起点至少5格
-  for (int y = 1; y < m_height - 1; ++y)
+  for (const auto &[x, y] : m_openCells)
   {
-    for (int x = 1; x < m_width - 1; ++x)
+    if (cell(x, y) == '.')
     {
-      if (m_grid[y][x] == '.')
-      {
-        // 计算与起点的距离
-        int distFromStart = std::abs(x - m_startX) + std::abs(y - m_startY);
-        int distFromEnd = std::abs(x - m_endX) + std::abs(y - m_endY);
+      // 计算与起点的距离
+      int distFromStart = std::abs(x - m_startX) + std::abs(y - m_startY);
+      int distFromEnd = std::abs(x - m_endX) + std::abs(y - m_endY);
 
-        // 不要太靠近起点或终点
-        if (distFromStart > minDistFromStart && distFromEnd > 3)
-        {
-          emptySpaces.push_back({x, y});
-        }
+      // 不要太靠近起点或终点
+      if (distFromStart > minDistFromStart && distFromEnd > 3)
+      {
+        emptySpaces.push_back({x, y});
       }
     }
   }
 
   // 随机放置敌人
-  std::shuffle(emptySpaces.begin(), emptySpaces.end(), m_rng);
+  m_rng.shuffle(emptySpaces.begin(), emptySpaces.end());
   int enemiesPlaced = 0;
   for (const auto &pos : emptySpaces)
   {
     if (enemiesPlaced >= m_enemyCount)
       break;
-    m_grid[pos.second][pos.first] = 'X';
+    cell(pos.first, pos.second) = 'X';
     enemiesPlaced++;
   }
 }
@@ -277,7 +323,7 @@ void MazeGenerator::placeDestructibleWalls()
   {
     for (int x = 1; x < m_width - 1; ++x)
     {
-      if (m_grid[y][x] == '#')
+      if (cell(x, y) == '#')
       {
         // 检查是否有相邻的通道
         bool hasAdjacentPath = false;
@@ -290,7 +336,7 @@ void MazeGenerator::placeDestructibleWalls()
           int ny = y + dy[i];
           if (nx >= 0 && nx < m_width && ny >= 0 && ny < m_height)
           {
-            if (m_grid[ny][nx] == '.' || m_grid[ny][nx] == 'S' || m_grid[ny][nx] == 'E')
+            if (cell(nx, ny) == '.' || cell(nx, ny) == 'S' || cell(nx, ny) == 'E')
             {
               hasAdjacentPath = true;
               break;
@@ -301,7 +347,7 @@ void MazeGenerator::placeDestructibleWalls()
         // 只有相邻有通道的墙才可能变成可破坏墙
         if (hasAdjacentPath)
         {
-          float roll = static_cast<float>(m_rng() % 1000) / 1000.f;
+          float roll = static_cast<float>(m_rng.below(1000)) / 1000.f;
           if (roll < m_destructibleRatio)
           {
             destructibleCandidates.push_back({x, y});
@@ -319,14 +365,14 @@ void MazeGenerator::placeDestructibleWalls()
       // 单人 Escape 模式：30%治疗，70%普通
       for (const auto &[x, y] : destructibleCandidates)
       {
-        float roll = static_cast<float>(m_rng() % 1000) / 1000.f;
+        float roll = static_cast<float>(m_rng.below(1000)) / 1000.f;
         if (roll < 0.30f)
         {
-          m_grid[y][x] = 'H'; // Heal (蓝色)
+          cell(x, y) = 'H'; // Heal (蓝色)
         }
         else
         {
-          m_grid[y][x] = '*'; // 普通 (棕色)
+          cell(x, y) = '*'; // 普通 (棕色)
         }
       }
     }
@@ -335,7 +381,7 @@ void MazeGenerator::placeDestructibleWalls()
       // 单人 Battle 模式：所有都是普通墙
       for (const auto &[x, y] : destructibleCandidates)
       {
-        m_grid[y][x] = '*'; // 普通可破坏墙
+        cell(x, y) = '*'; // 普通可破坏墙
       }
     }
     return;
@@ -348,14 +394,14 @@ void MazeGenerator::placeDestructibleWalls()
     // 30%治疗，70%普通
     for (const auto &[x, y] : destructibleCandidates)
     {
-      float roll = static_cast<float>(m_rng() % 1000) / 1000.f;
+      float roll = static_cast<float>(m_rng.below(1000)) / 1000.f;
       if (roll < 0.30f)
       {
-        m_grid[y][x] = 'H'; // Heal (蓝色)
+        cell(x, y) = 'H'; // Heal (蓝色)
       }
       else
       {
-        m_grid[y][x] = '*'; // 普通 (棕色)
+        cell(x, y) = '*'; // 普通 (棕色)
       }
     }
   }
@@ -364,18 +410,18 @@ void MazeGenerator::placeDestructibleWalls()
     // Battle 模式：15%金色，10%治疗，75%普通
     for (const auto &[x, y] : destructibleCandidates)
     {
-      float roll = static_cast<float>(m_rng() % 1000) / 1000.f;
+      float roll = static_cast<float>(m_rng.below(1000)) / 1000.f;
       if (roll < 0.15f)
       {
-        m_grid[y][x] = 'G'; // Gold
+        cell(x, y) = 'G'; // Gold
       }
       else if (roll < 0.25f)
       {
-        m_grid[y][x] = 'H'; // Heal
+        cell(x, y) = 'H'; // Heal
       }
       else
       {
-        m_grid[y][x] = '*'; // 普通
+        cell(x, y) = '*'; // 普通
       }
     }
   }
@@ -386,9 +432,9 @@ void MazeGenerator::placeMultiplayerSpawns()
   // 为多人模式找两个出生点和一个合适的终点：
   // 1. 两个出生点在地图中部区域，有一定距离
   // 2. 终点在地图边缘/四周区域
-  // 3. 两个出生点到终点的距离要相近（公平）
+  // 3. 两个出生点到终点的路径长度要相近（公平）
 
-  auto emptySpaces = getEmptySpaces();
+  const auto &emptySpaces = m_openCells;
   if (emptySpaces.size() < 3)
   {
     // 回退到默认位置
@@ -398,9 +444,11 @@ void MazeGenerator::placeMultiplayerSpawns()
     m_spawn2Y = m_height / 2;
     m_endX = m_width - 2;
     m_endY = m_height - 2;
-    m_grid[m_spawn1Y][m_spawn1X] = '1';
-    m_grid[m_spawn2Y][m_spawn2X] = '2';
-    m_grid[m_endY][m_endX] = 'E';
+    cell(m_spawn1X, m_spawn1Y) = '1';
+    cell(m_spawn2X, m_spawn2Y) = '2';
+    cell(m_endX, m_endY) = 'E';
+    computeDistances(m_spawn1X, m_spawn1Y, m_distance[0]);
+    computeDistances(m_spawn2X, m_spawn2Y, m_distance[1]);
     return;
   }
 
@@ -423,7 +471,7 @@ void MazeGenerator::placeMultiplayerSpawns()
   std::vector<std::pair<int, int>> spawnCandidates;
   for (const auto &[x, y] : emptySpaces)
   {
-    if (m_grid[y][x] == '.' || m_grid[y][x] == 'S')
+    if (cell(x, y) == '.' || cell(x, y) == 'S')
     {
       // 在中部区域
       if (x >= centerMinX && x < centerMaxX && y >= centerMinY && y < centerMaxY)
@@ -441,7 +489,7 @@ void MazeGenerator::placeMultiplayerSpawns()
     int smallMarginY = m_height / 6;
     for (const auto &[x, y] : emptySpaces)
     {
-      if (m_grid[y][x] == '.' || m_grid[y][x] == 'S')
+      if (cell(x, y) == '.' || cell(x, y) == 'S')
       {
         if (x >= smallMarginX && x < m_width - smallMarginX &&
             y >= smallMarginY && y < m_height - smallMarginY)
@@ -458,7 +506,7 @@ void MazeGenerator::placeMultiplayerSpawns()
   }
 
   // 随机打乱候选点
-  std::shuffle(spawnCandidates.begin(), spawnCandidates.end(), m_rng);
+  m_rng.shuffle(spawnCandidates.begin(), spawnCandidates.end());
 
   // 找两个有一定距离的出生点
   int minSpawnDist = std::max(6, std::min(m_width, m_height) / 4);  // 最小距离（增大）
@@ -483,7 +531,7 @@ void MazeGenerator::placeMultiplayerSpawns()
   // 从有效的出生点对中随机选择一对
   if (!validSpawnPairs.empty())
   {
-    int pairIdx = m_rng() % validSpawnPairs.size();
+    int pairIdx = m_rng.below(static_cast<uint32_t>(validSpawnPairs.size()));
     auto [idx1, idx2] = validSpawnPairs[pairIdx];
     m_spawn1X = spawnCandidates[idx1].first;
     m_spawn1Y = spawnCandidates[idx1].second;
@@ -507,18 +555,27 @@ void MazeGenerator::placeMultiplayerSpawns()
     m_spawn2Y = m_height / 2;
   }
 
+  // 两个出生点各做一次 BFS，终点候选直接查表得到实际路径长度
+  computeDistances(m_spawn1X, m_spawn1Y, m_distance[0]);
+  computeDistances(m_spawn2X, m_spawn2Y, m_distance[1]);
+  auto pathDistances = [&](int x, int y, int &distToSpawn1, int &distToSpawn2)
+  {
+    distToSpawn1 = m_distance[0][y * m_width + x];
+    distToSpawn2 = m_distance[1][y * m_width + x];
+    return distToSpawn1 >= 0 && distToSpawn2 >= 0;
+  };
+
   // 筛选边缘区域的空地作为终点候选，并计算到两个出生点的距离
   std::vector<std::tuple<int, int, int, int>> endCandidates; // {x, y, minDist, distDiff}
 
   for (const auto &[x, y] : emptySpaces)
   {
-    if (m_grid[y][x] == '.' || m_grid[y][x] == 'S')
+    if (cell(x, y) == '.' || cell(x, y) == 'S')
     {
       // 优先选择边缘区域的点
-      if (isEdgeArea(x, y))
+      int distToSpawn1, distToSpawn2;
+      if (isEdgeArea(x, y) && pathDistances(x, y, distToSpawn1, distToSpawn2))
       {
-        int distToSpawn1 = std::abs(x - m_spawn1X) + std::abs(y - m_spawn1Y);
-        int distToSpawn2 = std::abs(x - m_spawn2X) + std::abs(y - m_spawn2Y);
         int minDist = std::min(distToSpawn1, distToSpawn2);
         int distDiff = std::abs(distToSpawn1 - distToSpawn2);
 
@@ -536,12 +593,11 @@ void MazeGenerator::placeMultiplayerSpawns()
   {
     for (const auto &[x, y] : emptySpaces)
     {
-      if (m_grid[y][x] == '.' || m_grid[y][x] == 'S')
+      if (cell(x, y) == '.' || cell(x, y) == 'S')
       {
-        if (!isEdgeArea(x, y))
+        int distToSpawn1, distToSpawn2;
+        if (!isEdgeArea(x, y) && pathDistances(x, y, distToSpawn1, distToSpawn2))
         {
-          int distToSpawn1 = std::abs(x - m_spawn1X) + std::abs(y - m_spawn1Y);
-          int distToSpawn2 = std::abs(x - m_spawn2X) + std::abs(y - m_spawn2Y);
           int minDist = std::min(distToSpawn1, distToSpawn2);
           int distDiff = std::abs(distToSpawn1 - distToSpawn2);
 
@@ -555,16 +611,22 @@ void MazeGenerator::placeMultiplayerSpawns()
     }
   }
 
-  // 按距离排序（从远到近），优先选择距离远的
+  // 按距离排序（从远到近），优先选择距离远的；同距离按行、列排序（同上）
   std::sort(endCandidates.begin(), endCandidates.end(),
             [](const auto &a, const auto &b)
-            { return std::get<2>(a) > std::get<2>(b); });
+            {
+              if (std::get<2>(a) != std::get<2>(b))
+                return std::get<2>(a) > std::get<2>(b);
+              if (std::get<1>(a) != std::get<1>(b))
+                return std::get<1>(a) < std::get<1>(b);
+              return std::get<0>(a) < std::get<0>(b);
+            });
 
   // 从距离最远的前 30% 中随机选一个作为终点
   if (!endCandidates.empty())
   {
     int topCount = std::max(1, static_cast<int>(endCandidates.size() * 0.3));
-    int selectedIdx = m_rng() % topCount;
+    int selectedIdx = m_rng.below(topCount);
     m_endX = std::get<0>(endCandidates[selectedIdx]);
     m_endY = std::get<1>(endCandidates[selectedIdx]);
   }
@@ -574,22 +636,22 @@ void MazeGenerator::placeMultiplayerSpawns()
     m_endX = m_width - 2;
     m_endY = m_height - 2;
   }
-  m_grid[m_endY][m_endX] = 'E';
+  cell(m_endX, m_endY) = 'E';
 
   // 在地图上标记出生点，用 '1' 和 '2' 表示
   // 确保位置是空地才标记
   if (m_spawn1Y >= 0 && m_spawn1Y < m_height && m_spawn1X >= 0 && m_spawn1X < m_width)
   {
-    if (m_grid[m_spawn1Y][m_spawn1X] == '.' || m_grid[m_spawn1Y][m_spawn1X] == 'S')
+    if (cell(m_spawn1X, m_spawn1Y) == '.' || cell(m_spawn1X, m_spawn1Y) == 'S')
     {
-      m_grid[m_spawn1Y][m_spawn1X] = '1';
+      cell(m_spawn1X, m_spawn1Y) = '1';
     }
   }
   if (m_spawn2Y >= 0 && m_spawn2Y < m_height && m_spawn2X >= 0 && m_spawn2X < m_width)
   {
-    if (m_grid[m_spawn2Y][m_spawn2X] == '.' || m_grid[m_spawn2Y][m_spawn2X] == 'S')
+    if (cell(m_spawn2X, m_spawn2Y) == '.' || cell(m_spawn2X, m_spawn2Y) == 'S')
     {
-      m_grid[m_spawn2Y][m_spawn2X] = '2';
+      cell(m_spawn2X, m_spawn2Y) = '2';
     }
   }
 }
@@ -0,0 +1,100 @@
+#include "MazePool.hpp"
+#include <algorithm>
+#include <random>
+
+MazePool::MazePool()
+{
+  m_worker = std::thread(&MazePool::workerLoop, this);
+}
+
+MazePool::~MazePool()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+    m_pending.clear();
+  }
+  m_cv.notify_all();
+  if (m_worker.joinable())
+    m_worker.join();
+}
+
+bool MazePool::isKnown(const MazeRequest &request) const
+{
+  if (m_busy && m_current == request)
+    return true;
+  if (std::find(m_pending.begin(), m_pending.end(), request) != m_pending.end())
+    return true;
+  return std::any_of(m_ready.begin(), m_ready.end(), [&](const ReadyMaze &ready)
+                     { return ready.request == request; });
+}
+
+void MazePool::prefetch(const MazeRequest &request)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (isKnown(request))
+      return;
+
+    // 菜单里快速切换尺寸时只保留最近的几个任务
+    if (m_pending.size() >= MAX_PENDING)
+      m_pending.pop_front();
+    m_pending.push_back(request);
+  }
+  m_cv.notify_one();
+}
+
+bool MazePool::take(const MazeRequest &request, Maze &out)
+{
+  std::unique_ptr<Maze> maze;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = std::find_if(m_ready.begin(), m_ready.end(), [&](const ReadyMaze &ready)
+                           { return ready.request == request; });
+    if (it == m_ready.end())
+      return false;
+    maze = std::move(it->maze);
+    m_ready.erase(it);
+  }
+
+  // 旧迷宫随 unique_ptr 一起释放
+  out.swap(*maze);
+  return true;
+}
+
+void MazePool::workerLoop()
+{
+  // 每个迷宫使用独立的随机种子（generate 默认按秒取时间，连续生成会重复）
+  std::random_device device;
+  std::mt19937 seeder(device());
+
+  while (true)
+  {
+    MazeRequest request;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_cv.wait(lock, [this]
+                { return m_stop || !m_pending.empty(); });
+      if (m_stop)
+        return;
+      request = m_pending.front();
+      m_pending.pop_front();
+      m_busy = true;
+      m_current = request;
+    }
+
+    unsigned int seed = 0;
+    while (seed == 0)
+      seed = seeder();
+
+    auto maze = std::make_unique<Maze>();
+    maze->generateRandomMaze(request.width, request.height, seed, request.enemyCount, request.multiplayer,
+                             request.escape);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_busy = false;
+    if (m_ready.size() >= MAX_READY)
+      m_ready.pop_front();
+    m_ready.push_back({request, std::move(maze)});
+  }
+}
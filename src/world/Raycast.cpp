@@ -0,0 +1,102 @@
+#include "Raycast.hpp"
+#include <cmath>
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <utility>
+
+void OccupancyGrid::resize(int cols, int rows, float tileSize)
+{
+  m_cols = std::max(0, cols);
+  m_rows = std::max(0, rows);
+  m_tileSize = tileSize;
+  m_invTileSize = 1.f / tileSize;
+  std::size_t cells = static_cast<std::size_t>(m_cols) * m_rows;
+  m_bits.assign((cells + 31) / 32, 0);
+}
+
+void OccupancyGrid::set(int col, int row, CellBlock block)
+{
+  if (col < 0 || col >= m_cols || row < 0 || row >= m_rows)
+    return;
+  std::size_t index = static_cast<std::size_t>(row) * m_cols + col;
+  unsigned shift = static_cast<unsigned>(index & 31) * 2;
+  uint64_t &word = m_bits[index >> 5];
+  word = (word & ~(uint64_t{3} << shift)) | (static_cast<uint64_t>(block) << shift);
+}
+
+RayHit OccupancyGrid::castRay(const RayQuery &ray, RayMode mode) const
+{
+  RayHit hit;
+
+  // 换算到格子坐标（1 格 = 1 单位）
+  float gx0 = ray.x0 * m_invTileSize;
+  float gy0 = ray.y0 * m_invTileSize;
+  float dx = ray.x1 * m_invTileSize - gx0;
+  float dy = ray.y1 * m_invTileSize - gy0;
+
+  int col = static_cast<int>(std::floor(gx0));
+  int row = static_cast<int>(std::floor(gy0));
+  int endCol = static_cast<int>(std::floor(gx0 + dx));
+  int endRow = static_cast<int>(std::floor(gy0 + dy));
+
+  // 每个轴上穿过一整格所需的 t，以及到达下一条格线的 t
+  constexpr float INF = std::numeric_limits<float>::infinity();
+  int stepX = dx > 0.f ? 1 : -1;
+  int stepY = dy > 0.f ? 1 : -1;
+  float tDeltaX = dx != 0.f ? std::abs(1.f / dx) : INF;
+  float tDeltaY = dy != 0.f ? std::abs(1.f / dy) : INF;
+  float tMaxX = dx > 0.f ? (col + 1 - gx0) * tDeltaX : (dx < 0.f ? (gx0 - col) * tDeltaX : INF);
+  float tMaxY = dy > 0.f ? (row + 1 - gy0) * tDeltaY : (dy < 0.f ? (gy0 - row) * tDeltaY : INF);
+
+  // 剩余格数固定了循环次数，浮点误差不会让遍历越过终点格
+  int remaining = std::abs(endCol - col) + std::abs(endRow - row);
+  float t = 0.f;
+  while (true)
+  {
+    CellBlock block = get(col, row);
+    if (block != CellBlock::Empty)
+    {
+      if (hit.block == CellBlock::Empty)
+      {
+        hit.col = col;
+        hit.row = row;
+        hit.t = t;
+      }
+      hit.block = block;
+      if (block == CellBlock::Solid || mode == RayMode::FirstHit)
+        return hit;
+    }
+
+    if (remaining-- <= 0)
+      break;
+    if (tMaxX < tMaxY)
+    {
+      t = tMaxX;
+      tMaxX += tDeltaX;
+      col += stepX;
+    }
+    else
+    {
+      t = tMaxY;
+      tMaxY += tDeltaY;
+      row += stepY;
+    }
+  }
+  return hit;
+}
+
+void OccupancyGrid::castRays(const RayQuery *rays, std::size_t count, RayHit *out, RayMode mode) const
+{
+  for (std::size_t i = 0; i < count; i++)
+    out[i] = castRay(rays[i], mode);
+}
+
+void OccupancyGrid::swap(OccupancyGrid &other)
+{
+  std::swap(m_cols, other.m_cols);
+  std::swap(m_rows, other.m_rows);
+  std::swap(m_tileSize, other.m_tileSize);
+  std::swap(m_invTileSize, other.m_invTileSize);
+  m_bits.swap(other.m_bits);
+}
@@ -0,0 +1,91 @@
+// MazeGenerator 输出回归测试（不依赖 SFML，由 ctest 调用）
+// 联机只同步种子（MazeSeed），输出变化会导致双方地图不一致：
+// 有意修改生成结果时必须递增 MazeGenerator::ALGORITHM_VERSION 并更新这里的哈希
+#include "MazeGenerator.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace
+{
+  // FNV-1a，覆盖全部格子
+  uint64_t hashMaze(const std::vector<std::string> &rows)
+  {
+    uint64_t h = 14695981039346656037ull;
+    for (const auto &row : rows)
+    {
+      for (char c : row)
+      {
+        h ^= static_cast<uint8_t>(c);
+        h *= 1099511628211ull;
+      }
+    }
+    return h;
+  }
+
+  // 当前算法版本的固定输出（种子 12345，10 个敌人）
+  struct PinnedMaze
+  {
+    int width, height;
+    bool multiplayer, escape;
+    uint64_t hash;
+  };
+
+  constexpr uint8_t PINNED_VERSION = 2;
+  constexpr PinnedMaze PINNED_MAZES[] = {
+      {41, 31, false, false, 0x19ff7cd8ce0dbd7bull},
+      {41, 31, false, true, 0xf88e91f7b60e6019ull},
+      {41, 31, true, false, 0x98389fde8b664ac2ull},
+      {41, 31, true, true, 0x4928c94a6a9a48e6ull},
+      {151, 101, false, false, 0x0d5fa64170a1ab6full},
+      {151, 101, false, true, 0x623b8ee731e0612dull},
+      {151, 101, true, false, 0x8f36d200c97ecc84ull},
+      {151, 101, true, true, 0x2528884ef34db3f1ull},
+  };
+
+  std::vector<std::string> generate(const PinnedMaze &pinned)
+  {
+    MazeGenerator generator(pinned.width, pinned.height);
+    generator.setSeed(12345);
+    generator.setEnemyCount(10);
+    generator.setMultiplayerMode(pinned.multiplayer);
+    generator.setEscapeMode(pinned.escape);
+    return generator.generate();
+  }
+}
+
+int main()
+{
+  if (MazeGenerator::ALGORITHM_VERSION != PINNED_VERSION)
+  {
+    std::printf("FAIL: pinned hashes are for generator v%d, current is v%d: update PINNED_MAZES\n",
+                static_cast<int>(PINNED_VERSION), static_cast<int>(MazeGenerator::ALGORITHM_VERSION));
+    return 1;
+  }
+
+  int failures = 0;
+  for (const auto &pinned : PINNED_MAZES)
+  {
+    uint64_t h = hashMaze(generate(pinned));
+    if (h != pinned.hash)
+    {
+      failures++;
+      std::printf("FAIL: %dx%d%s%s: got %016llx, expected %016llx\n", pinned.width, pinned.height,
+                  pinned.multiplayer ? " multiplayer" : "", pinned.escape ? " escape" : "",
+                  static_cast<unsigned long long>(h), static_cast<unsigned long long>(pinned.hash));
+    }
+    // 同一进程内重复生成也必须一致（生成器不能依赖全局状态）
+    else if (hashMaze(generate(pinned)) != h)
+    {
+      failures++;
+      std::printf("FAIL: %dx%d regenerated with a different hash\n", pinned.width, pinned.height);
+    }
+  }
+
+  if (failures == 0)
+    std::printf("MazeDeterminismTest: %zu pinned mazes ok (v%d)\n", std::size(PINNED_MAZES),
+                static_cast<int>(PINNED_VERSION));
+  return failures == 0 ? 0 : 1;
+}
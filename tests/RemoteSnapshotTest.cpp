@@ -0,0 +1,97 @@
+// 远程快照插值：采样结果必须真正写回对方坦克和 NPC（无窗口运行，由 ctest 调用）
+#include "MultiplayerHandler.hpp"
+#include "NetworkManager.hpp"
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+  int s_failures = 0;
+
+  void check(bool condition, const char *what)
+  {
+    if (!condition)
+    {
+      std::printf("FAIL: %s\n", what);
+      s_failures++;
+    }
+  }
+
+  bool near(sf::Vector2f a, sf::Vector2f b, float tolerance)
+  {
+    return std::hypot(a.x - b.x, a.y - b.y) <= tolerance;
+  }
+
+  // 四周实心墙、中间全是空地的小地图
+  std::vector<std::string> openMap(int cols, int rows)
+  {
+    std::vector<std::string> map(rows, std::string(cols, '.'));
+    for (int c = 0; c < cols; c++)
+      map.front()[c] = map.back()[c] = '#';
+    for (auto &row : map)
+      row.front() = row.back() = '#';
+    return map;
+  }
+}
+
+int main()
+{
+  sf::RenderWindow window;
+  sf::View gameView, uiView;
+  sf::Font font;
+  EntityStore entities;
+  Maze maze;
+  maze.loadFromString(openMap(12, 12));
+
+  const sf::Vector2f from{3.f * TILE_SIZE, 3.f * TILE_SIZE};
+  const sf::Vector2f to{8.f * TILE_SIZE, 3.f * TILE_SIZE};
+
+  Tank player(entities, 2.f * TILE_SIZE, 8.f * TILE_SIZE);
+  Tank otherPlayer(entities, from.x, from.y);
+  std::vector<std::unique_ptr<Enemy>> enemies;
+  enemies.push_back(std::make_unique<Enemy>(entities));
+  enemies[0]->setId(0);
+  enemies[0]->setPosition(from + sf::Vector2f{0.f, 4.f * TILE_SIZE});
+  std::vector<std::unique_ptr<Bullet>> bullets;
+
+  MultiplayerContext ctx{window, gameView, uiView, font, &player, &otherPlayer, enemies, entities, bullets, maze,
+                         1920, 1080, 0.25f, false, true, false};
+  MultiplayerState state;
+  state.isMultiplayer = true;
+  state.isHost = false; // 非房主：NPC 也由快照驱动
+  state.npcSnapshots.assign(enemies.size(), SnapshotBuffer());
+
+  // 两帧快照：当前渲染时刻（now - INTERP_DELAY）正好落在两帧中点
+  float now = NetworkManager::getInstance().getNetworkTime();
+  float t0 = now - SnapshotBuffer::INTERP_DELAY - 0.05f;
+  float t1 = now - SnapshotBuffer::INTERP_DELAY + 0.05f;
+  sf::Vector2f npcOffset{0.f, 4.f * TILE_SIZE};
+  state.otherPlayerSnapshots.push(0.f, t0, from, 0.f, 0.f);
+  state.otherPlayerSnapshots.push(0.f, t1, to, 90.f, 45.f);
+  state.npcSnapshots[0].push(0.f, t0, from + npcOffset, 0.f, 0.f);
+  state.npcSnapshots[0].push(0.f, t1, to + npcOffset, 0.f, 0.f);
+
+  MultiplayerHandler::applyRemoteSnapshots(ctx, state);
+
+  // 采样时钟在两次读取之间还会前进一点，容差取几个像素
+  sf::Vector2f middle = (from + to) / 2.f;
+  check(!near(otherPlayer.getPosition(), from, 1.f), "remote tank left its spawn");
+  check(near(otherPlayer.getPosition(), middle, 8.f), "remote tank interpolated between snapshots");
+  check(otherPlayer.getRotation() > 0.f, "remote tank rotation sampled");
+  check(near(enemies[0]->getPosition(), middle + npcOffset, 8.f), "guest NPC interpolated between snapshots");
+
+  // 房主自己模拟 NPC：只移动对方坦克
+  sf::Vector2f npcBefore = enemies[0]->getPosition();
+  state.isHost = true;
+  state.npcSnapshots[0].clear();
+  state.npcSnapshots[0].push(0.f, t0, from, 0.f, 0.f);
+  MultiplayerHandler::applyRemoteSnapshots(ctx, state);
+  check(near(enemies[0]->getPosition(), npcBefore, 0.01f), "host NPCs are not driven by snapshots");
+
+  if (s_failures == 0)
+    std::printf("RemoteSnapshotTest: ok\n");
+  return s_failures == 0 ? 0 : 1;
+}